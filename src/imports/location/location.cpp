@@ -53,6 +53,7 @@
 #include <QtLocation/private/qdeclarativegeomapparameter_p.h>
 #include <QtLocation/private/qdeclarativegeomapcopyrightsnotice_p.h>
 #include <QtLocation/private/qdeclarativegeomapitemgroup_p.h>
+#include <QtLocation/private/qdeclarativegeomapitembatch_p.h>
 
 //Place includes
 #include <QtLocation/private/qdeclarativecategory_p.h>
@@ -180,6 +181,11 @@ public:
             qmlRegisterUncreatableType<QDeclarativeGeoCameraCapabilities>(uri, major, minor, "CameraCapabilities"
                                                                              , QStringLiteral("CameraCapabilities is not intended instantiable by developer."));
 
+            // Register the 5.11 types
+            minor = 11;
+            qmlRegisterType<QDeclarativeGeoMap, 11>(uri, major, minor, "Map");
+            qmlRegisterType<QDeclarativeGeoMapItemBatch>(uri, major, minor, "MapItemBatch");
+
             // Register the latest Qt version as QML type version
             qmlRegisterModule(uri, QT_VERSION_MAJOR, QT_VERSION_MINOR);
 
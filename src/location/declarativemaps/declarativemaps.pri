@@ -23,10 +23,12 @@ PRIVATE_HEADERS += \
            declarativemaps/qdeclarativeroutemapitem_p.h \
            declarativemaps/qdeclarativegeomapparameter_p.h \
            declarativemaps/qgeomapitemgeometry_p.h \
+           declarativemaps/qgeomapitemindex_p.h \
            declarativemaps/qdeclarativegeomapcopyrightsnotice_p.h \
            declarativemaps/locationvaluetypehelper_p.h \
            declarativemaps/qquickgeomapgesturearea_p.h \
            declarativemaps/qdeclarativegeomapitemgroup_p.h \
+           declarativemaps/qdeclarativegeomapitembatch_p.h \
            declarativemaps/mapitemviewdelegateincubator_p.h \
            ../imports/positioning/qquickgeocoordinateanimation_p.h
 
@@ -49,11 +51,13 @@ SOURCES += \
            declarativemaps/qdeclarativeroutemapitem.cpp \
            declarativemaps/qdeclarativegeomapparameter.cpp \
            declarativemaps/qgeomapitemgeometry.cpp \
+           declarativemaps/qgeomapitemindex.cpp \
            declarativemaps/qdeclarativegeomapcopyrightsnotice.cpp \
            declarativemaps/error_messages.cpp \
            declarativemaps/locationvaluetypehelper.cpp \
            declarativemaps/qquickgeomapgesturearea.cpp \
            declarativemaps/qdeclarativegeomapitemgroup.cpp \
+           declarativemaps/qdeclarativegeomapitembatch.cpp \
            ../imports/positioning/qquickgeocoordinateanimation.cpp \
            declarativemaps/mapitemviewdelegateincubator.cpp
 
@@ -142,7 +142,7 @@ QGeoMapCircleGeometry::QGeoMapCircleGeometry()
 /*!
     \internal
 */
-void QGeoMapCircleGeometry::updateScreenPointsInvert(const QList<QDoubleVector2D> &circlePath, const QGeoMap &map)
+void QGeoMapCircleGeometry::updateScreenPointsInvert(const QList<QDoubleVector2D> &circlePath, const QGeoMapSnapshot &map)
 {
     // Not checking for !screenDirty anymore, as everything is now recalculated.
     clear();
@@ -489,6 +489,15 @@ void QDeclarativeCircleMapItem::updatePolish()
     QScopedValueRollback<bool> rollback(updatingGeometry_);
     updatingGeometry_ = true;
 
+    const qreal borderWidth = (border_.color() != Qt::transparent && border_.width() > 0) ? border_.width() : 0;
+
+    // The camera only moved as far as scaling and rotating the item can show
+    if (!geometry_.isSourceDirty() && !borderGeometry_.isSourceDirty()) {
+        updateBorderStroke(borderWidth);
+        updateItemGeometry(QRectF(0, 0, width(), height()));
+        return;
+    }
+
     QList<QDoubleVector2D> circlePath = circlePath_;
 
     int pathCount = circlePath.size();
@@ -498,51 +507,142 @@ void QDeclarativeCircleMapItem::updatePolish()
     geometry_.setPreserveGeometry(true, leftBound_); // to set the geoLeftBound_
     geometry_.setPreserveGeometry(preserve, leftBound_);
 
-    bool invertedCircle = false;
-    if (crossEarthPole(circle_.center(), circle_.radius()) && circlePath.size() == pathCount) {
-        geometry_.updateScreenPointsInvert(circlePath, *map()); // invert fill area for really huge circles
-        invertedCircle = true;
+    const bool invertedCircle = crossEarthPole(circle_.center(), circle_.radius()) && circlePath.size() == pathCount;
+
+    // The outline has a fixed number of samples, below AsyncGeometryThreshold
+    // unless that is lowered
+    if (circlePath.size() >= AsyncGeometryThreshold) {
+        if (deferGeometryUpdate())
+            return;
+        const QGeoMapSnapshot snapshot = QGeoMapSnapshot::copy(*map());
+        if (snapshot.isCopy()) {
+            QSharedPointer<QGeoMapCircleGeometry> geometry(new QGeoMapCircleGeometry(geometry_));
+            QSharedPointer<QGeoMapPolylineGeometry> borderGeometry(new QGeoMapPolylineGeometry(borderGeometry_));
+            QSharedPointer<QRectF> combined(new QRectF);
+            const QList<QDoubleVector2D> sourcePath = circlePath_;
+            const QGeoCoordinate leftBound = leftBound_;
+            const QGeoCameraData camera = snapshot.cameraData();
+            startGeometryJob([snapshot, geometry, borderGeometry, combined, circlePath, sourcePath,
+                              invertedCircle, preserve, leftBound, borderWidth]() {
+                *combined = updateGeometries(snapshot, circlePath, sourcePath, invertedCircle,
+                                             preserve, leftBound, borderWidth,
+                                             *geometry, *borderGeometry);
+            }, [this, geometry, borderGeometry, combined, camera, borderWidth, invertedCircle]() {
+                QScopedValueRollback<bool> rollback(updatingGeometry_);
+                updatingGeometry_ = true;
+                // The item may have been marked dirty again while the job ran
+                const bool outdated = geometry_.sourceRevision() != geometry->sourceRevision()
+                        || borderGeometry_.sourceRevision() != borderGeometry->sourceRevision();
+                geometry_ = *geometry;
+                borderGeometry_ = *borderGeometry;
+                const bool moved = !(map()->cameraData() == camera);
+                if (!setGeometryReference(camera) || outdated || (invertedCircle && moved)) {
+                    geometry_.markSourceDirty();
+                    borderGeometry_.markSourceDirty();
+                    polishAndUpdate();
+                }
+                updateBorderStroke(borderWidth);
+                updateItemGeometry(*combined);
+            });
+            return;
+        }
+    }
+
+    cancelGeometryJob();
+    setGeometryReference(map()->cameraData());
+    updateItemGeometry(updateGeometries(*map(), circlePath, circlePath_, invertedCircle,
+                                        preserve, leftBound_, borderWidth,
+                                        geometry_, borderGeometry_));
+}
+
+/*!
+    \internal
+
+    Generates the fill \a geometry and, for a positive \a borderWidth, the
+    \a borderGeometry of \a circlePath, and returns their combined bounds.
+    \a sourcePath is the unmodified outline, used for the border of an
+    \a inverted circle. Only touches its arguments, so that it can run on a
+    worker thread.
+*/
+QRectF QDeclarativeCircleMapItem::updateGeometries(const QGeoMapSnapshot &map,
+                                                   const QList<QDoubleVector2D> &circlePath,
+                                                   const QList<QDoubleVector2D> &sourcePath,
+                                                   bool inverted,
+                                                   bool preserve,
+                                                   const QGeoCoordinate &leftBound,
+                                                   qreal borderWidth,
+                                                   QGeoMapCircleGeometry &geometry,
+                                                   QGeoMapPolylineGeometry &borderGeometry)
+{
+    if (inverted) {
+        geometry.updateScreenPointsInvert(circlePath, map); // invert fill area for really huge circles
     } else {
-        geometry_.updateSourcePoints(*map(), circlePath);
-        geometry_.updateScreenPoints(*map());
+        geometry.updateSourcePoints(map, circlePath);
+        geometry.updateScreenPoints(map);
     }
 
-    borderGeometry_.clear();
+    borderGeometry.clear();
     QList<QGeoMapItemGeometry *> geoms;
-    geoms << &geometry_;
+    geoms << &geometry;
 
-    if (border_.color() != Qt::transparent && border_.width() > 0) {
+    if (borderWidth > 0) {
         QList<QDoubleVector2D> closedPath = circlePath;
         closedPath << closedPath.first();
 
-        if (invertedCircle) {
-            closedPath = circlePath_;
+        if (inverted) {
+            closedPath = sourcePath;
             closedPath << closedPath.first();
             std::reverse(closedPath.begin(), closedPath.end());
         }
 
-        borderGeometry_.setPreserveGeometry(true, leftBound_);
-        borderGeometry_.setPreserveGeometry(preserve, leftBound_);
+        borderGeometry.setPreserveGeometry(true, leftBound);
+        borderGeometry.setPreserveGeometry(preserve, leftBound);
 
         // Use srcOrigin_ from fill geometry after clipping to ensure that translateToCommonOrigin won't fail.
-        const QGeoCoordinate &geometryOrigin = geometry_.origin();
+        const QGeoCoordinate &geometryOrigin = geometry.origin();
 
-        borderGeometry_.srcPoints_.clear();
-        borderGeometry_.srcPointTypes_.clear();
+        borderGeometry.srcPoints_.clear();
+        borderGeometry.srcPointTypes_.clear();
 
         QDoubleVector2D borderLeftBoundWrapped;
-        QList<QList<QDoubleVector2D > > clippedPaths = borderGeometry_.clipPath(*map(), closedPath, borderLeftBoundWrapped);
+        QList<QList<QDoubleVector2D > > clippedPaths = borderGeometry.clipPath(map, closedPath, borderLeftBoundWrapped);
         if (clippedPaths.size()) {
-            borderLeftBoundWrapped = map()->geoProjection().geoToWrappedMapProjection(geometryOrigin);
-            borderGeometry_.pathToScreen(*map(), clippedPaths, borderLeftBoundWrapped);
-            borderGeometry_.updateScreenPoints(*map(), border_.width());
-            geoms << &borderGeometry_;
+            borderLeftBoundWrapped = map.geoProjection().geoToWrappedMapProjection(geometryOrigin);
+            borderGeometry.pathToScreen(map, clippedPaths, borderLeftBoundWrapped);
+            borderGeometry.updateScreenPoints(map, borderWidth);
+            geoms << &borderGeometry;
         } else {
-            borderGeometry_.clear();
+            borderGeometry.clear();
         }
     }
 
-    QRectF combined = QGeoMapItemGeometry::translateToCommonOrigin(geoms);
+    return QGeoMapItemGeometry::translateToCommonOrigin(geoms);
+}
+
+/*!
+    \internal
+
+    Strokes the border again if scaling the item would change its width.
+*/
+void QDeclarativeCircleMapItem::updateBorderStroke(qreal borderWidth)
+{
+    const qreal strokeWidth = borderWidth / geometryScale();
+    if (borderGeometry_.size() == 0 || qFuzzyCompare(strokeWidth, borderGeometry_.strokeWidth()))
+        return;
+
+    borderGeometry_.markScreenDirty();
+    borderGeometry_.updateScreenPoints(*map(), strokeWidth);
+
+    QList<QGeoMapItemGeometry *> geoms;
+    geoms << &geometry_ << &borderGeometry_;
+    QGeoMapItemGeometry::translateToCommonOrigin(geoms);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeCircleMapItem::updateItemGeometry(const QRectF &combined)
+{
     setWidth(combined.width());
     setHeight(combined.height());
 
@@ -557,6 +657,14 @@ void QDeclarativeCircleMapItem::afterViewportChanged(const QGeoMapViewportChange
     if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
         return;
 
+    // Pans, rotations and zooming within an integer zoom level keep the geometry,
+    // except for circles around a pole, whose fill is clipped to the viewport
+    if (!event.mapSizeChanged && !crossEarthPole(circle_.center(), circle_.radius())
+            && updateGeometryTransform(event.cameraData)) {
+        polishAndUpdate();
+        return;
+    }
+
     markSourceDirtyAndUpdate();
 }
 
@@ -602,7 +710,8 @@ void QDeclarativeCircleMapItem::geometryChanged(const QRectF &newGeometry, const
         return;
     }
 
-    QDoubleVector2D newPoint = QDoubleVector2D(x(),y()) + QDoubleVector2D(width(), height()) / 2;
+    // The item can be scaled and rotated, see updateGeometryTransform()
+    QDoubleVector2D newPoint(mapToItem(parentItem(), QPointF(width(), height()) / 2));
     QGeoCoordinate newCoordinate = map()->geoProjection().itemPositionToCoordinate(newPoint, false);
     if (newCoordinate.isValid())
         setCenter(newCoordinate);
@@ -63,7 +63,7 @@ class QGeoMapCircleGeometry : public QGeoMapPolygonGeometry
 public:
     QGeoMapCircleGeometry();
 
-    void updateScreenPointsInvert(const QList<QDoubleVector2D> &circlePath, const QGeoMap &map);
+    void updateScreenPointsInvert(const QList<QDoubleVector2D> &circlePath, const QGeoMapSnapshot &map);
 };
 
 class Q_LOCATION_PRIVATE_EXPORT QDeclarativeCircleMapItem : public QDeclarativeGeoMapItemBase
@@ -119,6 +119,17 @@ private:
     void updateCirclePath();
     void updateCirclePathForRendering(QList<QDoubleVector2D> &path, const QGeoCoordinate &center,
                                       qreal distance);
+    void updateBorderStroke(qreal borderWidth);
+    void updateItemGeometry(const QRectF &combined);
+    static QRectF updateGeometries(const QGeoMapSnapshot &map,
+                                   const QList<QDoubleVector2D> &circlePath,
+                                   const QList<QDoubleVector2D> &sourcePath,
+                                   bool inverted,
+                                   bool preserve,
+                                   const QGeoCoordinate &leftBound,
+                                   qreal borderWidth,
+                                   QGeoMapCircleGeometry &geometry,
+                                   QGeoMapPolylineGeometry &borderGeometry);
 
 private:
     QGeoCircle circle_;
@@ -42,6 +42,8 @@
 #include "qgeomappingmanager_p.h"
 #include "qgeocameracapabilities_p.h"
 #include "qgeomap_p.h"
+#include "qgeotiledmap_p.h"
+#include "qabstractgeotilecache_p.h"
 #include "qdeclarativegeomapparameter_p.h"
 #include <QtPositioning/QGeoCircle>
 #include <QtPositioning/QGeoRectangle>
@@ -139,6 +141,11 @@ QT_BEGIN_NAMESPACE
     Further, more detailed notes on this are in the documentation for each
     map item type.
 
+    MapRectangle, MapCircle, MapPolyline and MapPolygon items are kept in a
+    spatial index, and when the map moves only those in or near the visible
+    area are updated. Many such items spread over a large area therefore cost
+    little more, per frame, than the ones on screen.
+
     \section2 Example Usage
 
     The following snippet shows a simple Map and the necessary Plugin type
@@ -753,7 +760,13 @@ void QDeclarativeGeoMap::mappingManagerInitialized()
 
 
     connect(m_map, &QGeoMap::sgNodeChanged, this, &QQuickItem::update);
+    connect(m_map, &QGeoMap::cameraDataChanged, this, &QDeclarativeGeoMap::onCameraDataChanged);
     connect(m_map, &QGeoMap::cameraCapabilitiesChanged, this, &QDeclarativeGeoMap::onCameraCapabilitiesChanged);
+    if (QGeoTiledMap *tiledMap = qobject_cast<QGeoTiledMap *>(m_map)) {
+        if (QAbstractGeoTileCache *cache = tiledMap->tileCache())
+            connect(cache, &QAbstractGeoTileCache::statisticsChanged,
+                    this, &QDeclarativeGeoMap::tileCacheStatisticsChanged);
+    }
 
     // This prefetches a buffer around the map
     m_map->prefetchData();
@@ -1352,6 +1365,30 @@ bool QDeclarativeGeoMap::mapReady() const
     return m_initialized;
 }
 
+/*!
+    \qmlproperty var QtLocation::Map::tileCacheStatistics
+
+    This read-only property holds a snapshot of the counters kept by the tile cache
+    of the current plugin, or an empty object if the map is not tile based.
+
+    The \c texture, \c memory and \c disk entries each hold \c hits, \c misses,
+    \c evictions, \c bytesIn, \c bytesOut, \c cost and \c maxCost. The
+    \c decodeTime and \c fetchTime entries hold the sample \c count, the mean, maximum
+    and 50th, 95th and 99th percentile latencies in microseconds, and the raw
+    \c buckets of the underlying log2 histogram.
+
+    Change notifications are coalesced, so the property is refreshed at most once per second.
+
+    \since 5.11
+*/
+QVariantMap QDeclarativeGeoMap::tileCacheStatistics() const
+{
+    QGeoTiledMap *tiledMap = qobject_cast<QGeoTiledMap *>(m_map);
+    if (!tiledMap || !tiledMap->tileCache())
+        return QVariantMap();
+    return tiledMap->tileCache()->statistics().toVariantMap();
+}
+
 // TODO: offer the possibility to specify the margins.
 void QDeclarativeGeoMap::fitViewportToGeoShape()
 {
@@ -1652,6 +1689,132 @@ void QDeclarativeGeoMap::onAttachedCopyrightNoticeVisibilityChanged()
         m_map->setCopyrightVisible(m_copyNoticesVisible > 0);
 }
 
+/*!
+    \internal
+
+    Passes \a cameraData on to the map items. Items drawn by the plugin and
+    quick items always receive it; rectangles, circles, polylines and polygons
+    are looked up in a spatial index, and only those near the viewport do.
+    An item moving away gets one last update, which leaves it off screen, and
+    catches up with every camera change it missed once it comes back.
+*/
+void QDeclarativeGeoMap::onCameraDataChanged(const QGeoCameraData &cameraData)
+{
+    for (QDeclarativeGeoMapItemBase *item : qAsConst(m_itemsToIndex))
+        updateMapItemBounds(item);
+    m_itemsToIndex.clear();
+
+    // The visible region grown by half its size on each side, so that strokes
+    // and items sized in pixels are covered too. Without a region, or when it
+    // wraps around the world, every item is near the viewport.
+    QRectF area(-1.0, -1.0, 3.0, 3.0);
+    const QList<QDoubleVector2D> &visibleRegion = m_map->geoProjection().visibleRegion();
+    if (!visibleRegion.isEmpty()) {
+        qreal left = visibleRegion.first().x();
+        qreal right = left;
+        qreal top = visibleRegion.first().y();
+        qreal bottom = top;
+        for (const QDoubleVector2D &p : visibleRegion) {
+            left = qMin(left, p.x());
+            right = qMax(right, p.x());
+            top = qMin(top, p.y());
+            bottom = qMax(bottom, p.y());
+        }
+        const qreal marginX = (right - left) / 2.0;
+        const qreal marginY = (bottom - top) / 2.0;
+        if (right - left + 2.0 * marginX < 1.0)
+            area = QRectF(QPointF(left - marginX, top - marginY), QPointF(right + marginX, bottom + marginY));
+    }
+
+    // The region is in wrapped coordinates, the index is not
+    QSet<QDeclarativeGeoMapItemBase *> nearViewport;
+    QVector<QDeclarativeGeoMapItemBase *> hits;
+    for (int shift = -1; shift <= 1; ++shift)
+        m_itemIndex.intersecting(area.translated(shift, 0.0), hits);
+    for (QDeclarativeGeoMapItemBase *item : qAsConst(hits))
+        nearViewport.insert(item);
+
+    QVector<QDeclarativeGeoMapItemBase *> receivers;
+    receivers.reserve(nearViewport.size() + m_itemsNearViewport.size() + m_unindexedItems.size());
+    for (QDeclarativeGeoMapItemBase *item : qAsConst(nearViewport))
+        receivers.append(item);
+    for (QDeclarativeGeoMapItemBase *item : qAsConst(m_itemsNearViewport)) {
+        if (!nearViewport.contains(item))
+            receivers.append(item);
+    }
+    for (QDeclarativeGeoMapItemBase *item : qAsConst(m_unindexedItems))
+        receivers.append(item);
+    m_itemsNearViewport.swap(nearViewport);
+
+    for (QDeclarativeGeoMapItemBase *item : qAsConst(receivers)) {
+        // Skip the items a previous receiver got rid of
+        if (m_itemIndex.contains(item) || m_unindexedItems.contains(item))
+            item->baseCameraDataChanged(cameraData);
+    }
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMap::registerMapItem(QDeclarativeGeoMapItemBase *item)
+{
+    const QGeoMap::ItemType type = item->itemType();
+    const bool indexed = (type == QGeoMap::MapRectangle || type == QGeoMap::MapCircle
+                          || type == QGeoMap::MapPolyline || type == QGeoMap::MapPolygon)
+            && !(m_map->supportedMapItemTypes() & type);
+    if (indexed)
+        m_itemsToIndex.insert(item);
+    else
+        m_unindexedItems.insert(item);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMap::unregisterMapItem(QDeclarativeGeoMapItemBase *item)
+{
+    m_itemIndex.remove(item);
+    m_itemsToIndex.remove(item);
+    m_unindexedItems.remove(item);
+    m_itemsNearViewport.remove(item);
+}
+
+/*!
+    \internal
+
+    Schedules \a item to be indexed again with the next camera change.
+*/
+void QDeclarativeGeoMap::markMapItemBoundsDirty(QDeclarativeGeoMapItemBase *item)
+{
+    if (!m_unindexedItems.contains(item))
+        m_itemsToIndex.insert(item);
+}
+
+/*!
+    \internal
+
+    Indexes \a item with the mercator bounds of its shape. Returns false, and
+    leaves the item out of the index, if its shape is empty.
+*/
+bool QDeclarativeGeoMap::updateMapItemBounds(QDeclarativeGeoMapItemBase *item)
+{
+    const QGeoRectangle box = item->geoShape().boundingGeoRectangle();
+    if (!box.isValid()) {
+        m_itemIndex.remove(item);
+        return false;
+    }
+
+    const QDoubleVector2D topLeft = m_map->geoProjection().geoToMapProjection(box.topLeft());
+    QDoubleVector2D bottomRight = m_map->geoProjection().geoToMapProjection(box.bottomRight());
+    if (bottomRight.x() < topLeft.x()) // crosses the dateline
+        bottomRight.setX(bottomRight.x() + 1.0);
+
+    const QRectF bounds(QPointF(topLeft.x(), topLeft.y()), QPointF(bottomRight.x(), bottomRight.y()));
+    if (!m_itemIndex.contains(item) || m_itemIndex.bounds(item) != bounds)
+        m_itemIndex.insert(item, bounds);
+    return true;
+}
+
 /*!
     \internal
 */
@@ -2152,10 +2315,12 @@ void QDeclarativeGeoMap::fitViewportToMapItemsRefine(bool refine, bool onlyVisib
             bottomRightX = topLeftX + brect.width();
             bottomRightY = topLeftY + brect.height();
         } else {
-            topLeftX = item->position().x();
-            topLeftY = item->position().y();
-            bottomRightX = topLeftX + item->width();
-            bottomRightY = topLeftY + item->height();
+            // Items showing their geometry through a scale and rotation map their bounds
+            QRectF brect = item->mapRectToItem(item->parentItem(), item->boundingRect());
+            topLeftX = brect.left();
+            topLeftY = brect.top();
+            bottomRightX = brect.right();
+            bottomRightY = brect.bottom();
         }
 
         minX = qMin(minX, topLeftX);
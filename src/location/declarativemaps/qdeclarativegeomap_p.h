@@ -55,9 +55,12 @@
 #include <QtLocation/qgeoserviceprovider.h>
 #include <QtLocation/private/qgeocameradata_p.h>
 #include <QtLocation/private/qgeocameracapabilities_p.h>
+#include <QtLocation/private/qgeomapitemindex_p.h>
 #include <QtQuick/QQuickItem>
 #include <QtCore/QList>
 #include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QVariantMap>
 #include <QtGui/QColor>
 #include <QtPositioning/qgeorectangle.h>
 #include <QtLocation/private/qgeomap_p.h>
@@ -101,6 +104,7 @@ class Q_LOCATION_PRIVATE_EXPORT QDeclarativeGeoMap : public QQuickItem
     Q_PROPERTY(bool copyrightsVisible READ copyrightsVisible WRITE setCopyrightsVisible NOTIFY copyrightsVisibleChanged)
     Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
     Q_PROPERTY(bool mapReady READ mapReady NOTIFY mapReadyChanged)
+    Q_PROPERTY(QVariantMap tileCacheStatistics READ tileCacheStatistics NOTIFY tileCacheStatisticsChanged REVISION 11)
     Q_INTERFACES(QQmlParserStatus)
 
 public:
@@ -154,6 +158,8 @@ public:
 
     bool mapReady() const;
 
+    QVariantMap tileCacheStatistics() const;
+
     QQmlListProperty<QDeclarativeGeoMapType> supportedMapTypes();
 
     Q_INVOKABLE void setBearing(qreal bearing, const QGeoCoordinate &coordinate);
@@ -216,6 +222,7 @@ Q_SIGNALS:
     void copyrightsChanged(const QImage &copyrightsImage);
     void copyrightsChanged(const QString &copyrightsHtml);
     void mapReadyChanged(bool ready);
+    Q_REVISION(11) void tileCacheStatisticsChanged();
 
 protected:
     void mousePressEvent(QMouseEvent *event) Q_DECL_OVERRIDE ;
@@ -246,6 +253,7 @@ private Q_SLOTS:
     void onSupportedMapTypesChanged();
     void onCameraCapabilitiesChanged(const QGeoCameraCapabilities &oldCameraCapabilities);
     void onAttachedCopyrightNoticeVisibilityChanged();
+    void onCameraDataChanged(const QGeoCameraData &cameraData);
 
 private:
     void setupMapView(QDeclarativeGeoMapItemView *view);
@@ -256,6 +264,10 @@ private:
     bool isInteractive();
     void attachCopyrightNotice(bool initialVisibility);
     void detachCopyrightNotice(bool currentVisibility);
+    void registerMapItem(QDeclarativeGeoMapItemBase *item);
+    void unregisterMapItem(QDeclarativeGeoMapItemBase *item);
+    void markMapItemBoundsDirty(QDeclarativeGeoMapItemBase *item);
+    bool updateMapItemBounds(QDeclarativeGeoMapItemBase *item);
 
 private:
     QDeclarativeGeoServiceProvider *m_plugin;
@@ -296,8 +308,16 @@ private:
     int m_copyNoticesVisible = 0;
     qreal m_maxChildZ = 0;
 
+    // Items receiving camera changes: those in m_itemIndex only while they are
+    // near the viewport, the others always
+    QGeoMapItemIndex m_itemIndex;
+    QSet<QDeclarativeGeoMapItemBase *> m_itemsToIndex;
+    QSet<QDeclarativeGeoMapItemBase *> m_unindexedItems;
+    QSet<QDeclarativeGeoMapItemBase *> m_itemsNearViewport;
+
 
     friend class QDeclarativeGeoMapItem;
+    friend class QDeclarativeGeoMapItemBase;
     friend class QDeclarativeGeoMapItemView;
     friend class QQuickGeoMapGestureArea;
     friend class QDeclarativeGeoMapCopyrightNotice;
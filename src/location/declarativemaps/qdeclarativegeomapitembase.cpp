@@ -36,14 +36,54 @@
 
 #include "qdeclarativegeomapitembase_p.h"
 #include "qgeocameradata_p.h"
+#include "qgeomapitemgeometry_p.h"
 #include <QtLocation/private/qgeomap_p.h>
 #include <QtQml/QQmlInfo>
 #include <QtQuick/QSGOpacityNode>
 #include <QtQuick/private/qquickmousearea_p.h>
 #include <QtQuick/private/qquickitem_p.h>
+#include <QtCore/QThreadPool>
+#include <QtGui/QTransform>
+#include <QtGui/QMatrix4x4>
+#include <cmath>
 
 QT_BEGIN_NAMESPACE
 
+/*
+    Shows the geometry generated for the reference camera from the current one,
+    by scaling and rotating the item around its top left corner. Kept first in
+    the item's transform list, so that it applies on top of the scale, rotation
+    and transforms set from QML, which remain the user's.
+*/
+class QGeoMapItemReferenceTransform : public QQuickTransform
+{
+public:
+    explicit QGeoMapItemReferenceTransform(QObject *parent)
+        : QQuickTransform(parent), scale_(1.0), rotation_(0.0)
+    {
+    }
+
+    void set(qreal scale, qreal rotation)
+    {
+        if (scale == scale_ && rotation == rotation_)
+            return;
+        scale_ = scale;
+        rotation_ = rotation;
+        update();
+    }
+
+    void applyTo(QMatrix4x4 *matrix) const Q_DECL_OVERRIDE
+    {
+        if (scale_ == 1.0 && rotation_ == 0.0)
+            return;
+        matrix->rotate(rotation_, 0, 0, 1);
+        matrix->scale(scale_, scale_);
+    }
+
+    qreal scale_;
+    qreal rotation_;
+};
+
 QGeoMapViewportChangeEvent::QGeoMapViewportChangeEvent()
     : zoomLevelChanged(false),
       centerChanged(false),
@@ -77,7 +117,9 @@ QGeoMapViewportChangeEvent &QGeoMapViewportChangeEvent::operator=(const QGeoMapV
 }
 
 QDeclarativeGeoMapItemBase::QDeclarativeGeoMapItemBase(QQuickItem *parent)
-:   QQuickItem(parent), map_(0), quickMap_(0), parentGroup_(0)
+:   QQuickItem(parent), map_(0), quickMap_(0), parentGroup_(0),
+    hasGeometryReference_(false), referenceTransform_(0), geometryGeneration_(new QAtomicInt(0)), geometryJobRestart_(false),
+    inViewportChange_(false)
 {
     setFiltersChildMouseEvents(true);
     connect(this, SIGNAL(childrenChanged()),
@@ -94,8 +136,11 @@ QDeclarativeGeoMapItemBase::QDeclarativeGeoMapItemBase(QQuickItem *parent)
 QDeclarativeGeoMapItemBase::~QDeclarativeGeoMapItemBase()
 {
     disconnect(this, SLOT(afterChildrenChanged()));
-    if (quickMap_)
+    cancelGeometryJob();
+    if (quickMap_) {
+        quickMap_->unregisterMapItem(this);
         quickMap_->removeMapItem(this);
+    }
 }
 
 /*!
@@ -130,17 +175,24 @@ void QDeclarativeGeoMapItemBase::setMap(QDeclarativeGeoMap *quickMap, QGeoMap *m
         return;
     if (quickMap && quickMap_)
         return; // don't allow association to more than one map
-    if (quickMap_)
+    if (quickMap_) {
+        quickMap_->unregisterMapItem(this);
         quickMap_->disconnect(this);
+    }
     if (map_)
         map_->disconnect(this);
+    cancelGeometryJob();
+    if (hasGeometryReference_) {
+        hasGeometryReference_ = false;
+        setReferenceTransform(1.0, 0.0);
+    }
 
     quickMap_ = quickMap;
     map_ = map;
 
     if (map_ && quickMap_) {
-        connect(map_, SIGNAL(cameraDataChanged(QGeoCameraData)),
-                this, SLOT(baseCameraDataChanged(QGeoCameraData)));
+        // Camera changes come through the map, which skips items far from the viewport
+        quickMap_->registerMapItem(this);
         connect(quickMap, SIGNAL(heightChanged()), this, SLOT(polishAndUpdate()));
         connect(quickMap, SIGNAL(widthChanged()), this, SLOT(polishAndUpdate()));
         lastSize_ = QSizeF(quickMap_->width(), quickMap_->height());
@@ -174,7 +226,10 @@ void QDeclarativeGeoMapItemBase::baseCameraDataChanged(const QGeoCameraData &cam
     lastSize_ = evt.mapSize;
     lastCameraData_ = cameraData;
 
+    // Repositioning keeps the bounds the map indexes the item with
+    inViewportChange_ = true;
     afterViewportChanged(evt);
+    inViewportChange_ = false;
 }
 
 /*!
@@ -190,11 +245,91 @@ void QDeclarativeGeoMapItemBase::setPositionOnMap(const QGeoCoordinate &coordina
         return;
 
     QDoubleVector2D pos = map_->geoProjection().wrappedMapProjectionToItemPosition(wrappedProjection);
-    QPointF topLeft = pos.toPointF() - offset;
+    // With a geometry reference, offset is in the scaled and rotated item coordinates
+    QPointF topLeft = pos.toPointF();
+    if (referenceTransform_)
+        topLeft -= QTransform().rotate(geometryRotation()).scale(geometryScale(), geometryScale()).map(offset);
+    else
+        topLeft -= offset;
 
     setPosition(topLeft);
 }
 
+/*!
+    \internal
+
+    Records \a camera as the one the item geometry has been generated for.
+    Later camera changes that updateGeometryTransform() accepts are then shown
+    by scaling and rotating the item instead of generating the geometry again.
+    Returns false if the map camera has already moved beyond that.
+*/
+bool QDeclarativeGeoMapItemBase::setGeometryReference(const QGeoCameraData &camera)
+{
+    geometryReference_ = camera;
+    hasGeometryReference_ = true;
+    if (map_ && updateGeometryTransform(map_->cameraData()))
+        return true;
+    setReferenceTransform(1.0, 0.0);
+    return map_ && map_->cameraData() == camera;
+}
+
+/*!
+    \internal
+
+    Sets the scale and rotation that show geometry generated for the reference
+    camera as seen from \a camera. Untilted views within the same integer zoom
+    level only differ by a similarity transform, since geometry is not clipped
+    to the viewport in them; everything else returns false, and the geometry
+    must be generated again. Items whose geometry is clipped to the viewport
+    regardless, like circles around a pole, must not call this.
+*/
+bool QDeclarativeGeoMapItemBase::updateGeometryTransform(const QGeoCameraData &camera)
+{
+    if (!hasGeometryReference_
+            || camera.tilt() != 0.0 || geometryReference_.tilt() != 0.0
+            || std::floor(camera.zoomLevel()) != std::floor(geometryReference_.zoomLevel())) {
+        return false;
+    }
+
+    // A larger bearing turns the map counter-clockwise
+    setReferenceTransform(std::pow(2.0, camera.zoomLevel() - geometryReference_.zoomLevel()),
+                          geometryReference_.bearing() - camera.bearing());
+    return true;
+}
+
+/*!
+    \internal
+
+    Scale of the geometry reference transform, by which stroke widths are
+    divided so that they look the same whatever the zoom level.
+*/
+qreal QDeclarativeGeoMapItemBase::geometryScale() const
+{
+    return referenceTransform_ ? referenceTransform_->scale_ : 1.0;
+}
+
+/*!
+    \internal
+*/
+qreal QDeclarativeGeoMapItemBase::geometryRotation() const
+{
+    return referenceTransform_ ? referenceTransform_->rotation_ : 0.0;
+}
+
+void QDeclarativeGeoMapItemBase::setReferenceTransform(qreal scale, qreal rotation)
+{
+    if (!referenceTransform_) {
+        if (scale == 1.0 && rotation == 0.0)
+            return;
+        referenceTransform_ = new QGeoMapItemReferenceTransform(this);
+    }
+    // Assigning the transform list from QML drops it
+    const QList<QQuickTransform *> &transforms = QQuickItemPrivate::get(this)->transforms;
+    if (transforms.isEmpty() || transforms.first() != referenceTransform_)
+        referenceTransform_->prependToItem(this);
+    referenceTransform_->set(scale, rotation);
+}
+
 static const double opacityRampMin = 1.5;
 static const double opacityRampMax = 2.5;
 /*!
@@ -282,8 +417,87 @@ bool QDeclarativeGeoMapItemBase::isPolishScheduled() const
 
 void QDeclarativeGeoMapItemBase::polishAndUpdate()
 {
+    if (quickMap_ && map_ && !inViewportChange_)
+        quickMap_->markMapItemBoundsDirty(this);
     polish();
     update();
 }
 
+/*!
+    \internal
+
+    Runs \a work on the global thread pool and calls \a done on the GUI thread
+    once it has completed, unless the job has been superseded or cancelled in
+    the meantime. \a work must only touch data it owns or shares read-only,
+    such as a QGeoMapSnapshot copy and fresh geometry objects; \a done swaps
+    the result into the item.
+*/
+void QDeclarativeGeoMapItemBase::startGeometryJob(const std::function<void()> &work,
+                                                  const std::function<void()> &done)
+{
+    const int generation = geometryGeneration_->fetchAndAddOrdered(1) + 1;
+    geometryJobDone_ = done;
+    geometryJobRestart_ = false;
+
+    QGeoMapItemGeometryJob *job = new QGeoMapItemGeometryJob(geometryGeneration_, generation, work);
+    connect(job, &QGeoMapItemGeometryJob::finished,
+            this, &QDeclarativeGeoMapItemBase::geometryJobFinished);
+    QThreadPool::globalInstance()->start(job);
+}
+
+/*!
+    \internal
+
+    Drops the result of the pending geometry job, if any. A job that has not
+    started running yet is skipped altogether.
+*/
+void QDeclarativeGeoMapItemBase::cancelGeometryJob()
+{
+    if (!geometryJobDone_)
+        return;
+    geometryGeneration_->ref();
+    geometryJobDone_ = nullptr;
+    geometryJobRestart_ = false;
+}
+
+bool QDeclarativeGeoMapItemBase::isGeometryJobPending() const
+{
+    return bool(geometryJobDone_);
+}
+
+/*!
+    \internal
+
+    Returns true if a geometry job is pending, in which case the item is
+    polished again once its result has landed. Restarting the job on every
+    camera change instead would never let a result through while the map
+    keeps moving.
+*/
+bool QDeclarativeGeoMapItemBase::deferGeometryUpdate()
+{
+    if (!geometryJobDone_)
+        return false;
+    geometryJobRestart_ = true;
+    return true;
+}
+
+void QDeclarativeGeoMapItemBase::geometryJobFinished(int generation)
+{
+    if (generation != geometryGeneration_->load() || !geometryJobDone_)
+        return;
+
+    const std::function<void()> done = geometryJobDone_;
+    const bool restart = geometryJobRestart_;
+    geometryJobDone_ = nullptr;
+    geometryJobRestart_ = false;
+
+    if (!map_)
+        return;
+    done();
+    if (restart)
+        polishAndUpdate();
+    else
+        update();
+}
+
 QT_END_NAMESPACE
@@ -57,8 +57,14 @@
 #include <QtLocation/private/qlocationglobal_p.h>
 #include <QtLocation/private/qgeomap_p.h>
 
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 
+class QGeoMapItemReferenceTransform;
+
 class Q_LOCATION_PRIVATE_EXPORT QGeoMapViewportChangeEvent
 {
 public:
@@ -108,12 +114,27 @@ protected Q_SLOTS:
     void polishAndUpdate();
 
 protected:
+    enum {
+        AsyncGeometryThreshold = 512 // Paths with at least this many vertices are processed on a worker thread
+    };
+
     float zoomLevelOpacity() const;
     bool childMouseEventFilter(QQuickItem *item, QEvent *event);
     bool isPolishScheduled() const;
 
+    bool setGeometryReference(const QGeoCameraData &camera);
+    bool updateGeometryTransform(const QGeoCameraData &camera);
+    qreal geometryScale() const;
+    qreal geometryRotation() const;
+
+    void startGeometryJob(const std::function<void()> &work, const std::function<void()> &done);
+    void cancelGeometryJob();
+    bool isGeometryJobPending() const;
+    bool deferGeometryUpdate();
+
 private Q_SLOTS:
     void baseCameraDataChanged(const QGeoCameraData &camera);
+    void geometryJobFinished(int generation);
 
 private:
     QGeoMap *map_;
@@ -124,6 +145,18 @@ private:
 
     QDeclarativeGeoMapItemGroup *parentGroup_;
 
+    void setReferenceTransform(qreal scale, qreal rotation);
+
+    QGeoCameraData geometryReference_;
+    bool hasGeometryReference_;
+    QGeoMapItemReferenceTransform *referenceTransform_;
+
+    QSharedPointer<QAtomicInt> geometryGeneration_;
+    std::function<void()> geometryJobDone_;
+    bool geometryJobRestart_;
+
+    bool inViewportChange_;
+
     friend class QDeclarativeGeoMap;
 };
 
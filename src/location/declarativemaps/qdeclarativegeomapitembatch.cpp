@@ -0,0 +1,722 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qdeclarativegeomapitembatch_p.h"
+#include "qdeclarativecirclemapitem_p.h"
+#include "qdeclarativepolygonmapitem_p.h"
+#include "qdeclarativepolylinemapitem_p.h"
+#include "locationvaluetypehelper_p.h"
+
+#include <QtLocation/private/qgeomap_p.h>
+#include <QtLocation/private/qgeoprojection_p.h>
+#include <QtPositioning/QGeoCircle>
+#include <QtPositioning/QGeoPath>
+#include <QtGui/QPolygonF>
+#include <QtQml/QQmlInfo>
+#include <QtQuick/QSGGeometryNode>
+#include <QtQuick/QSGVertexColorMaterial>
+
+QT_BEGIN_NAMESPACE
+
+static const int BatchCircleSamples = 64;
+
+/*!
+    \qmltype MapItemBatch
+    \instantiates QDeclarativeGeoMapItemBatch
+    \inqmlmodule QtLocation
+    \ingroup qml-QtLocation5-maps
+    \since Qt Location 5.11
+
+    \brief The MapItemBatch type displays many simple items on a Map at once.
+
+    The MapItemBatch type holds circles, rectangles and polylines as plain
+    data instead of one QML object per item. All of them are drawn with a
+    handful of scene graph nodes, and a camera change updates all of them in a
+    single pass. Use it for thousands of simple shapes, such as vehicle
+    positions or trip segments, where individual \l MapCircle or
+    \l MapPolyline items become too expensive.
+
+    Items are added with \l addCircle, \l addRectangle and \l addPolyline,
+    which return an identifier used to modify or remove the item later.
+    Changing the color of an item only rewrites its own vertices.
+
+    \l itemAt returns the identifier of the topmost item at a position, so
+    that a MouseArea inside the batch can find the item that was clicked.
+
+    \section2 Example Usage
+
+    \code
+    MapItemBatch {
+        id: vehicles
+        MouseArea {
+            anchors.fill: parent
+            onClicked: console.log("clicked vehicle", vehicles.itemAt(Qt.point(mouse.x, mouse.y)))
+        }
+    }
+
+    Component.onCompleted: {
+        for (var i = 0; i < positions.length; ++i)
+            vehicles.addCircle(positions[i], 50, "#8000a000")
+        map.addMapItem(vehicles)
+    }
+    \endcode
+
+    Batched items have no border, and circles crossing a pole are not
+    supported.
+*/
+
+class MapItemBatchNode : public QSGGeometryNode
+{
+public:
+    MapItemBatchNode()
+    {
+        setFlag(OwnsGeometry);
+        setGeometry(new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0, 0,
+                                    QSGGeometry::UnsignedShortType));
+        geometry()->setDrawingMode(QSGGeometry::DrawTriangles);
+        setMaterial(&material_);
+    }
+
+    void allocate(int vertexCount, int indexCount)
+    {
+        const int indexType = vertexCount > QDeclarativeGeoMapItemBatch::MaxBatchVertices
+                ? QSGGeometry::UnsignedIntType : QSGGeometry::UnsignedShortType;
+        if (geometry()->indexType() != indexType) {
+            setGeometry(new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0, 0, indexType));
+            geometry()->setDrawingMode(QSGGeometry::DrawTriangles);
+        }
+        geometry()->allocate(vertexCount, indexCount);
+    }
+
+    void write(const QVector<QPointF> &vertices, const QVector<quint32> &indices,
+               const QColor &color, int vertexOffset, int indexOffset)
+    {
+        // QSGVertexColorMaterial expects premultiplied colors
+        const qreal alpha = color.alphaF();
+        const uchar r = uchar(qRound(color.red() * alpha));
+        const uchar g = uchar(qRound(color.green() * alpha));
+        const uchar b = uchar(qRound(color.blue() * alpha));
+        const uchar a = uchar(color.alpha());
+
+        QSGGeometry::ColoredPoint2D *vs = geometry()->vertexDataAsColoredPoint2D() + vertexOffset;
+        for (int i = 0; i < vertices.size(); ++i)
+            vs[i].set(vertices.at(i).x(), vertices.at(i).y(), r, g, b, a);
+
+        if (geometry()->indexType() == QSGGeometry::UnsignedIntType) {
+            quint32 *is = geometry()->indexDataAsUInt() + indexOffset;
+            for (int i = 0; i < indices.size(); ++i)
+                is[i] = quint32(vertexOffset) + indices.at(i);
+        } else {
+            quint16 *is = geometry()->indexDataAsUShort() + indexOffset;
+            for (int i = 0; i < indices.size(); ++i)
+                is[i] = quint16(vertexOffset + indices.at(i));
+        }
+    }
+
+private:
+    QSGVertexColorMaterial material_;
+};
+
+static bool triangleContains(const QPointF &a, const QPointF &b, const QPointF &c, const QPointF &p)
+{
+    const qreal d1 = (p.x() - b.x()) * (a.y() - b.y()) - (a.x() - b.x()) * (p.y() - b.y());
+    const qreal d2 = (p.x() - c.x()) * (b.y() - c.y()) - (b.x() - c.x()) * (p.y() - c.y());
+    const qreal d3 = (p.x() - a.x()) * (c.y() - a.y()) - (c.x() - a.x()) * (p.y() - a.y());
+    const bool hasNegative = d1 < 0 || d2 < 0 || d3 < 0;
+    const bool hasPositive = d1 > 0 || d2 > 0 || d3 > 0;
+    return !(hasNegative && hasPositive);
+}
+
+QDeclarativeGeoMapItemBatch::QDeclarativeGeoMapItemBatch(QQuickItem *parent)
+:   QDeclarativeGeoMapItemBase(parent), geoshapeDirty_(false), layoutDirty_(true)
+{
+    setFlag(ItemHasContents, true);
+}
+
+QDeclarativeGeoMapItemBatch::~QDeclarativeGeoMapItemBatch()
+{
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemBatch::setMap(QDeclarativeGeoMap *quickMap, QGeoMap *map)
+{
+    QDeclarativeGeoMapItemBase::setMap(quickMap, map);
+    if (!map)
+        return;
+    for (Entry &entry : entries_) {
+        if (entry.shape != NoShape) {
+            updateProjection(entry);
+            entry.geometryDirty = true;
+        }
+    }
+    polishAndUpdate();
+}
+
+/*!
+    \qmlproperty int MapItemBatch::count
+
+    This property holds the number of items in the batch.
+*/
+int QDeclarativeGeoMapItemBatch::count() const
+{
+    return entries_.size() - freeEntries_.size();
+}
+
+/*!
+    \qmlmethod int MapItemBatch::addCircle(coordinate center, real radius, color color)
+
+    Adds a circle of \a radius meters around \a center, filled with \a color,
+    and returns its identifier.
+*/
+int QDeclarativeGeoMapItemBatch::addCircle(const QGeoCoordinate &center, qreal radius, const QColor &color)
+{
+    Entry entry;
+    entry.shape = CircleShape;
+    entry.coordinates << center;
+    entry.radius = radius;
+    entry.color = color;
+    entry.geoBounds = QGeoCircle(center, radius).boundingGeoRectangle();
+    return insertEntry(entry);
+}
+
+/*!
+    \qmlmethod int MapItemBatch::addRectangle(coordinate topLeft, coordinate bottomRight, color color)
+
+    Adds a rectangle spanning from \a topLeft to \a bottomRight, filled with
+    \a color, and returns its identifier.
+*/
+int QDeclarativeGeoMapItemBatch::addRectangle(const QGeoCoordinate &topLeft, const QGeoCoordinate &bottomRight,
+                                              const QColor &color)
+{
+    Entry entry;
+    entry.shape = RectangleShape;
+    entry.coordinates << topLeft << bottomRight;
+    entry.color = color;
+    entry.geoBounds = QGeoRectangle(topLeft, bottomRight);
+    return insertEntry(entry);
+}
+
+/*!
+    \qmlmethod int MapItemBatch::addPolyline(list<coordinate> path, real width, color color)
+
+    Adds a polyline along \a path, \a width pixels wide and drawn with
+    \a color, and returns its identifier. Returns -1 if \a path is not a list
+    of valid coordinates.
+*/
+int QDeclarativeGeoMapItemBatch::addPolyline(const QJSValue &path, qreal width, const QColor &color)
+{
+    bool ok;
+    const QList<QGeoCoordinate> coordinates = parsePath(path, &ok);
+    if (!ok) {
+        qmlWarning(this) << "Unsupported path type";
+        return -1;
+    }
+    return addPolyline(coordinates, width, color);
+}
+
+int QDeclarativeGeoMapItemBatch::addPolyline(const QList<QGeoCoordinate> &path, qreal width, const QColor &color)
+{
+    Entry entry;
+    entry.shape = PolylineShape;
+    entry.coordinates = path;
+    entry.width = width;
+    entry.color = color;
+    entry.geoBounds = QGeoPath(path).boundingGeoRectangle();
+    return insertEntry(entry);
+}
+
+/*!
+    \qmlmethod void MapItemBatch::setCircle(int id, coordinate center, real radius)
+
+    Moves the circle \a id to \a center and sets its \a radius.
+*/
+void QDeclarativeGeoMapItemBatch::setCircle(int id, const QGeoCoordinate &center, qreal radius)
+{
+    Entry *circle = entry(id);
+    if (!circle || circle->shape != CircleShape)
+        return;
+    circle->coordinates.clear();
+    circle->coordinates << center;
+    circle->radius = radius;
+    circle->geoBounds = QGeoCircle(center, radius).boundingGeoRectangle();
+    markEntryDirty(*circle);
+}
+
+/*!
+    \qmlmethod void MapItemBatch::setRectangle(int id, coordinate topLeft, coordinate bottomRight)
+
+    Sets the corners of the rectangle \a id to \a topLeft and \a bottomRight.
+*/
+void QDeclarativeGeoMapItemBatch::setRectangle(int id, const QGeoCoordinate &topLeft,
+                                               const QGeoCoordinate &bottomRight)
+{
+    Entry *rectangle = entry(id);
+    if (!rectangle || rectangle->shape != RectangleShape)
+        return;
+    rectangle->coordinates.clear();
+    rectangle->coordinates << topLeft << bottomRight;
+    rectangle->geoBounds = QGeoRectangle(topLeft, bottomRight);
+    markEntryDirty(*rectangle);
+}
+
+/*!
+    \qmlmethod void MapItemBatch::setPath(int id, list<coordinate> path)
+
+    Replaces the path of the polyline \a id with \a path.
+*/
+void QDeclarativeGeoMapItemBatch::setPath(int id, const QJSValue &path)
+{
+    bool ok;
+    const QList<QGeoCoordinate> coordinates = parsePath(path, &ok);
+    if (!ok) {
+        qmlWarning(this) << "Unsupported path type";
+        return;
+    }
+    setPath(id, coordinates);
+}
+
+void QDeclarativeGeoMapItemBatch::setPath(int id, const QList<QGeoCoordinate> &path)
+{
+    Entry *polyline = entry(id);
+    if (!polyline || polyline->shape != PolylineShape)
+        return;
+    polyline->coordinates = path;
+    polyline->geoBounds = QGeoPath(path).boundingGeoRectangle();
+    markEntryDirty(*polyline);
+}
+
+/*!
+    \qmlmethod void MapItemBatch::setColor(int id, color color)
+
+    Sets the color of the item \a id. Only the vertices of that item are
+    written again.
+*/
+void QDeclarativeGeoMapItemBatch::setColor(int id, const QColor &color)
+{
+    Entry *item = entry(id);
+    if (!item || item->color == color)
+        return;
+    item->color = color;
+    item->uploadDirty = true;
+    if (item->batch >= 0)
+        batches_[item->batch].dirty = true;
+    update();
+}
+
+/*!
+    \qmlmethod void MapItemBatch::removeItem(int id)
+
+    Removes the item \a id from the batch. Its identifier may be reused by
+    items added later.
+*/
+void QDeclarativeGeoMapItemBatch::removeItem(int id)
+{
+    Entry *item = entry(id);
+    if (!item)
+        return;
+    if (!item->vertices.isEmpty())
+        layoutDirty_ = true;
+    *item = Entry();
+    freeEntries_.append(id);
+    geoshapeDirty_ = true;
+    polishAndUpdate();
+    emit countChanged();
+}
+
+/*!
+    \qmlmethod void MapItemBatch::clear()
+
+    Removes all items from the batch.
+*/
+void QDeclarativeGeoMapItemBatch::clear()
+{
+    if (entries_.isEmpty())
+        return;
+    entries_.clear();
+    freeEntries_.clear();
+    layoutDirty_ = true;
+    geoshapeDirty_ = true;
+    polishAndUpdate();
+    emit countChanged();
+}
+
+/*!
+    \qmlmethod int MapItemBatch::itemAt(point position)
+
+    Returns the identifier of the topmost item drawn at \a position, in the
+    coordinates of the batch, or -1 if there is none.
+*/
+int QDeclarativeGeoMapItemBatch::itemAt(const QPointF &position) const
+{
+    for (int id = entries_.size() - 1; id >= 0; --id) {
+        const Entry &entry = entries_.at(id);
+        if (entry.shape == NoShape || !entry.bounds.contains(position))
+            continue;
+        for (int i = 0; i + 2 < entry.indices.size(); i += 3) {
+            if (triangleContains(entry.vertices.at(entry.indices.at(i)),
+                                 entry.vertices.at(entry.indices.at(i + 1)),
+                                 entry.vertices.at(entry.indices.at(i + 2)),
+                                 position)) {
+                return id;
+            }
+        }
+    }
+    return -1;
+}
+
+/*!
+    \internal
+    Returns the number of scene graph nodes the items are drawn with.
+*/
+int QDeclarativeGeoMapItemBatch::nodeCount() const
+{
+    return batches_.size();
+}
+
+bool QDeclarativeGeoMapItemBatch::contains(const QPointF &point) const
+{
+    return itemAt(point) >= 0;
+}
+
+const QGeoShape &QDeclarativeGeoMapItemBatch::geoShape() const
+{
+    if (geoshapeDirty_) {
+        geoshape_ = QGeoRectangle();
+        for (const Entry &entry : entries_) {
+            if (entry.shape == NoShape || !entry.geoBounds.isValid())
+                continue;
+            geoshape_ = geoshape_.isValid() ? geoshape_.united(entry.geoBounds) : entry.geoBounds;
+        }
+        geoshapeDirty_ = false;
+    }
+    return geoshape_;
+}
+
+QGeoMap::ItemType QDeclarativeGeoMapItemBatch::itemType() const
+{
+    return QGeoMap::NoItem;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemBatch::afterViewportChanged(const QGeoMapViewportChangeEvent &event)
+{
+    if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
+        return;
+
+    for (Entry &entry : entries_)
+        entry.geometryDirty = true;
+    polishAndUpdate();
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemBatch::updatePolish()
+{
+    if (!map() || !quickMap())
+        return;
+
+    // The batch covers the map, so that vertices are in map item coordinates
+    setPosition(QPointF(0, 0));
+    setSize(QSizeF(quickMap()->width(), quickMap()->height()));
+
+    for (Entry &entry : entries_) {
+        if (entry.shape == NoShape || !entry.geometryDirty)
+            continue;
+
+        const int vertexCount = entry.vertices.size();
+        const int indexCount = entry.indices.size();
+        updateGeometry(entry);
+        entry.geometryDirty = false;
+        entry.uploadDirty = true;
+
+        if (entry.vertices.size() != vertexCount || entry.indices.size() != indexCount)
+            layoutDirty_ = true;
+        else if (entry.batch >= 0)
+            batches_[entry.batch].dirty = true;
+    }
+
+    if (layoutDirty_)
+        updateLayout();
+}
+
+/*!
+    \internal
+*/
+QSGNode *QDeclarativeGeoMapItemBatch::updateMapItemPaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data);
+
+    QSGNode *root = oldNode;
+    if (!root)
+        root = new QSGNode();
+
+    while (root->childCount() > batches_.size()) {
+        QSGNode *node = root->lastChild();
+        root->removeChildNode(node);
+        delete node;
+    }
+    while (root->childCount() < batches_.size())
+        root->appendChildNode(new MapItemBatchNode());
+
+    QSGNode *child = root->firstChild();
+    for (int i = 0; i < batches_.size(); ++i, child = child->nextSibling()) {
+        MapItemBatchNode *node = static_cast<MapItemBatchNode *>(child);
+        Batch &batch = batches_[i];
+        if (!oldNode)
+            batch.reallocate = true;
+        if (!batch.reallocate && !batch.dirty)
+            continue;
+
+        if (batch.reallocate)
+            node->allocate(batch.vertexCount, batch.indexCount);
+
+        // Unless the layout changed, only the items that changed are written again
+        for (int e = batch.firstEntry; e < batch.endEntry; ++e) {
+            Entry &entry = entries_[e];
+            if (entry.batch != i || (!batch.reallocate && !entry.uploadDirty))
+                continue;
+            node->write(entry.vertices, entry.indices, entry.color,
+                        entry.vertexOffset, entry.indexOffset);
+            entry.uploadDirty = false;
+        }
+        node->markDirty(QSGNode::DirtyGeometry);
+
+        batch.reallocate = false;
+        batch.dirty = false;
+    }
+
+    return root;
+}
+
+int QDeclarativeGeoMapItemBatch::insertEntry(const Entry &entry)
+{
+    int id;
+    if (freeEntries_.isEmpty()) {
+        id = entries_.size();
+        entries_.append(entry);
+    } else {
+        id = freeEntries_.takeLast();
+        entries_[id] = entry;
+    }
+
+    if (map())
+        updateProjection(entries_[id]);
+    if (geoshape_.isValid() && !geoshapeDirty_)
+        geoshape_ = geoshape_.united(entry.geoBounds);
+    else
+        geoshapeDirty_ = true;
+
+    polishAndUpdate();
+    emit countChanged();
+    return id;
+}
+
+QDeclarativeGeoMapItemBatch::Entry *QDeclarativeGeoMapItemBatch::entry(int id)
+{
+    if (id < 0 || id >= entries_.size() || entries_.at(id).shape == NoShape)
+        return 0;
+    return &entries_[id];
+}
+
+void QDeclarativeGeoMapItemBatch::markEntryDirty(Entry &entry)
+{
+    geoshapeDirty_ = true;
+    if (map())
+        updateProjection(entry);
+    entry.geometryDirty = true;
+    polishAndUpdate();
+}
+
+void QDeclarativeGeoMapItemBatch::updateProjection(Entry &entry)
+{
+    const QGeoProjection &projection = map()->geoProjection();
+    entry.projected.clear();
+
+    switch (entry.shape) {
+    case CircleShape: {
+        QList<QGeoCoordinate> path;
+        QDeclarativeCircleMapItem::calculatePeripheralPoints(path, entry.coordinates.first(), entry.radius,
+                                                             BatchCircleSamples, entry.leftBound);
+        for (const QGeoCoordinate &c : path)
+            entry.projected << projection.geoToMapProjection(c);
+        break;
+    }
+    case RectangleShape: {
+        const QGeoCoordinate &topLeft = entry.coordinates.at(0);
+        const QGeoCoordinate &bottomRight = entry.coordinates.at(1);
+        entry.projected << projection.geoToMapProjection(topLeft)
+                        << projection.geoToMapProjection(QGeoCoordinate(topLeft.latitude(), bottomRight.longitude()))
+                        << projection.geoToMapProjection(bottomRight)
+                        << projection.geoToMapProjection(QGeoCoordinate(bottomRight.latitude(), topLeft.longitude()));
+        entry.leftBound = topLeft;
+        break;
+    }
+    case PolylineShape:
+        for (const QGeoCoordinate &c : entry.coordinates)
+            entry.projected << projection.geoToMapProjection(c);
+        entry.leftBound = entry.geoBounds.topLeft();
+        break;
+    case NoShape:
+        break;
+    }
+}
+
+/*
+    Runs the same projection, clipping and tessellation as the individual map
+    items, then moves the result from the item's own origin into the
+    coordinates of the batch.
+*/
+void QDeclarativeGeoMapItemBatch::updateGeometry(Entry &entry)
+{
+    entry.vertices.clear();
+    entry.indices.clear();
+    entry.bounds = QRectF();
+
+    if (entry.projected.size() < 2)
+        return;
+
+    const QGeoProjection &projection = map()->geoProjection();
+
+    if (entry.shape == PolylineShape) {
+        QGeoMapPolylineGeometry geometry;
+        geometry.setPreserveGeometry(true, entry.leftBound);
+        geometry.updateSourcePoints(*map(), entry.projected, entry.leftBound);
+        geometry.updateScreenPoints(*map(), entry.width);
+        const QVector<QPointF> strip = geometry.vertices();
+        const QDoubleVector2D origin = projection.geoToWrappedMapProjection(geometry.origin());
+        if (strip.size() < 3 || !projection.isProjectable(origin))
+            return;
+
+        const QPointF offset = projection.wrappedMapProjectionToItemPosition(origin).toPointF()
+                + geometry.sourceBoundingBox().topLeft();
+        entry.vertices.reserve(strip.size());
+        for (const QPointF &p : strip)
+            entry.vertices << p + offset;
+        // The stroker produces a triangle strip
+        entry.indices.reserve((strip.size() - 2) * 3);
+        for (int i = 2; i < strip.size(); ++i)
+            entry.indices << quint32(i - 2) << quint32(i - 1) << quint32(i);
+    } else {
+        QGeoMapPolygonGeometry geometry;
+        geometry.setPreserveGeometry(true, entry.leftBound);
+        geometry.updateSourcePoints(*map(), entry.projected);
+        geometry.updateScreenPoints(*map());
+        const QDoubleVector2D origin = projection.geoToWrappedMapProjection(geometry.origin());
+        if (!geometry.isIndexed() || !projection.isProjectable(origin))
+            return;
+
+        const QPointF offset = projection.wrappedMapProjectionToItemPosition(origin).toPointF()
+                - geometry.firstPointOffset();
+        const QVector<QPointF> vertices = geometry.vertices();
+        entry.vertices.reserve(vertices.size());
+        for (const QPointF &p : vertices)
+            entry.vertices << p + offset;
+        entry.indices = geometry.indices();
+    }
+
+    for (const QPointF &p : qAsConst(entry.vertices)) {
+        if (!qIsFinite(p.x()) || !qIsFinite(p.y())) {
+            entry.vertices.clear();
+            entry.indices.clear();
+            return;
+        }
+    }
+    entry.bounds = QPolygonF(entry.vertices).boundingRect();
+}
+
+/*
+    Packs the entries into batches of at most MaxBatchVertices vertices, in
+    entry order so that later items are drawn on top. An entry larger than
+    that gets a batch of its own with 32 bit indices.
+*/
+void QDeclarativeGeoMapItemBatch::updateLayout()
+{
+    batches_.clear();
+
+    Batch current;
+    for (int i = 0; i < entries_.size(); ++i) {
+        Entry &entry = entries_[i];
+        entry.batch = -1;
+        if (entry.shape == NoShape || entry.vertices.isEmpty())
+            continue;
+
+        if (current.vertexCount > 0 && current.vertexCount + entry.vertices.size() > MaxBatchVertices) {
+            current.endEntry = i;
+            batches_.append(current);
+            current = Batch();
+            current.firstEntry = i;
+        }
+
+        entry.batch = batches_.size();
+        entry.vertexOffset = current.vertexCount;
+        entry.indexOffset = current.indexCount;
+        entry.uploadDirty = true;
+        current.vertexCount += entry.vertices.size();
+        current.indexCount += entry.indices.size();
+    }
+    if (current.vertexCount > 0) {
+        current.endEntry = entries_.size();
+        batches_.append(current);
+    }
+
+    layoutDirty_ = false;
+}
+
+QList<QGeoCoordinate> QDeclarativeGeoMapItemBatch::parsePath(const QJSValue &value, bool *ok)
+{
+    QList<QGeoCoordinate> path;
+    *ok = value.isArray();
+    if (!*ok)
+        return path;
+
+    const quint32 length = value.property(QStringLiteral("length")).toUInt();
+    for (quint32 i = 0; i < length; ++i) {
+        const QGeoCoordinate c = parseCoordinate(value.property(i), ok);
+        if (!*ok || !c.isValid()) {
+            *ok = false;
+            return QList<QGeoCoordinate>();
+        }
+        path.append(c);
+    }
+    return path;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,187 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QDECLARATIVEGEOMAPITEMBATCH_P_H
+#define QDECLARATIVEGEOMAPITEMBATCH_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/private/qlocationglobal_p.h>
+#include <QtLocation/private/qdeclarativegeomapitembase_p.h>
+
+#include <QtPositioning/QGeoRectangle>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+#include <QtGui/QColor>
+#include <QtQml/QJSValue>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+class Q_LOCATION_PRIVATE_EXPORT QDeclarativeGeoMapItemBatch : public QDeclarativeGeoMapItemBase
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum {
+        MaxBatchVertices = 65535 // Vertices per node addressable with 16 bit indices
+    };
+
+    explicit QDeclarativeGeoMapItemBatch(QQuickItem *parent = 0);
+    ~QDeclarativeGeoMapItemBatch();
+
+    virtual void setMap(QDeclarativeGeoMap *quickMap, QGeoMap *map) Q_DECL_OVERRIDE;
+    virtual QSGNode *updateMapItemPaintNode(QSGNode *, UpdatePaintNodeData *) Q_DECL_OVERRIDE;
+
+    int count() const;
+
+    Q_INVOKABLE int addCircle(const QGeoCoordinate &center, qreal radius, const QColor &color);
+    Q_INVOKABLE int addRectangle(const QGeoCoordinate &topLeft, const QGeoCoordinate &bottomRight,
+                                 const QColor &color);
+    Q_INVOKABLE int addPolyline(const QJSValue &path, qreal width, const QColor &color);
+    int addPolyline(const QList<QGeoCoordinate> &path, qreal width, const QColor &color);
+
+    Q_INVOKABLE void setCircle(int id, const QGeoCoordinate &center, qreal radius);
+    Q_INVOKABLE void setRectangle(int id, const QGeoCoordinate &topLeft, const QGeoCoordinate &bottomRight);
+    Q_INVOKABLE void setPath(int id, const QJSValue &path);
+    void setPath(int id, const QList<QGeoCoordinate> &path);
+    Q_INVOKABLE void setColor(int id, const QColor &color);
+
+    Q_INVOKABLE void removeItem(int id);
+    Q_INVOKABLE void clear();
+
+    Q_INVOKABLE int itemAt(const QPointF &position) const;
+
+    int nodeCount() const;
+
+    bool contains(const QPointF &point) const Q_DECL_OVERRIDE;
+    const QGeoShape &geoShape() const Q_DECL_OVERRIDE;
+    QGeoMap::ItemType itemType() const Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void countChanged();
+
+protected:
+    void updatePolish() Q_DECL_OVERRIDE;
+
+protected Q_SLOTS:
+    virtual void afterViewportChanged(const QGeoMapViewportChangeEvent &event) Q_DECL_OVERRIDE;
+
+private:
+    enum Shape {
+        NoShape,
+        CircleShape,
+        RectangleShape,
+        PolylineShape
+    };
+
+    // One batched item, kept as plain data. Its screen geometry is an
+    // indexed triangle list in the coordinates of the batch.
+    class Entry
+    {
+    public:
+        Entry()
+            : shape(NoShape), radius(0), width(0),
+              batch(-1), vertexOffset(0), indexOffset(0),
+              geometryDirty(true), uploadDirty(true) {}
+
+        Shape shape;
+        QList<QGeoCoordinate> coordinates;
+        qreal radius;
+        qreal width;
+        QColor color;
+        QGeoCoordinate leftBound;
+        QGeoRectangle geoBounds;
+        QList<QDoubleVector2D> projected;
+
+        QVector<QPointF> vertices;
+        QVector<quint32> indices;
+        QRectF bounds;
+
+        int batch;
+        int vertexOffset;
+        int indexOffset;
+        bool geometryDirty;
+        bool uploadDirty;
+    };
+
+    // A contiguous range of entries sharing one vertex and one index buffer.
+    class Batch
+    {
+    public:
+        Batch()
+            : firstEntry(0), endEntry(0), vertexCount(0), indexCount(0),
+              reallocate(true), dirty(true) {}
+
+        int firstEntry;
+        int endEntry;
+        int vertexCount;
+        int indexCount;
+        bool reallocate;
+        bool dirty;
+    };
+
+    int insertEntry(const Entry &entry);
+    Entry *entry(int id);
+    void markEntryDirty(Entry &entry);
+    void updateProjection(Entry &entry);
+    void updateGeometry(Entry &entry);
+    void updateLayout();
+    static QList<QGeoCoordinate> parsePath(const QJSValue &value, bool *ok);
+
+    QVector<Entry> entries_;
+    QVector<int> freeEntries_;
+    QVector<Batch> batches_;
+    mutable QGeoRectangle geoshape_;
+    mutable bool geoshapeDirty_;
+    bool layoutDirty_;
+};
+
+QT_END_NAMESPACE
+
+QML_DECLARE_TYPE(QDeclarativeGeoMapItemBatch)
+
+#endif // QDECLARATIVEGEOMAPITEMBATCH_P_H
@@ -104,9 +104,12 @@ QT_BEGIN_NAMESPACE
     MapPolygons have a rendering cost that is O(n) with respect to the number
     of vertices. This means that the per frame cost of having a Polygon on the
     Map grows in direct proportion to the number of points on the Polygon. There
-    is an additional triangulation cost (approximately O(n log n)) which is
-    currently paid with each frame, but in future may be paid only upon adding
-    or removing points.
+    is an additional triangulation cost (approximately O(n log n)), which is
+    paid when the map changes zoom level or is tilted. Panning, rotating and
+    zooming the map within the same integer zoom level reuse the triangulation;
+    only a border is stroked again when the zoom changes. For polygons of
+    several hundred vertices or more the triangulation happens on a worker
+    thread, so the polygon may lag a frame or two behind the map while it moves.
 
     Like the other map objects, MapPolygon is normally drawn without a smooth
     appearance. Setting the \l {Item::opacity}{opacity} property will force the object to
@@ -142,7 +145,7 @@ QGeoMapPolygonGeometry::QGeoMapPolygonGeometry()
 /*!
     \internal
 */
-void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
+void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMapSnapshot &map,
                                                 const QList<QDoubleVector2D> &path)
 {
     if (!sourceDirty_)
@@ -246,7 +249,7 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
 /*!
     \internal
 */
-void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMap &map)
+void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMapSnapshot &map)
 {
     if (!screenDirty_)
         return;
@@ -531,38 +534,130 @@ void QDeclarativePolygonMapItem::updatePolish()
     QScopedValueRollback<bool> rollback(updatingGeometry_);
     updatingGeometry_ = true;
 
-    geometry_.updateSourcePoints(*map(), geopathProjected_);
-    geometry_.updateScreenPoints(*map());
+    const qreal borderWidth = (border_.color() != Qt::transparent && border_.width() > 0) ? border_.width() : 0;
+
+    // The camera only moved as far as scaling and rotating the item can show
+    if (!geometry_.isSourceDirty() && !borderGeometry_.isSourceDirty()) {
+        updateBorderStroke(borderWidth);
+        updateItemGeometry(QRectF(0, 0, width(), height()));
+        return;
+    }
+
+    // Long paths are processed at the resolution the current zoom level can show
+    const QList<QDoubleVector2D> &path = geopathSimplified_.path(geopathProjected_, map()->cameraData().zoomLevel(), true);
+    const QGeoCoordinate borderLeftBound = geopath_.boundingGeoRectangle().topLeft();
+
+    // and, when that is still long, on a worker thread
+    if (path.size() >= AsyncGeometryThreshold) {
+        if (deferGeometryUpdate())
+            return;
+        const QGeoMapSnapshot snapshot = QGeoMapSnapshot::copy(*map());
+        if (snapshot.isCopy()) {
+            QSharedPointer<QGeoMapPolygonGeometry> geometry(new QGeoMapPolygonGeometry(geometry_));
+            QSharedPointer<QGeoMapPolylineGeometry> borderGeometry(new QGeoMapPolylineGeometry(borderGeometry_));
+            QSharedPointer<QRectF> combined(new QRectF);
+            const QList<QDoubleVector2D> source = path;
+            const QGeoCameraData camera = snapshot.cameraData();
+            startGeometryJob([snapshot, geometry, borderGeometry, combined, source, borderLeftBound, borderWidth]() {
+                *combined = updateGeometries(snapshot, source, borderLeftBound, borderWidth,
+                                             *geometry, *borderGeometry);
+            }, [this, geometry, borderGeometry, combined, camera, borderWidth]() {
+                QScopedValueRollback<bool> rollback(updatingGeometry_);
+                updatingGeometry_ = true;
+                // The item may have been marked dirty again while the job ran
+                const bool outdated = geometry_.sourceRevision() != geometry->sourceRevision()
+                        || borderGeometry_.sourceRevision() != borderGeometry->sourceRevision();
+                geometry_ = *geometry;
+                borderGeometry_ = *borderGeometry;
+                if (!setGeometryReference(camera) || outdated) {
+                    geometry_.markSourceDirty();
+                    borderGeometry_.markSourceDirty();
+                    polishAndUpdate();
+                }
+                updateBorderStroke(borderWidth);
+                updateItemGeometry(*combined);
+            });
+            return;
+        }
+    }
+
+    cancelGeometryJob();
+    setGeometryReference(map()->cameraData());
+    updateItemGeometry(updateGeometries(*map(), path, borderLeftBound, borderWidth, geometry_, borderGeometry_));
+}
+
+/*!
+    \internal
+
+    Generates the fill \a geometry and, for a positive \a borderWidth, the
+    \a borderGeometry of \a path, and returns their combined bounds. Only
+    touches its arguments, so that it can run on a worker thread.
+*/
+QRectF QDeclarativePolygonMapItem::updateGeometries(const QGeoMapSnapshot &map,
+                                                    const QList<QDoubleVector2D> &path,
+                                                    const QGeoCoordinate &borderLeftBound,
+                                                    qreal borderWidth,
+                                                    QGeoMapPolygonGeometry &geometry,
+                                                    QGeoMapPolylineGeometry &borderGeometry)
+{
+    geometry.updateSourcePoints(map, path);
+    geometry.updateScreenPoints(map);
 
     QList<QGeoMapItemGeometry *> geoms;
-    geoms << &geometry_;
-    borderGeometry_.clear();
+    geoms << &geometry;
+    borderGeometry.clear();
 
-    if (border_.color() != Qt::transparent && border_.width() > 0) {
-        QList<QDoubleVector2D> closedPath = geopathProjected_;
+    if (borderWidth > 0) {
+        QList<QDoubleVector2D> closedPath = path;
         closedPath << closedPath.first();
 
-        borderGeometry_.setPreserveGeometry(true, geopath_.boundingGeoRectangle().topLeft());
+        borderGeometry.setPreserveGeometry(true, borderLeftBound);
 
-        const QGeoCoordinate &geometryOrigin = geometry_.origin();
+        const QGeoCoordinate &geometryOrigin = geometry.origin();
 
-        borderGeometry_.srcPoints_.clear();
-        borderGeometry_.srcPointTypes_.clear();
+        borderGeometry.srcPoints_.clear();
+        borderGeometry.srcPointTypes_.clear();
 
         QDoubleVector2D borderLeftBoundWrapped;
-        QList<QList<QDoubleVector2D > > clippedPaths = borderGeometry_.clipPath(*map(), closedPath, borderLeftBoundWrapped);
+        QList<QList<QDoubleVector2D > > clippedPaths = borderGeometry.clipPath(map, closedPath, borderLeftBoundWrapped);
         if (clippedPaths.size()) {
-            borderLeftBoundWrapped = map()->geoProjection().geoToWrappedMapProjection(geometryOrigin);
-            borderGeometry_.pathToScreen(*map(), clippedPaths, borderLeftBoundWrapped);
-            borderGeometry_.updateScreenPoints(*map(), border_.width());
+            borderLeftBoundWrapped = map.geoProjection().geoToWrappedMapProjection(geometryOrigin);
+            borderGeometry.pathToScreen(map, clippedPaths, borderLeftBoundWrapped);
+            borderGeometry.updateScreenPoints(map, borderWidth);
 
-            geoms << &borderGeometry_;
+            geoms << &borderGeometry;
         } else {
-            borderGeometry_.clear();
+            borderGeometry.clear();
         }
     }
 
-    QRectF combined = QGeoMapItemGeometry::translateToCommonOrigin(geoms);
+    return QGeoMapItemGeometry::translateToCommonOrigin(geoms);
+}
+
+/*!
+    \internal
+
+    Strokes the border again if scaling the item would change its width.
+*/
+void QDeclarativePolygonMapItem::updateBorderStroke(qreal borderWidth)
+{
+    const qreal strokeWidth = borderWidth / geometryScale();
+    if (borderGeometry_.size() == 0 || qFuzzyCompare(strokeWidth, borderGeometry_.strokeWidth()))
+        return;
+
+    borderGeometry_.markScreenDirty();
+    borderGeometry_.updateScreenPoints(*map(), strokeWidth);
+
+    QList<QGeoMapItemGeometry *> geoms;
+    geoms << &geometry_ << &borderGeometry_;
+    QGeoMapItemGeometry::translateToCommonOrigin(geoms);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativePolygonMapItem::updateItemGeometry(const QRectF &combined)
+{
     setWidth(combined.width());
     setHeight(combined.height());
 
@@ -584,6 +679,12 @@ void QDeclarativePolygonMapItem::afterViewportChanged(const QGeoMapViewportChang
     if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
         return;
 
+    // Pans, rotations and zooming within an integer zoom level keep the geometry
+    if (!event.mapSizeChanged && updateGeometryTransform(event.cameraData)) {
+        polishAndUpdate();
+        return;
+    }
+
     geometry_.setPreserveGeometry(true, geometry_.geoLeftBound());
     borderGeometry_.setPreserveGeometry(true, borderGeometry_.geoLeftBound());
     geometry_.markSourceDirty();
@@ -598,6 +699,7 @@ void QDeclarativePolygonMapItem::regenerateCache()
 {
     if (!map())
         return;
+    geopathSimplified_.invalidate();
     geopathProjected_.clear();
     geopathProjected_.reserve(geopath_.path().size());
     for (const QGeoCoordinate &c : geopath_.path())
@@ -611,6 +713,7 @@ void QDeclarativePolygonMapItem::updateCache()
 {
     if (!map())
         return;
+    geopathSimplified_.invalidate();
     geopathProjected_ << map()->geoProjection().geoToMapProjection(geopath_.path().last());
 }
 
@@ -67,10 +67,10 @@ public:
 
     inline void setAssumeSimple(bool value) { assumeSimple_ = value; }
 
-    void updateSourcePoints(const QGeoMap &map,
+    void updateSourcePoints(const QGeoMapSnapshot &map,
                             const QList<QDoubleVector2D> &path);
 
-    void updateScreenPoints(const QGeoMap &map);
+    void updateScreenPoints(const QGeoMapSnapshot &map);
 
 protected:
     QPainterPath srcPath_;
@@ -124,9 +124,18 @@ protected Q_SLOTS:
 private:
     void regenerateCache();
     void updateCache();
+    void updateBorderStroke(qreal borderWidth);
+    void updateItemGeometry(const QRectF &combined);
+    static QRectF updateGeometries(const QGeoMapSnapshot &map,
+                                   const QList<QDoubleVector2D> &path,
+                                   const QGeoCoordinate &borderLeftBound,
+                                   qreal borderWidth,
+                                   QGeoMapPolygonGeometry &geometry,
+                                   QGeoMapPolylineGeometry &borderGeometry);
 
     QGeoPath geopath_;
     QList<QDoubleVector2D> geopathProjected_;
+    QGeoPathSimplificationCache geopathSimplified_;
     QDeclarativeMapLineProperties border_;
     QColor color_;
     bool dirtyMaterial_;
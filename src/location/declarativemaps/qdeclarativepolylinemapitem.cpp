@@ -89,6 +89,14 @@ QT_BEGIN_NAMESPACE
     of vertices. This means that the per frame cost of having a polyline on
     the Map grows in direct proportion to the number of points in the polyline.
 
+    Coordinates added with \l addCoordinate while the map is neither moved nor
+    tilted only cost their own segments, which suits tracks growing in real
+    time. Panning, rotating and zooming the map within the same integer zoom
+    level move, rotate and scale the existing geometry; other camera changes,
+    such as tilting the map, process the whole path again. For paths of
+    several hundred vertices or more this happens on a worker thread, so the
+    polyline may lag a frame or two behind the map while it moves.
+
     Like the other map objects, MapPolyline is normally drawn without a smooth
     appearance. Setting the \l {Item::opacity}{opacity} property will force the object to
     be blended, which decreases performance considerably depending on the hardware in use.
@@ -175,10 +183,11 @@ struct Vertex
 };
 
 QGeoMapPolylineGeometry::QGeoMapPolylineGeometry()
+:   strokeWidth_(0)
 {
 }
 
-QList<QList<QDoubleVector2D> > QGeoMapPolylineGeometry::clipPath(const QGeoMap &map,
+QList<QList<QDoubleVector2D> > QGeoMapPolylineGeometry::clipPath(const QGeoMapSnapshot &map,
                                                            const QList<QDoubleVector2D> &path,
                                                            QDoubleVector2D &leftBoundWrapped)
 {
@@ -261,7 +270,7 @@ QList<QList<QDoubleVector2D> > QGeoMapPolylineGeometry::clipPath(const QGeoMap &
     return clippedPaths;
 }
 
-void QGeoMapPolylineGeometry::pathToScreen(const QGeoMap &map,
+void QGeoMapPolylineGeometry::pathToScreen(const QGeoMapSnapshot &map,
                                            const QList<QList<QDoubleVector2D> > &clippedPaths,
                                            const QDoubleVector2D &leftBoundWrapped)
 {
@@ -273,6 +282,7 @@ void QGeoMapPolylineGeometry::pathToScreen(const QGeoMap &map,
 
     srcOrigin_ = map.geoProjection().mapProjectionToGeo(map.geoProjection().unwrapMapProjection(leftBoundWrapped));
     QDoubleVector2D origin = map.geoProjection().wrappedMapProjectionToItemPosition(leftBoundWrapped);
+    srcOriginPosition_ = origin;
     for (const QList<QDoubleVector2D> &path: clippedPaths) {
         QDoubleVector2D lastAddedPoint;
         for (int i = 0; i < path.size(); ++i) {
@@ -298,6 +308,8 @@ void QGeoMapPolylineGeometry::pathToScreen(const QGeoMap &map,
                 }
             }
         }
+        if (!path.isEmpty())
+            lastWrappedPoint_ = path.last();
     }
 
     sourceBounds_ = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
@@ -306,7 +318,7 @@ void QGeoMapPolylineGeometry::pathToScreen(const QGeoMap &map,
 /*!
     \internal
 */
-void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
+void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMapSnapshot &map,
                                                  const QList<QDoubleVector2D> &path,
                                                  const QGeoCoordinate geoLeftBound)
 {
@@ -341,12 +353,13 @@ void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
 /*!
     \internal
 */
-void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMap &map,
+void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMapSnapshot &map,
                                                  qreal strokeWidth)
 {
     if (!screenDirty_)
         return;
 
+    strokeWidth_ = strokeWidth;
     QPointF origin = map.geoProjection().coordinateToItemPosition(srcOrigin_, false).toPointF();
 
     if (!qIsFinite(origin.x()) || !qIsFinite(origin.y()) || srcPointTypes_.size() < 2) { // the line might have been clipped away.
@@ -409,8 +422,113 @@ void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMap &map,
     this->translate( -1 * sourceBounds_.topLeft());
 }
 
+/*!
+    \internal
+    Extends the geometry with the last \a count points of \a path, without
+    clipping or stroking again what is already there. The previous end of the
+    path is stroked again together with the new points, so that the join is
+    drawn as in a full rebuild.
+
+    This requires the camera to be unchanged since the geometry was last
+    built, and an untilted map so that nothing needs clipping. Returns false
+    if the geometry has to be rebuilt instead.
+*/
+bool QGeoMapPolylineGeometry::appendPoints(const QGeoMapSnapshot &map,
+                                           const QList<QDoubleVector2D> &path,
+                                           int count,
+                                           qreal strokeWidth)
+{
+    const int typeCount = srcPointTypes_.size();
+    if (count <= 0 || count >= path.size() || typeCount < 2 || screenVertices_.isEmpty()
+            || srcPointTypes_.last() != QPainterPath::LineToElement
+            || strokeWidth != strokeWidth_ || map.cameraData().tilt() != 0.0) {
+        return false;
+    }
+
+    const QGeoProjection &projection = map.geoProjection();
+
+    // Picks the copy of a wrapped point closest to the previous point, as the unwrapping
+    // around geoLeftBound_ does for paths that are not crossing half the globe.
+    auto unwrapNear = [](QDoubleVector2D point, const QDoubleVector2D &previous) {
+        if (point.x() - previous.x() > 0.5)
+            point.setX(point.x() - 1.0);
+        else if (previous.x() - point.x() > 0.5)
+            point.setX(point.x() + 1.0);
+        return point;
+    };
+
+    // The geometry must end where the path ended before the new points
+    QDoubleVector2D previous = unwrapNear(projection.wrapMapProjection(path.at(path.size() - count - 1)),
+                                          lastWrappedPoint_);
+    const QDoubleVector2D previousPosition = projection.wrappedMapProjectionToItemPosition(previous)
+            - srcOriginPosition_;
+    const QDoubleVector2D lastPosition(srcPoints_.at(typeCount * 2 - 2), srcPoints_.at(typeCount * 2 - 1));
+    if ((previousPosition - lastPosition).manhattanLength() > 0.5)
+        return false;
+
+    // The last segment is stroked again for the join
+    QVector<qreal> points;
+    QVector<QPainterPath::ElementType> types;
+    points << srcPoints_.at(typeCount * 2 - 4) << srcPoints_.at(typeCount * 2 - 3)
+           << lastPosition.x() << lastPosition.y();
+    types << QPainterPath::MoveToElement << QPainterPath::LineToElement;
+
+    QRectF bounds = sourceBounds_;
+    for (int i = path.size() - count; i < path.size(); ++i) {
+        const QDoubleVector2D wrapped = unwrapNear(projection.wrapMapProjection(path.at(i)), previous);
+        if (qAbs(wrapped.x() - previous.x()) > 0.25)
+            return false;
+        const QDoubleVector2D point = projection.wrappedMapProjectionToItemPosition(wrapped) - srcOriginPosition_;
+        if (!qIsFinite(point.x()) || !qIsFinite(point.y()))
+            return false;
+
+        points << point.x() << point.y();
+        types << QPainterPath::LineToElement;
+        bounds.setLeft(qMin(bounds.left(), point.x()));
+        bounds.setTop(qMin(bounds.top(), point.y()));
+        bounds.setRight(qMax(bounds.right(), point.x()));
+        bounds.setBottom(qMax(bounds.bottom(), point.y()));
+        previous = wrapped;
+    }
+
+    QVectorPath vp(points.data(), types.size(), types.data());
+    QTriangulatingStroker ts;
+    ts.process(vp, QPen(QBrush(Qt::black), strokeWidth), QRectF(), QPainter::Qt4CompatiblePainting);
+    if (ts.vertexCount() < 6)
+        return false;
+
+    for (int i = 4; i < points.size(); i += 2)
+        srcPoints_ << points.at(i) << points.at(i + 1);
+    srcPointTypes_ << types.mid(2);
+    lastWrappedPoint_ = previous;
+
+    // Vertices are relative to the top left of the source bounds
+    const QPointF offset = -1 * sourceBounds_.topLeft();
+    const float *vs = ts.vertices();
+    const int vertexCount = ts.vertexCount() / 2;
+    screenVertices_.reserve(screenVertices_.size() + vertexCount + 2);
+    // Degenerate triangles connect the new strip to the previous one
+    screenVertices_ << screenVertices_.last() << QPointF(vs[0], vs[1]) + offset;
+    for (int i = 0; i < vertexCount; ++i) {
+        const QPointF pt = QPointF(vs[i * 2], vs[i * 2 + 1]) + offset;
+        screenVertices_ << pt;
+        screenBounds_.setLeft(qMin(screenBounds_.left(), pt.x()));
+        screenBounds_.setTop(qMin(screenBounds_.top(), pt.y()));
+        screenBounds_.setRight(qMax(screenBounds_.right(), pt.x()));
+        screenBounds_.setBottom(qMax(screenBounds_.bottom(), pt.y()));
+    }
+
+    if (bounds.topLeft() != sourceBounds_.topLeft())
+        translate(sourceBounds_.topLeft() - bounds.topLeft());
+    sourceBounds_ = bounds;
+
+    screenDirty_ = true;
+    return true;
+}
+
 QDeclarativePolylineMapItem::QDeclarativePolylineMapItem(QQuickItem *parent)
-:   QDeclarativeGeoMapItemBase(parent), line_(this), dirtyMaterial_(true), updatingGeometry_(false)
+:   QDeclarativeGeoMapItemBase(parent), line_(this), dirtyMaterial_(true), appendedCoordinates_(0),
+    updatingGeometry_(false)
 {
     setFlag(ItemHasContents, true);
     QObject::connect(&line_, SIGNAL(colorChanged(QColor)),
@@ -559,8 +677,14 @@ void QDeclarativePolylineMapItem::addCoordinate(const QGeoCoordinate &coordinate
     geopath_.addCoordinate(coordinate);
 
     updateCache();
-    geometry_.setPreserveGeometry(true, geopath_.boundingGeoRectangle().topLeft());
-    markSourceDirtyAndUpdate();
+    if (map() && !geometry_.isSourceDirty() && !isGeometryJobPending()) {
+        // updatePolish() extends the current geometry, unless the camera changes first
+        ++appendedCoordinates_;
+        polishAndUpdate();
+    } else {
+        geometry_.setPreserveGeometry(true, geopath_.boundingGeoRectangle().topLeft());
+        markSourceDirtyAndUpdate();
+    }
     emit pathChanged();
 }
 
@@ -740,6 +864,12 @@ void QDeclarativePolylineMapItem::afterViewportChanged(const QGeoMapViewportChan
     if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
         return;
 
+    // Pans, rotations and zooming within an integer zoom level keep the geometry
+    if (!event.mapSizeChanged && updateGeometryTransform(event.cameraData)) {
+        polishAndUpdate();
+        return;
+    }
+
     geometry_.setPreserveGeometry(true, geometry_.geoLeftBound());
     markSourceDirtyAndUpdate();
 }
@@ -751,6 +881,7 @@ void QDeclarativePolylineMapItem::regenerateCache()
 {
     if (!map())
         return;
+    geopathSimplified_.invalidate();
     geopathProjected_.clear();
     geopathProjected_.reserve(geopath_.path().size());
     for (const QGeoCoordinate &c : geopath_.path())
@@ -764,6 +895,7 @@ void QDeclarativePolylineMapItem::updateCache()
 {
     if (!map())
         return;
+    geopathSimplified_.invalidate();
     geopathProjected_ << map()->geoProjection().geoToMapProjection(geopath_.path().last());
 }
 
@@ -778,9 +910,77 @@ void QDeclarativePolylineMapItem::updatePolish()
     QScopedValueRollback<bool> rollback(updatingGeometry_);
     updatingGeometry_ = true;
 
-    geometry_.updateSourcePoints(*map(), geopathProjected_, geopath_.boundingGeoRectangle().topLeft());
+    // Coordinates appended since the last update only need their own segments
+    if (appendedCoordinates_ > 0 && !geometry_.isSourceDirty() && !isGeometryJobPending()) {
+        const int appended = appendedCoordinates_;
+        appendedCoordinates_ = 0;
+        if (geometry_.appendPoints(*map(), geopathProjected_, appended, line_.width())) {
+            updateItemGeometry();
+            return;
+        }
+        geometry_.setPreserveGeometry(true, geopath_.boundingGeoRectangle().topLeft());
+        geometry_.markSourceDirty();
+    }
+    appendedCoordinates_ = 0;
+
+    // The camera only moved as far as scaling and rotating the item can show;
+    // the stroke is redone if the scale would otherwise change its width
+    if (!geometry_.isSourceDirty()) {
+        const qreal strokeWidth = line_.width() / geometryScale();
+        if (!qFuzzyCompare(strokeWidth, geometry_.strokeWidth())) {
+            geometry_.markScreenDirty();
+            geometry_.updateScreenPoints(*map(), strokeWidth);
+        }
+        updateItemGeometry();
+        return;
+    }
+
+    // Long paths are processed at the resolution the current zoom level can show
+    const QList<QDoubleVector2D> &path = geopathSimplified_.path(geopathProjected_, map()->cameraData().zoomLevel());
+    const QGeoCoordinate leftBound = geopath_.boundingGeoRectangle().topLeft();
+
+    // and, when that is still long, on a worker thread
+    if (path.size() >= AsyncGeometryThreshold) {
+        if (deferGeometryUpdate())
+            return;
+        const QGeoMapSnapshot snapshot = QGeoMapSnapshot::copy(*map());
+        if (snapshot.isCopy()) {
+            QSharedPointer<QGeoMapPolylineGeometry> geometry(new QGeoMapPolylineGeometry(geometry_));
+            const QList<QDoubleVector2D> source = path;
+            const qreal width = line_.width();
+            const QGeoCameraData camera = snapshot.cameraData();
+            startGeometryJob([snapshot, geometry, source, leftBound, width]() {
+                geometry->updateSourcePoints(snapshot, source, leftBound);
+                geometry->updateScreenPoints(snapshot, width);
+            }, [this, geometry, camera]() {
+                QScopedValueRollback<bool> rollback(updatingGeometry_);
+                updatingGeometry_ = true;
+                // The item may have been marked dirty again while the job ran
+                const bool outdated = geometry_.sourceRevision() != geometry->sourceRevision();
+                geometry_ = *geometry;
+                if (!setGeometryReference(camera) || outdated) {
+                    geometry_.markSourceDirty();
+                    polishAndUpdate();
+                }
+                updateItemGeometry();
+            });
+            return;
+        }
+    }
+
+    cancelGeometryJob();
+    setGeometryReference(map()->cameraData());
+    geometry_.updateSourcePoints(*map(), path, leftBound);
     geometry_.updateScreenPoints(*map(), line_.width());
 
+    updateItemGeometry();
+}
+
+/*!
+    \internal
+*/
+void QDeclarativePolylineMapItem::updateItemGeometry()
+{
     setWidth(geometry_.sourceBoundingBox().width());
     setHeight(geometry_.sourceBoundingBox().height());
 
@@ -90,25 +90,35 @@ class QGeoMapPolylineGeometry : public QGeoMapItemGeometry
 public:
     QGeoMapPolylineGeometry();
 
-    void updateSourcePoints(const QGeoMap &map,
+    void updateSourcePoints(const QGeoMapSnapshot &map,
                             const QList<QDoubleVector2D> &path,
                             const QGeoCoordinate geoLeftBound);
 
-    void updateScreenPoints(const QGeoMap &map,
+    void updateScreenPoints(const QGeoMapSnapshot &map,
                             qreal strokeWidth);
 
+    bool appendPoints(const QGeoMapSnapshot &map,
+                      const QList<QDoubleVector2D> &path,
+                      int count,
+                      qreal strokeWidth);
+
+    inline qreal strokeWidth() const { return strokeWidth_; }
+
 protected:
-    QList<QList<QDoubleVector2D> > clipPath(const QGeoMap &map,
+    QList<QList<QDoubleVector2D> > clipPath(const QGeoMapSnapshot &map,
                     const QList<QDoubleVector2D> &path,
                     QDoubleVector2D &leftBoundWrapped);
 
-    void pathToScreen(const QGeoMap &map,
+    void pathToScreen(const QGeoMapSnapshot &map,
                       const QList<QList<QDoubleVector2D> > &clippedPaths,
                       const QDoubleVector2D &leftBoundWrapped);
 
 private:
     QVector<qreal> srcPoints_;
     QVector<QPainterPath::ElementType> srcPointTypes_;
+    QDoubleVector2D srcOriginPosition_;
+    QDoubleVector2D lastWrappedPoint_;
+    qreal strokeWidth_;
 
     friend class QDeclarativeCircleMapItem;
     friend class QDeclarativePolygonMapItem;
@@ -165,13 +175,16 @@ protected Q_SLOTS:
 private:
     void regenerateCache();
     void updateCache();
+    void updateItemGeometry();
 
     QGeoPath geopath_;
     QList<QDoubleVector2D> geopathProjected_;
+    QGeoPathSimplificationCache geopathSimplified_;
     QDeclarativeMapLineProperties line_;
     QColor color_;
     bool dirtyMaterial_;
     QGeoMapPolylineGeometry geometry_;
+    int appendedCoordinates_;
     bool updatingGeometry_;
 };
 
@@ -40,11 +40,53 @@
 #include <QtQuick/QSGGeometry>
 #include "qdoublevector2d_p.h"
 #include <QtLocation/private/qgeomap_p.h>
+#include <QtLocation/private/qgeoprojection_p.h>
+#include <cmath>
+#include <limits>
 
 QT_BEGIN_NAMESPACE
 
+QGeoMapSnapshot::QGeoMapSnapshot(const QGeoMap &map)
+:   projection_(&map.geoProjection()), viewportSize_(map.viewportSize()), cameraData_(map.cameraData())
+{
+}
+
+/*!
+    \internal
+*/
+QGeoMapSnapshot QGeoMapSnapshot::copy(const QGeoMap &map)
+{
+    QGeoMapSnapshot snapshot(map);
+    const QGeoProjection *projection = map.geoProjection().clone();
+    if (projection) {
+        snapshot.ownedProjection_.reset(projection);
+        snapshot.projection_ = projection;
+    }
+    return snapshot;
+}
+
+QGeoMapItemGeometryJob::QGeoMapItemGeometryJob(const QSharedPointer<QAtomicInt> &generation,
+                                               int expectedGeneration,
+                                               const std::function<void()> &work)
+:   generation_(generation), expectedGeneration_(expectedGeneration), work_(work)
+{
+    setAutoDelete(true);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemGeometryJob::run()
+{
+    if (generation_->load() != expectedGeneration_)
+        return;
+    work_();
+    emit finished(expectedGeneration_);
+}
+
 QGeoMapItemGeometry::QGeoMapItemGeometry()
-:   sourceDirty_(true), screenDirty_(true), clipToViewport_(true), preserveGeometry_(false)
+:   sourceDirty_(true), screenDirty_(true), clipToViewport_(true), preserveGeometry_(false),
+    sourceRevision_(0)
 {
 }
 
@@ -118,7 +160,7 @@ QRectF QGeoMapItemGeometry::translateToCommonOrigin(const QList<QGeoMapItemGeome
 /*!
     \internal
 */
-double QGeoMapItemGeometry::geoDistanceToScreenWidth(const QGeoMap &map,
+double QGeoMapItemGeometry::geoDistanceToScreenWidth(const QGeoMapSnapshot &map,
                                                      const QGeoCoordinate &fromCoord,
                                                      const QGeoCoordinate &toCoord)
 {
@@ -137,4 +179,143 @@ double QGeoMapItemGeometry::geoDistanceToScreenWidth(const QGeoMap &map,
     return halfScreenDist.x() * 2.0;
 }
 
+QGeoPathSimplificationCache::QGeoPathSimplificationCache()
+    : levels_(MaximumLevel + 1), levelValid_(MaximumLevel + 1, false), closed_(false)
+{
+}
+
+/*!
+    \internal
+    Drops all levels, to be called whenever the source path changes.
+*/
+void QGeoPathSimplificationCache::invalidate()
+{
+    ranks_.clear();
+    for (int i = 0; i <= MaximumLevel; ++i) {
+        levels_[i].clear();
+        levelValid_[i] = false;
+    }
+}
+
+/*!
+    \internal
+    Returns the largest deviation from \a source, in map projection units,
+    allowed at zoom \a level: half a pixel of a 256 pixel tile.
+*/
+double QGeoPathSimplificationCache::tolerance(int level)
+{
+    return 0.5 / (256.0 * std::pow(2.0, level));
+}
+
+/*!
+    \internal
+    Returns \a source simplified for \a zoomLevel. The level above a
+    fractional zoom is used, so the error stays below half a pixel.
+    \a closed tells whether \a source is the ring of a polygon.
+*/
+const QList<QDoubleVector2D> &QGeoPathSimplificationCache::path(const QList<QDoubleVector2D> &source,
+                                                                double zoomLevel,
+                                                                bool closed)
+{
+    if (source.size() < MinimumPathSize)
+        return source;
+
+    if (ranks_.size() != source.size() || closed_ != closed) {
+        invalidate();
+        rankVertices(source, closed);
+    }
+
+    const int level = qBound(0, int(std::ceil(zoomLevel)), int(MaximumLevel));
+    if (!levelValid_.at(level)) {
+        const double tol = tolerance(level);
+        const double tol2 = tol * tol;
+        QList<QDoubleVector2D> &simplified = levels_[level];
+        simplified.clear();
+        for (int i = 0; i < source.size(); ++i) {
+            if (ranks_.at(i) > tol2)
+                simplified.append(source.at(i));
+        }
+        levelValid_[level] = true;
+    }
+    return levels_.at(level);
+}
+
+static double squaredSegmentDistance(const QDoubleVector2D &p, const QDoubleVector2D &a, const QDoubleVector2D &b)
+{
+    const QDoubleVector2D ab = b - a;
+    const double length2 = ab.x() * ab.x() + ab.y() * ab.y();
+    QDoubleVector2D d = p - a;
+    if (length2 > 0.0) {
+        const double t = qBound(0.0, (d.x() * ab.x() + d.y() * ab.y()) / length2, 1.0);
+        d = p - (a + t * ab);
+    }
+    return d.x() * d.x() + d.y() * d.y();
+}
+
+/*!
+    \internal
+    Runs Douglas-Peucker down to a zero tolerance and records, for each
+    vertex, the squared deviation at which it got selected. A vertex is never
+    ranked above the vertex whose split introduced it, so that every level
+    is a proper simplification of the levels below it.
+*/
+void QGeoPathSimplificationCache::rankVertices(const QList<QDoubleVector2D> &source, bool closed)
+{
+    const int n = source.size();
+    const double infinity = std::numeric_limits<double>::infinity();
+    ranks_.fill(0.0, n);
+    closed_ = closed;
+
+    struct Span { int first; int last; double rank; };
+    QVector<Span> stack;
+
+    ranks_[0] = infinity;
+    ranks_[n - 1] = infinity;
+    if (closed) {
+        // A ring needs a second anchor, take the vertex farthest from the first
+        int far = 0;
+        double farDistance = -1.0;
+        for (int i = 1; i < n - 1; ++i) {
+            const QDoubleVector2D d = source.at(i) - source.at(0);
+            const double distance = d.x() * d.x() + d.y() * d.y();
+            if (distance > farDistance) {
+                far = i;
+                farDistance = distance;
+            }
+        }
+        ranks_[far] = infinity;
+        const Span head = { 0, far, infinity };
+        const Span tail = { far, n - 1, infinity };
+        stack << head << tail;
+    } else {
+        const Span all = { 0, n - 1, infinity };
+        stack << all;
+    }
+
+    // Explicit stack, tracks can have hundreds of thousands of points
+    while (!stack.isEmpty()) {
+        const Span span = stack.takeLast();
+        if (span.last - span.first < 2)
+            continue;
+
+        const QDoubleVector2D &a = source.at(span.first);
+        const QDoubleVector2D &b = source.at(span.last);
+        int split = -1;
+        double maxDistance = -1.0;
+        for (int i = span.first + 1; i < span.last; ++i) {
+            const double distance = squaredSegmentDistance(source.at(i), a, b);
+            if (distance > maxDistance) {
+                split = i;
+                maxDistance = distance;
+            }
+        }
+
+        const double rank = qMin(maxDistance, span.rank);
+        ranks_[split] = rank;
+        const Span left = { span.first, split, rank };
+        const Span right = { split, span.last, rank };
+        stack << left << right;
+    }
+}
+
 QT_END_NAMESPACE
@@ -49,7 +49,13 @@
 //
 
 #include <QtLocation/private/qlocationglobal_p.h>
+#include <QtLocation/private/qgeocameradata_p.h>
 
+#include <QObject>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QSize>
 #include <QPainterPath>
 #include <QPointF>
 #include <QRectF>
@@ -57,11 +63,68 @@
 #include <QGeoCoordinate>
 #include <QVector2D>
 #include <QList>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <functional>
 
 QT_BEGIN_NAMESPACE
 
 class QSGGeometry;
 class QGeoMap;
+class QGeoProjection;
+
+/*
+    The map state that item geometry is generated from: projection, viewport
+    size and camera. Converting a QGeoMap refers to its live projection;
+    copy() takes a private copy of the projection, which stays valid on a
+    worker thread while the map keeps moving.
+*/
+class Q_LOCATION_PRIVATE_EXPORT QGeoMapSnapshot
+{
+public:
+    QGeoMapSnapshot(const QGeoMap &map);
+
+    static QGeoMapSnapshot copy(const QGeoMap &map);
+
+    // false if the projection could not be copied
+    inline bool isCopy() const { return !ownedProjection_.isNull(); }
+
+    inline const QGeoProjection &geoProjection() const { return *projection_; }
+    inline const QGeoCameraData &cameraData() const { return cameraData_; }
+    inline QSize viewportSize() const { return viewportSize_; }
+    inline int viewportWidth() const { return viewportSize_.width(); }
+    inline int viewportHeight() const { return viewportSize_.height(); }
+
+private:
+    QSharedPointer<const QGeoProjection> ownedProjection_;
+    const QGeoProjection *projection_;
+    QSize viewportSize_;
+    QGeoCameraData cameraData_;
+};
+
+/*
+    Runs a geometry update on a worker thread. The job is dropped, without
+    running, if the generation counter it was started with has moved on by
+    the time a thread picks it up; finished() is emitted otherwise.
+*/
+class Q_LOCATION_PRIVATE_EXPORT QGeoMapItemGeometryJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    QGeoMapItemGeometryJob(const QSharedPointer<QAtomicInt> &generation,
+                           int expectedGeneration,
+                           const std::function<void()> &work);
+
+    void run() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void finished(int generation);
+
+private:
+    QSharedPointer<QAtomicInt> generation_;
+    int expectedGeneration_;
+    std::function<void()> work_;
+};
 
 class QGeoMapItemGeometry
 {
@@ -70,10 +133,12 @@ public:
 
     inline bool isSourceDirty() const { return sourceDirty_; }
     inline bool isScreenDirty() const { return screenDirty_; }
-    inline void markSourceDirty() { sourceDirty_ = true; screenDirty_ = true; }
+    inline void markSourceDirty() { sourceDirty_ = true; screenDirty_ = true; ++sourceRevision_; }
     inline void markScreenDirty() { screenDirty_ = true; clipToViewport_ = true; }
     inline void markFullScreenDirty() { screenDirty_ = true; clipToViewport_ = false;}
     inline void markClean() { screenDirty_ = (sourceDirty_ = false); clipToViewport_ = true;}
+    // Counts markSourceDirty() calls, which markClean() does not undo
+    inline int sourceRevision() const { return sourceRevision_; }
 
     inline void setPreserveGeometry(bool value, const QGeoCoordinate &geoLeftBound = QGeoCoordinate())
     {
@@ -81,6 +146,7 @@ public:
         if (preserveGeometry_)
             geoLeftBound_ = geoLeftBound;
     }
+    inline bool preserveGeometry() const { return preserveGeometry_; }
     inline QGeoCoordinate geoLeftBound() { return geoLeftBound_; }
 
     inline QRectF sourceBoundingBox() const { return sourceBounds_; }
@@ -118,7 +184,7 @@ public:
 
     void allocateAndFill(QSGGeometry *geom) const;
 
-    double geoDistanceToScreenWidth(const QGeoMap &map,
+    double geoDistanceToScreenWidth(const QGeoMapSnapshot &map,
                                            const QGeoCoordinate &fromCoord,
                                            const QGeoCoordinate &toCoord);
 
@@ -130,6 +196,7 @@ protected:
     bool screenDirty_;
     bool clipToViewport_;
     bool preserveGeometry_;
+    int sourceRevision_;
     QGeoCoordinate geoLeftBound_;
 
     QPointF firstPointOffset_;
@@ -145,6 +212,41 @@ protected:
     QVector<quint32> screenIndices_;
 };
 
+/*
+    Multi-resolution representation of a path in map projection space, for
+    paths too long to be processed in full on every camera change.
+
+    The vertices are ranked once with Douglas-Peucker: each one gets the
+    deviation below which it can be dropped. The path for an integer zoom
+    level keeps the vertices whose rank exceeds half a pixel at that level,
+    and is cached until the source path changes.
+*/
+class Q_LOCATION_PRIVATE_EXPORT QGeoPathSimplificationCache
+{
+public:
+    enum {
+        MinimumPathSize = 256, // Shorter paths are used as they are
+        MaximumLevel = 30
+    };
+
+    QGeoPathSimplificationCache();
+
+    void invalidate();
+    const QList<QDoubleVector2D> &path(const QList<QDoubleVector2D> &source,
+                                       double zoomLevel,
+                                       bool closed = false);
+
+    static double tolerance(int level);
+
+private:
+    void rankVertices(const QList<QDoubleVector2D> &source, bool closed);
+
+    QVector<double> ranks_;
+    QVector<QList<QDoubleVector2D> > levels_;
+    QVector<bool> levelValid_;
+    bool closed_;
+};
+
 QT_END_NAMESPACE
 
 #endif // QGEOMAPITEMGEOMETRY_H
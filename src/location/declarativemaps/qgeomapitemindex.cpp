@@ -0,0 +1,344 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeomapitemindex_p.h"
+
+#include <QtCore/qnumeric.h>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// Unlike QRectF::intersects(), true for touching and for empty rectangles,
+// which is what points and straight lines are bounded by
+inline bool touches(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right()
+            && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+// QRectF::united() skips null rectangles
+inline QRectF unite(const QRectF &a, const QRectF &b)
+{
+    return QRectF(QPointF(qMin(a.left(), b.left()), qMin(a.top(), b.top())),
+                  QPointF(qMax(a.right(), b.right()), qMax(a.bottom(), b.bottom())));
+}
+
+// Area that still orders flat rectangles by size
+inline qreal measure(const QRectF &r)
+{
+    const qreal epsilon = 1e-9;
+    return (r.width() + epsilon) * (r.height() + epsilon);
+}
+
+// Moves the upper half of first, ordered along the axis where the centers
+// spread the most, to second
+template <typename T, typename BoundsOf>
+void splitHalves(QVector<T> &first, QVector<T> &second, BoundsOf boundsOf)
+{
+    qreal minX = qInf();
+    qreal maxX = -qInf();
+    qreal minY = qInf();
+    qreal maxY = -qInf();
+    for (const T &t : qAsConst(first)) {
+        const QPointF c = boundsOf(t).center();
+        minX = qMin(minX, c.x());
+        maxX = qMax(maxX, c.x());
+        minY = qMin(minY, c.y());
+        maxY = qMax(maxY, c.y());
+    }
+
+    if (maxX - minX >= maxY - minY) {
+        std::sort(first.begin(), first.end(), [&boundsOf](const T &a, const T &b) {
+            return boundsOf(a).center().x() < boundsOf(b).center().x();
+        });
+    } else {
+        std::sort(first.begin(), first.end(), [&boundsOf](const T &a, const T &b) {
+            return boundsOf(a).center().y() < boundsOf(b).center().y();
+        });
+    }
+
+    const int half = first.size() / 2;
+    second = first.mid(half);
+    first.resize(half);
+}
+
+} // namespace
+
+QGeoMapItemIndex::QGeoMapItemIndex()
+:   root_(new Node)
+{
+}
+
+QGeoMapItemIndex::~QGeoMapItemIndex()
+{
+    deleteNode(root_);
+}
+
+/*!
+    \internal
+
+    Adds \a item with \a bounds, replacing the entry it already has.
+*/
+void QGeoMapItemIndex::insert(QDeclarativeGeoMapItemBase *item, const QRectF &bounds)
+{
+    remove(item);
+
+    Entry entry;
+    entry.bounds = bounds;
+    entry.item = item;
+    insertEntry(entry);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemIndex::remove(QDeclarativeGeoMapItemBase *item)
+{
+    Node *leaf = leaves_.take(item);
+    if (!leaf)
+        return;
+
+    for (int i = 0; i < leaf->entries.size(); ++i) {
+        if (leaf->entries.at(i).item == item) {
+            leaf->entries.remove(i);
+            break;
+        }
+    }
+
+    // Drop the nodes left underfull, and reinsert what they held
+    QVector<Entry> orphans;
+    Node *node = leaf;
+    while (node != root_) {
+        Node *parent = node->parent;
+        const int count = node->leaf ? node->entries.size() : node->children.size();
+        if (count < MinimumEntries) {
+            parent->children.removeOne(node);
+            collectEntries(node, orphans);
+            deleteNode(node);
+        } else {
+            updateBounds(node);
+        }
+        node = parent;
+    }
+    updateBounds(root_);
+
+    while (!root_->leaf && root_->children.size() == 1) {
+        Node *child = root_->children.first();
+        root_->children.clear();
+        delete root_;
+        root_ = child;
+        root_->parent = 0;
+    }
+    if (!root_->leaf && root_->children.isEmpty())
+        root_->leaf = true;
+
+    for (const Entry &entry : qAsConst(orphans))
+        insertEntry(entry);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemIndex::clear()
+{
+    deleteNode(root_);
+    root_ = new Node;
+    leaves_.clear();
+}
+
+/*!
+    \internal
+*/
+QRectF QGeoMapItemIndex::bounds(QDeclarativeGeoMapItemBase *item) const
+{
+    const Node *leaf = leaves_.value(item);
+    if (leaf) {
+        for (const Entry &entry : leaf->entries) {
+            if (entry.item == item)
+                return entry.bounds;
+        }
+    }
+    return QRectF();
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemIndex::intersecting(const QRectF &rect, QVector<QDeclarativeGeoMapItemBase *> &result) const
+{
+    if (leaves_.isEmpty())
+        return;
+
+    QVector<const Node *> stack;
+    stack.append(root_);
+    while (!stack.isEmpty()) {
+        const Node *node = stack.takeLast();
+        if (!touches(node->bounds, rect))
+            continue;
+        if (node->leaf) {
+            for (const Entry &entry : node->entries) {
+                if (touches(entry.bounds, rect))
+                    result.append(entry.item);
+            }
+        } else {
+            for (const Node *child : node->children)
+                stack.append(child);
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Returns the leaf whose bounds grow the least by including \a bounds.
+*/
+QGeoMapItemIndex::Node *QGeoMapItemIndex::chooseLeaf(const QRectF &bounds) const
+{
+    Node *node = root_;
+    while (!node->leaf) {
+        Node *best = 0;
+        qreal bestGrowth = 0;
+        qreal bestMeasure = 0;
+        for (Node *child : qAsConst(node->children)) {
+            const qreal childMeasure = measure(child->bounds);
+            const qreal growth = measure(unite(child->bounds, bounds)) - childMeasure;
+            if (!best || growth < bestGrowth || (growth == bestGrowth && childMeasure < bestMeasure)) {
+                best = child;
+                bestGrowth = growth;
+                bestMeasure = childMeasure;
+            }
+        }
+        node = best;
+    }
+    return node;
+}
+
+void QGeoMapItemIndex::insertEntry(const Entry &entry)
+{
+    Node *leaf = chooseLeaf(entry.bounds);
+    leaf->entries.append(entry);
+    leaves_.insert(entry.item, leaf);
+
+    if (leaf->entries.size() > MaximumEntries) {
+        split(leaf);
+    } else {
+        for (Node *node = leaf; node; node = node->parent)
+            updateBounds(node);
+    }
+}
+
+/*!
+    \internal
+
+    Moves half of the content of the overfull \a node to a new sibling, and
+    splits the parent in turn if that overflows.
+*/
+void QGeoMapItemIndex::split(Node *node)
+{
+    Node *sibling = new Node;
+    sibling->leaf = node->leaf;
+    if (node->leaf) {
+        splitHalves(node->entries, sibling->entries, [](const Entry &entry) { return entry.bounds; });
+        for (const Entry &entry : qAsConst(sibling->entries))
+            leaves_.insert(entry.item, sibling);
+    } else {
+        splitHalves(node->children, sibling->children, [](const Node *child) { return child->bounds; });
+        for (Node *child : qAsConst(sibling->children))
+            child->parent = sibling;
+    }
+    updateBounds(node);
+    updateBounds(sibling);
+
+    Node *parent = node->parent;
+    if (!parent) {
+        parent = new Node;
+        parent->leaf = false;
+        parent->children.append(node);
+        node->parent = parent;
+        root_ = parent;
+    }
+    parent->children.append(sibling);
+    sibling->parent = parent;
+
+    if (parent->children.size() > MaximumEntries) {
+        split(parent);
+    } else {
+        for (Node *n = parent; n; n = n->parent)
+            updateBounds(n);
+    }
+}
+
+void QGeoMapItemIndex::updateBounds(Node *node)
+{
+    node->bounds = QRectF();
+    if (node->leaf) {
+        for (int i = 0; i < node->entries.size(); ++i)
+            node->bounds = i ? unite(node->bounds, node->entries.at(i).bounds) : node->entries.at(i).bounds;
+    } else {
+        for (int i = 0; i < node->children.size(); ++i)
+            node->bounds = i ? unite(node->bounds, node->children.at(i)->bounds) : node->children.at(i)->bounds;
+    }
+}
+
+/*!
+    \internal
+
+    Appends the entries held under \a node to \a entries, and forgets their
+    leaves.
+*/
+void QGeoMapItemIndex::collectEntries(Node *node, QVector<Entry> &entries)
+{
+    if (node->leaf) {
+        for (const Entry &entry : qAsConst(node->entries))
+            leaves_.remove(entry.item);
+        entries += node->entries;
+    } else {
+        for (Node *child : qAsConst(node->children))
+            collectEntries(child, entries);
+    }
+}
+
+void QGeoMapItemIndex::deleteNode(Node *node)
+{
+    for (Node *child : qAsConst(node->children))
+        deleteNode(child);
+    delete node;
+}
+
+QT_END_NAMESPACE
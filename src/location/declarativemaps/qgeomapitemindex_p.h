@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOMAPITEMINDEX_P_H
+#define QGEOMAPITEMINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/private/qlocationglobal_p.h>
+
+#include <QtCore/QRectF>
+#include <QtCore/QVector>
+#include <QtCore/QHash>
+
+QT_BEGIN_NAMESPACE
+
+class QDeclarativeGeoMapItemBase;
+
+/*
+    R-tree of map item bounds in map projection (mercator) space, where x and
+    y are in [0, 1]. Bounds crossing the dateline extend past x = 1.
+
+    Nodes split at the median of their entries along the axis with the widest
+    spread; removing an item reinserts the entries of nodes left underfull.
+*/
+class Q_LOCATION_PRIVATE_EXPORT QGeoMapItemIndex
+{
+public:
+    enum {
+        MaximumEntries = 16,
+        MinimumEntries = 4
+    };
+
+    QGeoMapItemIndex();
+    ~QGeoMapItemIndex();
+
+    void insert(QDeclarativeGeoMapItemBase *item, const QRectF &bounds);
+    void remove(QDeclarativeGeoMapItemBase *item);
+    void clear();
+
+    inline bool contains(QDeclarativeGeoMapItemBase *item) const { return leaves_.contains(item); }
+    QRectF bounds(QDeclarativeGeoMapItemBase *item) const;
+    inline int size() const { return leaves_.size(); }
+
+    // Appends the items whose bounds intersect rect, touching edges included
+    void intersecting(const QRectF &rect, QVector<QDeclarativeGeoMapItemBase *> &result) const;
+
+private:
+    struct Node;
+
+    struct Entry
+    {
+        QRectF bounds;
+        QDeclarativeGeoMapItemBase *item;
+    };
+
+    struct Node
+    {
+        Node() : parent(0), leaf(true) {}
+
+        QRectF bounds;
+        Node *parent;
+        bool leaf;
+        QVector<Entry> entries; // leaf nodes
+        QVector<Node *> children; // inner nodes
+    };
+
+    Node *chooseLeaf(const QRectF &bounds) const;
+    void insertEntry(const Entry &entry);
+    void split(Node *node);
+    void updateBounds(Node *node);
+    void collectEntries(Node *node, QVector<Entry> &entries);
+    static void deleteNode(Node *node);
+
+    Node *root_;
+    QHash<QDeclarativeGeoMapItemBase *, Node *> leaves_;
+
+    Q_DISABLE_COPY(QGeoMapItemIndex)
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOMAPITEMINDEX_P_H
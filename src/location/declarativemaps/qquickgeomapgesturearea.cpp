@@ -63,6 +63,8 @@
 #define QML_MAP_FLICK_MAXIMUMDECELERATION 10000
 
 #define QML_MAP_FLICK_VELOCITY_SAMPLE_PERIOD 38
+// How long a pinch is assumed to take to reach the next zoom level
+#define QML_MAP_PINCH_PREDICTION_PERIOD 500
 // FlickThreshold determines how far the "mouse" must have moved
 // before we perform a flick.
 static const int FlickThreshold = 20;
@@ -1560,6 +1562,7 @@ void QQuickGeoMapGestureArea::startPinch()
     m_pinch.m_lastPoint2 = mapFromScene(m_allPoints.at(1).scenePos());
 
     m_pinch.m_zoom.m_start = m_declarativeMap->zoomLevel();
+    m_pinch.m_zoom.m_predicted = -1;
 }
 
 /*!
@@ -1598,6 +1601,20 @@ void QQuickGeoMapGestureArea::updatePinch()
         qreal perPinchMaximumZoomLevel = qMin(m_pinch.m_zoom.m_start + m_pinch.m_zoom.maximumChange, m_pinch.m_zoom.m_maximum);
         newZoomLevel = qMin(qMax(perPinchMinimumZoomLevel, newZoomLevel), perPinchMaximumZoomLevel);
         m_declarativeMap->setZoomLevel(qMin<qreal>(newZoomLevel, maximumZoomLevel()), false);
+
+        // Let the map fetch the next zoom level in the direction of the pinch
+        if (newZoomLevel != m_pinch.m_zoom.m_previous) {
+            const qreal nextZoomLevel = newZoomLevel > m_pinch.m_zoom.m_previous
+                    ? std::ceil(newZoomLevel) : std::floor(newZoomLevel);
+            const int predicted = static_cast<int>(qMin(qMax(perPinchMinimumZoomLevel, nextZoomLevel),
+                                                        qMin<qreal>(perPinchMaximumZoomLevel, maximumZoomLevel())));
+            if (predicted != m_pinch.m_zoom.m_predicted) {
+                m_pinch.m_zoom.m_predicted = predicted;
+                QGeoCameraData destination = m_map->cameraData();
+                destination.setZoomLevel(predicted);
+                m_map->prefetchCameraPath(destination, QML_MAP_PINCH_PREDICTION_PERIOD);
+            }
+        }
         m_pinch.m_zoom.m_previous = newZoomLevel;
     }
 }
@@ -1781,6 +1798,10 @@ void QQuickGeoMapGestureArea::startFlick(int dx, int dy, int timeMs)
     m_flick.m_animation->setFrom(animationStartCoordinate);
     m_flick.m_animation->setTo(animationEndCoordinate);
     m_flick.m_animation->start();
+
+    QGeoCameraData destination = m_map->cameraData();
+    destination.setCenter(animationEndCoordinate);
+    m_map->prefetchCameraPath(destination, timeMs);
 }
 
 void QQuickGeoMapGestureArea::stopPan()
@@ -284,12 +284,13 @@ private:
         struct Zoom
         {
             Zoom() : m_minimum(0.0), m_maximum(30.0), m_start(0.0), m_previous(0.0),
-                     maximumChange(4.0) {}
+                     maximumChange(4.0), m_predicted(-1) {}
             qreal m_minimum;
             qreal m_maximum;
             qreal m_start;
             qreal m_previous;
             qreal maximumChange;
+            int m_predicted; // zoom level the pinch is heading to, -1 if none yet
         } m_zoom;
 
         struct Rotation
@@ -51,10 +51,15 @@ PRIVATE_HEADERS += \
                     maps/qgeoserviceprovider_p.h \
                     maps/qabstractgeotilecache_p.h \
                     maps/qgeofiletilecache_p.h \
+                    maps/qgeotilediskstorage_p.h \
+                    maps/qgeotilepackstorage_p.h \
+                    maps/qgeotilesharedstorage_p.h \
+                    maps/qgeotilevalidators_p.h \
+                    maps/qgeotileseedjob_p.h \
+                    maps/qgeotiledirectoryindex_p.h \
                     maps/qgeotiledmapreply_p.h \
                     maps/qgeotiledmapreply_p_p.h \
                     maps/qgeotilespec_p.h \
-                    maps/qgeotilespec_p_p.h \
                     maps/qgeorouteparser_p.h \
                     maps/qgeorouteparser_p_p.h \
                     maps/qgeorouteparserosrmv5_p.h \
@@ -87,6 +92,12 @@ SOURCES += \
             maps/qgeoserviceproviderfactory.cpp \
             maps/qabstractgeotilecache.cpp \
             maps/qgeofiletilecache.cpp \
+            maps/qgeotilediskstorage.cpp \
+            maps/qgeotilepackstorage.cpp \
+            maps/qgeotilesharedstorage.cpp \
+            maps/qgeotilevalidators.cpp \
+            maps/qgeotileseedjob.cpp \
+            maps/qgeotiledirectoryindex.cpp \
             maps/qgeotiledmapreply.cpp \
             maps/qgeotilespec.cpp \
             maps/qgeotiledmap.cpp \
@@ -40,35 +40,247 @@
 #include "qgeomappingmanager_p.h"
 
 #include <QDir>
+#include <QtMath>
 #include <QStandardPaths>
 #include <QMetaType>
 #include <QPixmap>
 #include <QDebug>
+#include <QLoggingCategory>
+#include <QVariantList>
 
 Q_DECLARE_METATYPE(QList<QGeoTileSpec>)
 Q_DECLARE_METATYPE(QSet<QGeoTileSpec>)
 
 QT_BEGIN_NAMESPACE
 
+Q_LOGGING_CATEGORY(lcTileCacheStatistics, "qt.location.tilecache.statistics")
+
+static const int statisticsChangedInterval = 1000;
+
+QGeoTileLatencyHistogram::QGeoTileLatencyHistogram()
+{
+    clear();
+}
+
+void QGeoTileLatencyHistogram::clear()
+{
+    for (int i = 0; i < BucketCount; ++i)
+        buckets_[i] = 0;
+    count_ = 0;
+    total_ = 0;
+    max_ = 0;
+}
+
+void QGeoTileLatencyHistogram::add(qint64 usecs)
+{
+    usecs = qMax<qint64>(0, usecs);
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && usecs >= bucketUpperBound(bucket))
+        ++bucket;
+    ++buckets_[bucket];
+    ++count_;
+    total_ += usecs;
+    max_ = qMax(max_, usecs);
+}
+
+qint64 QGeoTileLatencyHistogram::bucketUpperBound(int i)
+{
+    return qint64(1) << i;
+}
+
+qint64 QGeoTileLatencyHistogram::percentileUsecs(double fraction) const
+{
+    if (!count_)
+        return 0;
+    const quint64 rank = quint64(qCeil(fraction * count_));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount - 1; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank)
+            return qMin(bucketUpperBound(i), max_);
+    }
+    return max_;
+}
+
+QVariantMap QGeoTileLatencyHistogram::toVariantMap() const
+{
+    QVariantList buckets;
+    for (int i = 0; i < BucketCount; ++i)
+        buckets.append(buckets_[i]);
+
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), count_);
+    map.insert(QStringLiteral("meanUsecs"), count_ ? total_ / qint64(count_) : 0);
+    map.insert(QStringLiteral("maxUsecs"), max_);
+    map.insert(QStringLiteral("p50Usecs"), percentileUsecs(0.5));
+    map.insert(QStringLiteral("p95Usecs"), percentileUsecs(0.95));
+    map.insert(QStringLiteral("p99Usecs"), percentileUsecs(0.99));
+    map.insert(QStringLiteral("buckets"), buckets);
+    return map;
+}
+
+QGeoTileCacheStatistics::TierCounters::TierCounters()
+    : hits(0), misses(0), evictions(0), bytesIn(0), bytesOut(0), cost(0), maxCost(0)
+{
+}
+
+static const char *tierName(int tier)
+{
+    switch (tier) {
+    case QGeoTileCacheStatistics::TextureTier:
+        return "texture";
+    case QGeoTileCacheStatistics::MemoryTier:
+        return "memory";
+    default:
+        return "disk";
+    }
+}
+
+QVariantMap QGeoTileCacheStatistics::toVariantMap() const
+{
+    QVariantMap map;
+    for (int i = 0; i < TierCount; ++i) {
+        const TierCounters &t = tiers[i];
+        QVariantMap tier;
+        tier.insert(QStringLiteral("hits"), t.hits);
+        tier.insert(QStringLiteral("misses"), t.misses);
+        tier.insert(QStringLiteral("evictions"), t.evictions);
+        tier.insert(QStringLiteral("bytesIn"), t.bytesIn);
+        tier.insert(QStringLiteral("bytesOut"), t.bytesOut);
+        tier.insert(QStringLiteral("cost"), t.cost);
+        tier.insert(QStringLiteral("maxCost"), t.maxCost);
+        map.insert(QLatin1String(tierName(i)), tier);
+    }
+    map.insert(QStringLiteral("decodeTime"), decodeTime.toVariantMap());
+    map.insert(QStringLiteral("fetchTime"), fetchTime.toVariantMap());
+    return map;
+}
+
+QString QGeoTileCacheStatistics::toString() const
+{
+    QString result;
+    for (int i = 0; i < TierCount; ++i) {
+        const TierCounters &t = tiers[i];
+        const quint64 lookups = t.hits + t.misses;
+        result += QString::asprintf("%s: hits %llu (%.1f%%) misses %llu evictions %llu "
+                                    "in %llu B out %llu B fill %lld/%lld; ",
+                                    tierName(i), t.hits,
+                                    lookups ? 100.0 * t.hits / lookups : 0.0,
+                                    t.misses, t.evictions, t.bytesIn, t.bytesOut,
+                                    t.cost, t.maxCost);
+    }
+    result += QString::asprintf("decode: n %llu p50 %lld us p99 %lld us max %lld us; "
+                                "fetch: n %llu p50 %lld us p99 %lld us max %lld us",
+                                decodeTime.count(), decodeTime.percentileUsecs(0.5),
+                                decodeTime.percentileUsecs(0.99), decodeTime.maxUsecs(),
+                                fetchTime.count(), fetchTime.percentileUsecs(0.5),
+                                fetchTime.percentileUsecs(0.99), fetchTime.maxUsecs());
+    return result;
+}
+
 QGeoTileTexture::QGeoTileTexture()
-    : textureBound(false) {}
+    : textureBound(false), provisional(false) {}
 
 QGeoTileTexture::~QGeoTileTexture()
 {
 }
 
 QAbstractGeoTileCache::QAbstractGeoTileCache(QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      statisticsChangedTimer_(new QTimer(this)),
+      statisticsLogTimer_(new QTimer(this))
 {
     qRegisterMetaType<QGeoTileSpec>();
     qRegisterMetaType<QList<QGeoTileSpec> >();
     qRegisterMetaType<QSet<QGeoTileSpec> >();
+
+    statisticsChangedTimer_->setSingleShot(true);
+    statisticsChangedTimer_->setInterval(statisticsChangedInterval);
+    connect(statisticsChangedTimer_, &QTimer::timeout,
+            this, &QAbstractGeoTileCache::statisticsChanged);
+    connect(statisticsLogTimer_, &QTimer::timeout,
+            this, &QAbstractGeoTileCache::logStatistics);
 }
 
 QAbstractGeoTileCache::~QAbstractGeoTileCache()
 {
 }
 
+/*
+    Returns the counters collected since construction or the last
+    resetStatistics(). Caches with tiers fill in their hits, misses,
+    evictions and fill levels; the base class keeps the byte counters and
+    the latency histograms.
+
+    Like the rest of the cache, this must be used from the cache's thread.
+*/
+QGeoTileCacheStatistics QAbstractGeoTileCache::statistics() const
+{
+    return statistics_;
+}
+
+void QAbstractGeoTileCache::resetStatistics()
+{
+    statistics_ = QGeoTileCacheStatistics();
+    statisticsUpdated();
+}
+
+/*
+    Records the network round trip of a tile fetch, from the request being
+    issued to its reply finishing.
+*/
+void QAbstractGeoTileCache::recordFetchTime(qint64 usecs)
+{
+    statistics_.fetchTime.add(usecs);
+    statisticsUpdated();
+}
+
+void QAbstractGeoTileCache::setStatisticsLogInterval(int msec)
+{
+    if (msec > 0)
+        statisticsLogTimer_->start(msec);
+    else
+        statisticsLogTimer_->stop();
+}
+
+int QAbstractGeoTileCache::statisticsLogInterval() const
+{
+    return statisticsLogTimer_->isActive() ? statisticsLogTimer_->interval() : 0;
+}
+
+void QAbstractGeoTileCache::recordBytesIn(QGeoTileCacheStatistics::Tier tier, qint64 bytes)
+{
+    statistics_.tiers[tier].bytesIn += bytes;
+    statisticsUpdated();
+}
+
+void QAbstractGeoTileCache::recordBytesOut(QGeoTileCacheStatistics::Tier tier, qint64 bytes)
+{
+    statistics_.tiers[tier].bytesOut += bytes;
+    statisticsUpdated();
+}
+
+void QAbstractGeoTileCache::recordDecodeTime(qint64 usecs)
+{
+    statistics_.decodeTime.add(usecs);
+    statisticsUpdated();
+}
+
+/*
+    Schedules statisticsChanged(). Lookups are far too frequent to notify
+    each of them, so changes are coalesced.
+*/
+void QAbstractGeoTileCache::statisticsUpdated()
+{
+    if (!statisticsChangedTimer_->isActive())
+        statisticsChangedTimer_->start();
+}
+
+void QAbstractGeoTileCache::logStatistics()
+{
+    qCInfo(lcTileCacheStatistics).noquote() << this << statistics().toString();
+}
+
 void QAbstractGeoTileCache::printStats()
 {
 }
@@ -78,6 +290,87 @@ void QAbstractGeoTileCache::handleError(const QGeoTileSpec &, const QString &err
     qWarning() << "tile request error " << error;
 }
 
+/*
+    Non-blocking variant of get(). Returns the texture if it is already
+    decoded. Otherwise, if the tile is cached but still has to be read and
+    decoded, that work is scheduled, \a pending is set to true and
+    tilesDecoded() is emitted once it is done. When \a pending is null,
+    only already decoded textures are returned and nothing is scheduled.
+
+    The default implementation falls back to get().
+*/
+QSharedPointer<QGeoTileTexture> QAbstractGeoTileCache::getAsync(const QGeoTileSpec &spec, bool *pending)
+{
+    if (pending)
+        *pending = false;
+    return get(spec);
+}
+
+/*
+    Drops the pending asynchronous lookup of \a spec, if any. No
+    tilesDecoded() notification is emitted for it.
+*/
+void QAbstractGeoTileCache::cancelAsync(const QGeoTileSpec &spec)
+{
+    Q_UNUSED(spec);
+}
+
+/*
+    Returns a provisional texture to show for \a spec until the tile itself is
+    available, built from the decoded textures of other zoom levels without
+    reading or decoding anything. The default implementation has none.
+*/
+QSharedPointer<QGeoTileTexture> QAbstractGeoTileCache::placeholder(const QGeoTileSpec &spec)
+{
+    Q_UNUSED(spec);
+    return QSharedPointer<QGeoTileTexture>();
+}
+
+/*
+    Returns whether \a spec is stored in one of the cache \a areas, without
+    touching it or the hit counters. The default implementation knows of no
+    tile.
+*/
+bool QAbstractGeoTileCache::isCached(const QGeoTileSpec &spec, CacheAreas areas) const
+{
+    Q_UNUSED(spec);
+    Q_UNUSED(areas);
+    return false;
+}
+
+/*
+    Returns whether the cached tile \a spec is stale and should be fetched
+    again with a conditional request, in which case \a validators is set to
+    those to send. The default implementation never revalidates.
+*/
+bool QAbstractGeoTileCache::needsRevalidation(const QGeoTileSpec &spec, QGeoTileValidators *validators) const
+{
+    Q_UNUSED(spec);
+    Q_UNUSED(validators);
+    return false;
+}
+
+/*
+    Stores the HTTP \a validators of the cached tile \a spec, after it was
+    fetched or revalidated. The default implementation drops them.
+*/
+void QAbstractGeoTileCache::setTileValidators(const QGeoTileSpec &spec, const QGeoTileValidators &validators)
+{
+    Q_UNUSED(spec);
+    Q_UNUSED(validators);
+}
+
+/*
+    Marks the tiles of \a mapId fetched before \a fetched as stale, e.g.
+    because the tile set changed. They are still served, and revalidated
+    when used. The default implementation ignores it.
+*/
+void QAbstractGeoTileCache::setStaleBefore(int mapId, const QDateTime &fetched)
+{
+    Q_UNUSED(mapId);
+    Q_UNUSED(fetched);
+}
+
 void QAbstractGeoTileCache::setMaxDiskUsage(int diskUsage)
 {
     Q_UNUSED(diskUsage);
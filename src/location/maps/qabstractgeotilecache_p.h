@@ -55,8 +55,10 @@
 #include <QSet>
 #include <QMutex>
 #include <QTimer>
+#include <QVariantMap>
 
 #include "qgeotilespec_p.h"
+#include "qgeotilevalidators_p.h"
 
 #include <QImage>
 
@@ -81,6 +83,68 @@ public:
     QGeoTileSpec spec;
     QImage image;
     bool textureBound;
+    bool provisional;   // stand-in synthesized from other levels until the tile itself is loaded
+};
+
+/* Latencies bucketed by powers of two of microseconds: bucket i holds samples
+ * in [2^(i-1), 2^i) us, bucket 0 those under 1 us and the last one everything
+ * from 2^19 us, about half a second, up. */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileLatencyHistogram
+{
+public:
+    enum { BucketCount = 21 };
+
+    QGeoTileLatencyHistogram();
+
+    void add(qint64 usecs);
+    void clear();
+
+    quint64 count() const { return count_; }
+    qint64 totalUsecs() const { return total_; }
+    qint64 maxUsecs() const { return max_; }
+    quint64 bucket(int i) const { return buckets_[i]; }
+    static qint64 bucketUpperBound(int i);
+    // Upper bound of the bucket holding the given fraction of the samples
+    qint64 percentileUsecs(double fraction) const;
+
+    QVariantMap toVariantMap() const;
+
+private:
+    quint64 buckets_[BucketCount];
+    quint64 count_;
+    qint64 total_;
+    qint64 max_;
+};
+
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileCacheStatistics
+{
+public:
+    enum Tier {
+        TextureTier,
+        MemoryTier,
+        DiskTier,
+        TierCount
+    };
+
+    struct TierCounters
+    {
+        TierCounters();
+
+        quint64 hits;
+        quint64 misses;
+        quint64 evictions;
+        quint64 bytesIn;      // inserted into the tier
+        quint64 bytesOut;     // served from the tier
+        qint64 cost;          // current and maximum cost, in the tier's cost strategy
+        qint64 maxCost;
+    };
+
+    TierCounters tiers[TierCount];
+    QGeoTileLatencyHistogram decodeTime;   // image decoding of cached tiles
+    QGeoTileLatencyHistogram fetchTime;    // network round trips of the fetcher
+
+    QVariantMap toVariantMap() const;
+    QString toString() const;
 };
 
 class Q_LOCATION_PRIVATE_EXPORT QAbstractGeoTileCache : public QObject
@@ -123,6 +187,14 @@ public:
     virtual CostStrategy costStrategyTexture() const = 0;
 
     virtual QSharedPointer<QGeoTileTexture> get(const QGeoTileSpec &spec) = 0;
+    virtual QSharedPointer<QGeoTileTexture> getAsync(const QGeoTileSpec &spec, bool *pending);
+    virtual void cancelAsync(const QGeoTileSpec &spec);
+    virtual QSharedPointer<QGeoTileTexture> placeholder(const QGeoTileSpec &spec);
+    virtual bool isCached(const QGeoTileSpec &spec, CacheAreas areas = AllCaches) const;
+
+    virtual bool needsRevalidation(const QGeoTileSpec &spec, QGeoTileValidators *validators) const;
+    virtual void setTileValidators(const QGeoTileSpec &spec, const QGeoTileValidators &validators);
+    virtual void setStaleBefore(int mapId, const QDateTime &fetched);
 
     virtual void insert(const QGeoTileSpec &spec,
                 const QByteArray &bytes,
@@ -134,10 +206,36 @@ public:
     static QString baseCacheDirectory();
     static QString baseLocationCacheDirectory();
 
+    virtual QGeoTileCacheStatistics statistics() const;
+    virtual void resetStatistics();
+    void recordFetchTime(qint64 usecs);
+
+    // Logs statistics() to qt.location.tilecache.statistics every msec, 0 disables
+    void setStatisticsLogInterval(int msec);
+    int statisticsLogInterval() const;
+
+Q_SIGNALS:
+    void tilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed);
+    // Coalesced, emitted at most about once per second while the cache is in use
+    void statisticsChanged();
+
 protected:
     QAbstractGeoTileCache(QObject *parent = 0);
     virtual void printStats() = 0;
 
+    void recordBytesIn(QGeoTileCacheStatistics::Tier tier, qint64 bytes);
+    void recordBytesOut(QGeoTileCacheStatistics::Tier tier, qint64 bytes);
+    void recordDecodeTime(qint64 usecs);
+    void statisticsUpdated();
+
+private Q_SLOTS:
+    void logStatistics();
+
+private:
+    QGeoTileCacheStatistics statistics_;
+    QTimer *statisticsChangedTimer_;
+    QTimer *statisticsLogTimer_;
+
     friend class QGeoTiledMappingManagerEngine;
 };
 
@@ -47,8 +47,8 @@
 //
 // We mean it.
 
-#include <QtCore/qlinkedlist.h>
 #include <QtCore/qhash.h>
+#include <QtCore/qvector.h>
 #include <QtCore/qcache.h>
 #include <QtCore/qsharedpointer.h>
 #include <QDebug>
@@ -106,20 +106,33 @@ void QCache3QDefaultEvictionPolicy<Key,T>::aboutToBeRemoved(const Key &key, QSha
  *                    from it takes place
  *  * promoteAt = minimum popularity necessary to promote a node from
  *                "newbie" to "regular"
+ *
+ * Nodes live in a slab and are linked by index, and keys are looked up in an
+ * open addressing table of node indexes, so that once the cache has reached
+ * its working size, lookups, insertions and evictions do not allocate.
+ * Released nodes are recycled through a free list.
  */
 template <class Key, class T, class EvPolicy = QCache3QDefaultEvictionPolicy<Key,T> >
 class QCache3Q : public EvPolicy
 {
 private:
-    class Queue;
+    enum QueueIndex {
+        Q1,          // "newbies": seen only once, evicted LRA (least-recently-added)
+        Q2,          // regular nodes, promoted from newbies, evicted LRU
+        Q3,          // "hobos": evicted from q2 but were very popular (above mean)
+        Q1Evicted,   // ghosts of recently evicted newbies and regulars
+        QueueCount
+    };
+
     class Node
     {
     public:
-        inline explicit Node() : q(0), n(0), p(0), pop(0), cost(0) {}
+        inline explicit Node() : q(-1), n(-1), p(-1), hash(0), pop(0), cost(0) {}
 
-        Queue *q;
-        Node *n;
-        Node *p;
+        int q;                      // queue index, -1 when on the free list
+        int n;                      // next node, or next free node
+        int p;
+        uint hash;
         Key k;
         QSharedPointer<T> v;
         quint64 pop;                // popularity, incremented each ping
@@ -129,24 +142,24 @@ private:
     class Queue
     {
     public:
-        inline explicit Queue() : f(0), l(0), cost(0), pop(0), size(0) {}
+        inline explicit Queue() : f(-1), l(-1), cost(0), pop(0), size(0) {}
 
-        Node *f;
-        Node *l;
+        int f;
+        int l;
         int cost;               // total cost of nodes on the queue
         quint64 pop;            // sum of popularity values on the queue
         int size;               // size of the queue
     };
 
-    Queue *q1_;          // "newbies": seen only once, evicted LRA (least-recently-added)
-    Queue *q2_;          // regular nodes, promoted from newbies, evicted LRU
-    Queue *q3_;          // "hobos": evicted from q2 but were very popular (above mean)
-    Queue *q1_evicted_;  // ghosts of recently evicted newbies and regulars
-    QHash<Key, Node *> lookup_;
+    Queue queues_[QueueCount];
+    QVector<Node> nodes_;       // slab of nodes, addressed by index
+    QVector<int> buckets_;      // node indexes by key hash, -1 if empty; size is a power of 2
+    int free_;                  // first node of the free list
+    int used_;                  // nodes not on the free list
 
 public:
     explicit QCache3Q(int maxCost = 0, int minRecent = -1, int maxOldPopular = -1);
-    inline ~QCache3Q() { clear(); delete q1_; delete q2_; delete q3_; delete q1_evicted_; }
+    inline ~QCache3Q() { clear(); }
 
     inline int maxCost() const { return maxCost_; }
     void setMaxCost(int maxCost, int minRecent = -1, int maxOldPopular = -1);
@@ -154,18 +167,35 @@ public:
     inline int promoteAt() const { return promote_; }
     inline void setPromoteAt(int p) { promote_ = p; }
 
-    inline int totalCost() const { return q1_->cost + q2_->cost + q3_->cost; }
+    inline int totalCost() const { return queues_[Q1].cost + queues_[Q2].cost + queues_[Q3].cost; }
 
     void clear();
     bool insert(const Key &key, QSharedPointer<T> object, int cost = 1);
     QSharedPointer<T> object(const Key &key) const;
     QSharedPointer<T> operator[](const Key &key) const;
+    // Like object(), without counting a hit or moving the node
+    QSharedPointer<T> peek(const Key &key) const;
+    inline bool contains(const Key &key) const
+    {
+        const int i = find(key, qHash(key));
+        return i >= 0 && nodes_.at(i).q != Q1Evicted;
+    }
 
     void remove(const Key &key, bool force = false);
     QList<Key> keys() const;
     void printStats();
 
-    // Copy data directly into a queue. Designed for single use after construction
+    inline quint64 hitCount() const { return hitCount_; }
+    inline quint64 missCount() const { return missCount_; }
+    // entries dropped to make room, not counting remove() and clear()
+    inline quint64 evictionCount() const { return evictionCount_; }
+    inline void resetCounters() { hitCount_ = missCount_ = evictionCount_ = 0; }
+
+    // Preallocates room for size keys, ghosts included
+    void reserve(int size);
+
+    // Copy data directly into a queue, preserving the order produced by serializeQueue.
+    // Keys already present in the cache are skipped.
     void deserializeQueue(int queueNumber, const QList<Key> &keys,
                           const QList<QSharedPointer<T> > &values, const QList<int> &costs);
     // Copy data from specific queue into list
@@ -173,11 +203,16 @@ public:
 
 private:
     int maxCost_, minRecent_, maxOldPopular_;
-    int hitCount_, missCount_, promote_;
+    quint64 hitCount_, missCount_, evictionCount_;
+    int promote_;
 
+    int find(const Key &key, uint hash) const;
+    int allocate(const Key &key, uint hash);
+    void release(int i);
+    void rehash(int bucketCount);
     void rebalance();
-    void unlink(Node *n);
-    void link_front(Node *n, Queue *q);
+    void unlink(int i);
+    void link_front(int i, int q);
 
 private:
     // make these private so they can't be used
@@ -189,21 +224,22 @@ template <class Key, class T, class EvPolicy>
 void QCache3Q<Key,T,EvPolicy>::printStats()
 {
     qDebug("\n=== cache %p ===", this);
-    qDebug("hits: %d (%.2f%%)\tmisses: %d\tfill: %.2f%%", hitCount_,
+    qDebug("hits: %llu (%.2f%%)\tmisses: %llu\tevictions: %llu\tfill: %.2f%%", hitCount_,
            100.0 * float(hitCount_) / (float(hitCount_ + missCount_)),
-           missCount_,
+           missCount_, evictionCount_,
            100.0 * float(totalCost()) / float(maxCost()));
-    qDebug("q1g: size=%d, pop=%llu", q1_evicted_->size, q1_evicted_->pop);
-    qDebug("q1:  cost=%d, size=%d, pop=%llu", q1_->cost, q1_->size, q1_->pop);
-    qDebug("q2:  cost=%d, size=%d, pop=%llu", q2_->cost, q2_->size, q2_->pop);
-    qDebug("q3:  cost=%d, size=%d, pop=%llu", q3_->cost, q3_->size, q3_->pop);
+    qDebug("q1g: size=%d, pop=%llu", queues_[Q1Evicted].size, queues_[Q1Evicted].pop);
+    qDebug("q1:  cost=%d, size=%d, pop=%llu", queues_[Q1].cost, queues_[Q1].size, queues_[Q1].pop);
+    qDebug("q2:  cost=%d, size=%d, pop=%llu", queues_[Q2].cost, queues_[Q2].size, queues_[Q2].pop);
+    qDebug("q3:  cost=%d, size=%d, pop=%llu", queues_[Q3].cost, queues_[Q3].size, queues_[Q3].pop);
+    qDebug("slab: used=%d, capacity=%d, buckets=%d", used_, nodes_.size(), buckets_.size());
 }
 
 template <class Key, class T, class EvPolicy>
 QCache3Q<Key,T,EvPolicy>::QCache3Q(int maxCost, int minRecent, int maxOldPopular)
-    : q1_(new Queue), q2_(new Queue), q3_(new Queue), q1_evicted_(new Queue),
+    : free_(-1), used_(0),
       maxCost_(maxCost), minRecent_(minRecent), maxOldPopular_(maxOldPopular),
-      hitCount_(0), missCount_(0), promote_(0)
+      hitCount_(0), missCount_(0), evictionCount_(0), promote_(0)
 {
     if (minRecent_ < 0)
         minRecent_ = maxCost_ / 3;
@@ -215,12 +251,9 @@ template <class Key, class T, class EvPolicy>
 void QCache3Q<Key,T,EvPolicy>::serializeQueue(int queueNumber, QList<QSharedPointer<T> > &buffer)
 {
     Q_ASSERT(queueNumber >= 1 && queueNumber <= 4);
-    Queue *queue = queueNumber == 1 ? q1_ :
-                   queueNumber == 2 ? q2_ :
-                   queueNumber == 3 ? q3_ :
-                                      q1_evicted_;
-    for (Node *node = queue->f; node; node = node->n)
-        buffer.append(node->v);
+    const Queue &queue = queues_[queueNumber - 1];
+    for (int i = queue.f; i >= 0; i = nodes_.at(i).n)
+        buffer.append(nodes_.at(i).v);
 }
 
 template <class Key, class T, class EvPolicy>
@@ -231,19 +264,18 @@ void QCache3Q<Key,T,EvPolicy>::deserializeQueue(int queueNumber, const QList<Key
     int bufferSize = keys.size();
     if (bufferSize == 0)
         return;
-    clear();
-    Queue *queue = queueNumber == 1 ? q1_ :
-                   queueNumber == 2 ? q2_ :
-                   queueNumber == 3 ? q3_ :
-                                      q1_evicted_;
-    for (int i = 0; i<bufferSize; ++i) {
-        Node *node = new Node;
-        node->v = values[i];
-        node->k = keys[i];
-        node->cost = costs[i];
-        link_front(node, queue);
-        lookup_[keys[i]] = node;
+    reserve(used_ + bufferSize);
+    // serializeQueue walks from the front, so link in reverse to keep the same order
+    for (int i = bufferSize - 1; i >= 0; --i) {
+        const uint hash = qHash(keys[i]);
+        if (find(keys[i], hash) >= 0)
+            continue;
+        const int n = allocate(keys[i], hash);
+        nodes_[n].v = values[i];
+        nodes_[n].cost = costs[i];
+        link_front(n, queueNumber - 1);
     }
+    rebalance();
 }
 
 
@@ -260,6 +292,116 @@ inline void QCache3Q<Key,T,EvPolicy>::setMaxCost(int maxCost, int minRecent, int
     rebalance();
 }
 
+template <class Key, class T, class EvPolicy>
+void QCache3Q<Key,T,EvPolicy>::reserve(int size)
+{
+    nodes_.reserve(size);
+    int buckets = qMax(buckets_.size(), 16);
+    while (buckets < size * 2)
+        buckets *= 2;
+    if (buckets != buckets_.size())
+        rehash(buckets);
+}
+
+template <class Key, class T, class EvPolicy>
+int QCache3Q<Key,T,EvPolicy>::find(const Key &key, uint hash) const
+{
+    if (buckets_.isEmpty())
+        return -1;
+    const int mask = buckets_.size() - 1;
+    for (int b = int(hash) & mask; ; b = (b + 1) & mask) {
+        const int i = buckets_.at(b);
+        if (i < 0)
+            return -1;
+        const Node &n = nodes_.at(i);
+        if (n.hash == hash && n.k == key)
+            return i;
+    }
+}
+
+/* Takes a node from the free list, or grows the slab, and indexes it under key. */
+template <class Key, class T, class EvPolicy>
+int QCache3Q<Key,T,EvPolicy>::allocate(const Key &key, uint hash)
+{
+    // keep the table at most half full, so probe sequences stay short
+    if ((used_ + 1) * 2 > buckets_.size())
+        rehash(qMax(16, buckets_.size() * 2));
+
+    int i = free_;
+    if (i >= 0) {
+        free_ = nodes_.at(i).n;
+    } else {
+        i = nodes_.size();
+        nodes_.append(Node());
+    }
+    ++used_;
+
+    Node &n = nodes_[i];
+    n.q = -1;
+    n.n = -1;
+    n.p = -1;
+    n.hash = hash;
+    n.k = key;
+    n.pop = 0;
+    n.cost = 0;
+
+    const int mask = buckets_.size() - 1;
+    int b = int(hash) & mask;
+    while (buckets_.at(b) >= 0)
+        b = (b + 1) & mask;
+    buckets_[b] = i;
+    return i;
+}
+
+/* Unindexes an unlinked node and puts it on the free list. */
+template <class Key, class T, class EvPolicy>
+void QCache3Q<Key,T,EvPolicy>::release(int i)
+{
+    const int mask = buckets_.size() - 1;
+    int b = int(nodes_.at(i).hash) & mask;
+    while (buckets_.at(b) != i)
+        b = (b + 1) & mask;
+
+    // backward shift deletion: move later entries of the probe sequence into the hole
+    for (int j = b; ; ) {
+        j = (j + 1) & mask;
+        const int e = buckets_.at(j);
+        if (e < 0)
+            break;
+        const int home = int(nodes_.at(e).hash) & mask;
+        const bool stays = (b <= j) ? (b < home && home <= j) : (b < home || home <= j);
+        if (!stays) {
+            buckets_[b] = e;
+            b = j;
+        }
+    }
+    buckets_[b] = -1;
+
+    Node &n = nodes_[i];
+    n.k = Key();
+    n.v.clear();
+    n.q = -1;
+    n.n = free_;
+    free_ = i;
+    --used_;
+}
+
+template <class Key, class T, class EvPolicy>
+void QCache3Q<Key,T,EvPolicy>::rehash(int bucketCount)
+{
+    buckets_.fill(-1, bucketCount);
+    const int mask = bucketCount - 1;
+    for (int i = 0; i < nodes_.size(); ++i) {
+        const Node &n = nodes_.at(i);
+        if (n.q < 0)
+            continue;
+        int b = int(n.hash) & mask;
+        while (buckets_.at(b) >= 0)
+            b = (b + 1) & mask;
+        buckets_[b] = i;
+    }
+}
+
 template <class Key, class T, class EvPolicy>
 bool QCache3Q<Key,T,EvPolicy>::insert(const Key &key, QSharedPointer<T> object, int cost)
 {
@@ -267,35 +409,36 @@ bool QCache3Q<Key,T,EvPolicy>::insert(const Key &key, QSharedPointer<T> object,
         return false;
     }
 
-    if (lookup_.contains(key)) {
-        Node *n = lookup_[key];
-        n->v = object;
-        n->q->cost -= n->cost;
-        n->cost = cost;
-        n->q->cost += cost;
-
-        if (n->q == q1_evicted_) {
-            if (n->pop > (uint)promote_) {
-                unlink(n);
-                link_front(n, q2_);
+    const uint hash = qHash(key);
+    int i = find(key, hash);
+    if (i >= 0) {
+        Node &n = nodes_[i];
+        Queue &q = queues_[n.q];
+        n.v = object;
+        q.cost -= n.cost;
+        n.cost = cost;
+        q.cost += cost;
+
+        if (n.q == Q1Evicted) {
+            if (n.pop > (uint)promote_) {
+                unlink(i);
+                link_front(i, Q2);
                 rebalance();
             }
-        } else if (n->q != q1_) {
-            Queue *q = n->q;
-            unlink(n);
-            link_front(n, q);
+        } else if (n.q != Q1) {
+            const int q = n.q;
+            unlink(i);
+            link_front(i, q);
             rebalance();
         }
 
         return true;
     }
 
-    Node *n = new Node;
-    n->v = object;
-    n->k = key;
-    n->cost = cost;
-    link_front(n, q1_);
-    lookup_[key] = n;
+    i = allocate(key, hash);
+    nodes_[i].v = object;
+    nodes_[i].cost = cost;
+    link_front(i, Q1);
 
     rebalance();
 
@@ -305,106 +448,102 @@ bool QCache3Q<Key,T,EvPolicy>::insert(const Key &key, QSharedPointer<T> object,
 template <class Key, class T, class EvPolicy>
 void QCache3Q<Key,T,EvPolicy>::clear()
 {
-    while (q1_evicted_->f) {
-        Node *n = q1_evicted_->f;
-        unlink(n);
-        delete n;
-    }
-
-    while (q1_->f) {
-        Node *n = q1_->f;
-        unlink(n);
-        EvPolicy::aboutToBeRemoved(n->k, n->v);
-        delete n;
-    }
-
-    while (q2_->f) {
-        Node *n = q2_->f;
-        unlink(n);
-        EvPolicy::aboutToBeRemoved(n->k, n->v);
-        delete n;
-    }
-
-    while (q3_->f) {
-        Node *n = q3_->f;
-        unlink(n);
-        EvPolicy::aboutToBeRemoved(n->k, n->v);
-        delete n;
+    for (int q = 0; q < QueueCount; ++q) {
+        while (queues_[q].f >= 0) {
+            const int i = queues_[q].f;
+            unlink(i);
+            if (q != Q1Evicted)
+                EvPolicy::aboutToBeRemoved(nodes_.at(i).k, nodes_.at(i).v);
+        }
     }
 
-    lookup_.clear();
+    nodes_.clear();
+    buckets_.clear();
+    free_ = -1;
+    used_ = 0;
 }
 
 template <class Key, class T, class EvPolicy>
-void QCache3Q<Key,T,EvPolicy>::unlink(Node *n)
+void QCache3Q<Key,T,EvPolicy>::unlink(int i)
 {
-    if (n->n)
-        n->n->p = n->p;
-    if (n->p)
-        n->p->n = n->n;
-    if (n->q->f == n)
-        n->q->f = n->n;
-    if (n->q->l == n)
-        n->q->l = n->p;
-    n->n = 0;
-    n->p = 0;
-    n->q->pop -= n->pop;
-    n->q->cost -= n->cost;
-    n->q->size--;
-    n->q = 0;
+    Node &n = nodes_[i];
+    Queue &q = queues_[n.q];
+    if (n.n >= 0)
+        nodes_[n.n].p = n.p;
+    if (n.p >= 0)
+        nodes_[n.p].n = n.n;
+    if (q.f == i)
+        q.f = n.n;
+    if (q.l == i)
+        q.l = n.p;
+    n.n = -1;
+    n.p = -1;
+    q.pop -= n.pop;
+    q.cost -= n.cost;
+    q.size--;
+    n.q = -1;
 }
 
 template <class Key, class T, class EvPolicy>
-void QCache3Q<Key,T,EvPolicy>::link_front(Node *n, Queue *q)
+void QCache3Q<Key,T,EvPolicy>::link_front(int i, int queue)
 {
-    n->n = q->f;
-    n->p = 0;
-    n->q = q;
-    if (q->f)
-        q->f->p = n;
-    q->f = n;
-    if (!q->l)
-        q->l = n;
-
-    q->pop += n->pop;
-    q->cost += n->cost;
-    q->size++;
+    Node &n = nodes_[i];
+    Queue &q = queues_[queue];
+    n.n = q.f;
+    n.p = -1;
+    n.q = queue;
+    if (q.f >= 0)
+        nodes_[q.f].p = i;
+    q.f = i;
+    if (q.l < 0)
+        q.l = i;
+
+    q.pop += n.pop;
+    q.cost += n.cost;
+    q.size++;
 }
 
 template <class Key, class T, class EvPolicy>
 void QCache3Q<Key,T,EvPolicy>::rebalance()
 {
-    while (q1_evicted_->size > (q1_->size + q2_->size + q3_->size) * 4) {
-        Node *n = q1_evicted_->l;
-        unlink(n);
-        lookup_.remove(n->k);
-        delete n;
+    Queue &q1 = queues_[Q1];
+    Queue &q2 = queues_[Q2];
+    Queue &q3 = queues_[Q3];
+    Queue &q1Evicted = queues_[Q1Evicted];
+
+    while (q1Evicted.size > (q1.size + q2.size + q3.size) * 4) {
+        const int i = q1Evicted.l;
+        unlink(i);
+        release(i);
     }
 
-    while ((q1_->cost + q2_->cost + q3_->cost) > maxCost_) {
-        if (q3_->cost > maxOldPopular_) {
-            Node *n = q3_->l;
-            unlink(n);
-            EvPolicy::aboutToBeEvicted(n->k, n->v);
-            lookup_.remove(n->k);
-            delete n;
-        } else if (q1_->cost > minRecent_) {
-            Node *n = q1_->l;
-            unlink(n);
-            EvPolicy::aboutToBeEvicted(n->k, n->v);
-            n->v.clear();
-            n->cost = 0;
-            link_front(n, q1_evicted_);
+    while ((q1.cost + q2.cost + q3.cost) > maxCost_) {
+        if (q3.cost > maxOldPopular_) {
+            const int i = q3.l;
+            unlink(i);
+            EvPolicy::aboutToBeEvicted(nodes_.at(i).k, nodes_.at(i).v);
+            ++evictionCount_;
+            release(i);
+        } else if (q1.cost > minRecent_) {
+            const int i = q1.l;
+            unlink(i);
+            EvPolicy::aboutToBeEvicted(nodes_.at(i).k, nodes_.at(i).v);
+            ++evictionCount_;
+            nodes_[i].v.clear();
+            nodes_[i].cost = 0;
+            link_front(i, Q1Evicted);
         } else {
-            Node *n = q2_->l;
-            unlink(n);
-            if (q2_->size && n->pop > (q2_->pop / q2_->size)) {
-                link_front(n, q3_);
+            const int i = q2.l;
+            unlink(i);
+            // q2.pop is kept up to date by link_front, unlink and object()
+            if (q2.size && nodes_.at(i).pop > (q2.pop / q2.size)) {
+                link_front(i, Q3);
             } else {
-                EvPolicy::aboutToBeEvicted(n->k, n->v);
-                n->v.clear();
-                n->cost = 0;
-                link_front(n, q1_evicted_);
+                EvPolicy::aboutToBeEvicted(nodes_.at(i).k, nodes_.at(i).v);
+                ++evictionCount_;
+                nodes_[i].v.clear();
+                nodes_[i].cost = 0;
+                link_front(i, Q1Evicted);
             }
         }
     }
@@ -413,57 +552,66 @@ void QCache3Q<Key,T,EvPolicy>::rebalance()
 template <class Key, class T, class EvPolicy>
 void QCache3Q<Key,T,EvPolicy>::remove(const Key &key, bool force)
 {
-    if (!lookup_.contains(key)) {
+    const int i = find(key, qHash(key));
+    if (i < 0) {
         return;
     }
-    Node *n = lookup_[key];
-    unlink(n);
-    if (n->q != q1_evicted_ && !force)
-        EvPolicy::aboutToBeRemoved(n->k, n->v);
-    lookup_.remove(key);
-    delete n;
+    const bool ghost = nodes_.at(i).q == Q1Evicted;
+    unlink(i);
+    if (!ghost && !force)
+        EvPolicy::aboutToBeRemoved(nodes_.at(i).k, nodes_.at(i).v);
+    release(i);
 }
 
 template <class Key, class T, class EvPolicy>
 QList<Key> QCache3Q<Key,T,EvPolicy>::keys() const
 {
-    return lookup_.keys();
+    QList<Key> result;
+    result.reserve(used_);
+    for (int i = 0; i < nodes_.size(); ++i) {
+        if (nodes_.at(i).q >= 0)
+            result.append(nodes_.at(i).k);
+    }
+    return result;
 }
 
 template <class Key, class T, class EvPolicy>
 QSharedPointer<T> QCache3Q<Key,T,EvPolicy>::object(const Key &key) const
 {
-    if (!lookup_.contains(key)) {
-        const_cast<QCache3Q<Key,T,EvPolicy> *>(this)->missCount_++;
+    QCache3Q<Key,T,EvPolicy> *me = const_cast<QCache3Q<Key,T,EvPolicy> *>(this);
+
+    const int i = find(key, qHash(key));
+    if (i < 0) {
+        me->missCount_++;
         return QSharedPointer<T>(0);
     }
 
-    QCache3Q<Key,T,EvPolicy> *me = const_cast<QCache3Q<Key,T,EvPolicy> *>(this);
-
-    Node *n = me->lookup_[key];
-    n->pop++;
-    n->q->pop++;
+    Node &n = me->nodes_[i];
+    // rebalance() may evict the node itself, if it is alone in q3
+    const QSharedPointer<T> v = n.v;
+    n.pop++;
+    me->queues_[n.q].pop++;
 
-    if (n->q == q1_) {
+    if (n.q == Q1) {
         me->hitCount_++;
 
-        if (n->pop > (quint64)promote_) {
-            me->unlink(n);
-            me->link_front(n, q2_);
+        if (n.pop > (quint64)promote_) {
+            me->unlink(i);
+            me->link_front(i, Q2);
             me->rebalance();
         }
-    } else if (n->q != q1_evicted_) {
+    } else if (n.q != Q1Evicted) {
         me->hitCount_++;
 
-        Queue *q = n->q;
-        me->unlink(n);
-        me->link_front(n, q);
+        const int q = n.q;
+        me->unlink(i);
+        me->link_front(i, q);
         me->rebalance();
     } else {
         me->missCount_++;
     }
 
-    return n->v;
+    return v;
 }
 
 template <class Key, class T, class EvPolicy>
@@ -472,6 +620,15 @@ inline QSharedPointer<T> QCache3Q<Key,T,EvPolicy>::operator[](const Key &key) co
     return object(key);
 }
 
+template <class Key, class T, class EvPolicy>
+QSharedPointer<T> QCache3Q<Key,T,EvPolicy>::peek(const Key &key) const
+{
+    const int i = find(key, qHash(key));
+    if (i < 0 || nodes_.at(i).q == Q1Evicted)
+        return QSharedPointer<T>();
+    return nodes_.at(i).v;
+}
+
 QT_END_NAMESPACE
 
 #endif // QCACHE3Q_H
@@ -48,6 +48,7 @@
 #include <QPair>
 #include <QSet>
 #include <QSize>
+#include <QRect>
 #include <cmath>
 #include <limits>
 
@@ -97,10 +98,26 @@ public:
 
     bool m_dirtyGeometry;
     bool m_dirtyMetadata;
+    bool m_dirtyFrustum;
+
+    // Tile changes of the last update, see QGeoCameraTiles::hasTilesDelta()
+    int m_generation;
+    bool m_hasDelta;
+    QSet<QGeoTileSpec> m_added;
+    QSet<QGeoTileSpec> m_removed;
+
+    // For a camera looking straight down, the footprint is a rectangle
+    // around the center and m_tiles the tiles it covers
+    bool m_panValid;
+    QDoubleVector2D m_panExtent;
+    QRect m_tileRect;
 
     double m_viewExpansion;
     void updateMetadata();
     void updateGeometry();
+    bool updatePan();
+    bool panRect(const QDoubleVector2D &center, QRect *rect) const;
+    void recordPanGeometry(const PolygonVector &footprint);
 
     Frustum createFrustum(double viewExpansion) const;
 
@@ -144,6 +161,12 @@ void QGeoCameraTiles::setCameraData(const QGeoCameraData &camera)
     if (d_ptr->m_camera == camera)
         return;
 
+    // Anything but a change of center needs a new frustum
+    QGeoCameraData panned = d_ptr->m_camera;
+    panned.setCenter(camera.center());
+    if (!(panned == camera))
+        d_ptr->m_dirtyFrustum = true;
+
     d_ptr->m_dirtyGeometry = true;
     d_ptr->m_camera = camera;
     d_ptr->m_intZoomLevel = static_cast<int>(std::floor(d_ptr->m_camera.zoomLevel()));
@@ -161,6 +184,7 @@ void QGeoCameraTiles::setScreenSize(const QSize &size)
         return;
 
     d_ptr->m_dirtyGeometry = true;
+    d_ptr->m_dirtyFrustum = true;
     d_ptr->m_screenSize = size;
 }
 
@@ -202,13 +226,18 @@ void QGeoCameraTiles::setTileSize(int tileSize)
         return;
 
     d_ptr->m_dirtyGeometry = true;
+    d_ptr->m_dirtyFrustum = true;
     d_ptr->m_tileSize = tileSize;
 }
 
 void QGeoCameraTiles::setViewExpansion(double viewExpansion)
 {
+    if (d_ptr->m_viewExpansion == viewExpansion)
+        return;
+
     d_ptr->m_viewExpansion = viewExpansion;
     d_ptr->m_dirtyGeometry = true;
+    d_ptr->m_dirtyFrustum = true;
 }
 
 int QGeoCameraTiles::tileSize() const
@@ -219,19 +248,58 @@ int QGeoCameraTiles::tileSize() const
 const QSet<QGeoTileSpec>& QGeoCameraTiles::createTiles()
 {
     if (d_ptr->m_dirtyGeometry) {
-        d_ptr->m_tiles.clear();
-        d_ptr->updateGeometry();
+        // A pure pan of a camera looking straight down only shifts the
+        // rectangle of tiles, no need to rasterise the footprint again
+        if (d_ptr->m_dirtyFrustum || d_ptr->m_dirtyMetadata || !d_ptr->updatePan()) {
+            d_ptr->m_tiles.clear();
+            d_ptr->updateGeometry();
+            d_ptr->m_hasDelta = false;
+            ++d_ptr->m_generation;
+        }
         d_ptr->m_dirtyGeometry = false;
+        d_ptr->m_dirtyFrustum = false;
     }
 
     if (d_ptr->m_dirtyMetadata) {
         d_ptr->updateMetadata();
         d_ptr->m_dirtyMetadata = false;
+        d_ptr->m_hasDelta = false;
+        ++d_ptr->m_generation;
     }
 
     return d_ptr->m_tiles;
 }
 
+/*
+    Returns a number that changes whenever createTiles() returns a different
+    set of tiles.
+*/
+int QGeoCameraTiles::tilesGeneration() const
+{
+    return d_ptr->m_generation;
+}
+
+/*
+    Returns true if addedTiles() and removedTiles() hold the difference
+    between the tiles of the current generation and those of the previous
+    one. This is the case after a pan of a camera that is neither tilted nor
+    rotated, as long as the view stays clear of the edges of the map.
+*/
+bool QGeoCameraTiles::hasTilesDelta() const
+{
+    return d_ptr->m_hasDelta;
+}
+
+const QSet<QGeoTileSpec> &QGeoCameraTiles::addedTiles() const
+{
+    return d_ptr->m_added;
+}
+
+const QSet<QGeoTileSpec> &QGeoCameraTiles::removedTiles() const
+{
+    return d_ptr->m_removed;
+}
+
 QGeoCameraTilesPrivate::QGeoCameraTilesPrivate()
 :   m_mapVersion(-1),
     m_tileSize(0),
@@ -239,6 +307,10 @@ QGeoCameraTilesPrivate::QGeoCameraTilesPrivate()
     m_sideLength(0),
     m_dirtyGeometry(false),
     m_dirtyMetadata(false),
+    m_dirtyFrustum(false),
+    m_generation(0),
+    m_hasDelta(false),
+    m_panValid(false),
     m_viewExpansion(1.0)
 {
 }
@@ -270,6 +342,7 @@ void QGeoCameraTilesPrivate::updateGeometry()
 
     // Find the polygon where the frustum intersects the plane of the map
     PolygonVector footprint = frustumFootprint(f);
+    m_panValid = false;
 
     // Clip the polygon to the map, split it up if it cross the dateline
     ClippedFootprint polygons = clipFootprintToMap(footprint);
@@ -288,6 +361,114 @@ void QGeoCameraTilesPrivate::updateGeometry()
         QSet<QGeoTileSpec> tilesRight = tilesFromPolygon(polygons.mid);
         m_tiles.unite(tilesRight);
     }
+
+    if (m_camera.tilt() == 0.0 && m_camera.bearing() == 0.0)
+        recordPanGeometry(footprint);
+}
+
+void QGeoCameraTilesPrivate::recordPanGeometry(const PolygonVector &footprint)
+{
+    if (footprint.size() != 4)
+        return;
+
+    double minX = std::numeric_limits<double>::max();
+    double maxX = std::numeric_limits<double>::lowest();
+    double minY = minX;
+    double maxY = maxX;
+    for (const QDoubleVector3D &p : footprint) {
+        minX = qMin(p.x(), minX);
+        maxX = qMax(p.x(), maxX);
+        minY = qMin(p.y(), minY);
+        maxY = qMax(p.y(), maxY);
+    }
+    m_panExtent = QDoubleVector2D((maxX - minX) * 0.5, (maxY - minY) * 0.5);
+
+    // Only trust the rectangle if it gives the tiles the full computation found
+    QRect rect;
+    const QDoubleVector2D center = m_sideLength * QWebMercator::coordToMercator(m_camera.center());
+    if (panRect(center, &rect) && rect.width() * rect.height() == m_tiles.size()) {
+        m_tileRect = rect;
+        m_panValid = true;
+    }
+}
+
+/*
+    Computes in \a rect the tiles covered by the pan footprint around \a
+    center. Returns false when the footprint reaches the edges of the map or
+    when one of its sides is too close to a tile boundary to tell what the
+    full computation would include.
+*/
+bool QGeoCameraTilesPrivate::panRect(const QDoubleVector2D &center, QRect *rect) const
+{
+    // The full computation goes through single precision math
+    const double epsilon = qMax(1e-3, m_sideLength * 4e-7);
+    const double side = m_sideLength;
+    const double bounds[4] = { center.x() - m_panExtent.x(), center.y() - m_panExtent.y(),
+                               center.x() + m_panExtent.x(), center.y() + m_panExtent.y() };
+    if (bounds[0] < epsilon || bounds[1] < epsilon
+            || bounds[2] > side - epsilon || bounds[3] > side - epsilon)
+        return false;
+
+    for (double v : bounds) {
+        const double fraction = v - std::floor(v);
+        if (fraction < epsilon || fraction > 1.0 - epsilon)
+            return false;
+    }
+
+    *rect = QRect(QPoint(int(bounds[0]), int(bounds[1])), QPoint(int(bounds[2]), int(bounds[3])));
+    return true;
+}
+
+// Calls visit(x, y) for every tile in a and not in b
+template <typename Visitor>
+static void forEachTileNotIn(const QRect &a, const QRect &b, Visitor visit)
+{
+    for (int y = a.top(); y <= a.bottom(); ++y) {
+        if (y < b.top() || y > b.bottom()) {
+            for (int x = a.left(); x <= a.right(); ++x)
+                visit(x, y);
+            continue;
+        }
+        for (int x = a.left(); x <= qMin(a.right(), b.left() - 1); ++x)
+            visit(x, y);
+        for (int x = qMax(a.left(), b.right() + 1); x <= a.right(); ++x)
+            visit(x, y);
+    }
+}
+
+bool QGeoCameraTilesPrivate::updatePan()
+{
+    if (!m_panValid)
+        return false;
+
+    QRect rect;
+    const QDoubleVector2D center = m_sideLength * QWebMercator::coordToMercator(m_camera.center());
+    if (!panRect(center, &rect) || rect.size() != m_tileRect.size())
+        return false;
+
+    m_added.clear();
+    m_removed.clear();
+    if (rect == m_tileRect) {
+        m_hasDelta = true;
+        return true;
+    }
+
+    const int mapId = m_mapType.mapId();
+    forEachTileNotIn(m_tileRect, rect, [&](int x, int y) {
+        const QGeoTileSpec spec(m_pluginString, mapId, m_intZoomLevel, x, y, m_mapVersion);
+        m_tiles.remove(spec);
+        m_removed.insert(spec);
+    });
+    forEachTileNotIn(rect, m_tileRect, [&](int x, int y) {
+        const QGeoTileSpec spec(m_pluginString, mapId, m_intZoomLevel, x, y, m_mapVersion);
+        m_tiles.insert(spec);
+        m_added.insert(spec);
+    });
+
+    m_tileRect = rect;
+    m_hasDelta = true;
+    ++m_generation;
+    return true;
 }
 
 Frustum QGeoCameraTilesPrivate::createFrustum(double viewExpansion) const
@@ -75,6 +75,11 @@ public:
     void setMapVersion(int mapVersion);
     const QSet<QGeoTileSpec>& createTiles();
 
+    int tilesGeneration() const;
+    bool hasTilesDelta() const;
+    const QSet<QGeoTileSpec> &addedTiles() const;
+    const QSet<QGeoTileSpec> &removedTiles() const;
+
 protected:
     QScopedPointer<QGeoCameraTilesPrivate> d_ptr;
     Q_DISABLE_COPY(QGeoCameraTiles)
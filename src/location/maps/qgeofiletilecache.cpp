@@ -38,12 +38,21 @@
 #include "qgeotilespec_p.h"
 
 #include "qgeomappingmanager_p.h"
+#include "qgeotilediskstorage_p.h"
 
 #include <QDir>
 #include <QStandardPaths>
 #include <QMetaType>
 #include <QPixmap>
+#include <QPainter>
 #include <QDebug>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 
 Q_DECLARE_METATYPE(QList<QGeoTileSpec>)
 Q_DECLARE_METATYPE(QSet<QGeoTileSpec>)
@@ -65,6 +74,205 @@ public:
     QString format;
 };
 
+/* The disk index is a single file holding the spec, file name, size and 3Q queue
+ * of every tile in the disk cache. It is written atomically on shutdown and
+ * deleted right after being read, so a session that does not terminate cleanly
+ * leaves no index behind and the next one falls back to a directory rescan. */
+static const quint32 tileCacheIndexMagic = 0x51475449; // "QGTI"
+static const quint32 tileCacheIndexVersion = 2;
+
+static QString tileCacheIndexFileName()
+{
+    return QStringLiteral("tilecache.index");
+}
+
+class QGeoFileTileCacheScanner : public QThread
+{
+public:
+    QGeoFileTileCacheScanner(QGeoTileDiskStorage *storage, bool statFiles, QObject *parent)
+        : QThread(parent), complete(false), m_storage(storage), m_statFiles(statFiles)
+    {
+    }
+
+    QVector<QGeoTileDiskStorage::Entry> entries;
+    bool complete;
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        complete = m_storage->list(&entries, m_statFiles);
+    }
+
+private:
+    QGeoTileDiskStorage *m_storage;
+    bool m_statFiles;
+};
+
+/* Reads and decodes tiles on a thread pool for getAsync(). Finished jobs are
+ * queued in results and handed back to the cache thread in batches, with at
+ * most one delivery call in flight at any time. Jobs and the hash tracking
+ * them are only touched from the cache thread; cancelling a job just flags it,
+ * so that workers skip it and its result, if any, gets dropped on delivery. */
+class QGeoFileTileCacheDecoder
+{
+public:
+    enum Status {
+        Decoded,
+        ReadFailed,
+        DecodeFailed
+    };
+
+    struct Result
+    {
+        QGeoTileSpec spec;
+        QSharedPointer<QAtomicInt> token;
+        Status status;
+        bool fromDisk;
+        bool offline; // read from the offline tiles, not from the disk cache
+        qint64 decodeUsecs;
+        QByteArray bytes;
+        QString format;
+        QImage image;
+    };
+
+    QGeoFileTileCacheDecoder(QObject *cache)
+        : m_cache(cache), m_deliveryScheduled(false)
+    {
+        // leave a core to the GUI and one to the render thread when possible
+        m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 2, 4));
+    }
+
+    ~QGeoFileTileCacheDecoder()
+    {
+        for (const QSharedPointer<QAtomicInt> &token : qAsConst(jobs))
+            token->store(1);
+        m_pool.clear();
+        m_pool.waitForDone();
+    }
+
+    void start(const QGeoTileSpec &spec, QGeoTileDiskStorage *storage, const QString &filename,
+               const QByteArray &bytes, const QString &format);
+    void startOffline(const QGeoTileSpec &spec, const QString &filename);
+
+    void post(const Result &result)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_results.append(result);
+        if (!m_deliveryScheduled) {
+            m_deliveryScheduled = true;
+            QMetaObject::invokeMethod(m_cache, "deliverDecodedTiles", Qt::QueuedConnection);
+        }
+    }
+
+    QVector<Result> takeResults()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_deliveryScheduled = false;
+        QVector<Result> results;
+        results.swap(m_results);
+        return results;
+    }
+
+    QHash<QGeoTileSpec, QSharedPointer<QAtomicInt> > jobs;
+
+private:
+    QObject *m_cache;
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QVector<Result> m_results;
+    bool m_deliveryScheduled;
+};
+
+class QGeoFileTileCacheDecodeJob : public QRunnable
+{
+public:
+    QGeoFileTileCacheDecodeJob(QGeoFileTileCacheDecoder *decoder, const QGeoFileTileCacheDecoder::Result &job,
+                               QGeoTileDiskStorage *storage, const QString &filename)
+        : m_decoder(decoder), m_job(job), m_storage(storage), m_filename(filename)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        if (m_job.token->load())
+            return;
+
+        if (m_job.fromDisk && !read()) {
+            m_job.status = QGeoFileTileCacheDecoder::ReadFailed;
+            m_decoder->post(m_job);
+            return;
+        }
+        if (m_job.token->load())
+            return;
+
+        // Bogus tiles fail here as well, and are told apart on delivery
+        QElapsedTimer decodeTimer;
+        decodeTimer.start();
+        if (!m_job.image.loadFromData(m_job.bytes)) {
+            m_job.status = QGeoFileTileCacheDecoder::DecodeFailed;
+            m_decoder->post(m_job);
+            return;
+        }
+
+        // Converting it here, instead of in each QSGTexture::bind()
+        if (m_job.image.format() != QImage::Format_RGB32 && m_job.image.format() != QImage::Format_ARGB32_Premultiplied)
+            m_job.image = m_job.image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        m_job.decodeUsecs = decodeTimer.nsecsElapsed() / 1000;
+
+        m_job.status = QGeoFileTileCacheDecoder::Decoded;
+        m_decoder->post(m_job);
+    }
+
+private:
+    bool read()
+    {
+        if (m_storage)
+            return m_storage->read(m_filename, &m_job.bytes);
+
+        QFile file(m_filename);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        m_job.bytes = file.readAll();
+        return true;
+    }
+
+    QGeoFileTileCacheDecoder *m_decoder;
+    QGeoFileTileCacheDecoder::Result m_job;
+    QGeoTileDiskStorage *m_storage;
+    QString m_filename;
+};
+
+void QGeoFileTileCacheDecoder::start(const QGeoTileSpec &spec, QGeoTileDiskStorage *storage, const QString &filename,
+                                     const QByteArray &bytes, const QString &format)
+{
+    Result job;
+    job.spec = spec;
+    job.token = QSharedPointer<QAtomicInt>::create(0);
+    job.status = Decoded;
+    job.fromDisk = bytes.isEmpty();
+    job.offline = false;
+    job.decodeUsecs = 0;
+    job.bytes = bytes;
+    job.format = format;
+    jobs.insert(spec, job.token);
+    m_pool.start(new QGeoFileTileCacheDecodeJob(this, job, storage, filename));
+}
+
+// Offline tiles are plain files outside of the cache storage
+void QGeoFileTileCacheDecoder::startOffline(const QGeoTileSpec &spec, const QString &filename)
+{
+    Result job;
+    job.spec = spec;
+    job.token = QSharedPointer<QAtomicInt>::create(0);
+    job.status = Decoded;
+    job.fromDisk = true;
+    job.offline = true;
+    job.decodeUsecs = 0;
+    job.format = QFileInfo(filename).suffix();
+    jobs.insert(spec, job.token);
+    m_pool.start(new QGeoFileTileCacheDecodeJob(this, job, 0, filename));
+}
+
 void QCache3QTileEvictionPolicy::aboutToBeRemoved(const QGeoTileSpec &key, QSharedPointer<QGeoCachedTileDisk> obj)
 {
     Q_UNUSED(key);
@@ -89,6 +297,7 @@ QGeoFileTileCache::QGeoFileTileCache(const QString &directory, QObject *parent)
     : QAbstractGeoTileCache(parent), directory_(directory), minTextureUsage_(0), extraTextureUsage_(0)
     ,costStrategyDisk_(ByteSize), costStrategyMemory_(ByteSize), costStrategyTexture_(ByteSize)
     ,isDiskCostSet_(false), isMemoryCostSet_(false), isTextureCostSet_(false)
+    ,diskIndexLoaded_(false), diskCacheComplete_(false), scanner_(0), diskStorage_(0), decoder_(0)
 {
 
 }
@@ -142,97 +351,255 @@ void QGeoFileTileCache::init()
             setExtraTextureUsage(30); // byte size of texture is >> compressed image, hence unitary cost should be lower
     }
 
+    // A shared storage sizes its index for the disk budget when it is opened,
+    // and then enforces it across all processes using it
+    if (!diskStorage_)
+        diskStorage_ = new QGeoTileFileStorage;
+    diskStorage_->setMaxCost(diskCache_.maxCost(), costStrategyDisk_ == ByteSize);
+    if (!diskStorage_->open(directory_))
+        qWarning() << "Unable to open tile cache storage in" << directory_;
+    if (diskStorage_->isShared())
+        diskStorage_->setMaxCost(diskCache_.maxCost(), costStrategyDisk_ == ByteSize);
+
     loadTiles();
 }
 
 void QGeoFileTileCache::loadTiles()
 {
-    QStringList formats;
-    formats << QLatin1String("*.*");
+    if (loadIndex())
+        return;
 
+    // The index is missing, stale or from an older version: rebuild the disk
+    // cache from the directory content without blocking the first frames.
+    startRescan();
+}
+
+bool QGeoFileTileCache::loadIndex()
+{
     QDir dir(directory_);
-    QStringList files = dir.entryList(formats, QDir::Files);
-#if 0 // workaround for QTBUG-60581
-    // Method:
-    // 1. read each queue file then, if each file exists, deserialize the data into the appropriate
-    // cache queue.
-    for (int i = 1; i<=4; i++) {
-        QString filename = dir.filePath(QString::fromLatin1("queue") + QString::number(i));
-        QFile file(filename);
-        if (!file.open(QIODevice::ReadOnly))
-            continue;
-        QList<QSharedPointer<QGeoCachedTileDisk> > queue;
+    const QString indexPath = dir.filePath(tileCacheIndexFileName());
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray data = file.readAll();
+    file.close();
+    // Invalidate the index right away, it gets rewritten on clean shutdown only
+    QFile::remove(indexPath);
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_8);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != tileCacheIndexMagic || version != tileCacheIndexVersion)
+        return false;
+
+    QByteArray metadata;
+    QHash<int, QDateTime> staleBefore;
+    in >> metadata >> staleBefore;
+
+    // Queues are stored from the least to the most valuable one, so that the
+    // rebalancing done while restoring them evicts the right tiles first.
+    static const int queues[] = { 3, 2, 1 };
+    for (int queue : queues) {
+        quint32 count = 0;
+        in >> count;
+        if (in.status() != QDataStream::Ok)
+            break;
+
         QList<QGeoTileSpec> specs;
+        QList<QSharedPointer<QGeoCachedTileDisk> > tiles;
         QList<int> costs;
-        while (!file.atEnd()) {
-            QByteArray line = file.readLine().trimmed();
-            QString filename = QString::fromLatin1(line.constData(), line.length());
-            if (dir.exists(filename)){
-                files.removeOne(filename);
-                QGeoTileSpec spec = filenameToTileSpec(filename);
-                if (spec.zoom() == -1)
-                    continue;
-                QSharedPointer<QGeoCachedTileDisk> tileDisk(new QGeoCachedTileDisk);
-                tileDisk->filename = dir.filePath(filename);
-                tileDisk->cache = this;
-                tileDisk->spec = spec;
-                QFileInfo fi(tileDisk->filename);
-                specs.append(spec);
-                queue.append(tileDisk);
-                if (costStrategyDisk_ == ByteSize)
-                    costs.append(fi.size());
-                else
-                    costs.append(1);
+        for (quint32 i = 0; i < count; ++i) {
+            QString plugin;
+            QString fileName;
+            qint32 mapId, zoom, x, y, tileVersion;
+            qint64 size;
+            QGeoTileValidators validators;
+            in >> plugin >> mapId >> zoom >> x >> y >> tileVersion >> fileName >> size >> validators;
+            if (in.status() != QDataStream::Ok)
+                break;
+
+            const QGeoTileSpec spec(plugin, mapId, zoom, x, y, tileVersion);
+            const QString filename = dir.filePath(fileName);
+            const QString format = fileName.mid(fileName.lastIndexOf(QLatin1Char('.')) + 1);
+            // Drop entries whose name no longer maps to the spec (e.g. the plugin changed naming scheme)
+            if (tileSpecToFilename(spec, format, directory_) != filename)
+                continue;
 
+            QSharedPointer<QGeoCachedTileDisk> td(new QGeoCachedTileDisk);
+            td->spec = spec;
+            td->filename = filename;
+            td->cache = this;
+            td->size = size;
+            td->validators = validators;
+
+            int cost = 1;
+            if (costStrategyDisk_ == ByteSize) {
+                if (td->size < 0)
+                    td->size = diskStorage_->size(filename);
+                cost = td->size;
             }
+            specs.append(spec);
+            tiles.append(td);
+            costs.append(cost);
         }
+        diskCache_.deserializeQueue(queue, specs, tiles, costs);
+    }
 
-        diskCache_.deserializeQueue(i, specs, queue, costs);
-        file.close();
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Corrupted tile cache index in" << directory_ << ", rescanning";
+        diskCache_.clear();
+        return false;
     }
-#endif
-    // 2. remaining tiles that aren't registered in a queue get pushed into cache here
-    // this is a backup, in case the queue manifest files get deleted or out of sync due to
-    // the application not closing down properly
-    for (int i = 0; i < files.size(); ++i) {
-        QGeoTileSpec spec = filenameToTileSpec(files.at(i));
-        if (spec.zoom() == -1)
-            continue;
-        QString filename = dir.filePath(files.at(i));
-        addToDiskCache(spec, filename);
+
+    indexMetadata_ = metadata;
+    staleBefore_ = staleBefore;
+    diskIndexLoaded_ = true;
+    diskCacheComplete_ = true;
+    return true;
+}
+
+void QGeoFileTileCache::saveIndex()
+{
+    QSaveFile file(QDir(directory_).filePath(tileCacheIndexFileName()));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write tile cache index " << file.fileName();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_8);
+    out << tileCacheIndexMagic << tileCacheIndexVersion << indexMetadata_ << staleBefore_;
+
+    static const int queues[] = { 3, 2, 1 };
+    for (int queue : queues) {
+        QList<QSharedPointer<QGeoCachedTileDisk> > tiles;
+        diskCache_.serializeQueue(queue, tiles);
+        out << quint32(tiles.size());
+        for (const QSharedPointer<QGeoCachedTileDisk> &tile : qAsConst(tiles)) {
+            const QGeoTileSpec &spec = tile->spec;
+            // we just want the filename here, not the full path
+            const int index = tile->filename.lastIndexOf(QLatin1Char('/'));
+            out << spec.plugin() << qint32(spec.mapId()) << qint32(spec.zoom())
+                << qint32(spec.x()) << qint32(spec.y()) << qint32(spec.version())
+                << tile->filename.mid(index + 1) << tile->size << tile->validators;
+        }
     }
+
+    if (!file.commit())
+        qWarning() << "Unable to write tile cache index " << file.fileName();
 }
 
-QGeoFileTileCache::~QGeoFileTileCache()
+void QGeoFileTileCache::startRescan()
 {
-#if 0 // workaround for QTBUG-60581
-    // write disk cache queues to disk
+    scanner_ = new QGeoFileTileCacheScanner(diskStorage_, costStrategyDisk_ == ByteSize, this);
+    connect(scanner_, &QThread::finished, this, &QGeoFileTileCache::onRescanFinished);
+    scanner_->start(QThread::LowPriority);
+}
+
+void QGeoFileTileCache::onRescanFinished()
+{
+    if (!scanner_ || !scanner_->isFinished() || !scanner_->complete)
+        return;
+
     QDir dir(directory_);
-    for (int i = 1; i<=4; i++) {
-        QString filename = dir.filePath(QString::fromLatin1("queue") + QString::number(i));
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly)){
-            qWarning() << "Unable to write tile cache file " << filename;
+    for (const QGeoTileDiskStorage::Entry &e : qAsConst(scanner_->entries)) {
+        QGeoTileSpec spec = filenameToTileSpec(e.fileName);
+        // Tiles inserted while the scan was running are already accounted for
+        if (spec.zoom() == -1 || diskCache_.contains(spec))
             continue;
-        }
-        QList<QSharedPointer<QGeoCachedTileDisk> > queue;
-        diskCache_.serializeQueue(i, queue);
-        foreach (const QSharedPointer<QGeoCachedTileDisk> &tile, queue) {
-            if (tile.isNull())
-                continue;
 
-            // we just want the filename here, not the full path
-            int index = tile->filename.lastIndexOf(QLatin1Char('/'));
-            QByteArray filename = tile->filename.mid(index + 1).toLatin1() + '\n';
-            file.write(filename);
+        QSharedPointer<QGeoCachedTileDisk> td(new QGeoCachedTileDisk);
+        td->spec = spec;
+        td->filename = dir.filePath(e.fileName);
+        td->cache = this;
+        td->size = e.size;
+
+        int cost = 1;
+        if (costStrategyDisk_ == ByteSize) {
+            if (td->size < 0)
+                td->size = diskStorage_->size(td->filename);
+            cost = td->size;
         }
-        file.close();
+        diskCache_.insert(spec, td, cost);
+    }
+
+    scanner_->deleteLater();
+    scanner_ = 0;
+    diskCacheComplete_ = true;
+}
+
+QGeoFileTileCache::~QGeoFileTileCache()
+{
+    // Workers may still be reading from the disk storage
+    delete decoder_;
+
+    if (scanner_) {
+        scanner_->requestInterruption();
+        scanner_->wait();
+        // If the scan was cut short the in-memory view of the directory is incomplete, don't persist it
+        if (scanner_->complete)
+            onRescanFinished();
+        else
+            diskCacheComplete_ = false;
+    }
+
+    if (diskCacheComplete_)
+        saveIndex();
+
+    // Detach the cached tiles from the storage before it goes away
+    diskCache_.clear();
+    if (diskStorage_) {
+        diskStorage_->sync();
+        delete diskStorage_;
     }
-#endif
+}
+
+void QGeoFileTileCache::setDiskStorage(QGeoTileDiskStorage *storage)
+{
+    if (diskStorage_ == storage)
+        return;
+    delete diskStorage_;
+    diskStorage_ = storage;
+}
+
+QGeoTileDiskStorage *QGeoFileTileCache::diskStorage() const
+{
+    return diskStorage_;
+}
+
+template <typename Cache>
+static void qgeofiletilecache_tierStatistics(QGeoTileCacheStatistics::TierCounters *tier,
+                                             const Cache &cache)
+{
+    tier->hits = cache.hitCount();
+    tier->misses = cache.missCount();
+    tier->evictions = cache.evictionCount();
+    tier->cost = cache.totalCost();
+    tier->maxCost = cache.maxCost();
+}
+
+QGeoTileCacheStatistics QGeoFileTileCache::statistics() const
+{
+    QGeoTileCacheStatistics stats = QAbstractGeoTileCache::statistics();
+    qgeofiletilecache_tierStatistics(&stats.tiers[QGeoTileCacheStatistics::TextureTier], textureCache_);
+    qgeofiletilecache_tierStatistics(&stats.tiers[QGeoTileCacheStatistics::MemoryTier], memoryCache_);
+    qgeofiletilecache_tierStatistics(&stats.tiers[QGeoTileCacheStatistics::DiskTier], diskCache_);
+    return stats;
+}
+
+void QGeoFileTileCache::resetStatistics()
+{
+    textureCache_.resetCounters();
+    memoryCache_.resetCounters();
+    diskCache_.resetCounters();
+    QAbstractGeoTileCache::resetStatistics();
 }
 
 void QGeoFileTileCache::printStats()
 {
+    qDebug() << statistics().toString();
     textureCache_.printStats();
     memoryCache_.printStats();
     diskCache_.printStats();
@@ -242,6 +609,8 @@ void QGeoFileTileCache::setMaxDiskUsage(int diskUsage)
 {
     diskCache_.setMaxCost(diskUsage);
     isDiskCostSet_ = true;
+    if (diskStorage_ && diskStorage_->isShared())
+        diskStorage_->setMaxCost(diskUsage, costStrategyDisk_ == ByteSize);
 }
 
 int QGeoFileTileCache::maxDiskUsage() const
@@ -251,6 +620,8 @@ int QGeoFileTileCache::maxDiskUsage() const
 
 int QGeoFileTileCache::diskUsage() const
 {
+    if (diskStorage_ && diskStorage_->isShared())
+        return int(diskStorage_->totalCost());
     return diskCache_.totalCost();
 }
 
@@ -301,19 +672,18 @@ int QGeoFileTileCache::textureUsage() const
 
 void QGeoFileTileCache::clearAll()
 {
+    abortDecodes(true);
     textureCache_.clear();
     memoryCache_.clear();
     diskCache_.clear();
-    QDir dir(directory_);
-    dir.setNameFilters(QStringList() << QLatin1String("*-*-*-*.*"));
-    dir.setFilter(QDir::Files);
-    foreach (QString dirFile, dir.entryList()) {
-        dir.remove(dirFile);
-    }
+    if (diskStorage_)
+        diskStorage_->clear();
 }
 
 void QGeoFileTileCache::clearMapId(const int mapId)
 {
+    staleBefore_.remove(mapId);
+    abortDecodes(false, mapId);
     for (const QGeoTileSpec &k : diskCache_.keys())
         if (k.mapId() == mapId)
             diskCache_.remove(k, true);
@@ -327,16 +697,17 @@ void QGeoFileTileCache::clearMapId(const int mapId)
     // TODO: It seems the cache leaves residues, like some tiles do not get picked up.
     // After the above calls, files that shouldnt be left behind are still on disk.
     // Do an additional pass and make sure what has to be deleted gets deleted.
+    if (!diskStorage_)
+        return;
     QDir dir(directory_);
-    QStringList formats;
-    formats << QLatin1String("*.*");
-    QStringList files = dir.entryList(formats, QDir::Files);
+    QVector<QGeoTileDiskStorage::Entry> files;
+    diskStorage_->list(&files, false);
     qWarning() << "Old tile data detected. Cache eviction left out "<< files.size() << "tiles";
-    for (const QString &tileFileName : files) {
-        QGeoTileSpec spec = filenameToTileSpec(tileFileName);
+    for (const QGeoTileDiskStorage::Entry &tileFile : qAsConst(files)) {
+        QGeoTileSpec spec = filenameToTileSpec(tileFile.fileName);
         if (spec.mapId() != mapId)
             continue;
-        QFile::remove(dir.filePath(tileFileName));
+        diskStorage_->remove(dir.filePath(tileFile.fileName));
     }
 }
 
@@ -375,9 +746,282 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::get(const QGeoTileSpec &spec)
     QSharedPointer<QGeoTileTexture> tt = getFromMemory(spec);
     if (tt)
         return tt;
+    if ((tt = getFromOfflineStorage(spec)))
+        return tt;
     return getFromDisk(spec);
 }
 
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getAsync(const QGeoTileSpec &spec, bool *pending)
+{
+    if (pending)
+        *pending = false;
+
+    QSharedPointer<QGeoTileTexture> tt = textureTile(spec);
+    if (tt)
+        recordBytesOut(QGeoTileCacheStatistics::TextureTier, tt->image.sizeInBytes());
+    if (tt || !pending)
+        return tt;
+
+    if (decoder_ && decoder_->jobs.contains(spec)) {
+        *pending = true;
+        return tt;
+    }
+
+    // Same lookup order as get()
+    QSharedPointer<QGeoCachedTileMemory> tm = memoryCache_.object(spec);
+    QString offlineFilename;
+    QSharedPointer<QGeoCachedTileDisk> td;
+    if (!tm) {
+        offlineFilename = offlineTileFilename(spec);
+        if (offlineFilename.isEmpty()) {
+            td = diskTile(spec);
+            if (!td)
+                return tt;
+        }
+    }
+
+    if (!decoder_)
+        decoder_ = new QGeoFileTileCacheDecoder(this);
+    if (!offlineFilename.isEmpty()) {
+        decoder_->startOffline(spec, offlineFilename);
+    } else if (tm) {
+        recordBytesOut(QGeoTileCacheStatistics::MemoryTier, tm->bytes.size());
+        decoder_->start(spec, diskStorage_, QString(), tm->bytes, tm->format);
+    } else {
+        decoder_->start(spec, diskStorage_, td->filename, QByteArray(), QFileInfo(td->filename).suffix());
+    }
+    *pending = true;
+    return tt;
+}
+
+bool QGeoFileTileCache::isCached(const QGeoTileSpec &spec, CacheAreas areas) const
+{
+    if ((areas & DiskCache) && (diskCache_.contains(spec) || !offlineTileFilename(spec).isEmpty()))
+        return true;
+    if ((areas & DiskCache) && diskStorage_ && diskStorage_->isShared()) {
+        QString stem = tileSpecToFilename(spec, QString(), directory_);
+        stem.chop(1);
+        if (!diskStorage_->lookup(stem).isEmpty())
+            return true;
+    }
+    if (!(areas & MemoryCache))
+        return false;
+    if (memoryCache_.contains(spec))
+        return true;
+    const QSharedPointer<QGeoTileTexture> tt = textureCache_.peek(spec);
+    return tt && !tt->provisional;
+}
+
+/*
+    Finds the texture of \a spec in the texture cache, provided it is decoded
+    from the tile itself and has an image, without counting a hit.
+*/
+static QSharedPointer<QGeoTileTexture> qgeofiletilecache_sourceTexture(const QCache3Q<QGeoTileSpec, QGeoTileTexture> &cache,
+                                                                       const QGeoTileSpec &spec)
+{
+    QSharedPointer<QGeoTileTexture> tt = cache.peek(spec);
+    if (tt && (tt->provisional || tt->image.isNull()))
+        tt.clear();
+    return tt;
+}
+
+/*
+    Builds the placeholder from the texture cache only: the four children
+    scaled down if they are all decoded, otherwise the matching region of the
+    nearest decoded ancestor up to four levels up, scaled up, with whichever
+    children there are drawn on top. The result stays in the texture cache,
+    marked provisional, until the tile itself replaces it.
+*/
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::placeholder(const QGeoTileSpec &spec)
+{
+    QSharedPointer<QGeoTileTexture> tt = textureCache_.peek(spec);
+    if (tt)
+        return tt;
+
+    QSharedPointer<QGeoTileTexture> children[4];
+    int childCount = 0;
+    QGeoTileSpec child = spec;
+    child.setZoom(spec.zoom() + 1);
+    for (int i = 0; i < 4; ++i) {
+        child.setX(spec.x() * 2 + (i & 1));
+        child.setY(spec.y() * 2 + (i >> 1));
+        children[i] = qgeofiletilecache_sourceTexture(textureCache_, child);
+        if (children[i])
+            ++childCount;
+    }
+
+    QImage image;
+    if (childCount < 4) {
+        QSharedPointer<QGeoTileTexture> ancestor;
+        int levels = 1;
+        QGeoTileSpec parent = spec;
+        for (; levels <= 4 && levels <= spec.zoom(); ++levels) {
+            parent.setZoom(spec.zoom() - levels);
+            parent.setX(spec.x() >> levels);
+            parent.setY(spec.y() >> levels);
+            ancestor = qgeofiletilecache_sourceTexture(textureCache_, parent);
+            if (ancestor)
+                break;
+        }
+        // Children alone would leave holes
+        if (!ancestor)
+            return tt;
+        const QImage &source = ancestor->image;
+        const int n = 1 << levels;
+        const int w = qMax(1, source.width() / n);
+        const int h = qMax(1, source.height() / n);
+        const QRect region((spec.x() % n) * w, (spec.y() % n) * h, w, h);
+        image = source.copy(region).scaled(source.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (childCount > 0) {
+        if (image.isNull()) {
+            image = QImage(children[0]->image.size(), QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::transparent);
+        } else {
+            image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        const QSizeF quadrant(image.width() / 2.0, image.height() / 2.0);
+        for (int i = 0; i < 4; ++i) {
+            if (!children[i])
+                continue;
+            const QPointF origin((i & 1) * quadrant.width(), (i >> 1) * quadrant.height());
+            painter.drawImage(QRectF(origin, quadrant), children[i]->image);
+        }
+    }
+
+    tt = addToTextureCache(spec, image);
+    tt->provisional = true;
+    return tt;
+}
+
+/*
+    Tiles are stale once the server given expiry has passed, or if they were
+    fetched before the time set with setStaleBefore() for their map id. Tiles
+    cached before validators were kept count as fetched when their file was
+    written, and are revalidated with If-Modified-Since that date.
+*/
+bool QGeoFileTileCache::needsRevalidation(const QGeoTileSpec &spec, QGeoTileValidators *validators) const
+{
+    const QSharedPointer<QGeoCachedTileDisk> td = diskCache_.peek(spec);
+    if (!td)
+        return false;
+
+    QGeoTileValidators v = td->validators;
+    bool stale = v.isExpired();
+    if (!stale) {
+        const QDateTime staleBefore = staleBefore_.value(spec.mapId());
+        if (!staleBefore.isValid())
+            return false;
+        QDateTime fetched = v.fetched;
+        if (!fetched.isValid()) {
+            fetched = diskStorage_->lastModified(td->filename).toUTC();
+            if (!v.canRevalidate())
+                v.lastModified = fetched;
+        }
+        stale = !fetched.isValid() || fetched < staleBefore;
+    }
+    if (stale && validators)
+        *validators = v;
+    return stale;
+}
+
+void QGeoFileTileCache::setTileValidators(const QGeoTileSpec &spec, const QGeoTileValidators &validators)
+{
+    const QSharedPointer<QGeoCachedTileDisk> td = diskCache_.peek(spec);
+    if (td)
+        td->validators = validators;
+}
+
+void QGeoFileTileCache::setStaleBefore(int mapId, const QDateTime &fetched)
+{
+    QDateTime &staleBefore = staleBefore_[mapId];
+    if (!staleBefore.isValid() || fetched > staleBefore)
+        staleBefore = fetched.toUTC();
+}
+
+void QGeoFileTileCache::cancelAsync(const QGeoTileSpec &spec)
+{
+    if (!decoder_)
+        return;
+    QSharedPointer<QAtomicInt> token = decoder_->jobs.take(spec);
+    if (token)
+        token->store(1);
+}
+
+void QGeoFileTileCache::deliverDecodedTiles()
+{
+    if (!decoder_)
+        return;
+
+    QList<QGeoTileSpec> decoded;
+    QList<QGeoTileSpec> failed;
+    const QVector<QGeoFileTileCacheDecoder::Result> results = decoder_->takeResults();
+    for (const QGeoFileTileCacheDecoder::Result &r : results) {
+        auto it = decoder_->jobs.find(r.spec);
+        if (it == decoder_->jobs.end() || it.value() != r.token)
+            continue; // cancelled
+        decoder_->jobs.erase(it);
+
+        switch (r.status) {
+        case QGeoFileTileCacheDecoder::ReadFailed:
+            // The tile went away behind our back (e.g. stale index), forget about it
+            if (!r.offline)
+                diskCache_.remove(r.spec, true);
+            failed.append(r.spec);
+            break;
+        case QGeoFileTileCacheDecoder::DecodeFailed:
+            // Tiles the fetcher flagged as not to be shown count as cached
+            if (isTileBogus(r.bytes)) {
+                decoded.append(r.spec);
+            } else {
+                handleError(r.spec, QLatin1String("Problem with tile image"));
+                failed.append(r.spec);
+            }
+            break;
+        case QGeoFileTileCacheDecoder::Decoded:
+            recordDecodeTime(r.decodeUsecs);
+            if (r.fromDisk) {
+                if (!r.offline)
+                    recordBytesOut(QGeoTileCacheStatistics::DiskTier, r.bytes.size());
+                addToMemoryCache(r.spec, r.bytes, r.format);
+            }
+            addToTextureCache(r.spec, r.image);
+            decoded.append(r.spec);
+            break;
+        }
+    }
+
+    if (!decoded.isEmpty() || !failed.isEmpty())
+        emit tilesDecoded(decoded, failed);
+}
+
+/*
+    Cancels the pending decodes of mapId, or of every map if allMaps is set,
+    and reports them as failed, as the data they were reading is going away.
+*/
+void QGeoFileTileCache::abortDecodes(bool allMaps, int mapId)
+{
+    if (!decoder_)
+        return;
+
+    QList<QGeoTileSpec> aborted;
+    for (auto it = decoder_->jobs.begin(); it != decoder_->jobs.end(); ) {
+        if (allMaps || it.key().mapId() == mapId) {
+            it.value()->store(1);
+            aborted.append(it.key());
+            it = decoder_->jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!aborted.isEmpty())
+        emit tilesDecoded(QList<QGeoTileSpec>(), aborted);
+}
+
 void QGeoFileTileCache::insert(const QGeoTileSpec &spec,
                            const QByteArray &bytes,
                            const QString &format,
@@ -386,6 +1030,9 @@ void QGeoFileTileCache::insert(const QGeoTileSpec &spec,
     if (bytes.isEmpty())
         return;
 
+    // Whatever texture there is for spec, placeholder or outdated tile, is superseded
+    textureCache_.remove(spec);
+
     if (areas & QAbstractGeoTileCache::DiskCache) {
         QString filename = tileSpecToFilename(spec, format, directory_);
         addToDiskCache(spec, filename, bytes);
@@ -430,19 +1077,20 @@ QGeoTileSpec QGeoFileTileCache::filenameToTileSpecDefault(const QString &filenam
 {
     QGeoTileSpec emptySpec;
 
-    QStringList parts = filename.split('.');
+    const QVector<QStringRef> parts = filename.splitRef(QLatin1Char('.'));
 
     if (parts.length() != 2)
         return emptySpec;
 
-    QString name = parts.at(0);
-    QStringList fields = name.split('-');
+    const QVector<QStringRef> fields = parts.at(0).split(QLatin1Char('-'));
 
     int length = fields.length();
     if (length != 5 && length != 6)
         return emptySpec;
 
-    QList<int> numbers;
+    int numbers[5];
+    //File name without version, append default
+    numbers[4] = -1;
 
     bool ok = false;
     for (int i = 1; i < length; ++i) {
@@ -450,24 +1098,22 @@ QGeoTileSpec QGeoFileTileCache::filenameToTileSpecDefault(const QString &filenam
         int value = fields.at(i).toInt(&ok);
         if (!ok)
             return emptySpec;
-        numbers.append(value);
+        numbers[i - 1] = value;
     }
 
-    //File name without version, append default
-    if (numbers.length() < 5)
-        numbers.append(-1);
-
-    return QGeoTileSpec(fields.at(0),
-                    numbers.at(0),
-                    numbers.at(1),
-                    numbers.at(2),
-                    numbers.at(3),
-                    numbers.at(4));
+    return QGeoTileSpec(fields.at(0).toString(),
+                    numbers[0],
+                    numbers[1],
+                    numbers[2],
+                    numbers[3],
+                    numbers[4]);
 }
 
 void QGeoFileTileCache::evictFromDiskCache(QGeoCachedTileDisk *td)
 {
-    QFile::remove(td->filename);
+    // Shared storages evict on their own, the tile may still be used by other processes
+    if (td->cache && td->cache->diskStorage_ && !td->cache->diskStorage_->isShared())
+        td->cache->diskStorage_->remove(td->filename);
 }
 
 void QGeoFileTileCache::evictFromMemoryCache(QGeoCachedTileMemory * /* tm  */)
@@ -483,8 +1129,8 @@ QSharedPointer<QGeoCachedTileDisk> QGeoFileTileCache::addToDiskCache(const QGeoT
 
     int cost = 1;
     if (costStrategyDisk_ == ByteSize) {
-        QFileInfo fi(filename);
-        cost = fi.size();
+        td->size = diskStorage_->size(filename);
+        cost = td->size;
     }
     diskCache_.insert(spec, td, cost);
     return td;
@@ -496,16 +1142,15 @@ bool QGeoFileTileCache::addToDiskCache(const QGeoTileSpec &spec, const QString &
     td->spec = spec;
     td->filename = filename;
     td->cache = this;
+    td->size = bytes.size();
 
     int cost = 1;
     if (costStrategyDisk_ == ByteSize)
         cost = bytes.size();
 
     if (diskCache_.insert(spec, td, cost)) {
-        QFile file(filename);
-        file.open(QIODevice::WriteOnly);
-        file.write(bytes);
-        file.close();
+        diskStorage_->write(filename, bytes);
+        recordBytesIn(QGeoTileCacheStatistics::DiskTier, bytes.size());
         return true;
     }
     return false;
@@ -525,7 +1170,8 @@ void QGeoFileTileCache::addToMemoryCache(const QGeoTileSpec &spec, const QByteAr
     int cost = 1;
     if (costStrategyMemory_ == ByteSize)
         cost = bytes.size();
-    memoryCache_.insert(spec, tm, cost);
+    if (memoryCache_.insert(spec, tm, cost))
+        recordBytesIn(QGeoTileCacheStatistics::MemoryTier, bytes.size());
 }
 
 QSharedPointer<QGeoTileTexture> QGeoFileTileCache::addToTextureCache(const QGeoTileSpec &spec, const QImage &image)
@@ -537,24 +1183,43 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::addToTextureCache(const QGeoT
     int cost = 1;
     if (costStrategyTexture_ == ByteSize)
         cost = image.width() * image.height() * image.depth() / 8;
-    textureCache_.insert(spec, tt, cost);
+    if (textureCache_.insert(spec, tt, cost))
+        recordBytesIn(QGeoTileCacheStatistics::TextureTier, image.sizeInBytes());
 
     return tt;
 }
 
+/*
+    Returns the texture cache entry of \a spec, unless it is only a
+    placeholder.
+*/
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::textureTile(const QGeoTileSpec &spec)
+{
+    const QSharedPointer<QGeoTileTexture> tt = textureCache_.peek(spec);
+    if (tt && tt->provisional)
+        return QSharedPointer<QGeoTileTexture>();
+    return textureCache_.object(spec);
+}
+
 QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromMemory(const QGeoTileSpec &spec)
 {
-    QSharedPointer<QGeoTileTexture> tt = textureCache_.object(spec);
-    if (tt)
+    QSharedPointer<QGeoTileTexture> tt = textureTile(spec);
+    if (tt) {
+        recordBytesOut(QGeoTileCacheStatistics::TextureTier, tt->image.sizeInBytes());
         return tt;
+    }
 
     QSharedPointer<QGeoCachedTileMemory> tm = memoryCache_.object(spec);
     if (tm) {
+        recordBytesOut(QGeoTileCacheStatistics::MemoryTier, tm->bytes.size());
         QImage image;
+        QElapsedTimer decodeTimer;
+        decodeTimer.start();
         if (!image.loadFromData(tm->bytes)) {
             handleError(spec, QLatin1String("Problem with tile image"));
             return QSharedPointer<QGeoTileTexture>(0);
         }
+        recordDecodeTime(decodeTimer.nsecsElapsed() / 1000);
         QSharedPointer<QGeoTileTexture> tt = addToTextureCache(spec, image);
         if (tt)
             return tt;
@@ -562,15 +1227,38 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromMemory(const QGeoTileS
     return QSharedPointer<QGeoTileTexture>();
 }
 
-QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromDisk(const QGeoTileSpec &spec)
+/*
+    Returns the disk cache entry for \a spec. With a shared storage, tiles
+    stored by other processes are added to the disk cache on first use.
+*/
+QSharedPointer<QGeoCachedTileDisk> QGeoFileTileCache::diskTile(const QGeoTileSpec &spec)
 {
     QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
+    if (td || !diskStorage_ || !diskStorage_->isShared())
+        return td;
+
+    QString stem = tileSpecToFilename(spec, QString(), directory_);
+    if (stem.isEmpty())
+        return td;
+    stem.chop(1); // the '.' before the format
+    const QString filename = diskStorage_->lookup(stem);
+    if (filename.isEmpty())
+        return td;
+    return addToDiskCache(spec, filename);
+}
+
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromDisk(const QGeoTileSpec &spec)
+{
+    QSharedPointer<QGeoCachedTileDisk> td = diskTile(spec);
     if (td) {
         const QString format = QFileInfo(td->filename).suffix();
-        QFile file(td->filename);
-        file.open(QIODevice::ReadOnly);
-        QByteArray bytes = file.readAll();
-        file.close();
+        QByteArray bytes;
+        if (!diskStorage_->read(td->filename, &bytes)) {
+            // The tile went away behind our back (e.g. stale index), forget about it
+            diskCache_.remove(spec, true);
+            return QSharedPointer<QGeoTileTexture>();
+        }
+        recordBytesOut(QGeoTileCacheStatistics::DiskTier, bytes.size());
 
         QImage image;
         // Some tiles from the servers could be valid images but the tile fetcher
@@ -584,6 +1272,8 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromDisk(const QGeoTileSpe
         }
 
         // This is a truly invalid image. The fetcher should try again.
+        QElapsedTimer decodeTimer;
+        decodeTimer.start();
         if (!image.loadFromData(bytes)) {
             handleError(spec, QLatin1String("Problem with tile image"));
             return QSharedPointer<QGeoTileTexture>(0);
@@ -592,6 +1282,7 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromDisk(const QGeoTileSpe
         // Converting it here, instead of in each QSGTexture::bind()
         if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
             image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        recordDecodeTime(decodeTimer.nsecsElapsed() / 1000);
 
         addToMemoryCache(spec, bytes, format);
         QSharedPointer<QGeoTileTexture> tt = addToTextureCache(td->spec, image);
@@ -602,6 +1293,46 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromDisk(const QGeoTileSpe
     return QSharedPointer<QGeoTileTexture>();
 }
 
+/*
+    Reads and decodes the offline tile of \a spec, if offlineTileFilename()
+    names one, and keeps it in the memory and texture caches.
+*/
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getFromOfflineStorage(const QGeoTileSpec &spec)
+{
+    const QString fileName = offlineTileFilename(spec);
+    if (fileName.isEmpty())
+        return QSharedPointer<QGeoTileTexture>();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QSharedPointer<QGeoTileTexture>();
+    const QByteArray bytes = file.readAll();
+    file.close();
+
+    QImage image;
+    if (!image.loadFromData(bytes)) {
+        handleError(spec, QLatin1String("Problem with tile image"));
+        return QSharedPointer<QGeoTileTexture>(0);
+    }
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    addToMemoryCache(spec, bytes, QFileInfo(fileName).suffix());
+    return addToTextureCache(spec, image);
+}
+
+/*
+    Returns the file of a tile shipped outside of the cache, such as a
+    preloaded offline tile, or an empty string if there is none. It is looked
+    up after the memory cache and before the disk cache, and may be called
+    from the cache thread only.
+*/
+QString QGeoFileTileCache::offlineTileFilename(const QGeoTileSpec &spec) const
+{
+    Q_UNUSED(spec)
+    return QString();
+}
+
 bool QGeoFileTileCache::isTileBogus(const QByteArray &bytes) const
 {
     if (bytes.size() == 7 && bytes == QByteArrayLiteral("NoRetry"))
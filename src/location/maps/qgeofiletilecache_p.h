@@ -69,6 +69,9 @@ class QGeoMappingManager;
 class QGeoTile;
 class QGeoCachedTileMemory;
 class QGeoFileTileCache;
+class QGeoFileTileCacheScanner;
+class QGeoFileTileCacheDecoder;
+class QGeoTileDiskStorage;
 
 class QPixmap;
 class QThread;
@@ -83,6 +86,8 @@ public:
     QGeoTileSpec spec;
     QString filename;
     QString format;
+    qint64 size = -1; // bytes on disk, -1 if unknown
+    QGeoTileValidators validators;
     QGeoFileTileCache *cache;
 };
 
@@ -126,16 +131,31 @@ public:
 
 
     QSharedPointer<QGeoTileTexture> get(const QGeoTileSpec &spec) Q_DECL_OVERRIDE;
+    QSharedPointer<QGeoTileTexture> getAsync(const QGeoTileSpec &spec, bool *pending) Q_DECL_OVERRIDE;
+    void cancelAsync(const QGeoTileSpec &spec) Q_DECL_OVERRIDE;
+    QSharedPointer<QGeoTileTexture> placeholder(const QGeoTileSpec &spec) Q_DECL_OVERRIDE;
+    bool isCached(const QGeoTileSpec &spec, CacheAreas areas = AllCaches) const Q_DECL_OVERRIDE;
+
+    bool needsRevalidation(const QGeoTileSpec &spec, QGeoTileValidators *validators) const Q_DECL_OVERRIDE;
+    void setTileValidators(const QGeoTileSpec &spec, const QGeoTileValidators &validators) Q_DECL_OVERRIDE;
+    void setStaleBefore(int mapId, const QDateTime &fetched) Q_DECL_OVERRIDE;
 
     // can be called without a specific tileCache pointer
     static void evictFromDiskCache(QGeoCachedTileDisk *td);
     static void evictFromMemoryCache(QGeoCachedTileMemory *tm);
 
+    QGeoTileCacheStatistics statistics() const Q_DECL_OVERRIDE;
+    void resetStatistics() Q_DECL_OVERRIDE;
+
     void insert(const QGeoTileSpec &spec,
                 const QByteArray &bytes,
                 const QString &format,
                 QAbstractGeoTileCache::CacheAreas areas = QAbstractGeoTileCache::AllCaches) Q_DECL_OVERRIDE;
 
+    // Takes ownership of storage. Must be called before init(), defaults to one file per tile.
+    void setDiskStorage(QGeoTileDiskStorage *storage);
+    QGeoTileDiskStorage *diskStorage() const;
+
     static QString tileSpecToFilenameDefault(const QGeoTileSpec &spec, const QString &format, const QString &directory);
     static QGeoTileSpec filenameToTileSpecDefault(const QString &filename);
 
@@ -143,6 +163,9 @@ protected:
     void init() Q_DECL_OVERRIDE;
     void printStats() Q_DECL_OVERRIDE;
     void loadTiles();
+    bool loadIndex();
+    void saveIndex();
+    void startRescan();
 
     QString directory() const;
 
@@ -150,10 +173,14 @@ protected:
     bool addToDiskCache(const QGeoTileSpec &spec, const QString &filename, const QByteArray &bytes);
     void addToMemoryCache(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
     QSharedPointer<QGeoTileTexture> addToTextureCache(const QGeoTileSpec &spec, const QImage &image);
+    QSharedPointer<QGeoTileTexture> textureTile(const QGeoTileSpec &spec);
     QSharedPointer<QGeoTileTexture> getFromMemory(const QGeoTileSpec &spec);
     QSharedPointer<QGeoTileTexture> getFromDisk(const QGeoTileSpec &spec);
+    QSharedPointer<QGeoTileTexture> getFromOfflineStorage(const QGeoTileSpec &spec);
+    QSharedPointer<QGeoCachedTileDisk> diskTile(const QGeoTileSpec &spec);
 
     virtual bool isTileBogus(const QByteArray &bytes) const;
+    virtual QString offlineTileFilename(const QGeoTileSpec &spec) const;
     virtual QString tileSpecToFilename(const QGeoTileSpec &spec, const QString &format, const QString &directory) const;
     virtual QGeoTileSpec filenameToTileSpec(const QString &filename) const;
 
@@ -171,6 +198,25 @@ protected:
     bool isDiskCostSet_;
     bool isMemoryCostSet_;
     bool isTextureCostSet_;
+
+    // true if diskCache_ and indexMetadata_ were restored from the on-disk index in init()
+    bool diskIndexLoaded_;
+    // opaque subclass data persisted alongside the disk index
+    QByteArray indexMetadata_;
+    // tiles of a map id fetched before that time need revalidation, persisted in the index
+    QHash<int, QDateTime> staleBefore_;
+
+private Q_SLOTS:
+    void onRescanFinished();
+    void deliverDecodedTiles();
+
+private:
+    void abortDecodes(bool allMaps, int mapId = -1);
+
+    bool diskCacheComplete_;
+    QGeoFileTileCacheScanner *scanner_;
+    QGeoTileDiskStorage *diskStorage_;
+    QGeoFileTileCacheDecoder *decoder_;
 };
 
 QT_END_NAMESPACE
@@ -162,6 +162,12 @@ void QGeoMap::prefetchData()
 
 }
 
+void QGeoMap::prefetchCameraPath(const QGeoCameraData &destination, int msecs)
+{
+    Q_UNUSED(destination);
+    Q_UNUSED(msecs);
+}
+
 void QGeoMap::clearData()
 {
 
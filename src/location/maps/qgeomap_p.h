@@ -110,6 +110,8 @@ public:
     const QGeoProjection &geoProjection() const;
 
     virtual void prefetchData();
+    // hints that the camera will reach destination in msecs, e.g. at the end of a flick
+    virtual void prefetchCameraPath(const QGeoCameraData &destination, int msecs);
     virtual void clearData();
 
     void addParameter(QGeoMapParameter *param);
@@ -73,6 +73,11 @@ QGeoProjection::~QGeoProjection()
 
 }
 
+QGeoProjection *QGeoProjection::clone() const
+{
+    return 0;
+}
+
 QGeoCoordinate QGeoProjection::anchorCoordinateToPoint(const QGeoCoordinate &coordinate, const QPointF &anchorPoint) const
 {
     // Approach: find the displacement in (wrapped) mercator space, and apply that to the center
@@ -115,6 +120,19 @@ QGeoProjectionWebMercator::~QGeoProjectionWebMercator()
 
 }
 
+QGeoProjection *QGeoProjectionWebMercator::clone() const
+{
+    // Everything else is derived from the viewport size and the camera
+    QGeoProjectionWebMercator *projection = new QGeoProjectionWebMercator;
+    projection->setViewportSize(QSize(qRound(m_viewportWidth), qRound(m_viewportHeight)));
+    projection->setCameraData(m_cameraData);
+    // Resolve the lazily computed regions now, so the copy is never written to
+    // by its const accessors
+    if (projection->m_visibleRegionDirty)
+        projection->updateVisibleRegion();
+    return projection;
+}
+
 // This method returns the minimum zoom level that this specific qgeomap type allows
 // at the current viewport size and for the default tile size of 256^2.
 double QGeoProjectionWebMercator::minimumZoom() const
@@ -60,6 +60,10 @@ public:
     QGeoProjection();
     virtual ~QGeoProjection();
 
+    // Returns an independent copy that can be used from another thread, or 0
+    // if the projection cannot be copied
+    virtual QGeoProjection *clone() const;
+
     virtual void setViewportSize(const QSize &size) = 0;
     virtual void setCameraData(const QGeoCameraData &cameraData) = 0;
 
@@ -106,6 +110,8 @@ public:
     QGeoProjectionWebMercator();
     ~QGeoProjectionWebMercator();
 
+    QGeoProjection *clone() const Q_DECL_OVERRIDE;
+
     double minimumZoom() const Q_DECL_OVERRIDE;
     double maximumCenterLatitudeAtZoom(const QGeoCameraData &cameraData) const Q_DECL_OVERRIDE;
 
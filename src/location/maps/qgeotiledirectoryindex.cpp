@@ -0,0 +1,211 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotiledirectoryindex_p.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 tileDirectoryIndexMagic = 0x51475444; // "QGTD"
+static const quint32 tileDirectoryIndexVersion = 1;
+
+static inline bool canceled(const QAtomicInt *cancel)
+{
+    return cancel && cancel->load();
+}
+
+static qint64 modificationTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+QGeoTileDirectoryIndex::QGeoTileDirectoryIndex()
+    : loaded_(false)
+{
+}
+
+bool QGeoTileDirectoryIndex::build(const QString &directory, const QString &indexFile, const QAtomicInt *cancel)
+{
+    if (load(directory, indexFile, cancel))
+        return true;
+    if (!scan(directory, cancel))
+        return false;
+    if (!indexFile.isEmpty())
+        save(indexFile);
+    return true;
+}
+
+/*
+    Walks \a directory once, recording the newest file of each name and the
+    modification time of each directory. Returns false if \a cancel got set.
+*/
+bool QGeoTileDirectoryIndex::scan(const QString &directory, const QAtomicInt *cancel)
+{
+    directory_ = directory;
+    directoryTimes_.clear();
+    entries_.clear();
+    loaded_ = false;
+
+    directoryTimes_.insert(directory, modificationTime(QFileInfo(directory)));
+
+    QHash<QString, int> byName;
+    QDirIterator it(directory, QStringList() << QStringLiteral("*.*"),
+                    QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (canceled(cancel))
+            return false;
+
+        const QFileInfo info = it.fileInfo();
+        if (info.isDir()) {
+            directoryTimes_.insert(path, modificationTime(info));
+            continue;
+        }
+
+        const QString name = it.fileName();
+        QHash<QString, int>::const_iterator known = byName.constFind(name);
+        if (known == byName.constEnd()) {
+            byName.insert(name, entries_.size());
+            const Entry entry = { name, path };
+            entries_.append(entry);
+        } else if (QFileInfo(path).lastModified() > QFileInfo(entries_.at(*known).filePath).lastModified()) {
+            // Duplicates: picking the newest
+            entries_[*known].filePath = path;
+        }
+    }
+    return true;
+}
+
+/*
+    Reads the index persisted in \a indexFile. Fails if it was made for
+    another directory, or if any directory of the tree was added, removed or
+    modified since.
+*/
+bool QGeoTileDirectoryIndex::load(const QString &directory, const QString &indexFile, const QAtomicInt *cancel)
+{
+    loaded_ = false;
+    QFile file(indexFile);
+    if (indexFile.isEmpty() || !file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray data = file.readAll();
+    file.close();
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_8);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString storedDirectory;
+    in >> magic >> version >> storedDirectory;
+    if (in.status() != QDataStream::Ok || magic != tileDirectoryIndexMagic
+            || version != tileDirectoryIndexVersion || storedDirectory != directory) {
+        return false;
+    }
+
+    QHash<QString, qint64> storedTimes;
+    in >> storedTimes;
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    QHash<QString, qint64> times;
+    if (!readDirectoryTimes(directory, &times, cancel) || times != storedTimes)
+        return false;
+
+    quint32 count = 0;
+    in >> count;
+    QVector<Entry> entries;
+    entries.reserve(int(qMin<quint32>(count, 1 << 24)));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Entry entry;
+        in >> entry.fileName >> entry.filePath;
+        entries.append(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Corrupted tile directory index" << indexFile;
+        return false;
+    }
+
+    directory_ = directory;
+    directoryTimes_ = times;
+    entries_.swap(entries);
+    loaded_ = true;
+    return true;
+}
+
+bool QGeoTileDirectoryIndex::save(const QString &indexFile) const
+{
+    QSaveFile file(indexFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write tile directory index" << indexFile;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_8);
+    out << tileDirectoryIndexMagic << tileDirectoryIndexVersion << directory_ << directoryTimes_;
+    out << quint32(entries_.size());
+    for (const Entry &entry : entries_)
+        out << entry.fileName << entry.filePath;
+    return file.commit();
+}
+
+bool QGeoTileDirectoryIndex::readDirectoryTimes(const QString &directory, QHash<QString, qint64> *times,
+                                                const QAtomicInt *cancel)
+{
+    const QFileInfo root(directory);
+    if (!root.isDir())
+        return false;
+    times->insert(directory, modificationTime(root));
+
+    QDirIterator it(directory, QDir::AllDirs | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (canceled(cancel))
+            return false;
+        times->insert(path, modificationTime(it.fileInfo()));
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
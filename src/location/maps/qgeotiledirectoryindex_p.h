@@ -1,6 +1,6 @@
 /****************************************************************************
 **
-** Copyright (C) 2015 The Qt Company Ltd.
+** Copyright (C) 2018 The Qt Company Ltd.
 ** Contact: http://www.qt.io/licensing/
 **
 ** This file is part of the QtLocation module of the Qt Toolkit.
@@ -33,8 +33,8 @@
 ** $QT_END_LICENSE$
 **
 ****************************************************************************/
-#ifndef QGEOTILESPEC_P_H
-#define QGEOTILESPEC_P_H
+#ifndef QGEOTILEDIRECTORYINDEX_P_H
+#define QGEOTILEDIRECTORYINDEX_P_H
 
 //
 //  W A R N I N G
@@ -47,32 +47,61 @@
 // We mean it.
 //
 
+#include <QtLocation/private/qlocationglobal_p.h>
+
+#include <QAtomicInt>
+#include <QHash>
 #include <QString>
-#include <QSharedData>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 
-class QGeoTileSpecPrivate : public QSharedData
+/*
+ * QGeoTileDirectoryIndex
+ *
+ * Lists the tile files found anywhere under a directory tree, such as a set
+ * of offline tiles, keeping the most recently modified file when a name
+ * appears in several places. The scan only reads directory listings: files
+ * are stat'ed only to settle such duplicates.
+ *
+ * The result can be persisted along with the modification time of every
+ * directory of the tree. Adding, removing or renaming files changes the
+ * time of their directory, so checking these is enough to reuse the index
+ * instead of scanning again; files overwritten in place go unnoticed.
+ */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileDirectoryIndex
 {
 public:
-    QGeoTileSpecPrivate();
-    QGeoTileSpecPrivate(const QGeoTileSpecPrivate &other);
-    QGeoTileSpecPrivate(const QString &plugin, int mapId, int zoom, int x, int y, int version);
-    ~QGeoTileSpecPrivate();
+    struct Entry
+    {
+        QString fileName;
+        QString filePath;
+    };
+
+    QGeoTileDirectoryIndex();
+
+    // Loads the index persisted in indexFile if it is still valid for
+    // directory, otherwise scans directory and persists the result
+    bool build(const QString &directory, const QString &indexFile, const QAtomicInt *cancel = 0);
+
+    bool scan(const QString &directory, const QAtomicInt *cancel = 0);
+    bool load(const QString &directory, const QString &indexFile, const QAtomicInt *cancel = 0);
+    bool save(const QString &indexFile) const;
 
-    QGeoTileSpecPrivate &operator = (const QGeoTileSpecPrivate &other);
+    QString directory() const { return directory_; }
+    const QVector<Entry> &entries() const { return entries_; }
+    bool isLoaded() const { return loaded_; }
 
-    bool operator == (const QGeoTileSpecPrivate &rhs) const;
-    bool operator < (const QGeoTileSpecPrivate &rhs) const;
+private:
+    static bool readDirectoryTimes(const QString &directory, QHash<QString, qint64> *times,
+                                   const QAtomicInt *cancel);
 
-    QString plugin_;
-    int mapId_;
-    int zoom_;
-    int x_;
-    int y_;
-    int version_;
+    QString directory_;
+    QHash<QString, qint64> directoryTimes_;   // last modification, in ms since the epoch
+    QVector<Entry> entries_;
+    bool loaded_;
 };
 
 QT_END_NAMESPACE
 
-#endif // QGEOTILESPEC_P_H
+#endif // QGEOTILEDIRECTORYINDEX_P_H
@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilediskstorage_p.h"
+#include "qgeotilepackstorage_p.h"
+#include "qgeotilesharedstorage_p.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+QT_BEGIN_NAMESPACE
+
+QGeoTileDiskStorage::~QGeoTileDiskStorage()
+{
+}
+
+void QGeoTileDiskStorage::sync()
+{
+}
+
+bool QGeoTileDiskStorage::isShared() const
+{
+    return false;
+}
+
+/*
+    Returns the file name of the tile stored as \a baseName plus a format
+    suffix, or an empty string if another process did not store it.
+*/
+QString QGeoTileDiskStorage::lookup(const QString &baseName)
+{
+    Q_UNUSED(baseName)
+    return QString();
+}
+
+void QGeoTileDiskStorage::setMaxCost(qint64 maxCost, bool byteSize)
+{
+    Q_UNUSED(maxCost)
+    Q_UNUSED(byteSize)
+}
+
+/* Returns the cost of all stored tiles, or -1 if the storage does not track it. */
+qint64 QGeoTileDiskStorage::totalCost()
+{
+    return -1;
+}
+
+/*
+    Returns a new storage for \a type, which is either "files" (the default),
+    "pack" or "shared". Unknown types fall back to "files".
+*/
+QGeoTileDiskStorage *QGeoTileDiskStorage::create(const QString &type)
+{
+    if (type.compare(QLatin1String("pack"), Qt::CaseInsensitive) == 0)
+        return new QGeoTilePackStorage;
+#if QT_CONFIG(sharedmemory)
+    if (type.compare(QLatin1String("shared"), Qt::CaseInsensitive) == 0)
+        return new QGeoTileSharedStorage;
+#endif
+    return new QGeoTileFileStorage;
+}
+
+bool QGeoTileFileStorage::open(const QString &directory)
+{
+    m_directory = directory;
+    return QDir::root().mkpath(directory);
+}
+
+bool QGeoTileFileStorage::write(const QString &filename, const QByteArray &bytes)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    const bool ok = file.write(bytes) == bytes.size();
+    file.close();
+    return ok;
+}
+
+bool QGeoTileFileStorage::read(const QString &filename, QByteArray *bytes)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    *bytes = file.readAll();
+    file.close();
+    return true;
+}
+
+qint64 QGeoTileFileStorage::size(const QString &filename)
+{
+    return QFileInfo(filename).size();
+}
+
+QDateTime QGeoTileFileStorage::lastModified(const QString &filename)
+{
+    return QFileInfo(filename).lastModified();
+}
+
+void QGeoTileFileStorage::remove(const QString &filename)
+{
+    QFile::remove(filename);
+}
+
+void QGeoTileFileStorage::clear()
+{
+    QDir dir(m_directory);
+    dir.setNameFilters(QStringList() << QLatin1String("*-*-*-*.*"));
+    dir.setFilter(QDir::Files);
+    foreach (QString dirFile, dir.entryList()) {
+        dir.remove(dirFile);
+    }
+}
+
+bool QGeoTileFileStorage::list(QVector<Entry> *entries, bool withSizes)
+{
+    QThread *thread = QThread::currentThread();
+    QDirIterator it(m_directory, QDir::Files);
+    while (it.hasNext()) {
+        if (thread->isInterruptionRequested())
+            return false;
+        it.next();
+        Entry e;
+        e.fileName = it.fileName();
+        e.size = withSizes ? it.fileInfo().size() : -1;
+        entries->append(e);
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
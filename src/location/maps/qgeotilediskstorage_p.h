@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEDISKSTORAGE_P_H
+#define QGEOTILEDISKSTORAGE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/private/qlocationglobal_p.h>
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QDateTime>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * QGeoTileDiskStorage
+ *
+ * Backend used by QGeoFileTileCache to persist the content of its disk cache.
+ * Tiles are addressed by the file path produced by
+ * QGeoFileTileCache::tileSpecToFilename(), which backends are free to map to
+ * whatever layout they use.
+ *
+ * list() can be called from a worker thread, and should return false as soon
+ * as QThread::currentThread()->isInterruptionRequested().
+ *
+ * Shared backends are used by several processes at once. They keep their own
+ * account of the disk usage, evict tiles themselves once setMaxCost() is
+ * exceeded, and can find tiles written by other processes with lookup().
+ */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileDiskStorage
+{
+public:
+    struct Entry
+    {
+        QString fileName; // relative to the storage directory
+        qint64 size;      // -1 if not requested
+    };
+
+    virtual ~QGeoTileDiskStorage();
+
+    virtual bool open(const QString &directory) = 0;
+    virtual bool write(const QString &filename, const QByteArray &bytes) = 0;
+    virtual bool read(const QString &filename, QByteArray *bytes) = 0;
+    virtual qint64 size(const QString &filename) = 0;
+    virtual QDateTime lastModified(const QString &filename) = 0;
+    virtual void remove(const QString &filename) = 0;
+    virtual void clear() = 0;
+    virtual bool list(QVector<Entry> *entries, bool withSizes) = 0;
+    virtual void sync();
+
+    virtual bool isShared() const;
+    virtual QString lookup(const QString &baseName);
+    virtual void setMaxCost(qint64 maxCost, bool byteSize);
+    virtual qint64 totalCost();
+
+    static QGeoTileDiskStorage *create(const QString &type);
+};
+
+/* One file per tile, named after the tile spec. This is the default. */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileFileStorage : public QGeoTileDiskStorage
+{
+public:
+    bool open(const QString &directory) Q_DECL_OVERRIDE;
+    bool write(const QString &filename, const QByteArray &bytes) Q_DECL_OVERRIDE;
+    bool read(const QString &filename, QByteArray *bytes) Q_DECL_OVERRIDE;
+    qint64 size(const QString &filename) Q_DECL_OVERRIDE;
+    QDateTime lastModified(const QString &filename) Q_DECL_OVERRIDE;
+    void remove(const QString &filename) Q_DECL_OVERRIDE;
+    void clear() Q_DECL_OVERRIDE;
+    bool list(QVector<Entry> *entries, bool withSizes) Q_DECL_OVERRIDE;
+
+private:
+    QString m_directory;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEDISKSTORAGE_P_H
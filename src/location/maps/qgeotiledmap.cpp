@@ -45,10 +45,17 @@
 #include "qgeotilerequestmanager_p.h"
 #include "qgeotiledmapscene_p.h"
 #include "qgeocameracapabilities_p.h"
+#include "qgeotilefetcher_p.h"
 #include <cmath>
 
 QT_BEGIN_NAMESPACE
 #define PREFETCH_FRUSTUM_SCALE 2.0
+// Points sampled along a predicted camera path, the last one being its destination
+#define PREDICTION_PATH_SAMPLES 4
+// Assumed tile round trip, until the cache has measured some
+#define PREDICTION_DEFAULT_LATENCY_MSECS 300
+// Predicted tiles stay requested this long after the camera should have arrived
+#define PREDICTION_SLACK_MSECS 250
 
 static const double invLog2 = 1.0 / std::log(2.0);
 
@@ -136,6 +143,12 @@ void QGeoTiledMap::prefetchData()
     d->prefetchTiles();
 }
 
+void QGeoTiledMap::prefetchCameraPath(const QGeoCameraData &destination, int msecs)
+{
+    Q_D(QGeoTiledMap);
+    d->prefetchCameraPath(destination, msecs);
+}
+
 void QGeoTiledMap::clearData()
 {
     Q_D(QGeoTiledMap);
@@ -183,6 +196,7 @@ QGeoTiledMapPrivate::QGeoTiledMapPrivate(QGeoTiledMappingManagerEngine *engine)
       m_prefetchTiles(new QGeoCameraTiles()),
       m_mapScene(new QGeoTiledMapScene()),
       m_tileRequests(0),
+      m_sceneTilesGeneration(-1),
       m_maxZoomLevel(static_cast<int>(std::ceil(m_cameraCapabilities.maximumZoomLevel()))),
       m_minZoomLevel(static_cast<int>(std::ceil(m_cameraCapabilities.minimumZoomLevel()))),
       m_prefetchStyle(QGeoTiledMap::PrefetchTwoNeighbourLayers)
@@ -210,6 +224,11 @@ QGeoTiledMapPrivate::~QGeoTiledMapPrivate()
 
 void QGeoTiledMapPrivate::prefetchTiles()
 {
+    // the camera came to rest, whatever was predicted for it
+    m_predictedTiles.clear();
+    if (m_tileRequests)
+        m_tileRequests->setPredictedTiles(m_predictedTiles);
+
     if (m_tileRequests && m_prefetchStyle != QGeoTiledMap::NoPrefetching) {
 
         QSet<QGeoTileSpec> tiles;
@@ -237,7 +256,8 @@ void QGeoTiledMapPrivate::prefetchTiles()
         }
             break;
 
-        case QGeoTiledMap::PrefetchTwoNeighbourLayers: {
+        case QGeoTiledMap::PrefetchTwoNeighbourLayers:
+        case QGeoTiledMap::PrefetchPredictive: {
             // This is a simpler strategy, we just prefetch from layer above and below
             // for the layer below we only use half the size as this fills the screen
             if (currentIntZoom > m_minZoomLevel) {
@@ -260,10 +280,85 @@ void QGeoTiledMapPrivate::prefetchTiles()
             break;
         }
 
+        m_tileRequests->setViewport(QWebMercator::coordToMercator(m_visibleTiles->cameraData().center()),
+                                    m_visibleTiles->createTiles());
         m_tileRequests->requestTiles(tiles - m_mapScene->texturedTiles());
     }
 }
 
+/*
+    Requests the tiles the camera is expected to show on its way to
+    \a destination, which it reaches in \a msecs decelerating like a flick.
+    The destination tiles come first, then the ones along the path in the order
+    the camera reaches them, as far as the fetcher can deliver them in time at
+    the median round trip measured by the cache.
+*/
+void QGeoTiledMapPrivate::prefetchCameraPath(const QGeoCameraData &destination, int msecs)
+{
+    if (!m_tileRequests || m_prefetchStyle != QGeoTiledMap::PrefetchPredictive)
+        return;
+
+    const QGeoCameraData start = m_visibleTiles->cameraData();
+    QGeoCameraData target = destination;
+    if (m_visibleTiles->tileSize() != 256)
+        target.setZoomLevel(zoomLevelFrom256(target.zoomLevel(), m_visibleTiles->tileSize()));
+    msecs = qMax(0, msecs);
+
+    qint64 latency = PREDICTION_DEFAULT_LATENCY_MSECS;
+    if (m_cache) {
+        const QGeoTileLatencyHistogram fetchTime = m_cache->statistics().fetchTime;
+        if (fetchTime.count() > 0)
+            latency = qMax<qint64>(1, fetchTime.percentileUsecs(0.5) / 1000);
+    }
+    int parallelRequests = 1;
+    QGeoTiledMappingManagerEngine *engine = qobject_cast<QGeoTiledMappingManagerEngine *>(m_engine);
+    if (engine && engine->tileFetcher())
+        parallelRequests = engine->tileFetcher()->maxRequestsPerHost();
+    const int budget = parallelRequests * qMax<qint64>(1, msecs / latency);
+
+    // mercator path, the short way across the dateline
+    const QDoubleVector2D from = QWebMercator::coordToMercator(start.center());
+    QDoubleVector2D to = QWebMercator::coordToMercator(target.center());
+    if (to.x() - from.x() > 0.5)
+        to.setX(to.x() - 1.0);
+    else if (to.x() - from.x() < -0.5)
+        to.setX(to.x() + 1.0);
+
+    const QSet<QGeoTileSpec> visible = m_visibleTiles->createTiles();
+    QHash<QGeoTileSpec, int> ranked;
+
+    // the destination always, then the path in the order the camera gets there
+    m_prefetchTiles->setViewExpansion(1.0);
+    for (int i = 0; i < PREDICTION_PATH_SAMPLES; ++i) {
+        QGeoCameraData camera = target;
+        if (i > 0) {
+            const double t = double(i) / PREDICTION_PATH_SAMPLES;
+            // the camera passes here before the tiles could arrive
+            if (msecs * t < latency)
+                continue;
+            // position along the OutQuad easing of a flick
+            const double f = 1.0 - (1.0 - t) * (1.0 - t);
+            QDoubleVector2D p = from + (to - from) * f;
+            p.setX(p.x() - std::floor(p.x()));
+            camera.setCenter(QWebMercator::mercatorToCoord(p));
+            camera.setZoomLevel(start.zoomLevel() + (target.zoomLevel() - start.zoomLevel()) * f);
+        }
+        m_prefetchTiles->setCameraData(camera);
+
+        const QSet<QGeoTileSpec> tiles = m_prefetchTiles->createTiles();
+        for (const QGeoTileSpec &tile : tiles) {
+            if (i > 0 && ranked.size() >= budget)
+                break;
+            if (!visible.contains(tile) && !ranked.contains(tile))
+                ranked.insert(tile, i);
+        }
+    }
+
+    m_predictedTiles = ranked;
+    m_predictionDeadline.setRemainingTime(msecs + PREDICTION_SLACK_MSECS);
+    updateScene();
+}
+
 QGeoMapType QGeoTiledMapPrivate::activeMapType()
 {
     return m_visibleTiles->activeMapType();
@@ -327,23 +422,56 @@ void QGeoTiledMapPrivate::updateScene()
     Q_Q(QGeoTiledMap);
     // detect if new tiles introduced
     const QSet<QGeoTileSpec>& tiles = m_visibleTiles->createTiles();
-    bool newTilesIntroduced = !m_mapScene->visibleTiles().contains(tiles);
-    m_mapScene->setVisibleTiles(tiles);
+    const int generation = m_visibleTiles->tilesGeneration();
+    bool newTilesIntroduced;
+    if (generation == m_sceneTilesGeneration) {
+        newTilesIntroduced = false;
+        m_mapScene->setVisibleTiles(tiles, QSet<QGeoTileSpec>());
+    } else if (generation == m_sceneTilesGeneration + 1 && m_visibleTiles->hasTilesDelta()) {
+        newTilesIntroduced = !m_visibleTiles->addedTiles().isEmpty();
+        m_mapScene->setVisibleTiles(tiles, m_visibleTiles->removedTiles());
+    } else {
+        newTilesIntroduced = !m_mapScene->visibleTiles().contains(tiles);
+        m_mapScene->setVisibleTiles(tiles);
+    }
+    m_sceneTilesGeneration = generation;
 
     if (newTilesIntroduced && m_copyrightVisible)
         q->evaluateCopyrights(tiles);
 
     // don't request tiles that are already built and textured
+    m_tileRequests->setViewport(QWebMercator::coordToMercator(m_visibleTiles->cameraData().center()), tiles);
     QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > cachedTiles =
-            m_tileRequests->requestTiles(m_visibleTiles->createTiles() - m_mapScene->texturedTiles());
-
-    for (auto it = cachedTiles.cbegin(); it != cachedTiles.cend(); ++it)
-        m_mapScene->addTile(it.key(), it.value());
+            m_tileRequests->requestTiles((tiles + predictedTiles()) - m_mapScene->texturedTiles());
+
+    bool tilesAdded = false;
+    for (auto it = cachedTiles.cbegin(); it != cachedTiles.cend(); ++it) {
+        if (tiles.contains(it.key())) {
+            m_mapScene->addTile(it.key(), it.value());
+            tilesAdded = true;
+        } else {
+            m_predictedTiles.remove(it.key()); // already cached, nothing to fetch
+        }
+    }
 
-    if (!cachedTiles.isEmpty())
+    if (tilesAdded)
         emit q->sgNodeChanged();
 }
 
+// Tiles predicted along the camera path, until the camera should have arrived
+QSet<QGeoTileSpec> QGeoTiledMapPrivate::predictedTiles()
+{
+    if (!m_predictedTiles.isEmpty() && m_predictionDeadline.hasExpired())
+        m_predictedTiles.clear();
+    m_tileRequests->setPredictedTiles(m_predictedTiles);
+
+    QSet<QGeoTileSpec> predicted;
+    predicted.reserve(m_predictedTiles.size());
+    for (auto it = m_predictedTiles.cbegin(); it != m_predictedTiles.cend(); ++it)
+        predicted.insert(it.key());
+    return predicted;
+}
+
 void QGeoTiledMapPrivate::changeActiveMapType(const QGeoMapType mapType)
 {
     m_visibleTiles->setTileSize(m_cameraCapabilities.tileSize());
@@ -366,6 +494,7 @@ void QGeoTiledMapPrivate::clearScene()
 {
     m_mapScene->clearTexturedTiles();
     m_mapScene->setVisibleTiles(QSet<QGeoTileSpec>());
+    m_sceneTilesGeneration = -1;
     updateScene();
 }
 
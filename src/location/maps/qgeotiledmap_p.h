@@ -75,7 +75,7 @@ class Q_LOCATION_PRIVATE_EXPORT QGeoTiledMap : public QGeoMap
     Q_OBJECT
     Q_DECLARE_PRIVATE(QGeoTiledMap)
 public:
-    enum PrefetchStyle { NoPrefetching, PrefetchNeighbourLayer, PrefetchTwoNeighbourLayers };
+    enum PrefetchStyle { NoPrefetching, PrefetchNeighbourLayer, PrefetchTwoNeighbourLayers, PrefetchPredictive };
     QGeoTiledMap(QGeoTiledMappingManagerEngine *engine, QObject *parent);
     virtual ~QGeoTiledMap();
 
@@ -85,6 +85,7 @@ public:
     void setPrefetchStyle(PrefetchStyle style);
 
     void prefetchData() Q_DECL_OVERRIDE;
+    void prefetchCameraPath(const QGeoCameraData &destination, int msecs) Q_DECL_OVERRIDE;
     void clearData() Q_DECL_OVERRIDE;
 
     void setCopyrightVisible(bool visible) override;
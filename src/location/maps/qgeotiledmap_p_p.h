@@ -51,9 +51,12 @@
 #include <QtLocation/private/qgeomap_p_p.h>
 #include <QtLocation/private/qgeocameradata_p.h>
 #include <QtLocation/private/qgeomaptype_p.h>
+#include <QtLocation/private/qgeotilespec_p.h>
 #include <QtPositioning/private/qdoublevector3d_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
 #include <QtCore/QPointer>
+#include <QtCore/QHash>
+#include <QtCore/QDeadlineTimer>
 
 QT_BEGIN_NAMESPACE
 
@@ -63,7 +66,6 @@ class QAbstractGeoTileCache;
 class QGeoTiledMappingManagerEngine;
 class QGeoTiledMap;
 class QGeoTileRequestManager;
-class QGeoTileSpec;
 class QSGNode;
 class QQuickWindow;
 class QGeoCameraCapabilities;
@@ -79,6 +81,7 @@ public:
 
     void updateTile(const QGeoTileSpec &spec);
     void prefetchTiles();
+    void prefetchCameraPath(const QGeoCameraData &destination, int msecs);
     QGeoMapType activeMapType();
     void onCameraCapabilitiesChanged(const QGeoCameraCapabilities &oldCameraCapabilities);
 
@@ -90,6 +93,7 @@ protected:
     void clearScene();
 
     void updateScene();
+    QSet<QGeoTileSpec> predictedTiles();
 
 protected:
     QAbstractGeoTileCache *m_cache;
@@ -97,9 +101,12 @@ protected:
     QGeoCameraTiles *m_prefetchTiles;
     QGeoTiledMapScene *m_mapScene;
     QGeoTileRequestManager *m_tileRequests;
+    int m_sceneTilesGeneration;
     int m_maxZoomLevel;
     int m_minZoomLevel;
     QGeoTiledMap::PrefetchStyle m_prefetchStyle;
+    QHash<QGeoTileSpec, int> m_predictedTiles;    // along the camera path, mapped to their rank
+    QDeadlineTimer m_predictionDeadline;
     Q_DISABLE_COPY(QGeoTiledMapPrivate)
 };
 
@@ -43,14 +43,55 @@
 #include "qgeotilerequestmanager_p.h"
 #include "qgeofiletilecache_p.h"
 #include "qgeotilespec_p.h"
+#include "qgeotileseedjob_p.h"
+#include "qgeocameracapabilities_p.h"
 
 #include <QTimer>
 #include <QLocale>
 #include <QDir>
 #include <QStandardPaths>
+#include <QMutex>
+#include <QtMath>
 
 QT_BEGIN_NAMESPACE
 
+/*
+    Hands the fetch and cancel lists collected in \a changes to the fetchers
+    of the engines concerned. Tiles both cancelled and fetched by the same
+    engine are left alone, the fetcher only updates their priority.
+*/
+static void dispatchTileRequests(const QGeoTileRequestTable::Changes &changes,
+                                 const QHash<QGeoTileSpec, int> &priorities)
+{
+    QSet<QGeoTiledMappingManagerEngine *> engines;
+    for (auto it = changes.fetch.cbegin(); it != changes.fetch.cend(); ++it)
+        engines.insert(it.key());
+    for (auto it = changes.cancel.cbegin(); it != changes.cancel.cend(); ++it)
+        engines.insert(it.key());
+
+    for (QGeoTiledMappingManagerEngine *engine : qAsConst(engines)) {
+        QGeoTileFetcher *fetcher = engine->tileFetcher();
+        if (!fetcher)
+            continue;
+
+        const QSet<QGeoTileSpec> fetch = changes.fetch.value(engine);
+        QSet<QGeoTileSpec> cancel = changes.cancel.value(engine);
+        QGeoTilePriorityHash reqTiles;
+        reqTiles.reserve(fetch.size());
+        for (const QGeoTileSpec &spec : fetch) {
+            reqTiles.insert(spec, priorities.value(spec, QGeoTileFetcher::VisiblePriority));
+            cancel.remove(spec);
+        }
+        if (reqTiles.isEmpty() && cancel.isEmpty())
+            continue;
+
+        QMetaObject::invokeMethod(fetcher, "updateTileRequests",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QGeoTilePriorityHash, reqTiles),
+                                  Q_ARG(QSet<QGeoTileSpec>, cancel));
+    }
+}
+
 QGeoTiledMappingManagerEngine::QGeoTiledMappingManagerEngine(QObject *parent)
     : QGeoMappingManagerEngine(parent),
       m_prefetchStyle(QGeoTiledMap::PrefetchTwoNeighbourLayers),
@@ -63,6 +104,17 @@ QGeoTiledMappingManagerEngine::QGeoTiledMappingManagerEngine(QObject *parent)
 */
 QGeoTiledMappingManagerEngine::~QGeoTiledMappingManagerEngine()
 {
+    // Seed jobs talk to the engine when they go away
+    qDeleteAll(findChildren<QGeoTileSeedJob *>(QString(), Qt::FindDirectChildrenOnly));
+
+    if (d_ptr->requests_) {
+        // Pass the tiles this engine was fetching for others on to them
+        QGeoTileRequestTable::Changes changes;
+        d_ptr->requests_->removeEngine(this, &changes);
+        changes.fetch.remove(this);
+        changes.cancel.remove(this);
+        dispatchTileRequests(changes, QHash<QGeoTileSpec, int>());
+    }
     delete d_ptr;
 }
 
@@ -79,11 +131,18 @@ void QGeoTiledMappingManagerEngine::setTileFetcher(QGeoTileFetcher *fetcher)
     d->fetcher_ = fetcher;
 
     qRegisterMetaType<QGeoTileSpec>();
+    qRegisterMetaType<QGeoTilePriorityHash>("QGeoTilePriorityHash");
+    qRegisterMetaType<QGeoTileValidators>();
 
     connect(d->fetcher_,
-            SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)),
+            SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString,QGeoTileValidators)),
             this,
-            SLOT(engineTileFinished(QGeoTileSpec,QByteArray,QString)),
+            SLOT(engineTileFinished(QGeoTileSpec,QByteArray,QString,QGeoTileValidators)),
+            Qt::QueuedConnection);
+    connect(d->fetcher_,
+            SIGNAL(tileNotModified(QGeoTileSpec,QGeoTileValidators)),
+            this,
+            SLOT(engineTileNotModified(QGeoTileSpec,QGeoTileValidators)),
             Qt::QueuedConnection);
     connect(d->fetcher_,
             SIGNAL(tileError(QGeoTileSpec,QString)),
@@ -107,139 +166,250 @@ QGeoMap *QGeoTiledMappingManagerEngine::createMap()
 
 void QGeoTiledMappingManagerEngine::releaseMap(QGeoTiledMap *map)
 {
-    d_ptr->mapHash_.remove(map);
-
-    QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > newTileHash = d_ptr->tileHash_;
-    typedef QHash<QGeoTileSpec, QSet<QGeoTiledMap *> >::const_iterator h_iter;
-    h_iter hi = d_ptr->tileHash_.constBegin();
-    h_iter hend = d_ptr->tileHash_.constEnd();
-    for (; hi != hend; ++hi) {
-        QSet<QGeoTiledMap *> maps = hi.value();
-        if (maps.contains(map)) {
-            maps.remove(map);
-            if (maps.isEmpty())
-                newTileHash.remove(hi.key());
-            else
-                newTileHash.insert(hi.key(), maps);
+    if (d_ptr->requests_) {
+        QGeoTileRequestTable::Changes changes;
+        QHash<QGeoTileSpec, int> priorities;
+        d_ptr->requests_->removeMap(map, &changes);
+        d_ptr->keepSeedTiles(this, &changes, &priorities);
+        dispatchTileRequests(changes, priorities);
+    }
+
+    for (auto it = d_ptr->decodeHash_.begin(); it != d_ptr->decodeHash_.end(); ) {
+        it->remove(map);
+        if (it->isEmpty()) {
+            if (d_ptr->tileCache_)
+                d_ptr->tileCache_->cancelAsync(it.key());
+            it = d_ptr->decodeHash_.erase(it);
+        } else {
+            ++it;
         }
     }
-    d_ptr->tileHash_ = newTileHash;
+
+    for (auto it = d_ptr->revalidating_.begin(); it != d_ptr->revalidating_.end(); ++it)
+        it->remove(map);
 }
 
+/*
+    Updates the tiles \a map wants. \a priorities optionally gives the fetch
+    priority of the added tiles, see QGeoTileFetcher::RequestPriority.
+*/
 void QGeoTiledMappingManagerEngine::updateTileRequests(QGeoTiledMap *map,
                                             const QSet<QGeoTileSpec> &tilesAdded,
-                                            const QSet<QGeoTileSpec> &tilesRemoved)
+                                            const QSet<QGeoTileSpec> &tilesRemoved,
+                                            const QHash<QGeoTileSpec, int> &priorities)
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
-    typedef QSet<QGeoTileSpec>::const_iterator tile_iter;
+    QGeoTileRequestTable *table = d->requestTable(tileCache());
+    QGeoTileRequestTable::Changes changes;
 
-    // add and remove tiles from tileset for this map
+    for (const QGeoTileSpec &spec : tilesRemoved)
+        table->unsubscribe(map, spec, &changes);
 
-    QSet<QGeoTileSpec> oldTiles = d->mapHash_.value(map);
+    // Only the first subscriber of a tile, across all engines sharing the
+    // table, fetches it
+    QSet<QGeoTileSpec> &fetch = changes.fetch[this];
+    for (const QGeoTileSpec &spec : tilesAdded) {
+        if (table->subscribe(this, map, spec))
+            fetch.insert(spec);
+    }
 
-    tile_iter rem = tilesRemoved.constBegin();
-    tile_iter remEnd = tilesRemoved.constEnd();
-    for (; rem != remEnd; ++rem) {
-        oldTiles.remove(*rem);
+    QHash<QGeoTileSpec, int> allPriorities = priorities;
+    d->keepSeedTiles(this, &changes, &allPriorities);
+    dispatchTileRequests(changes, allPriorities);
+}
+
+/*
+    Starts downloading the tiles of the map type \a mapId covering \a region
+    into the disk cache, from \a minimumZoomLevel to \a maximumZoomLevel
+    clamped to the camera capabilities of the map type. \a startPosition is
+    the QGeoTileSeedJob::position() reached by an earlier job over the same
+    region and levels, to resume it. The job belongs to the engine and is
+    stopped by deleting it.
+*/
+QGeoTileSeedJob *QGeoTiledMappingManagerEngine::seedRegion(const QGeoShape &region,
+                                                           int minimumZoomLevel, int maximumZoomLevel,
+                                                           int mapId, quint64 startPosition)
+{
+    const QGeoCameraCapabilities capabilities = cameraCapabilities(mapId);
+    if (capabilities.isValid()) {
+        minimumZoomLevel = qMax(minimumZoomLevel, qCeil(capabilities.minimumZoomLevel()));
+        maximumZoomLevel = qMin(maximumZoomLevel, qFloor(capabilities.maximumZoomLevel()));
     }
+    minimumZoomLevel = qMax(0, minimumZoomLevel);
+    maximumZoomLevel = qMin(30, maximumZoomLevel);
+    return new QGeoTileSeedJob(this, region, minimumZoomLevel, maximumZoomLevel, mapId, startPosition);
+}
+
+/*
+    Queues \a spec for \a job. Returns false if the tile needs no download
+    from this engine: another job already wants it, or another engine sharing
+    the disk cache is fetching it. Tiles a map of this engine is fetching are
+    only tracked, the map's request completes them.
+*/
+bool QGeoTiledMappingManagerEngine::requestSeedTile(QGeoTileSeedJob *job, const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
 
-    tile_iter add = tilesAdded.constBegin();
-    tile_iter addEnd = tilesAdded.constEnd();
-    for (; add != addEnd; ++add) {
-        oldTiles.insert(*add);
+    if (d->seedTiles_.contains(spec))
+        return false;
+    QGeoTiledMappingManagerEngine *owner = d->requestTable(tileCache())->owner(spec);
+    if (owner && owner != this)
+        return false;
+
+    d->seedTiles_.insert(spec, job);
+    if (!owner) {
+        QGeoTileRequestTable::Changes changes;
+        changes.fetch[this].insert(spec);
+        QHash<QGeoTileSpec, int> priorities;
+        priorities.insert(spec, QGeoTileFetcher::SeedPriority);
+        dispatchTileRequests(changes, priorities);
     }
+    return true;
+}
+
+/*
+    Forgets the \a tiles \a job was waiting for, and cancels the ones no map
+    of this engine is waiting for.
+*/
+void QGeoTiledMappingManagerEngine::releaseSeedTiles(QGeoTileSeedJob *job, const QList<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
 
-    d->mapHash_.insert(map, oldTiles);
+    QGeoTileRequestTable::Changes changes;
+    QSet<QGeoTileSpec> &cancel = changes.cancel[this];
+    for (const QGeoTileSpec &spec : tiles) {
+        QHash<QGeoTileSpec, QGeoTileSeedJob *>::iterator it = d->seedTiles_.find(spec);
+        if (it == d->seedTiles_.end() || *it != job)
+            continue;
+        d->seedTiles_.erase(it);
+        if (!d->requests_ || d->requests_->owner(spec) != this)
+            cancel.insert(spec);
+    }
+    dispatchTileRequests(changes, QHash<QGeoTileSpec, int>());
+}
 
-    // add and remove map from mapset for the tiles
+void QGeoTiledMappingManagerEngine::engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format,
+                                                       const QGeoTileValidators &validators)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
 
-    QSet<QGeoTileSpec> reqTiles;
-    QSet<QGeoTileSpec> cancelTiles;
+    QGeoTiledMappingManagerEngine *owner = 0;
+    const QGeoTileRequestTable::Subscribers subscribers = d->requests_
+            ? d->requests_->take(spec, &owner) : QGeoTileRequestTable::Subscribers();
+    QGeoTileSeedJob *seedJob = d->seedTiles_.take(spec);
+
+    // Tiles only a seed job wants stay out of the memory and texture caches
+    QAbstractGeoTileCache::CacheAreas areas = d->cacheHint_;
+    if (seedJob && subscribers.isEmpty())
+        areas &= QAbstractGeoTileCache::DiskCache;
+    tileCache()->insert(spec, bytes, format, areas);
+    tileCache()->setTileValidators(spec, validators);
+
+    // The tile was handed over to another engine after this one was asked
+    // to cancel it, but it arrived anyway: no need for a second download
+    if (owner && owner != this) {
+        QGeoTileRequestTable::Changes changes;
+        changes.cancel[owner].insert(spec);
+        dispatchTileRequests(changes, QHash<QGeoTileSpec, int>());
+    }
 
-    rem = tilesRemoved.constBegin();
-    for (; rem != remEnd; ++rem) {
-        QSet<QGeoTiledMap *> mapSet = d->tileHash_.value(*rem);
-        mapSet.remove(map);
-        if (mapSet.isEmpty()) {
-            cancelTiles.insert(*rem);
-            d->tileHash_.remove(*rem);
-        } else {
-            d->tileHash_.insert(*rem, mapSet);
-        }
+    // Other engines share the disk cache, only fill their memory caches
+    QSet<QGeoTiledMappingManagerEngine *> engines;
+    engines.insert(this);
+    for (const QGeoTileRequestTable::Subscriber &s : subscribers) {
+        if (engines.contains(s.engine))
+            continue;
+        engines.insert(s.engine);
+        const QAbstractGeoTileCache::CacheAreas areas = s.engine->cacheHint() & ~QAbstractGeoTileCache::DiskCache;
+        if (areas)
+            s.engine->tileCache()->insert(spec, bytes, format, areas);
     }
 
-    add = tilesAdded.constBegin();
-    for (; add != addEnd; ++add) {
-        QSet<QGeoTiledMap *> mapSet = d->tileHash_.value(*add);
-        if (mapSet.isEmpty()) {
-            reqTiles.insert(*add);
-        }
-        mapSet.insert(map);
-        d->tileHash_.insert(*add, mapSet);
+    QSet<QGeoTiledMap *> maps = d->revalidating_.take(spec);
+    for (const QGeoTileRequestTable::Subscriber &s : subscribers) {
+        s.map->requestManager()->tileFetched(spec);
+        maps.remove(s.map);
     }
+    // Maps showing the stale tile pick up the new one
+    for (QGeoTiledMap *map : qAsConst(maps))
+        map->requestManager()->tileFetched(spec);
 
-    cancelTiles -= reqTiles;
+    if (seedJob)
+        seedJob->tileDone(spec, true);
+}
 
-    QMetaObject::invokeMethod(d->fetcher_, "updateTileRequests",
-                              Qt::QueuedConnection,
-                              Q_ARG(QSet<QGeoTileSpec>, reqTiles),
-                              Q_ARG(QSet<QGeoTileSpec>, cancelTiles));
+/*
+    The server confirmed that the cached tile \a spec is still current: only
+    its \a validators change, the maps keep showing it.
+*/
+void QGeoTiledMappingManagerEngine::engineTileNotModified(const QGeoTileSpec &spec, const QGeoTileValidators &validators)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+
+    d->revalidating_.remove(spec);
+    tileCache()->setTileValidators(spec, validators);
+
+    const QGeoTileRequestTable::Subscribers subscribers = d->requests_
+            ? d->requests_->take(spec, 0) : QGeoTileRequestTable::Subscribers();
+    for (const QGeoTileRequestTable::Subscriber &s : subscribers)
+        s.map->requestManager()->tileFetched(spec);
+
+    if (QGeoTileSeedJob *seedJob = d->seedTiles_.take(spec))
+        seedJob->tileDone(spec, true);
 }
 
-void QGeoTiledMappingManagerEngine::engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format)
+void QGeoTiledMappingManagerEngine::engineTileError(const QGeoTileSpec &spec, const QString &errorString)
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
-    QSet<QGeoTiledMap *> maps = d->tileHash_.value(spec);
+    const bool revalidating = d->revalidating_.remove(spec);
+    QGeoTileSeedJob *seedJob = d->seedTiles_.take(spec);
+    if (seedJob)
+        seedJob->tileDone(spec, false);
 
-    typedef QSet<QGeoTiledMap *>::const_iterator map_iter;
+    QGeoTiledMappingManagerEngine *owner = d->requests_ ? d->requests_->owner(spec) : 0;
+    // The stale tile keeps being shown, next time it is used is soon enough to retry
+    if (revalidating && !owner && !seedJob)
+        return;
 
-    map_iter map = maps.constBegin();
-    map_iter mapEnd = maps.constEnd();
-    for (; map != mapEnd; ++map) {
-        QSet<QGeoTileSpec> tileSet = d->mapHash_.value(*map);
-        tileSet.remove(spec);
-        if (tileSet.isEmpty())
-            d->mapHash_.remove(*map);
-        else
-            d->mapHash_.insert(*map, tileSet);
-    }
+    // A late error from a request that was handed over to another engine
+    if (owner && owner != this)
+        return;
 
-    d->tileHash_.remove(spec);
-    tileCache()->insert(spec, bytes, format, d->cacheHint_);
+    const QGeoTileRequestTable::Subscribers subscribers = owner
+            ? d->requests_->take(spec, 0) : QGeoTileRequestTable::Subscribers();
 
-    map = maps.constBegin();
-    mapEnd = maps.constEnd();
-    for (; map != mapEnd; ++map) {
-        (*map)->requestManager()->tileFetched(spec);
+    QSet<QGeoTiledMappingManagerEngine *> engines;
+    for (const QGeoTileRequestTable::Subscriber &s : subscribers) {
+        s.map->requestManager()->tileError(spec, errorString);
+        engines.insert(s.engine);
     }
+    engines.insert(this);
+
+    for (QGeoTiledMappingManagerEngine *engine : qAsConst(engines))
+        emit engine->tileError(spec, errorString);
 }
 
-void QGeoTiledMappingManagerEngine::engineTileError(const QGeoTileSpec &spec, const QString &errorString)
+void QGeoTiledMappingManagerEngine::engineTilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed)
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
-    QSet<QGeoTiledMap *> maps = d->tileHash_.value(spec);
-    typedef QSet<QGeoTiledMap *>::const_iterator map_iter;
-    map_iter map = maps.constBegin();
-    map_iter mapEnd = maps.constEnd();
-    for (; map != mapEnd; ++map) {
-        QSet<QGeoTileSpec> tileSet = d->mapHash_.value(*map);
-
-        tileSet.remove(spec);
-        if (tileSet.isEmpty())
-            d->mapHash_.remove(*map);
-        else
-            d->mapHash_.insert(*map, tileSet);
+    // Group the batch per map, so that each map handles it in one go
+    QHash<QGeoTiledMap *, QPair<QList<QGeoTileSpec>, QList<QGeoTileSpec> > > results;
+    for (const QGeoTileSpec &spec : decoded) {
+        const QSet<QGeoTiledMap *> maps = d->decodeHash_.take(spec);
+        for (QGeoTiledMap *map : maps)
+            results[map].first.append(spec);
     }
-    d->tileHash_.remove(spec);
-
-    for (map = maps.constBegin(); map != mapEnd; ++map) {
-        (*map)->requestManager()->tileError(spec, errorString);
+    for (const QGeoTileSpec &spec : failed) {
+        const QSet<QGeoTiledMap *> maps = d->decodeHash_.take(spec);
+        for (QGeoTiledMap *map : maps)
+            results[map].second.append(spec);
     }
 
-    emit tileError(spec, errorString);
+    for (auto it = results.cbegin(); it != results.cend(); ++it)
+        it.key()->requestManager()->tilesDecoded(it.value().first, it.value().second);
 }
 
 void QGeoTiledMappingManagerEngine::setTileSize(const QSize &tileSize)
@@ -290,6 +460,8 @@ void QGeoTiledMappingManagerEngine::setTileCache(QAbstractGeoTileCache *cache)
     Q_ASSERT_X(!d->tileCache_, Q_FUNC_INFO, "This should be called only once");
     cache->setParent(this);
     d->tileCache_ = cache;
+    connect(d->tileCache_, &QAbstractGeoTileCache::tilesDecoded,
+            this, &QGeoTiledMappingManagerEngine::engineTilesDecoded);
     d->tileCache_->init();
 }
 
@@ -301,6 +473,8 @@ QAbstractGeoTileCache *QGeoTiledMappingManagerEngine::tileCache()
         if (!managerName().isEmpty())
             cacheDirectory = QAbstractGeoTileCache::baseLocationCacheDirectory() + managerName();
         d->tileCache_ = new QGeoFileTileCache(cacheDirectory);
+        connect(d->tileCache_, &QAbstractGeoTileCache::tilesDecoded,
+                this, &QGeoTiledMappingManagerEngine::engineTilesDecoded);
         d->tileCache_->init();
     }
     return d->tileCache_;
@@ -311,6 +485,62 @@ QSharedPointer<QGeoTileTexture> QGeoTiledMappingManagerEngine::getTileTexture(co
     return d_ptr->tileCache_->get(spec);
 }
 
+/*
+    Looks up \a spec in the tile cache without blocking on disk reads or image
+    decoding. If \a pending is set on return, \a map is notified through its
+    request manager once the tile is decoded or turns out to be unusable.
+    With a null \a pending, only textures already decoded are returned.
+*/
+QSharedPointer<QGeoTileTexture> QGeoTiledMappingManagerEngine::getTileTextureAsync(QGeoTiledMap *map, const QGeoTileSpec &spec, bool *pending)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+    QSharedPointer<QGeoTileTexture> tex = tileCache()->getAsync(spec, pending);
+    if (pending && *pending)
+        d->decodeHash_[spec].insert(map);
+
+    // Stale tiles are shown right away and refreshed in the background
+    if (pending && (tex || *pending) && d->fetcher_) {
+        QHash<QGeoTileSpec, QSet<QGeoTiledMap *> >::iterator it = d->revalidating_.find(spec);
+        QGeoTileValidators validators;
+        if (it != d->revalidating_.end()) {
+            if (map)
+                it->insert(map);
+        } else if (tileCache()->needsRevalidation(spec, &validators)) {
+            QSet<QGeoTiledMap *> &maps = d->revalidating_[spec];
+            if (map)
+                maps.insert(map);
+            QHash<QGeoTileSpec, QGeoTileValidators> tiles;
+            tiles.insert(spec, validators);
+            d->fetcher_->revalidateTiles(tiles);
+        }
+    }
+    return tex;
+}
+
+/*
+    Returns a provisional texture for \a spec synthesized from the decoded
+    tiles of neighbouring zoom levels, see QAbstractGeoTileCache::placeholder().
+*/
+QSharedPointer<QGeoTileTexture> QGeoTiledMappingManagerEngine::getTilePlaceholder(const QGeoTileSpec &spec)
+{
+    return tileCache()->placeholder(spec);
+}
+
+void QGeoTiledMappingManagerEngine::cancelTileTextures(QGeoTiledMap *map, const QSet<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+    for (const QGeoTileSpec &spec : tiles) {
+        auto it = d->decodeHash_.find(spec);
+        if (it == d->decodeHash_.end())
+            continue;
+        it->remove(map);
+        if (it->isEmpty()) {
+            d->decodeHash_.erase(it);
+            tileCache()->cancelAsync(spec);
+        }
+    }
+}
+
 /*******************************************************************************
 *******************************************************************************/
 
@@ -326,4 +556,207 @@ QGeoTiledMappingManagerEnginePrivate::~QGeoTiledMappingManagerEnginePrivate()
 {
 }
 
+/*
+    Returns the request table of this engine, shared with the engines whose
+    \a cache is stored in the same directory.
+*/
+QGeoTileRequestTable *QGeoTiledMappingManagerEnginePrivate::requestTable(QAbstractGeoTileCache *cache)
+{
+    if (!requests_) {
+        QString directory;
+        if (QGeoFileTileCache *fileCache = qobject_cast<QGeoFileTileCache *>(cache)) {
+            const QDir dir(fileCache->directory());
+            directory = dir.exists() ? dir.canonicalPath() : dir.absolutePath();
+        }
+        requests_ = QGeoTileRequestTable::shared(directory);
+    }
+    return requests_.data();
+}
+
+/*
+    Keeps fetching the tiles a seed job waits for when the maps of \a engine
+    stop wanting them, at seeding priority.
+*/
+void QGeoTiledMappingManagerEnginePrivate::keepSeedTiles(QGeoTiledMappingManagerEngine *engine,
+                                                         QGeoTileRequestTable::Changes *changes,
+                                                         QHash<QGeoTileSpec, int> *priorities) const
+{
+    if (seedTiles_.isEmpty())
+        return;
+    QHash<QGeoTiledMappingManagerEngine *, QSet<QGeoTileSpec> >::const_iterator it = changes->cancel.constFind(engine);
+    if (it == changes->cancel.constEnd())
+        return;
+
+    QSet<QGeoTileSpec> &fetch = changes->fetch[engine];
+    for (const QGeoTileSpec &spec : *it) {
+        if (!seedTiles_.contains(spec) || fetch.contains(spec))
+            continue;
+        fetch.insert(spec);
+        priorities->insert(spec, QGeoTileFetcher::SeedPriority);
+    }
+}
+
+/*******************************************************************************
+*******************************************************************************/
+
+typedef QHash<QString, QWeakPointer<QGeoTileRequestTable> > QGeoTileRequestTableRegistry;
+Q_GLOBAL_STATIC(QGeoTileRequestTableRegistry, requestTables)
+Q_GLOBAL_STATIC(QMutex, requestTablesMutex)
+
+/*
+    Returns the table for engines caching in \a cacheDirectory, creating it
+    if needed. An empty directory gives a table that is not shared.
+*/
+QSharedPointer<QGeoTileRequestTable> QGeoTileRequestTable::shared(const QString &cacheDirectory)
+{
+    if (cacheDirectory.isEmpty())
+        return QSharedPointer<QGeoTileRequestTable>(new QGeoTileRequestTable);
+
+    QMutexLocker locker(requestTablesMutex());
+    QWeakPointer<QGeoTileRequestTable> &slot = (*requestTables())[cacheDirectory];
+    QSharedPointer<QGeoTileRequestTable> table = slot.toStrongRef();
+    if (!table) {
+        table = QSharedPointer<QGeoTileRequestTable>(new QGeoTileRequestTable);
+        table->key_ = cacheDirectory;
+        slot = table;
+    }
+    return table;
+}
+
+QGeoTileRequestTable::~QGeoTileRequestTable()
+{
+    if (key_.isEmpty() || !requestTables.exists())
+        return;
+    QMutexLocker locker(requestTablesMutex());
+    QGeoTileRequestTableRegistry::iterator it = requestTables()->find(key_);
+    if (it != requestTables()->end() && it->isNull())
+        requestTables()->erase(it);
+}
+
+QGeoTiledMappingManagerEngine *QGeoTileRequestTable::owner(const QGeoTileSpec &spec) const
+{
+    QHash<QGeoTileSpec, Entry>::const_iterator it = tiles_.constFind(spec);
+    return it == tiles_.constEnd() ? 0 : it->owner;
+}
+
+/*
+    Adds \a map of \a engine to the subscribers of \a spec. Returns true if
+    the tile was not in flight yet, \a engine is then its owner and has to
+    fetch it.
+*/
+bool QGeoTileRequestTable::subscribe(QGeoTiledMappingManagerEngine *engine, QGeoTiledMap *map, const QGeoTileSpec &spec)
+{
+    Entry &entry = tiles_[spec];
+    const bool fresh = entry.subscribers.isEmpty();
+    if (fresh) {
+        entry.owner = engine;
+    } else {
+        for (const Subscriber &s : qAsConst(entry.subscribers)) {
+            if (s.map == map)
+                return false;
+        }
+    }
+    const Subscriber subscriber = { engine, map };
+    entry.subscribers.append(subscriber);
+    mapTiles_[map].insert(spec);
+    return fresh;
+}
+
+void QGeoTileRequestTable::unsubscribe(QGeoTiledMap *map, const QGeoTileSpec &spec, Changes *changes)
+{
+    EntryIterator it = tiles_.find(spec);
+    if (it == tiles_.end() || !detach(*it, map))
+        return;
+
+    QHash<QGeoTiledMap *, QSet<QGeoTileSpec> >::iterator mt = mapTiles_.find(map);
+    if (mt != mapTiles_.end()) {
+        mt->remove(spec);
+        if (mt->isEmpty())
+            mapTiles_.erase(mt);
+    }
+    settle(it, changes);
+}
+
+void QGeoTileRequestTable::removeMap(QGeoTiledMap *map, Changes *changes)
+{
+    const QSet<QGeoTileSpec> tiles = mapTiles_.take(map);
+    for (const QGeoTileSpec &spec : tiles) {
+        EntryIterator it = tiles_.find(spec);
+        if (it != tiles_.end() && detach(*it, map))
+            settle(it, changes);
+    }
+}
+
+void QGeoTileRequestTable::removeEngine(QGeoTiledMappingManagerEngine *engine, Changes *changes)
+{
+    QSet<QGeoTiledMap *> maps;
+    for (const Entry &entry : qAsConst(tiles_)) {
+        for (const Subscriber &s : entry.subscribers) {
+            if (s.engine == engine)
+                maps.insert(s.map);
+        }
+    }
+    for (QGeoTiledMap *map : qAsConst(maps))
+        removeMap(map, changes);
+}
+
+/*
+    Removes \a spec from the table and returns its subscribers. \a owner is
+    set to the engine that was fetching it.
+*/
+QGeoTileRequestTable::Subscribers QGeoTileRequestTable::take(const QGeoTileSpec &spec, QGeoTiledMappingManagerEngine **owner)
+{
+    EntryIterator it = tiles_.find(spec);
+    if (it == tiles_.end())
+        return Subscribers();
+
+    const Entry entry = *it;
+    tiles_.erase(it);
+    for (const Subscriber &s : entry.subscribers) {
+        QHash<QGeoTiledMap *, QSet<QGeoTileSpec> >::iterator mt = mapTiles_.find(s.map);
+        if (mt != mapTiles_.end()) {
+            mt->remove(spec);
+            if (mt->isEmpty())
+                mapTiles_.erase(mt);
+        }
+    }
+    if (owner)
+        *owner = entry.owner;
+    return entry.subscribers;
+}
+
+bool QGeoTileRequestTable::detach(Entry &entry, QGeoTiledMap *map)
+{
+    for (int i = 0; i < entry.subscribers.size(); ++i) {
+        if (entry.subscribers.at(i).map == map) {
+            entry.subscribers.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Called after subscribers left the tile at \a it: cancels the fetch when
+    nobody waits for the tile anymore, or hands it over to a remaining engine
+    when its owner has no subscriber left.
+*/
+void QGeoTileRequestTable::settle(EntryIterator it, Changes *changes)
+{
+    Entry &entry = *it;
+    if (entry.subscribers.isEmpty()) {
+        changes->cancel[entry.owner].insert(it.key());
+        tiles_.erase(it);
+        return;
+    }
+
+    for (const Subscriber &s : qAsConst(entry.subscribers)) {
+        if (s.engine == entry.owner)
+            return;
+    }
+    changes->cancel[entry.owner].insert(it.key());
+    entry.owner = entry.subscribers.first().engine;
+    changes->fetch[entry.owner].insert(it.key());
+}
+
 QT_END_NAMESPACE
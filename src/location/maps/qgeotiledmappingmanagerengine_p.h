@@ -65,6 +65,8 @@ class QGeoTileFetcher;
 class QGeoTileTexture;
 class QGeoTileSpec;
 class QGeoTiledMap;
+class QGeoTileSeedJob;
+class QGeoShape;
 
 class Q_LOCATION_PRIVATE_EXPORT QGeoTiledMappingManagerEngine : public QGeoMappingManagerEngine
 {
@@ -84,17 +86,27 @@ public:
 
     void updateTileRequests(QGeoTiledMap *map,
                             const QSet<QGeoTileSpec> &tilesAdded,
-                            const QSet<QGeoTileSpec> &tilesRemoved);
+                            const QSet<QGeoTileSpec> &tilesRemoved,
+                            const QHash<QGeoTileSpec, int> &priorities = QHash<QGeoTileSpec, int>());
 
     QAbstractGeoTileCache *tileCache();
     QSharedPointer<QGeoTileTexture> getTileTexture(const QGeoTileSpec &spec);
+    QSharedPointer<QGeoTileTexture> getTileTextureAsync(QGeoTiledMap *map, const QGeoTileSpec &spec, bool *pending);
+    QSharedPointer<QGeoTileTexture> getTilePlaceholder(const QGeoTileSpec &spec);
+    void cancelTileTextures(QGeoTiledMap *map, const QSet<QGeoTileSpec> &tiles);
 
 
     QAbstractGeoTileCache::CacheAreas cacheHint() const;
 
+    QGeoTileSeedJob *seedRegion(const QGeoShape &region, int minimumZoomLevel, int maximumZoomLevel,
+                                int mapId, quint64 startPosition = 0);
+
 private Q_SLOTS:
-    void engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
+    void engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format,
+                            const QGeoTileValidators &validators);
+    void engineTileNotModified(const QGeoTileSpec &spec, const QGeoTileValidators &validators);
     void engineTileError(const QGeoTileSpec &spec, const QString &errorString);
+    void engineTilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed);
 
 Q_SIGNALS:
     void tileError(const QGeoTileSpec &spec, const QString &errorString);
@@ -109,12 +121,16 @@ protected:
 
     QGeoTiledMap::PrefetchStyle m_prefetchStyle;
 private:
+    bool requestSeedTile(QGeoTileSeedJob *job, const QGeoTileSpec &spec);
+    void releaseSeedTiles(QGeoTileSeedJob *job, const QList<QGeoTileSpec> &tiles);
+
     QGeoTiledMappingManagerEnginePrivate *d_ptr;
 
     Q_DECLARE_PRIVATE(QGeoTiledMappingManagerEngine)
     Q_DISABLE_COPY(QGeoTiledMappingManagerEngine)
 
     friend class QGeoTileFetcher;
+    friend class QGeoTileSeedJob;
 };
 
 QT_END_NAMESPACE
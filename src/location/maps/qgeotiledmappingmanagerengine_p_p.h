@@ -52,7 +52,10 @@
 #include <QSize>
 #include <QHash>
 #include <QSet>
+#include <QSharedPointer>
+#include <QVarLengthArray>
 #include "qgeotiledmappingmanagerengine_p.h"
+#include "qgeotilespec_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -60,6 +63,62 @@ class QGeoTiledMap;
 class QAbstractGeoTileCache;
 class QGeoTileSpec;
 class QGeoTileFetcher;
+class QGeoTileSeedJob;
+
+/*
+    Tracks the tiles in flight and the maps waiting for them. Each tile is
+    fetched by a single engine, its owner, and fanned out to all subscribers
+    when it arrives. Engines whose caches share a directory share one table,
+    so a tile wanted by several service providers is downloaded once.
+    Not thread-safe; engines use it from the thread they live in.
+*/
+class QGeoTileRequestTable
+{
+public:
+    struct Subscriber
+    {
+        QGeoTiledMappingManagerEngine *engine;
+        QGeoTiledMap *map;
+    };
+    typedef QVarLengthArray<Subscriber, 2> Subscribers;
+
+    // Fetches to start and to abort, per engine
+    struct Changes
+    {
+        QHash<QGeoTiledMappingManagerEngine *, QSet<QGeoTileSpec> > fetch;
+        QHash<QGeoTiledMappingManagerEngine *, QSet<QGeoTileSpec> > cancel;
+    };
+
+    static QSharedPointer<QGeoTileRequestTable> shared(const QString &cacheDirectory);
+    ~QGeoTileRequestTable();
+
+    inline int size() const { return tiles_.size(); }
+    QGeoTiledMappingManagerEngine *owner(const QGeoTileSpec &spec) const;
+
+    bool subscribe(QGeoTiledMappingManagerEngine *engine, QGeoTiledMap *map, const QGeoTileSpec &spec);
+    void unsubscribe(QGeoTiledMap *map, const QGeoTileSpec &spec, Changes *changes);
+    void removeMap(QGeoTiledMap *map, Changes *changes);
+    void removeEngine(QGeoTiledMappingManagerEngine *engine, Changes *changes);
+    Subscribers take(const QGeoTileSpec &spec, QGeoTiledMappingManagerEngine **owner);
+
+private:
+    struct Entry
+    {
+        QGeoTiledMappingManagerEngine *owner;
+        Subscribers subscribers;
+    };
+    typedef QHash<QGeoTileSpec, Entry>::iterator EntryIterator;
+
+    QGeoTileRequestTable() {}
+    bool detach(Entry &entry, QGeoTiledMap *map);
+    void settle(EntryIterator it, Changes *changes);
+
+    QHash<QGeoTileSpec, Entry> tiles_;
+    QHash<QGeoTiledMap *, QSet<QGeoTileSpec> > mapTiles_;
+    QString key_;
+
+    Q_DISABLE_COPY(QGeoTileRequestTable)
+};
 
 class QGeoTiledMappingManagerEnginePrivate
 {
@@ -67,13 +126,19 @@ public:
     QGeoTiledMappingManagerEnginePrivate();
     ~QGeoTiledMappingManagerEnginePrivate();
 
+    QGeoTileRequestTable *requestTable(QAbstractGeoTileCache *cache);
+    void keepSeedTiles(QGeoTiledMappingManagerEngine *engine, QGeoTileRequestTable::Changes *changes,
+                       QHash<QGeoTileSpec, int> *priorities) const;
+
     QSize tileSize_;
     int m_tileVersion;
-    QHash<QGeoTiledMap *, QSet<QGeoTileSpec> > mapHash_;
-    QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > tileHash_;
+    QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > decodeHash_;
     QAbstractGeoTileCache::CacheAreas cacheHint_;
     QAbstractGeoTileCache *tileCache_;
     QGeoTileFetcher *fetcher_;
+    QSharedPointer<QGeoTileRequestTable> requests_;
+    QHash<QGeoTileSpec, QGeoTileSeedJob *> seedTiles_;    // tiles wanted by seed jobs
+    QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > revalidating_;  // stale tiles shown while revalidated
 
 private:
     Q_DISABLE_COPY(QGeoTiledMappingManagerEnginePrivate)
@@ -233,6 +233,44 @@ void QGeoTiledMapReply::setMapImageFormat(const QString &format)
     d_ptr->mapImageFormat = format;
 }
 
+/*!
+    Returns the HTTP cache validators and expiry of the tile, as sent by the
+    server.
+*/
+QGeoTileValidators QGeoTiledMapReply::validators() const
+{
+    return d_ptr->validators;
+}
+
+/*!
+    Sets the HTTP cache validators and expiry of the tile to \a validators.
+    They are kept with the cached tile, to revalidate it with a conditional
+    request once it is stale.
+*/
+void QGeoTiledMapReply::setValidators(const QGeoTileValidators &validators)
+{
+    d_ptr->validators = validators;
+}
+
+/*!
+    Returns true if the server answered a conditional request with
+    304 Not Modified: the cached tile is still current, and there is no
+    image data.
+*/
+bool QGeoTiledMapReply::isNotModified() const
+{
+    return d_ptr->isNotModified;
+}
+
+/*!
+    Sets whether the server answered a conditional request with
+    304 Not Modified to \a notModified.
+*/
+void QGeoTiledMapReply::setNotModified(bool notModified)
+{
+    d_ptr->isNotModified = notModified;
+}
+
 /*!
     Cancels the operation immediately.
 
@@ -304,13 +342,15 @@ QGeoTiledMapReplyPrivate::QGeoTiledMapReplyPrivate(const QGeoTileSpec &spec)
     : error(QGeoTiledMapReply::NoError),
       isFinished(false),
       isCached(false),
+      isNotModified(false),
       spec(spec) {}
 
 QGeoTiledMapReplyPrivate::QGeoTiledMapReplyPrivate(QGeoTiledMapReply::Error error, const QString &errorString)
     : error(error),
       errorString(errorString),
       isFinished(true),
-      isCached(false) {}
+      isCached(false),
+      isNotModified(false) {}
 
 QGeoTiledMapReplyPrivate::~QGeoTiledMapReplyPrivate() {}
 
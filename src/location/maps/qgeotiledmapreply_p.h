@@ -55,6 +55,7 @@
 QT_BEGIN_NAMESPACE
 
 class QGeoTileSpec;
+class QGeoTileValidators;
 class QGeoTiledMapReplyPrivate;
 
 class Q_LOCATION_PRIVATE_EXPORT QGeoTiledMapReply : public QObject
@@ -84,6 +85,9 @@ public:
     QByteArray mapImageData() const;
     QString mapImageFormat() const;
 
+    QGeoTileValidators validators() const;
+    bool isNotModified() const;
+
     virtual void abort();
 
 Q_SIGNALS:
@@ -100,6 +104,9 @@ protected:
     void setMapImageData(const QByteArray &data);
     void setMapImageFormat(const QString &format);
 
+    void setValidators(const QGeoTileValidators &validators);
+    void setNotModified(bool notModified);
+
 private:
     QGeoTiledMapReplyPrivate *d_ptr;
     Q_DISABLE_COPY(QGeoTiledMapReply)
@@ -50,6 +50,7 @@
 
 #include "qgeotiledmapreply_p.h"
 #include "qgeotilespec_p.h"
+#include "qgeotilevalidators_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -64,10 +65,12 @@ public:
     QString errorString;
     bool isFinished;
     bool isCached;
+    bool isNotModified;
 
     QGeoTileSpec spec;
     QByteArray mapImageData;
     QString mapImageFormat;
+    QGeoTileValidators validators;
 };
 
 QT_END_NAMESPACE
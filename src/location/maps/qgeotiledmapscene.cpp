@@ -42,8 +42,14 @@
 #include <QtPositioning/private/qwebmercator_p.h>
 #include <QtCore/private/qobject_p.h>
 #include <QtQuick/QSGImageNode>
+#include <QtQuick/QSGGeometryNode>
+#include <QtQuick/QSGTextureMaterial>
 #include <QtQuick/QQuickWindow>
 #include <QtQuick/private/qsgdefaultimagenode_p.h>
+#if QT_CONFIG(opengl)
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+#endif
 #include <QtGui/QVector3D>
 #include <cmath>
 #include <QtPositioning/private/qlocationutils_p.h>
@@ -101,11 +107,15 @@ public:
 
     bool m_dropTextures;
 
+    bool m_textureAtlasEnabled;
+
     void addTile(const QGeoTileSpec &spec, QSharedPointer<QGeoTileTexture> texture);
 
     void setVisibleTiles(const QSet<QGeoTileSpec> &visibleTiles);
+    void setVisibleTiles(const QSet<QGeoTileSpec> &visibleTiles, const QSet<QGeoTileSpec> &removed);
     void removeTiles(const QSet<QGeoTileSpec> &oldTiles);
-    bool buildGeometry(const QGeoTileSpec &spec, QSGImageNode *imageNode, bool &overzooming);
+    bool tileRect(const QGeoTileSpec &spec, QRectF &rect) const;
+    QRectF tileSourceRect(const QGeoTileSpec &spec, const QSize &textureSize, bool &overzooming) const;
     void updateTileBounds(const QSet<QGeoTileSpec> &tiles);
     void setupCamera();
     inline bool isTiltedOrRotated() { return (m_cameraData.tilt() > 0.0) || (m_cameraData.bearing() > 0.0); }
@@ -159,6 +169,16 @@ void QGeoTiledMapScene::setVisibleTiles(const QSet<QGeoTileSpec> &tiles)
     d->setVisibleTiles(tiles);
 }
 
+/*
+    Same as above, for callers that already know which of the current
+    visible tiles are \a removed from the scene.
+*/
+void QGeoTiledMapScene::setVisibleTiles(const QSet<QGeoTileSpec> &tiles, const QSet<QGeoTileSpec> &removed)
+{
+    Q_D(QGeoTiledMapScene);
+    d->setVisibleTiles(tiles, removed);
+}
+
 const QSet<QGeoTileSpec> &QGeoTiledMapScene::visibleTiles() const
 {
     Q_D(const QGeoTiledMapScene);
@@ -175,8 +195,10 @@ QSet<QGeoTileSpec> QGeoTiledMapScene::texturedTiles()
 {
     Q_D(QGeoTiledMapScene);
     QSet<QGeoTileSpec> textured;
-    for (auto it = d->m_textures.cbegin(); it != d->m_textures.cend(); ++it)
-        textured += it.value()->spec;
+    for (auto it = d->m_textures.cbegin(); it != d->m_textures.cend(); ++it) {
+        if (!it.value()->provisional)
+            textured += it.value()->spec;
+    }
 
     return textured;
 }
@@ -188,6 +210,26 @@ void QGeoTiledMapScene::clearTexturedTiles()
     d->m_dropTextures = true;
 }
 
+/*
+    Whether tiles of the same zoom level share atlas textures, drawn in as few
+    nodes as possible. This only has an effect with the OpenGL scene graph
+    backend, other backends always draw each tile with its own texture.
+*/
+void QGeoTiledMapScene::setTextureAtlasEnabled(bool enabled)
+{
+    Q_D(QGeoTiledMapScene);
+    if (d->m_textureAtlasEnabled == enabled)
+        return;
+    d->m_textureAtlasEnabled = enabled;
+    d->m_dropTextures = true;
+}
+
+bool QGeoTiledMapScene::isTextureAtlasEnabled() const
+{
+    Q_D(const QGeoTiledMapScene);
+    return d->m_textureAtlasEnabled;
+}
+
 QGeoTiledMapScenePrivate::QGeoTiledMapScenePrivate()
     : QObjectPrivate(),
       m_tileSize(0),
@@ -200,7 +242,8 @@ QGeoTiledMapScenePrivate::QGeoTiledMapScenePrivate()
       m_maxTileY(-1),
       m_tileXWrapsBelow(0),
       m_linearScaling(false),
-      m_dropTextures(false)
+      m_dropTextures(false),
+      m_textureAtlasEnabled(true)
 {
 }
 
@@ -208,9 +251,8 @@ QGeoTiledMapScenePrivate::~QGeoTiledMapScenePrivate()
 {
 }
 
-bool QGeoTiledMapScenePrivate::buildGeometry(const QGeoTileSpec &spec, QSGImageNode *imageNode, bool &overzooming)
+bool QGeoTiledMapScenePrivate::tileRect(const QGeoTileSpec &spec, QRectF &rect) const
 {
-    overzooming = false;
     int x = spec.x();
 
     if (x < m_tileXWrapsBelow)
@@ -237,8 +279,13 @@ bool QGeoTiledMapScenePrivate::buildGeometry(const QGeoTileSpec &spec, QSGImageN
     y1 *= edge;
     y2 *= edge;
 
-    imageNode->setRect(QRectF(QPointF(x1, y2), QPointF(x2, y1)));
-    imageNode->setTextureCoordinatesTransform(QSGImageNode::MirrorVertically);
+    rect = QRectF(QPointF(x1, y2), QPointF(x2, y1));
+    return true;
+}
+
+QRectF QGeoTiledMapScenePrivate::tileSourceRect(const QGeoTileSpec &spec, const QSize &textureSize, bool &overzooming) const
+{
+    overzooming = false;
 
     // Calculate the texture mapping, in case we are magnifying some lower ZL tile
     const auto it = m_textures.find(spec); // This should be always found, but apparently sometimes it isn't, possibly due to memory shortage
@@ -246,20 +293,17 @@ bool QGeoTiledMapScenePrivate::buildGeometry(const QGeoTileSpec &spec, QSGImageN
         if (it.value()->spec.zoom() < spec.zoom()) {
             // Currently only using lower ZL tiles for the overzoom.
             const int tilesPerTexture = 1 << (spec.zoom() - it.value()->spec.zoom());
-            const int mappedSize = imageNode->texture()->textureSize().width() / tilesPerTexture;
+            const int mappedSize = textureSize.width() / tilesPerTexture;
             const int x = (spec.x() % tilesPerTexture) * mappedSize;
             const int y = (spec.y() % tilesPerTexture) * mappedSize;
-            imageNode->setSourceRect(QRectF(x, y, mappedSize, mappedSize));
             overzooming = true;
-        } else {
-            imageNode->setSourceRect(QRectF(QPointF(0,0), imageNode->texture()->textureSize()));
+            return QRectF(x, y, mappedSize, mappedSize);
         }
     } else {
-        qWarning() << "!! buildGeometry: tileSpec not present in m_textures !!";
-        imageNode->setSourceRect(QRectF(QPointF(0,0), imageNode->texture()->textureSize()));
+        qWarning() << "!! tileSourceRect: tileSpec not present in m_textures !!";
     }
 
-    return true;
+    return QRectF(QPointF(0,0), textureSize);
 }
 
 void QGeoTiledMapScenePrivate::addTile(const QGeoTileSpec &spec, QSharedPointer<QGeoTileTexture> texture)
@@ -287,6 +331,17 @@ void QGeoTiledMapScenePrivate::setVisibleTiles(const QSet<QGeoTileSpec> &visible
     m_visibleTiles = visibleTiles;
 }
 
+void QGeoTiledMapScenePrivate::setVisibleTiles(const QSet<QGeoTileSpec> &visibleTiles, const QSet<QGeoTileSpec> &removed)
+{
+    updateTileBounds(visibleTiles);
+    setupCamera();
+
+    if (!removed.isEmpty())
+        removeTiles(removed);
+
+    m_visibleTiles = visibleTiles;
+}
+
 void QGeoTiledMapScenePrivate::removeTiles(const QSet<QGeoTileSpec> &oldTiles)
 {
     typedef QSet<QGeoTileSpec>::const_iterator iter;
@@ -469,6 +524,255 @@ void QGeoTiledMapScenePrivate::setupCamera()
     m_projectionMatrix.frustum(-halfWidth, halfWidth, -halfHeight, halfHeight, nearPlane, farPlane);
 }
 
+// Size of the atlas textures, which hold a few dozen tiles each
+#define TILE_ATLAS_PAGE_SIZE 2048
+// Image nodes kept for reuse, enough for the tiles entering a 4K view at once
+#define TILE_NODE_POOL_SIZE 256
+
+/*
+    An atlas texture holding tile images of one zoom level and size, each in a
+    slot with a one pixel border copied from the image edges, so that linear
+    filtering does not blend in the neighbouring tiles.
+*/
+class QGeoTileAtlasPage
+{
+public:
+    QGeoTileAtlasPage(int zoom, const QSize &imageSize)
+        : zoom(zoom),
+          imageSize(imageSize),
+          columns(TILE_ATLAS_PAGE_SIZE / (imageSize.width() + 2)),
+          rows(TILE_ATLAS_PAGE_SIZE / (imageSize.height() + 2)),
+          texture(0)
+    {
+        freeSlots.reserve(columns * rows);
+        for (int slot = columns * rows - 1; slot >= 0; --slot)
+            freeSlots.append(slot);
+    }
+
+    // the image area of the slot, inside its border
+    QRect slotRect(int slot) const
+    {
+        return QRect((slot % columns) * (imageSize.width() + 2) + 1,
+                     (slot / columns) * (imageSize.height() + 2) + 1,
+                     imageSize.width(), imageSize.height());
+    }
+
+    bool isEmpty() const { return freeSlots.size() == columns * rows; }
+
+    int zoom;
+    QSize imageSize;
+    int columns;
+    int rows;
+    QSGTexture *texture;
+    QVector<int> freeSlots;
+};
+
+static QImage qgeotiledmapscene_borderedImage(const QImage &image)
+{
+    const QImage source = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+    const int w = source.width();
+    const int h = source.height();
+    QImage bordered(w + 2, h + 2, QImage::Format_RGBA8888_Premultiplied);
+    for (int y = 0; y < h + 2; ++y) {
+        const quint32 *from = reinterpret_cast<const quint32 *>(source.constScanLine(qBound(0, y - 1, h - 1)));
+        quint32 *to = reinterpret_cast<quint32 *>(bordered.scanLine(y));
+        to[0] = from[0];
+        memcpy(to + 1, from, w * sizeof(quint32));
+        to[w + 1] = from[w - 1];
+    }
+    return bordered;
+}
+
+/*
+    The atlas pages of a map, and where each visible tile is in them. Tiles
+    are uploaded into their slot in place, which requires OpenGL.
+*/
+class QGeoTileAtlas
+{
+public:
+    struct Entry
+    {
+        QGeoTileAtlasPage *page;
+        int slot;
+    };
+
+    ~QGeoTileAtlas()
+    {
+        for (QGeoTileAtlasPage *page : qAsConst(pages))
+            delete page->texture;
+        qDeleteAll(pages);
+    }
+
+    static bool fits(const QImage &image)
+    {
+        return image.width() + 2 <= TILE_ATLAS_PAGE_SIZE && image.height() + 2 <= TILE_ATLAS_PAGE_SIZE;
+    }
+
+    bool insert(const QGeoTileSpec &spec, const QImage &image, int zoom, QQuickWindow *window);
+    QGeoTileAtlasPage *remove(const QGeoTileSpec &spec);
+    void removePage(QGeoTileAtlasPage *page);
+    void clear();
+
+    QHash<QGeoTileSpec, Entry> entries;
+    QList<QGeoTileAtlasPage *> pages;
+};
+
+bool QGeoTileAtlas::insert(const QGeoTileSpec &spec, const QImage &image, int zoom, QQuickWindow *window)
+{
+#if QT_CONFIG(opengl)
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context || !fits(image))
+        return false;
+
+    QGeoTileAtlasPage *page = 0;
+    for (QGeoTileAtlasPage *p : qAsConst(pages)) {
+        if (p->zoom == zoom && p->imageSize == image.size() && !p->freeSlots.isEmpty()) {
+            page = p;
+            break;
+        }
+    }
+    QOpenGLFunctions *functions = context->functions();
+    if (!page) {
+        // Allocated here rather than by createTextureFromImage(), which may pick
+        // an internal format (e.g. GL_BGRA on GLES) that the RGBA uploads of the
+        // slots below do not match
+        QImage blank(TILE_ATLAS_PAGE_SIZE, TILE_ATLAS_PAGE_SIZE, QImage::Format_RGBA8888_Premultiplied);
+        blank.fill(Qt::transparent);
+        GLuint id = 0;
+        functions->glGenTextures(1, &id);
+        if (!id)
+            return false;
+        functions->glBindTexture(GL_TEXTURE_2D, id);
+        functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        functions->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TILE_ATLAS_PAGE_SIZE, TILE_ATLAS_PAGE_SIZE, 0,
+                                GL_RGBA, GL_UNSIGNED_BYTE, blank.constBits());
+        QSGTexture *texture = window->createTextureFromId(id, blank.size(),
+                                                          QQuickWindow::TextureHasAlphaChannel
+                                                          | QQuickWindow::TextureOwnsGLTexture);
+        if (!texture) {
+            functions->glDeleteTextures(1, &id);
+            return false;
+        }
+        page = new QGeoTileAtlasPage(zoom, image.size());
+        page->texture = texture;
+        pages.append(page);
+    }
+
+    const int slot = page->freeSlots.takeLast();
+    const QRect rect = page->slotRect(slot).adjusted(-1, -1, 1, 1);
+    const QImage bordered = qgeotiledmapscene_borderedImage(image);
+    page->texture->bind();
+    functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    functions->glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                               GL_RGBA, GL_UNSIGNED_BYTE, bordered.constBits());
+
+    Entry entry;
+    entry.page = page;
+    entry.slot = slot;
+    entries.insert(spec, entry);
+    return true;
+#else
+    Q_UNUSED(spec)
+    Q_UNUSED(image)
+    Q_UNUSED(zoom)
+    Q_UNUSED(window)
+    return false;
+#endif
+}
+
+/*
+    Frees the slot of \a spec. Returns its page if that is left empty, for the
+    caller to drop with removePage() once nothing refers to it anymore.
+*/
+QGeoTileAtlasPage *QGeoTileAtlas::remove(const QGeoTileSpec &spec)
+{
+    const auto it = entries.find(spec);
+    if (it == entries.end())
+        return 0;
+
+    QGeoTileAtlasPage *page = it->page;
+    page->freeSlots.append(it->slot);
+    entries.erase(it);
+    return page->isEmpty() ? page : 0;
+}
+
+void QGeoTileAtlas::removePage(QGeoTileAtlasPage *page)
+{
+    pages.removeOne(page);
+    page->texture->deleteLater();
+    delete page;
+}
+
+void QGeoTileAtlas::clear()
+{
+    entries.clear();
+    for (QGeoTileAtlasPage *page : qAsConst(pages))
+        page->texture->deleteLater();
+    qDeleteAll(pages);
+    pages.clear();
+}
+
+/*
+    The tiles in one atlas page, drawn as a single geometry node: one quad of
+    four vertices and six indices per tile.
+*/
+class QGeoTiledMapTileBatchNode : public QSGGeometryNode
+{
+public:
+    QGeoTiledMapTileBatchNode()
+        : geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0, 0)
+    {
+        geometry.setDrawingMode(QSGGeometry::DrawTriangles);
+        setGeometry(&geometry);
+        material.setFlag(QSGMaterial::Blending);
+        opaqueMaterial.setFlag(QSGMaterial::Blending);
+        material.setAnisotropyLevel(QSGTexture::Anisotropy16x);
+        opaqueMaterial.setAnisotropyLevel(QSGTexture::Anisotropy16x);
+        setMaterial(&material);
+        setOpaqueMaterial(&opaqueMaterial);
+    }
+
+    void setTexture(QSGTexture *texture, QSGTexture::Filtering filtering)
+    {
+        if (opaqueMaterial.texture() == texture && opaqueMaterial.filtering() == filtering)
+            return;
+        material.setTexture(texture);
+        opaqueMaterial.setTexture(texture);
+        material.setFiltering(filtering);
+        opaqueMaterial.setFiltering(filtering);
+        markDirty(DirtyMaterial);
+    }
+
+    void setVertices(const QVector<QSGGeometry::TexturedPoint2D> &vertices)
+    {
+        const int count = vertices.size();
+        const size_t bytes = count * sizeof(QSGGeometry::TexturedPoint2D);
+        if (count == geometry.vertexCount()
+                && memcmp(geometry.vertexDataAsTexturedPoint2D(), vertices.constData(), bytes) == 0) {
+            return;
+        }
+
+        if (count != geometry.vertexCount()) {
+            geometry.allocate(count, count / 4 * 6);
+            quint16 *indices = geometry.indexDataAsUShort();
+            for (int v = 0; v < count; v += 4) {
+                *indices++ = v;
+                *indices++ = v + 1;
+                *indices++ = v + 2;
+                *indices++ = v + 2;
+                *indices++ = v + 1;
+                *indices++ = v + 3;
+            }
+        }
+        memcpy(geometry.vertexDataAsTexturedPoint2D(), vertices.constData(), bytes);
+        markDirty(DirtyGeometry);
+    }
+
+    QSGGeometry geometry;
+    QSGTextureMaterial material;
+    QSGOpaqueTextureMaterial opaqueMaterial;
+};
+
 class QGeoTiledMapTileContainerNode : public QSGTransformNode
 {
 public:
@@ -477,7 +781,8 @@ public:
         tiles.insert(spec, node);
         appendChildNode(node);
     }
-    QHash<QGeoTileSpec, QSGImageNode *> tiles;
+    QHash<QGeoTileSpec, QSGImageNode *> tiles;                          // tiles with their own texture
+    QHash<QGeoTileAtlasPage *, QGeoTiledMapTileBatchNode *> batches;    // tiles in the atlas
 };
 
 class QGeoTiledMapRootNode : public QSGClipNode
@@ -502,6 +807,7 @@ public:
     ~QGeoTiledMapRootNode()
     {
         qDeleteAll(textures);
+        qDeleteAll(nodePool);
     }
 
     void setClipRect(const QRect &rect)
@@ -520,6 +826,60 @@ public:
                      QQuickWindow *window,
                      bool ogl);
 
+    QSGImageNode *takeImageNode(QQuickWindow *window)
+    {
+        if (!nodePool.isEmpty())
+            return nodePool.takeLast();
+        return window->createImageNode();
+    }
+
+    void recycleImageNode(QSGImageNode *node)
+    {
+        if (node->parent())
+            node->parent()->removeChildNode(node);
+        if (nodePool.size() < TILE_NODE_POOL_SIZE)
+            nodePool.append(node);
+        else
+            delete node;
+    }
+
+    void removeTile(const QGeoTileSpec &spec)
+    {
+        for (QGeoTiledMapTileContainerNode *container : { tiles, wrapLeft, wrapRight }) {
+            if (QSGImageNode *node = container->tiles.take(spec))
+                recycleImageNode(node);
+        }
+        if (QSGTexture *texture = textures.take(spec))
+            texture->deleteLater();
+        removeAtlasTile(spec);
+    }
+
+    void removeAtlasTile(const QGeoTileSpec &spec)
+    {
+        QGeoTileAtlasPage *page = atlas.remove(spec);
+        if (!page)
+            return;
+        // The batches drawing the page are keyed by it, drop them first
+        for (QGeoTiledMapTileContainerNode *container : { tiles, wrapLeft, wrapRight })
+            delete container->batches.take(page);
+        atlas.removePage(page);
+    }
+
+    void removeAllTiles()
+    {
+        for (QGeoTiledMapTileContainerNode *container : { tiles, wrapLeft, wrapRight }) {
+            for (QSGImageNode *node : qAsConst(container->tiles))
+                recycleImageNode(node);
+            container->tiles.clear();
+            qDeleteAll(container->batches);
+            container->batches.clear();
+        }
+        for (QSGTexture *texture : qAsConst(textures))
+            texture->deleteLater();
+        textures.clear();
+        atlas.clear();
+    }
+
     bool isTextureLinear;
 
     QSGGeometry geometry;
@@ -531,7 +891,9 @@ public:
     QGeoTiledMapTileContainerNode *wrapLeft;     // When zoomed out, the tiles that wrap around on the left.
     QGeoTiledMapTileContainerNode *wrapRight;    // When zoomed out, the tiles that wrap around on the right
 
-    QHash<QGeoTileSpec, QSGTexture *> textures;
+    QHash<QGeoTileSpec, QSGTexture *> textures;  // tiles that are not in the atlas
+    QGeoTileAtlas atlas;
+    QVector<QSGImageNode *> nodePool;
 };
 
 static bool qgeotiledmapscene_isTileInViewport_Straight(const QRectF &tileRect, const QMatrix4x4 &matrix)
@@ -578,72 +940,101 @@ void QGeoTiledMapRootNode::updateTiles(QGeoTiledMapTileContainerNode *root,
     cameraMatrix.lookAt(toVector3D(eye), toVector3D(center), toVector3D(d->m_cameraUp));
     root->setMatrix(d->m_projectionMatrix * cameraMatrix);
 
-    const QSet<QGeoTileSpec> tilesInSG = QSet<QGeoTileSpec>::fromList(root->tiles.keys());
-    const QSet<QGeoTileSpec> toRemove = tilesInSG - d->m_visibleTiles;
-    const QSet<QGeoTileSpec> toAdd = d->m_visibleTiles - tilesInSG;
-
-    for (const QGeoTileSpec &s : toRemove)
-        delete root->tiles.take(s);
-    bool straight = !d->isTiltedOrRotated();
-    bool overzooming;
-    qreal pixelRatio = window->effectiveDevicePixelRatio();
-    for (QHash<QGeoTileSpec, QSGImageNode *>::iterator it = root->tiles.begin();
-         it != root->tiles.end(); ) {
-        QSGImageNode *node = it.value();
-        bool ok = d->buildGeometry(it.key(), node, overzooming)
-                && qgeotiledmapscene_isTileInViewport(node->rect(), root->matrix(), straight);
-
-        QSGNode::DirtyState dirtyBits = 0;
-
-        if (!ok) {
+    for (auto it = root->tiles.begin(); it != root->tiles.end(); ) {
+        if (!d->m_visibleTiles.contains(it.key())) {
+            recycleImageNode(it.value());
             it = root->tiles.erase(it);
-            delete node;
         } else {
-            if (isTextureLinear != d->m_linearScaling) {
-                if (node->texture()->textureSize().width() > d->m_tileSize * pixelRatio) {
-                    node->setFiltering(QSGTexture::Linear); // With mipmapping QSGTexture::Nearest generates artifacts
-                    node->setMipmapFiltering(QSGTexture::Linear);
-                } else {
-                    node->setFiltering((d->m_linearScaling || overzooming) ? QSGTexture::Linear : QSGTexture::Nearest);
-                }
-#if QT_CONFIG(opengl)
-                if (ogl)
-                    static_cast<QSGDefaultImageNode *>(node)->setAnisotropyLevel(QSGTexture::Anisotropy16x);
-#else
-    Q_UNUSED(ogl)
-#endif
-                dirtyBits |= QSGNode::DirtyMaterial;
-            }
-            if (dirtyBits != 0)
-                node->markDirty(dirtyBits);
-            it++;
+            ++it;
         }
     }
 
-    for (const QGeoTileSpec &s : toAdd) {
-        QGeoTileTexture *tileTexture = d->m_textures.value(s).data();
-        if (!tileTexture || tileTexture->image.isNull())
+    const bool straight = !d->isTiltedOrRotated();
+    const qreal pixelRatio = window->effectiveDevicePixelRatio();
+    QHash<QGeoTileAtlasPage *, QVector<QSGGeometry::TexturedPoint2D> > quads;
+    for (const QGeoTileSpec &spec : d->m_visibleTiles) {
+        QRectF rect;
+        if (!d->tileRect(spec, rect) || !qgeotiledmapscene_isTileInViewport(rect, root->matrix(), straight)) {
+            if (QSGImageNode *node = root->tiles.take(spec))
+                recycleImageNode(node);
+            continue;
+        }
+
+        bool overzooming;
+        const auto entry = atlas.entries.constFind(spec);
+        if (entry != atlas.entries.constEnd()) {
+            // One quad in the batch of the page, the texture mirrored vertically like the image nodes
+            const QGeoTileAtlasPage *page = entry->page;
+            const QRectF source = d->tileSourceRect(spec, page->imageSize, overzooming)
+                    .translated(page->slotRect(entry->slot).topLeft());
+            const float u1 = source.left() / TILE_ATLAS_PAGE_SIZE;
+            const float u2 = source.right() / TILE_ATLAS_PAGE_SIZE;
+            const float v1 = source.top() / TILE_ATLAS_PAGE_SIZE;
+            const float v2 = source.bottom() / TILE_ATLAS_PAGE_SIZE;
+            QVector<QSGGeometry::TexturedPoint2D> &vertices = quads[entry->page];
+            vertices.resize(vertices.size() + 4);
+            QSGGeometry::TexturedPoint2D *v = vertices.end() - 4;
+            v[0].set(rect.left(), rect.bottom(), u1, v1);
+            v[1].set(rect.right(), rect.bottom(), u2, v1);
+            v[2].set(rect.left(), rect.top(), u1, v2);
+            v[3].set(rect.right(), rect.top(), u2, v2);
             continue;
-        QSGImageNode *tileNode = window->createImageNode();
-        // note: setTexture will update coordinates so do it here, before we buildGeometry
-        tileNode->setTexture(textures.value(s));
-        if (d->buildGeometry(s, tileNode, overzooming)
-                && qgeotiledmapscene_isTileInViewport(tileNode->rect(), root->matrix(), straight)) {
-            if (tileNode->texture()->textureSize().width() > d->m_tileSize * pixelRatio) {
-                tileNode->setFiltering(QSGTexture::Linear); // with mipmapping QSGTexture::Nearest generates artifacts
-                tileNode->setMipmapFiltering(QSGTexture::Linear);
+        }
+
+        QSGTexture *texture = textures.value(spec);
+        if (!texture)
+            continue;
+        QSGImageNode *node = root->tiles.value(spec);
+        const bool isNew = !node;
+        if (isNew) {
+            node = takeImageNode(window);
+            // note: setTexture will update coordinates so do it here, before setting the rects
+            node->setTexture(texture);
+            node->setTextureCoordinatesTransform(QSGImageNode::MirrorVertically);
+            root->addChild(spec, node);
+        }
+        node->setRect(rect);
+        node->setSourceRect(d->tileSourceRect(spec, texture->textureSize(), overzooming));
+
+        if (isNew || isTextureLinear != d->m_linearScaling) {
+            if (texture->textureSize().width() > d->m_tileSize * pixelRatio) {
+                node->setFiltering(QSGTexture::Linear); // With mipmapping QSGTexture::Nearest generates artifacts
+                node->setMipmapFiltering(QSGTexture::Linear);
             } else {
-                tileNode->setFiltering((d->m_linearScaling || overzooming) ? QSGTexture::Linear : QSGTexture::Nearest);
+                node->setFiltering((d->m_linearScaling || overzooming) ? QSGTexture::Linear : QSGTexture::Nearest);
+                node->setMipmapFiltering(QSGTexture::None);
             }
 #if QT_CONFIG(opengl)
             if (ogl)
-                static_cast<QSGDefaultImageNode *>(tileNode)->setAnisotropyLevel(QSGTexture::Anisotropy16x);
+                static_cast<QSGDefaultImageNode *>(node)->setAnisotropyLevel(QSGTexture::Anisotropy16x);
+#else
+    Q_UNUSED(ogl)
 #endif
-            root->addChild(s, tileNode);
+            node->markDirty(QSGNode::DirtyMaterial);
+        }
+    }
+
+    for (auto it = root->batches.begin(); it != root->batches.end(); ) {
+        if (!quads.contains(it.key())) {
+            delete it.value();
+            it = root->batches.erase(it);
         } else {
-            delete tileNode;
+            ++it;
         }
     }
+    for (auto it = quads.cbegin(); it != quads.cend(); ++it) {
+        QGeoTileAtlasPage *page = it.key();
+        QGeoTiledMapTileBatchNode *batch = root->batches.value(page);
+        if (!batch) {
+            batch = new QGeoTiledMapTileBatchNode();
+            root->batches.insert(page, batch);
+            root->appendChildNode(batch);
+        }
+        // Pages of a lower zoom level hold the tiles magnified for overzooming
+        const bool linear = d->m_linearScaling || page->zoom < d->m_intZoomLevel;
+        batch->setTexture(page->texture, linear ? QSGTexture::Linear : QSGTexture::Nearest);
+        batch->setVertices(it.value());
+    }
 }
 
 QSGNode *QGeoTiledMapScene::updateSceneGraph(QSGNode *oldNode, QQuickWindow *window)
@@ -671,46 +1062,50 @@ QSGNode *QGeoTiledMapScene::updateSceneGraph(QSGNode *oldNode, QQuickWindow *win
     mapRoot->root->setMatrix(itemSpaceMatrix);
 
     if (d->m_dropTextures) {
-        for (const QGeoTileSpec &s : mapRoot->tiles->tiles.keys())
-            delete mapRoot->tiles->tiles.take(s);
-        for (const QGeoTileSpec &s : mapRoot->wrapLeft->tiles.keys())
-            delete mapRoot->wrapLeft->tiles.take(s);
-        for (const QGeoTileSpec &s : mapRoot->wrapRight->tiles.keys())
-            delete mapRoot->wrapRight->tiles.take(s);
-        for (const QGeoTileSpec &spec : mapRoot->textures.keys())
-            mapRoot->textures.take(spec)->deleteLater();
+        mapRoot->removeAllTiles();
         d->m_dropTextures = false;
     }
 
     // Evicting loZL tiles temporarily used in place of hiZL ones
     if (d->m_updatedTextures.size()) {
-        const QVector<QGeoTileSpec> &toRemove = d->m_updatedTextures;
-        for (const QGeoTileSpec &s : toRemove) {
-            if (mapRoot->tiles->tiles.contains(s))
-                delete mapRoot->tiles->tiles.take(s);
-
-            if (mapRoot->wrapLeft->tiles.contains(s))
-                delete mapRoot->wrapLeft->tiles.take(s);
-
-            if (mapRoot->wrapRight->tiles.contains(s))
-                delete mapRoot->wrapRight->tiles.take(s);
-
-            if (mapRoot->textures.contains(s))
-                mapRoot->textures.take(s)->deleteLater();
-        }
+        for (const QGeoTileSpec &s : qAsConst(d->m_updatedTextures))
+            mapRoot->removeTile(s);
         d->m_updatedTextures.clear();
     }
 
-    const QSet<QGeoTileSpec> textures = QSet<QGeoTileSpec>::fromList(mapRoot->textures.keys());
-    const QSet<QGeoTileSpec> toRemove = textures - d->m_visibleTiles;
-    const QSet<QGeoTileSpec> toAdd = d->m_visibleTiles - textures;
+    for (auto it = mapRoot->textures.begin(); it != mapRoot->textures.end(); ) {
+        if (!d->m_visibleTiles.contains(it.key())) {
+            it.value()->deleteLater();
+            it = mapRoot->textures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    QVector<QGeoTileSpec> leftAtlas;
+    for (auto it = mapRoot->atlas.entries.cbegin(); it != mapRoot->atlas.entries.cend(); ++it) {
+        if (!d->m_visibleTiles.contains(it.key()))
+            leftAtlas.append(it.key());
+    }
+    for (const QGeoTileSpec &spec : qAsConst(leftAtlas))
+        mapRoot->removeAtlasTile(spec);
 
-    for (const QGeoTileSpec &spec : toRemove)
-        mapRoot->textures.take(spec)->deleteLater();
-    for (const QGeoTileSpec &spec : toAdd) {
+    bool useAtlas = false;
+#if QT_CONFIG(opengl)
+    useAtlas = isOpenGL && d->m_textureAtlasEnabled && QOpenGLContext::currentContext();
+#endif
+    const qreal pixelRatio = window->effectiveDevicePixelRatio();
+    for (const QGeoTileSpec &spec : qAsConst(d->m_visibleTiles)) {
+        if (mapRoot->textures.contains(spec) || mapRoot->atlas.entries.contains(spec))
+            continue;
         QGeoTileTexture *tileTexture = d->m_textures.value(spec).data();
         if (!tileTexture || tileTexture->image.isNull())
             continue;
+        // Tiles with more pixels than shown are mipmapped, which does not work in an atlas
+        const bool downscaled = tileTexture->image.width() > d->m_tileSize * pixelRatio;
+        if (useAtlas && !downscaled
+                && mapRoot->atlas.insert(spec, tileTexture->image, tileTexture->spec.zoom(), window)) {
+            continue;
+        }
         mapRoot->textures.insert(spec, window->createTextureFromImage(tileTexture->image));
     }
 
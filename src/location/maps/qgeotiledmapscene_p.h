@@ -74,6 +74,7 @@ public:
     void setCameraData(const QGeoCameraData &cameraData);
 
     void setVisibleTiles(const QSet<QGeoTileSpec> &tiles);
+    void setVisibleTiles(const QSet<QGeoTileSpec> &tiles, const QSet<QGeoTileSpec> &removed);
     const QSet<QGeoTileSpec> &visibleTiles() const;
 
     void addTile(const QGeoTileSpec &spec, QSharedPointer<QGeoTileTexture> texture);
@@ -84,6 +85,9 @@ public:
 
     void clearTexturedTiles();
 
+    void setTextureAtlasEnabled(bool enabled);
+    bool isTextureAtlasEnabled() const;
+
 Q_SIGNALS:
     void newTilesVisible(const QSet<QGeoTileSpec> &newTiles);
 
@@ -42,9 +42,24 @@
 #include "qgeotiledmapreply_p.h"
 #include "qgeotilespec_p.h"
 #include "qgeotiledmap_p.h"
+#include "qgeotiledmappingmanagerengine_p.h"
+#include "qabstractgeotilecache_p.h"
+
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
+// Matches the number of parallel connections QNetworkAccessManager opens per
+// host; going above it only moves the queueing into the network layer, where
+// priorities are unknown.
+static const int defaultMaxRequestsPerHost = 6;
+// Upper bound on the requests issued in a single timer tick, to keep the
+// event loop responsive when replies finish synchronously
+static const int maxRequestsPerTick = 32;
+// Tiles of saturated hosts are set aside, which only costs a heap operation;
+// bounds the scan for other hosts' tiles behind a long backlog
+static const int maxDeferredPerTick = 256;
+
 QGeoTileFetcher::QGeoTileFetcher(QGeoMappingManagerEngine *parent)
 :   QObject(*new QGeoTileFetcherPrivate(), parent)
 {
@@ -72,8 +87,75 @@ QGeoTileFetcher::~QGeoTileFetcher()
 {
 }
 
+/*!
+    Sets the maximum number of requests in flight to a single host, as told
+    by tileHost(), to \a maxRequests.
+*/
+void QGeoTileFetcher::setMaxRequestsPerHost(int maxRequests)
+{
+    Q_D(QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    d->maxRequestsPerHost_ = qMax(1, maxRequests);
+}
+
+int QGeoTileFetcher::maxRequestsPerHost() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->maxRequestsPerHost_;
+}
+
+/*!
+    Queues the stale cached \a tiles for a conditional request with their
+    validators, at RevalidatePriority unless they are already queued. The
+    outcome is reported by tileNotModified() or tileFinished(). Maps do not
+    cancel revalidations.
+*/
+void QGeoTileFetcher::revalidateTiles(const QHash<QGeoTileSpec, QGeoTileValidators> &tiles)
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+
+    for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+        if (d->invmap_.contains(it.key()))
+            continue;
+        d->revalidate_.insert(it.key(), it.value());
+        if (!d->queue_.contains(it.key()))
+            d->queue_.insert(it.key(), RevalidatePriority);
+    }
+
+    if (d->enabled_ && initialized() && !d->queue_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
+}
+
+/*!
+    Returns the validators to revalidate \a spec with, for getTileImage() to
+    turn into conditional request headers, see
+    QGeoTileValidators::conditionalHeaders(). Tiles that are not being
+    revalidated have none.
+*/
+QGeoTileValidators QGeoTileFetcher::tileValidators(const QGeoTileSpec &spec) const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->revalidate_.value(spec);
+}
+
 void QGeoTileFetcher::updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded,
                                                   const QSet<QGeoTileSpec> &tilesRemoved)
+{
+    QGeoTilePriorityHash prioritized;
+    prioritized.reserve(tilesAdded.size());
+    for (const QGeoTileSpec &spec : tilesAdded)
+        prioritized.insert(spec, VisiblePriority);
+    updateTileRequests(prioritized, tilesRemoved);
+}
+
+/*!
+    Queues \a tilesAdded, mapped to their priority, and cancels \a tilesRemoved.
+    Tiles with a lower priority value are fetched first.
+*/
+void QGeoTileFetcher::updateTileRequests(const QGeoTilePriorityHash &tilesAdded,
+                                         const QSet<QGeoTileSpec> &tilesRemoved)
 {
     Q_D(QGeoTileFetcher);
 
@@ -81,7 +163,10 @@ void QGeoTileFetcher::updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded,
 
     cancelTileRequests(tilesRemoved);
 
-    d->queue_ += tilesAdded.toList();
+    for (auto it = tilesAdded.constBegin(); it != tilesAdded.constEnd(); ++it) {
+        if (!d->invmap_.contains(it.key()))
+            d->queue_.insert(it.key(), it.value());
+    }
 
     if (d->enabled_ && initialized() && !d->queue_.isEmpty() && !d->timer_.isActive())
         d->timer_.start(0, this);
@@ -95,17 +180,28 @@ void QGeoTileFetcher::cancelTileRequests(const QSet<QGeoTileSpec> &tiles)
     tile_iter tile = tiles.constBegin();
     tile_iter end = tiles.constEnd();
     for (; tile != end; ++tile) {
-        QGeoTiledMapReply *reply = d->invmap_.value(*tile, 0);
+        if (d->revalidate_.contains(*tile))
+            continue;
+        if (d->queue_.remove(*tile))
+            continue;
+        QGeoTiledMapReply *reply = d->invmap_.take(*tile);
         if (reply) {
-            d->invmap_.remove(*tile);
+            d->releaseHost(*tile);
+            d->replyStarted_.remove(*tile);
             reply->abort();
             if (reply->isFinished())
                 reply->deleteLater();
         }
-        d->queue_.removeAll(*tile);
     }
 }
 
+/*
+    Issues requests for the most urgent queued tiles, as many as the per host
+    budgets allow, skipping the tiles of saturated hosts. The timer keeps
+    running while ticks issue requests, and is stopped once the whole queue
+    was scanned or nothing could be sent; a reply freeing a slot or new
+    tiles being queued restarts it.
+*/
 void QGeoTileFetcher::requestNextTile()
 {
     Q_D(QGeoTileFetcher);
@@ -115,35 +211,57 @@ void QGeoTileFetcher::requestNextTile()
     if (!d->enabled_)
         return;
 
-    if (d->queue_.isEmpty())
-        return;
-
-    QGeoTileSpec ts = d->queue_.takeFirst();
-    if (d->queue_.isEmpty())
-        d->timer_.stop();
+    QVector<QPair<QGeoTileSpec, int> > deferred;
+    int issued = 0;
+    while (!d->queue_.isEmpty() && issued < maxRequestsPerTick && deferred.size() < maxDeferredPerTick) {
+        int priority = 0;
+        QGeoTileSpec ts = d->queue_.takeFirst(&priority);
+
+        // Check against min/max zoom to prevent sending requests for not existing objects
+        const QGeoCameraCapabilities & cameraCaps = d->engine_->cameraCapabilities(ts.mapId());
+        // the ZL in QGeoTileSpec is relative to the native tile size of the provider.
+        // It gets denormalized in QGeoTiledMap.
+        if (ts.zoom() < cameraCaps.minimumZoomLevel() || ts.zoom() > cameraCaps.maximumZoomLevel() || !fetchingEnabled()) {
+            d->revalidate_.remove(ts);
+            continue;
+        }
 
-    // Check against min/max zoom to prevent sending requests for not existing objects
-    const QGeoCameraCapabilities & cameraCaps = d->engine_->cameraCapabilities(ts.mapId());
-    // the ZL in QGeoTileSpec is relative to the native tile size of the provider.
-    // It gets denormalized in QGeoTiledMap.
-    if (ts.zoom() < cameraCaps.minimumZoomLevel() || ts.zoom() > cameraCaps.maximumZoomLevel() || !fetchingEnabled())
-        return;
+        const QString host = tileHost(ts);
+        if (d->hostRequests_.value(host) >= d->maxRequestsPerHost_) {
+            deferred.append(qMakePair(ts, priority));
+            continue;
+        }
 
-    QGeoTiledMapReply *reply = getTileImage(ts);
-    if (!reply)
-        return;
+        QGeoTiledMapReply *reply = getTileImage(ts);
+        if (!reply) {
+            d->revalidate_.remove(ts);
+            continue;
+        }
+        ++issued;
+
+        if (reply->isFinished()) {
+            handleReply(reply, ts);
+        } else {
+            connect(reply,
+                    SIGNAL(finished()),
+                    this,
+                    SLOT(finished()),
+                    Qt::QueuedConnection);
+
+            d->invmap_.insert(ts, reply);
+            d->replyHosts_.insert(ts, host);
+            d->replyStarted_.insert(ts, d->clock_.nsecsElapsed());
+            ++d->hostRequests_[host];
+        }
+    }
 
-    if (reply->isFinished()) {
-        handleReply(reply, ts);
-    } else {
-        connect(reply,
-                SIGNAL(finished()),
-                this,
-                SLOT(finished()),
-                Qt::QueuedConnection);
+    const bool scanned = d->queue_.isEmpty();
+    for (const auto &tile : qAsConst(deferred))
+        d->queue_.insert(tile.first, tile.second);
 
-        d->invmap_.insert(ts, reply);
-    }
+    // Whatever is left waits for a reply to free a slot
+    if (scanned || issued == 0)
+        d->timer_.stop();
 }
 
 void QGeoTileFetcher::finished()
@@ -164,8 +282,16 @@ void QGeoTileFetcher::finished()
     }
 
     d->invmap_.remove(spec);
+    d->releaseHost(spec);
+    if (reply->error() == QGeoTiledMapReply::NoError)
+        d->recordRoundTrip(spec);
+    else
+        d->replyStarted_.remove(spec);
 
     handleReply(reply, spec);
+
+    if (d->enabled_ && !d->queue_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
 }
 
 void QGeoTileFetcher::timerEvent(QTimerEvent *event)
@@ -194,17 +320,32 @@ bool QGeoTileFetcher::fetchingEnabled() const
     return true;
 }
 
+/*!
+    Returns the host \a spec is fetched from. Requests are throttled per host,
+    as configured with setMaxRequestsPerHost(). The default implementation puts
+    all tiles under the same host.
+*/
+QString QGeoTileFetcher::tileHost(const QGeoTileSpec &spec) const
+{
+    Q_UNUSED(spec);
+    return QString();
+}
+
 void QGeoTileFetcher::handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &spec)
 {
     Q_D(QGeoTileFetcher);
 
+    const QGeoTileValidators validators = d->revalidate_.take(spec);
     if (!d->enabled_) {
         reply->deleteLater();
         return;
     }
 
     if (reply->error() == QGeoTiledMapReply::NoError) {
-        emit tileFinished(spec, reply->mapImageData(), reply->mapImageFormat());
+        if (reply->isNotModified())
+            emit tileNotModified(spec, validators.refreshed(reply->validators()));
+        else
+            emit tileFinished(spec, reply->mapImageData(), reply->mapImageFormat(), reply->validators());
     } else {
         emit tileError(spec, reply->errorString());
     }
@@ -216,12 +357,126 @@ void QGeoTileFetcher::handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &
 *******************************************************************************/
 
 QGeoTileFetcherPrivate::QGeoTileFetcherPrivate()
-:   QObjectPrivate(), enabled_(false), engine_(0)
+:   QObjectPrivate(), enabled_(false), maxRequestsPerHost_(defaultMaxRequestsPerHost), engine_(0)
 {
+    clock_.start();
+}
+
+/*
+    Feeds the time since the request for spec was issued into the tile cache
+    statistics of the engine.
+*/
+void QGeoTileFetcherPrivate::recordRoundTrip(const QGeoTileSpec &spec)
+{
+    const auto it = replyStarted_.find(spec);
+    if (it == replyStarted_.end())
+        return;
+    const qint64 usecs = (clock_.nsecsElapsed() - it.value()) / 1000;
+    replyStarted_.erase(it);
+
+    QGeoTiledMappingManagerEngine *engine = qobject_cast<QGeoTiledMappingManagerEngine *>(engine_);
+    if (engine && engine->tileCache())
+        engine->tileCache()->recordFetchTime(usecs);
 }
 
 QGeoTileFetcherPrivate::~QGeoTileFetcherPrivate()
 {
 }
 
+void QGeoTileFetcherPrivate::releaseHost(const QGeoTileSpec &spec)
+{
+    auto it = replyHosts_.find(spec);
+    if (it == replyHosts_.end())
+        return;
+    auto count = hostRequests_.find(it.value());
+    if (count != hostRequests_.end() && --count.value() <= 0)
+        hostRequests_.erase(count);
+    replyHosts_.erase(it);
+}
+
+QGeoTileFetchQueue::QGeoTileFetchQueue()
+    : sequence_(0)
+{
+}
+
+/*
+    Returns true if a should come out of the heap after b.
+*/
+bool QGeoTileFetchQueue::lessUrgent(const Entry &a, const Entry &b)
+{
+    if (a.priority != b.priority)
+        return a.priority > b.priority;
+    return a.sequence > b.sequence;
+}
+
+void QGeoTileFetchQueue::insert(const QGeoTileSpec &spec, int priority)
+{
+    // Re-inserting supersedes the previous entry, which becomes stale
+    Entry e;
+    e.priority = priority;
+    e.sequence = sequence_++;
+    e.spec = spec;
+    live_.insert(spec, e.sequence);
+    heap_.append(e);
+    std::push_heap(heap_.begin(), heap_.end(), lessUrgent);
+    compact();
+}
+
+bool QGeoTileFetchQueue::remove(const QGeoTileSpec &spec)
+{
+    if (!live_.remove(spec))
+        return false;
+    compact();
+    return true;
+}
+
+QGeoTileSpec QGeoTileFetchQueue::takeFirst(int *priority)
+{
+    dropStale();
+    Q_ASSERT(!heap_.isEmpty());
+    std::pop_heap(heap_.begin(), heap_.end(), lessUrgent);
+    const Entry e = heap_.takeLast();
+    live_.remove(e.spec);
+    if (priority)
+        *priority = e.priority;
+    return e.spec;
+}
+
+void QGeoTileFetchQueue::clear()
+{
+    heap_.clear();
+    live_.clear();
+}
+
+void QGeoTileFetchQueue::dropStale()
+{
+    while (!heap_.isEmpty()) {
+        const Entry &top = heap_.first();
+        const auto it = live_.constFind(top.spec);
+        if (it != live_.constEnd() && it.value() == top.sequence)
+            return;
+        std::pop_heap(heap_.begin(), heap_.end(), lessUrgent);
+        heap_.removeLast();
+    }
+}
+
+/*
+    Rebuilds the heap without its stale entries once they make up most of it,
+    so that heavy cancellation does not let it grow unbounded.
+*/
+void QGeoTileFetchQueue::compact()
+{
+    if (heap_.size() < 64 || heap_.size() < 2 * live_.size())
+        return;
+    QVector<Entry> heap;
+    heap.reserve(live_.size());
+    for (const Entry &e : qAsConst(heap_)) {
+        const auto it = live_.constFind(e.spec);
+        if (it != live_.constEnd() && it.value() == e.sequence)
+            heap.append(e);
+    }
+    std::make_heap(heap.begin(), heap.end(), lessUrgent);
+    heap_.swap(heap);
+}
+
 QT_END_NAMESPACE
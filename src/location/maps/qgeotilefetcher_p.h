@@ -52,6 +52,7 @@
 #include <QtLocation/private/qlocationglobal_p.h>
 #include "qgeomaptype_p.h"
 #include "qgeotiledmappingmanagerengine_p.h"
+#include "qgeotilevalidators_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -62,17 +63,35 @@ class QGeoTiledMappingManagerEngine;
 class QGeoTiledMapReply;
 class QGeoTileSpec;
 
+// Tiles to fetch, mapped to their priority
+typedef QHash<QGeoTileSpec, int> QGeoTilePriorityHash;
+
 class Q_LOCATION_PRIVATE_EXPORT QGeoTileFetcher : public QObject
 {
     Q_OBJECT
     Q_DECLARE_PRIVATE(QGeoTileFetcher)
 
 public:
+    // Lower values are fetched first
+    enum RequestPriority {
+        VisiblePriority = 0,            // plus the distance to the viewport center
+        PredictedPriority = 1 << 23,    // plus the rank along the predicted camera path
+        PrefetchPriority = 1 << 24,     // plus the distance to the viewport center
+        RevalidatePriority = 1 << 25,   // stale cached tiles, which are displayed meanwhile
+        SeedPriority = 1 << 26          // offline region seeding, after anything a map wants
+    };
+
     QGeoTileFetcher(QGeoMappingManagerEngine *parent);
     virtual ~QGeoTileFetcher();
 
+    void setMaxRequestsPerHost(int maxRequests);
+    int maxRequestsPerHost() const;
+
+    void revalidateTiles(const QHash<QGeoTileSpec, QGeoTileValidators> &tiles);
+
 public Q_SLOTS:
     void updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
+    void updateTileRequests(const QGeoTilePriorityHash &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
 
 private Q_SLOTS:
     void cancelTileRequests(const QSet<QGeoTileSpec> &tiles);
@@ -80,7 +99,9 @@ private Q_SLOTS:
     void finished();
 
 Q_SIGNALS:
-    void tileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
+    void tileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format,
+                      const QGeoTileValidators &validators);
+    void tileNotModified(const QGeoTileSpec &spec, const QGeoTileValidators &validators);
     void tileError(const QGeoTileSpec &spec, const QString &errorString);
 
 protected:
@@ -90,6 +111,8 @@ protected:
     QAbstractGeoTileCache::CacheAreas cacheHint() const;
     virtual bool initialized() const;
     virtual bool fetchingEnabled() const;
+    virtual QString tileHost(const QGeoTileSpec &spec) const;
+    QGeoTileValidators tileValidators(const QGeoTileSpec &spec) const;
 
 private:
 
@@ -56,17 +56,53 @@
 #include <QMap>
 #include <QLocale>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QHash>
+#include <QVector>
 #include "qgeomaptype_p.h"
+#include "qgeotilespec_p.h"
 
 QT_BEGIN_NAMESPACE
 
-class QGeoTileSpec;
 class QGeoTiledMapReply;
 class QGeoMappingManagerEngine;
 
+/* Tiles waiting to be fetched, lowest priority value first and in insertion
+ * order among equal priorities. Cancellation is O(1): removed or re-prioritized
+ * tiles are only dropped from the lookup hash, and their stale heap entries are
+ * skipped when they reach the top. */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileFetchQueue
+{
+public:
+    QGeoTileFetchQueue();
+
+    inline bool isEmpty() const { return live_.isEmpty(); }
+    inline int size() const { return live_.size(); }
+    inline bool contains(const QGeoTileSpec &spec) const { return live_.contains(spec); }
+
+    void insert(const QGeoTileSpec &spec, int priority);
+    bool remove(const QGeoTileSpec &spec);
+    QGeoTileSpec takeFirst(int *priority = 0);
+    void clear();
+
+private:
+    struct Entry
+    {
+        int priority;
+        quint64 sequence;
+        QGeoTileSpec spec;
+    };
+    static bool lessUrgent(const Entry &a, const Entry &b);
+    void dropStale();
+    void compact();
+
+    QVector<Entry> heap_;
+    QHash<QGeoTileSpec, quint64> live_;
+    quint64 sequence_;
+};
+
 class Q_LOCATION_PRIVATE_EXPORT QGeoTileFetcherPrivate : public QObjectPrivate
 {
     Q_DECLARE_PUBLIC(QGeoTileFetcher)
@@ -74,11 +110,20 @@ public:
     QGeoTileFetcherPrivate();
     virtual ~QGeoTileFetcherPrivate();
 
+    void releaseHost(const QGeoTileSpec &spec);
+    void recordRoundTrip(const QGeoTileSpec &spec);
+
     bool enabled_;
     QBasicTimer timer_;
     QMutex queueMutex_;
-    QList<QGeoTileSpec> queue_;
+    QGeoTileFetchQueue queue_;
     QHash<QGeoTileSpec, QGeoTiledMapReply *> invmap_;
+    QHash<QGeoTileSpec, QString> replyHosts_;
+    QHash<QString, int> hostRequests_;
+    QHash<QGeoTileSpec, qint64> replyStarted_;   // clock_ time of the request, in ns
+    QHash<QGeoTileSpec, QGeoTileValidators> revalidate_;  // tiles to fetch with a conditional request
+    QElapsedTimer clock_;
+    int maxRequestsPerHost_;
     QGeoMappingManagerEngine *engine_;
 
 private:
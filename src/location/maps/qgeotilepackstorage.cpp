@@ -0,0 +1,486 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilepackstorage_p.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QThread>
+#include <QRandomGenerator>
+#include <QDebug>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+/* Pack layout: a fixed header followed by records.
+ *
+ *   header: magic, version, generation               (3 x quint32)
+ *   record: name length, data length, timestamp, name, data
+ *           (quint32, quint32, qint64, UTF-8 name, raw bytes)
+ *
+ * A data length of tombstoneLength marks the removal of the named tile.
+ * All integers are big endian, as written by QDataStream. The generation
+ * changes whenever the pack is rewritten, so that an index written for an
+ * older pack is never applied to a newer one. */
+static const quint32 packMagic = 0x51475450; // "QGTP"
+static const quint32 packIndexMagic = 0x51475058; // "QGPX"
+static const quint32 packVersion = 1;
+static const qint64 packHeaderSize = 3 * sizeof(quint32);
+static const quint32 recordHeaderSize = 2 * sizeof(quint32) + sizeof(qint64);
+static const quint32 tombstoneLength = 0xFFFFFFFF;
+static const qint64 minCompactionSize = 1024 * 1024;
+
+static QString packFileName()
+{
+    return QStringLiteral("tiles.pack");
+}
+
+static QString packIndexFileName()
+{
+    return QStringLiteral("tiles.pack.index");
+}
+
+static inline QString baseName(const QString &filename)
+{
+    return filename.mid(filename.lastIndexOf(QLatin1Char('/')) + 1);
+}
+
+static QByteArray packHeader(quint32 generation)
+{
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out << packMagic << packVersion << generation;
+    return header;
+}
+
+QGeoTilePackStorage::QGeoTilePackStorage()
+    : m_generation(0), m_liveBytes(0), m_dirty(false)
+{
+}
+
+QGeoTilePackStorage::~QGeoTilePackStorage()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_pack.isOpen())
+        return;
+    if (needsCompaction())
+        compactLocked();
+    else if (m_dirty)
+        saveIndex();
+    m_pack.close();
+}
+
+bool QGeoTilePackStorage::open(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_directory = directory;
+    m_records.clear();
+    m_liveBytes = 0;
+    QDir::root().mkpath(directory);
+
+    m_pack.setFileName(QDir(directory).filePath(packFileName()));
+    if (!m_pack.open(QIODevice::ReadWrite)) {
+        qWarning() << "Unable to open tile pack" << m_pack.fileName();
+        return false;
+    }
+
+    QDataStream in(&m_pack);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version >> m_generation;
+    if (in.status() != QDataStream::Ok || magic != packMagic || version != packVersion) {
+        if (m_pack.size() > 0)
+            qWarning() << "Discarding unreadable tile pack" << m_pack.fileName();
+        if (!createPack())
+            return false;
+    } else {
+        if (!loadIndex())
+            replay(packHeaderSize);
+    }
+
+    if (needsCompaction())
+        compactLocked();
+    return true;
+}
+
+bool QGeoTilePackStorage::createPack()
+{
+    m_generation = QRandomGenerator::global()->generate();
+    m_records.clear();
+    m_liveBytes = 0;
+    if (!m_pack.resize(0) || !m_pack.seek(0) || m_pack.write(packHeader(m_generation)) != packHeaderSize) {
+        qWarning() << "Unable to initialize tile pack" << m_pack.fileName();
+        m_pack.close();
+        return false;
+    }
+    QFile::remove(QDir(m_directory).filePath(packIndexFileName()));
+    m_dirty = true;
+    return true;
+}
+
+bool QGeoTilePackStorage::loadIndex()
+{
+    QFile file(QDir(m_directory).filePath(packIndexFileName()));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray data = file.readAll();
+    file.close();
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_8);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 generation = 0;
+    qint64 covered = 0;
+    quint32 count = 0;
+    in >> magic >> version >> generation >> covered >> count;
+    if (in.status() != QDataStream::Ok || magic != packIndexMagic || version != packVersion
+            || generation != m_generation || covered < packHeaderSize || covered > m_pack.size())
+        return false;
+
+    m_records.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        QString name;
+        Record r;
+        in >> name >> r.offset >> r.headerSize >> r.dataSize >> r.timestamp;
+        if (in.status() != QDataStream::Ok
+                || r.offset < packHeaderSize || r.offset + r.headerSize + r.dataSize > covered) {
+            m_records.clear();
+            m_liveBytes = 0;
+            return false;
+        }
+        m_records.insert(name, r);
+        m_liveBytes += r.headerSize + r.dataSize;
+    }
+
+    // Pick up whatever was appended after the index was last written
+    replay(covered);
+    return true;
+}
+
+/*
+    Reads the records from \a from to the end of the pack into the in-memory
+    index. A trailing record that was only partially written is cut off.
+*/
+void QGeoTilePackStorage::replay(qint64 from)
+{
+    const qint64 end = m_pack.size();
+    qint64 pos = from;
+    m_pack.seek(pos);
+    QDataStream in(&m_pack);
+    while (pos < end) {
+        quint32 nameLength = 0;
+        quint32 dataLength = 0;
+        qint64 timestamp = 0;
+        in >> nameLength >> dataLength >> timestamp;
+        if (in.status() != QDataStream::Ok || pos + recordHeaderSize + nameLength > end)
+            break;
+        const QByteArray name = m_pack.read(nameLength);
+        if (name.size() != int(nameLength))
+            break;
+        const QString key = QString::fromUtf8(name);
+        const bool tombstone = dataLength == tombstoneLength;
+        const qint64 recordEnd = pos + recordHeaderSize + nameLength + (tombstone ? 0 : dataLength);
+        if (recordEnd > end)
+            break;
+
+        auto it = m_records.find(key);
+        if (it != m_records.end()) {
+            m_liveBytes -= it->headerSize + it->dataSize;
+            m_records.erase(it);
+        }
+        if (!tombstone) {
+            Record r;
+            r.offset = pos;
+            r.headerSize = recordHeaderSize + nameLength;
+            r.dataSize = dataLength;
+            r.timestamp = timestamp;
+            m_records.insert(key, r);
+            m_liveBytes += r.headerSize + r.dataSize;
+        }
+
+        pos = recordEnd;
+        if (!m_pack.seek(pos))
+            break;
+        m_dirty = true;
+    }
+
+    if (pos < end) {
+        qWarning() << "Truncating incomplete record at" << pos << "in tile pack" << m_pack.fileName();
+        m_pack.resize(pos);
+        m_dirty = true;
+    }
+}
+
+bool QGeoTilePackStorage::appendRecord(const QString &name, const QByteArray *bytes, Record *record)
+{
+    const QByteArray utf8 = name.toUtf8();
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    QByteArray buffer;
+    buffer.reserve(recordHeaderSize + utf8.size() + (bytes ? bytes->size() : 0));
+    {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out << quint32(utf8.size()) << (bytes ? quint32(bytes->size()) : tombstoneLength) << timestamp;
+    }
+    buffer += utf8;
+    if (bytes)
+        buffer += *bytes;
+
+    const qint64 offset = m_pack.size();
+    if (!m_pack.seek(offset) || m_pack.write(buffer) != buffer.size()) {
+        // Don't leave a partial record behind for the next replay
+        m_pack.resize(offset);
+        return false;
+    }
+    m_dirty = true;
+
+    if (record) {
+        record->offset = offset;
+        record->headerSize = recordHeaderSize + utf8.size();
+        record->dataSize = bytes ? bytes->size() : 0;
+        record->timestamp = timestamp;
+    }
+    return true;
+}
+
+bool QGeoTilePackStorage::write(const QString &filename, const QByteArray &bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_pack.isOpen())
+        return false;
+
+    const QString name = baseName(filename);
+    Record r;
+    if (!appendRecord(name, &bytes, &r))
+        return false;
+
+    auto it = m_records.find(name);
+    if (it != m_records.end()) {
+        m_liveBytes -= it->headerSize + it->dataSize;
+        *it = r;
+    } else {
+        m_records.insert(name, r);
+    }
+    m_liveBytes += r.headerSize + r.dataSize;
+    if (needsCompaction())
+        compactLocked();
+    return true;
+}
+
+bool QGeoTilePackStorage::read(const QString &filename, QByteArray *bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_records.constFind(baseName(filename));
+    if (it == m_records.constEnd() || !m_pack.seek(it->offset + it->headerSize))
+        return false;
+    *bytes = m_pack.read(it->dataSize);
+    return bytes->size() == int(it->dataSize);
+}
+
+qint64 QGeoTilePackStorage::size(const QString &filename)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_records.constFind(baseName(filename));
+    return it == m_records.constEnd() ? 0 : qint64(it->dataSize);
+}
+
+QDateTime QGeoTilePackStorage::lastModified(const QString &filename)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_records.constFind(baseName(filename));
+    if (it == m_records.constEnd())
+        return QDateTime();
+    return QDateTime::fromMSecsSinceEpoch(it->timestamp);
+}
+
+void QGeoTilePackStorage::remove(const QString &filename)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString name = baseName(filename);
+    auto it = m_records.find(name);
+    if (it == m_records.end())
+        return;
+    if (!appendRecord(name, 0, 0))
+        return;
+    m_liveBytes -= it->headerSize + it->dataSize;
+    m_records.erase(it);
+    if (needsCompaction())
+        compactLocked();
+}
+
+void QGeoTilePackStorage::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pack.isOpen())
+        createPack();
+}
+
+bool QGeoTilePackStorage::list(QVector<Entry> *entries, bool withSizes)
+{
+    QVector<Entry> result;
+    {
+        QMutexLocker locker(&m_mutex);
+        result.reserve(m_records.size());
+        for (auto it = m_records.constBegin(); it != m_records.constEnd(); ++it) {
+            Entry e;
+            e.fileName = it.key();
+            e.size = withSizes ? qint64(it->dataSize) : -1;
+            result.append(e);
+        }
+    }
+    if (QThread::currentThread()->isInterruptionRequested())
+        return false;
+    *entries += result;
+    return true;
+}
+
+void QGeoTilePackStorage::sync()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_pack.isOpen())
+        return;
+    m_pack.flush();
+    if (m_dirty)
+        saveIndex();
+}
+
+void QGeoTilePackStorage::saveIndex()
+{
+    QSaveFile file(QDir(m_directory).filePath(packIndexFileName()));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write tile pack index" << file.fileName();
+        return;
+    }
+
+    m_pack.flush();
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_8);
+    out << packIndexMagic << packVersion << m_generation << m_pack.size() << quint32(m_records.size());
+    for (auto it = m_records.constBegin(); it != m_records.constEnd(); ++it)
+        out << it.key() << it->offset << it->headerSize << it->dataSize << it->timestamp;
+
+    if (file.commit())
+        m_dirty = false;
+    else
+        qWarning() << "Unable to write tile pack index" << file.fileName();
+}
+
+qint64 QGeoTilePackStorage::liveBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_liveBytes;
+}
+
+qint64 QGeoTilePackStorage::deadBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pack.isOpen() ? m_pack.size() - packHeaderSize - m_liveBytes : 0;
+}
+
+/*
+    A rewrite costs as much as the live records, and only happens once at
+    least as many dead bytes have been appended since the last one, so
+    compacting from write() and remove() keeps the amortized cost of each
+    append constant while bounding the pack to twice its live size.
+*/
+bool QGeoTilePackStorage::needsCompaction() const
+{
+    const qint64 dead = m_pack.size() - packHeaderSize - m_liveBytes;
+    return dead > minCompactionSize && dead > m_liveBytes;
+}
+
+bool QGeoTilePackStorage::compact()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_pack.isOpen())
+        return false;
+    return compactLocked();
+}
+
+/*
+    Rewrites the pack with the live records only, in their current order,
+    under a new generation.
+*/
+bool QGeoTilePackStorage::compactLocked()
+{
+    QVector<QPair<qint64, QString> > order;
+    order.reserve(m_records.size());
+    for (auto it = m_records.constBegin(); it != m_records.constEnd(); ++it)
+        order.append(qMakePair(it->offset, it.key()));
+    std::sort(order.begin(), order.end());
+
+    QSaveFile out(m_pack.fileName());
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+
+    const quint32 generation = QRandomGenerator::global()->generate();
+    out.write(packHeader(generation));
+    QHash<QString, Record> records;
+    records.reserve(m_records.size());
+    qint64 pos = packHeaderSize;
+    for (const auto &entry : qAsConst(order)) {
+        Record r = m_records.value(entry.second);
+        const qint64 length = r.headerSize + r.dataSize;
+        if (!m_pack.seek(r.offset))
+            return false;
+        const QByteArray record = m_pack.read(length);
+        if (record.size() != length || out.write(record) != length)
+            return false;
+        r.offset = pos;
+        pos += length;
+        records.insert(entry.second, r);
+    }
+
+    m_pack.close();
+    const bool committed = out.commit();
+    if (!m_pack.open(QIODevice::ReadWrite)) {
+        qWarning() << "Unable to reopen tile pack" << m_pack.fileName();
+        m_records.clear();
+        m_liveBytes = 0;
+        return false;
+    }
+    if (!committed)
+        return false;
+
+    m_records = records;
+    m_generation = generation;
+    m_dirty = true;
+    saveIndex();
+    return true;
+}
+
+QT_END_NAMESPACE
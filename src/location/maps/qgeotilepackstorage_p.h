@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEPACKSTORAGE_P_H
+#define QGEOTILEPACKSTORAGE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qgeotilediskstorage_p.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * QGeoTilePackStorage
+ *
+ * Stores all tiles of a cache directory in a single append-only pack file,
+ * "tiles.pack", plus an offset index, "tiles.pack.index", rewritten on sync().
+ * Overwrites and removals append a new record (a tombstone for removals),
+ * which keeps every write a single sequential append. Records past the part
+ * covered by the index are replayed on open, and a truncated trailing record
+ * left by a crash is discarded. The pack is compacted on open, after a write
+ * or removal, and on destruction once dead records outweigh live ones.
+ */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTilePackStorage : public QGeoTileDiskStorage
+{
+public:
+    QGeoTilePackStorage();
+    ~QGeoTilePackStorage();
+
+    bool open(const QString &directory) Q_DECL_OVERRIDE;
+    bool write(const QString &filename, const QByteArray &bytes) Q_DECL_OVERRIDE;
+    bool read(const QString &filename, QByteArray *bytes) Q_DECL_OVERRIDE;
+    qint64 size(const QString &filename) Q_DECL_OVERRIDE;
+    QDateTime lastModified(const QString &filename) Q_DECL_OVERRIDE;
+    void remove(const QString &filename) Q_DECL_OVERRIDE;
+    void clear() Q_DECL_OVERRIDE;
+    bool list(QVector<Entry> *entries, bool withSizes) Q_DECL_OVERRIDE;
+    void sync() Q_DECL_OVERRIDE;
+
+    qint64 liveBytes() const;
+    qint64 deadBytes() const;
+    bool compact();
+
+private:
+    struct Record
+    {
+        qint64 offset;       // start of the record in the pack
+        quint32 headerSize;  // fixed header + name
+        quint32 dataSize;
+        qint64 timestamp;    // msecs since epoch
+    };
+
+    bool createPack();
+    bool loadIndex();
+    void replay(qint64 from);
+    bool appendRecord(const QString &name, const QByteArray *bytes, Record *record);
+    void saveIndex();
+    bool needsCompaction() const;
+    bool compactLocked();
+
+    QString m_directory;
+    QFile m_pack;
+    QHash<QString, Record> m_records;
+    quint32 m_generation;
+    qint64 m_liveBytes;
+    mutable QMutex m_mutex;
+    bool m_dirty;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEPACKSTORAGE_P_H
@@ -38,6 +38,7 @@
 #include "qgeotiledmap_p.h"
 #include "qgeotiledmappingmanagerengine_p.h"
 #include "qabstractgeotilecache_p.h"
+#include "qgeotilefetcher_p.h"
 #include <QtCore/QPointer>
 
 QT_BEGIN_NAMESPACE
@@ -59,8 +60,15 @@ public:
     QHash<QGeoTileSpec, int> m_retries;
     QHash<QGeoTileSpec, QSharedPointer<RetryFuture> > m_futures;
     QSet<QGeoTileSpec> m_requested;
+    QSet<QGeoTileSpec> m_decoding;
+    QDoubleVector2D m_center;
+    QSet<QGeoTileSpec> m_visible;
+    QHash<QGeoTileSpec, int> m_predicted;
+
+    int priority(const QGeoTileSpec &tile) const;
 
     void tileFetched(const QGeoTileSpec &spec);
+    void tilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed);
 };
 
 QGeoTileRequestManager::QGeoTileRequestManager(QGeoTiledMap *map, QGeoTiledMappingManagerEngine *engine)
@@ -79,11 +87,37 @@ QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > QGeoTileRequestManager::req
     return d_ptr->requestTiles(tiles);
 }
 
+/*
+    Sets the mercator \a center of the viewport and the \a visibleTiles, used to
+    prioritize the tiles requested next: visible tiles first, nearest to the
+    center first, then prefetched ones.
+*/
+void QGeoTileRequestManager::setViewport(const QDoubleVector2D &center, const QSet<QGeoTileSpec> &visibleTiles)
+{
+    d_ptr->m_center = center;
+    d_ptr->m_visible = visibleTiles;
+}
+
+/*
+    Sets the tiles expected along the camera path of a running gesture, mapped
+    to their rank: the order in which the camera is expected to reach them.
+    They are fetched after the visible tiles and before anything prefetched.
+*/
+void QGeoTileRequestManager::setPredictedTiles(const QHash<QGeoTileSpec, int> &rankedTiles)
+{
+    d_ptr->m_predicted = rankedTiles;
+}
+
 void QGeoTileRequestManager::tileFetched(const QGeoTileSpec &spec)
 {
     d_ptr->tileFetched(spec);
 }
 
+void QGeoTileRequestManager::tilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed)
+{
+    d_ptr->tilesDecoded(decoded, failed);
+}
+
 QSharedPointer<QGeoTileTexture> QGeoTileRequestManager::tileTexture(const QGeoTileSpec &spec)
 {
     if (d_ptr->m_engine)
@@ -110,7 +144,8 @@ QGeoTileRequestManagerPrivate::~QGeoTileRequestManagerPrivate()
 QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTiles(const QSet<QGeoTileSpec> &tiles)
 {
     QSet<QGeoTileSpec> cancelTiles = m_requested - tiles;
-    QSet<QGeoTileSpec> requestTiles = tiles - m_requested;
+    QSet<QGeoTileSpec> cancelDecodes = m_decoding - tiles;
+    QSet<QGeoTileSpec> requestTiles = tiles - m_requested - m_decoding;
     QSet<QGeoTileSpec> cached;
 //    int tileSize = tiles.size();
 //    int newTiles = requestTiles.size();
@@ -121,30 +156,34 @@ QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPriva
 
     // remove tiles in cache from request tiles
     if (!m_engine.isNull()) {
+        // Tiles that left the view don't need decoding anymore
+        if (!cancelDecodes.isEmpty()) {
+            m_engine->cancelTileTextures(m_map, cancelDecodes);
+            m_decoding -= cancelDecodes;
+        }
+
         iter i = requestTiles.constBegin();
         iter end = requestTiles.constEnd();
         for (; i != end; ++i) {
             QGeoTileSpec tile = *i;
-            QSharedPointer<QGeoTileTexture> tex = m_engine->getTileTexture(tile);
+            // Tiles still to be read and decoded from the cache are delivered
+            // later through tilesDecoded(), and only fetched if that fails
+            bool pending = false;
+            QSharedPointer<QGeoTileTexture> tex = m_engine->getTileTextureAsync(m_map, tile, &pending);
+            if (pending) {
+                m_decoding.insert(tile);
+                cached.insert(tile);
+            }
             if (tex) {
                 if (!tex->image.isNull())
                     cachedTex.insert(tile, tex);
                 cached.insert(tile);
-            } else {
-                // Try to use textures from lower zoom levels, but still request the proper tile
-                QGeoTileSpec spec = tile;
-                const int endRange = qMax(0, tile.zoom() - 4); // Using up to 4 zoom levels up. 4 is arbitrary.
-                for (int z = tile.zoom() - 1; z >= endRange; z--) {
-                    int denominator = 1 << (tile.zoom() - z);
-                    spec.setZoom(z);
-                    spec.setX(tile.x() / denominator);
-                    spec.setY(tile.y() / denominator);
-                    QSharedPointer<QGeoTileTexture> t = m_engine->getTileTexture(spec);
-                    if (t && !t->image.isNull()) {
-                        cachedTex.insert(tile, t);
-                        break;
-                    }
-                }
+            } else if (m_visible.contains(tile)) {
+                // Show a stand-in made from the decoded parent or children
+                // meanwhile, but still request the proper tile
+                QSharedPointer<QGeoTileTexture> t = m_engine->getTilePlaceholder(tile);
+                if (t && !t->image.isNull())
+                    cachedTex.insert(tile, t);
             }
         }
     }
@@ -159,7 +198,11 @@ QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPriva
     if (!requestTiles.isEmpty() || !cancelTiles.isEmpty()) {
         if (!m_engine.isNull()) {
 //            qDebug() << "new server requests: " << requestTiles.size() << ", server cancels: " << cancelTiles.size();
-            m_engine->updateTileRequests(m_map, requestTiles, cancelTiles);
+            QHash<QGeoTileSpec, int> priorities;
+            priorities.reserve(requestTiles.size());
+            for (const QGeoTileSpec &tile : qAsConst(requestTiles))
+                priorities.insert(tile, priority(tile));
+            m_engine->updateTileRequests(m_map, requestTiles, cancelTiles, priorities);
 
             // Remove any cancelled tiles from the error retry hash to avoid
             // re-using the numbers for a totally different request cycle.
@@ -175,6 +218,28 @@ QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPriva
     return cachedTex;
 }
 
+int QGeoTileRequestManagerPrivate::priority(const QGeoTileSpec &tile) const
+{
+    // Squared distance between the tile and the viewport centers, in quarter tiles
+    const double side = double(1 << tile.zoom());
+    double dx = tile.x() + 0.5 - m_center.x() * side;
+    const double dy = tile.y() + 0.5 - m_center.y() * side;
+    if (dx > side / 2)
+        dx -= side;
+    else if (dx < -side / 2)
+        dx += side;
+    const double squared = 16.0 * (dx * dx + dy * dy);
+
+    if (m_visible.contains(tile))
+        return QGeoTileFetcher::VisiblePriority + int(qMin(squared, double(QGeoTileFetcher::PredictedPriority - 1)));
+
+    const auto predicted = m_predicted.constFind(tile);
+    if (predicted != m_predicted.constEnd())
+        return QGeoTileFetcher::PredictedPriority + qMin(predicted.value(), QGeoTileFetcher::PredictedPriority - 1);
+
+    return QGeoTileFetcher::PrefetchPriority + int(qMin(squared, double(QGeoTileFetcher::PrefetchPriority - 1)));
+}
+
 void QGeoTileRequestManagerPrivate::tileFetched(const QGeoTileSpec &spec)
 {
     m_map->updateTile(spec);
@@ -183,6 +248,25 @@ void QGeoTileRequestManagerPrivate::tileFetched(const QGeoTileSpec &spec)
     m_futures.remove(spec);
 }
 
+void QGeoTileRequestManagerPrivate::tilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed)
+{
+    for (const QGeoTileSpec &spec : decoded) {
+        if (m_decoding.remove(spec))
+            m_map->updateTile(spec);
+    }
+
+    // Whatever could not be loaded from the cache goes to the network instead
+    QSet<QGeoTileSpec> requestTiles;
+    for (const QGeoTileSpec &spec : failed) {
+        if (m_decoding.remove(spec))
+            requestTiles.insert(spec);
+    }
+    if (requestTiles.isEmpty() || m_engine.isNull())
+        return;
+    m_requested += requestTiles;
+    m_engine->updateTileRequests(m_map, requestTiles, QSet<QGeoTileSpec>());
+}
+
 // Represents a tile that needs to be retried after a certain period of time
 class RetryFuture : public QObject
 {
@@ -48,6 +48,8 @@
 //
 
 #include <QtCore/QSharedPointer>
+#include <QtCore/QHash>
+#include <QtPositioning/private/qdoublevector2d_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -65,9 +67,12 @@ public:
     ~QGeoTileRequestManager();
 
     QMap<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > requestTiles(const QSet<QGeoTileSpec> &tiles);
+    void setViewport(const QDoubleVector2D &center, const QSet<QGeoTileSpec> &visibleTiles);
+    void setPredictedTiles(const QHash<QGeoTileSpec, int> &rankedTiles);
 
     void tileError(const QGeoTileSpec &tile, const QString &errorString);
     void tileFetched(const QGeoTileSpec &spec);
+    void tilesDecoded(const QList<QGeoTileSpec> &decoded, const QList<QGeoTileSpec> &failed);
     QSharedPointer<QGeoTileTexture> tileTexture(const QGeoTileSpec &spec);
 
 private:
@@ -0,0 +1,438 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotileseedjob_p.h"
+#include "qgeotiledmappingmanagerengine_p.h"
+#include "qabstractgeotilecache_p.h"
+
+#include <QtPositioning/QGeoPath>
+#include <QtPositioning/QGeoPolygon>
+#include <QtPositioning/QGeoRectangle>
+#include <QtPositioning/private/qwebmercator_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+#include <QtPositioning/private/qlocationutils_p.h>
+#include <QTimerEvent>
+#include <QtCore/qmath.h>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+// Candidates looked at per timer tick, most of them are usually skipped when resuming
+static const int maxScannedPerTick = 4096;
+
+static int tileIndex(double mercator, int side)
+{
+    return qBound(0, int(std::floor(qBound(0.0, mercator, 1.0) * side)), side - 1);
+}
+
+/*
+    Returns whether the segment from \a a to \a b crosses the rectangle
+    \a x0, \a y0, \a x1, \a y1, by Liang-Barsky clipping.
+*/
+static bool segmentIntersects(const QDoubleVector2D &a, const QDoubleVector2D &b,
+                              double x0, double y0, double x1, double y1)
+{
+    const double dx = b.x() - a.x();
+    const double dy = b.y() - a.y();
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { a.x() - x0, x1 - a.x(), a.y() - y0, y1 - a.y() };
+    double t0 = 0.0;
+    double t1 = 1.0;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0)
+                return false;
+        } else {
+            const double t = q[i] / p[i];
+            if (p[i] < 0.0)
+                t0 = qMax(t0, t);
+            else
+                t1 = qMin(t1, t);
+            if (t0 > t1)
+                return false;
+        }
+    }
+    return true;
+}
+
+QGeoTileSeedJob::QGeoTileSeedJob(QGeoTiledMappingManagerEngine *engine, const QGeoShape &region,
+                                 int minimumZoomLevel, int maximumZoomLevel, int mapId,
+                                 quint64 startPosition)
+    : QObject(engine),
+      engine_(engine),
+      pluginString_(engine->managerName() + QLatin1Char('_') + QString::number(engine->managerVersion())),
+      version_(engine->tileVersion()),
+      region_(region),
+      minimumZoomLevel_(minimumZoomLevel),
+      maximumZoomLevel_(maximumZoomLevel),
+      mapId_(mapId),
+      state_(Running),
+      tileCount_(0),
+      next_(0),
+      fetched_(0),
+      skipped_(0),
+      failed_(0),
+      tilesPerSecond_(10),
+      maxPendingTiles_(4)
+{
+    QList<QGeoCoordinate> vertices;
+    if (region.type() == QGeoShape::PathType)
+        vertices = QGeoPath(region).path();
+    else if (region.type() == QGeoShape::PolygonType)
+        vertices = QGeoPolygon(region).path();
+    // Unwrapped, so that each segment takes the short way across the dateline
+    for (const QGeoCoordinate &vertex : qAsConst(vertices)) {
+        QDoubleVector2D p = QWebMercator::coordToMercator(vertex);
+        if (!mercatorPath_.isEmpty()) {
+            const double previous = mercatorPath_.last().x();
+            p.setX(p.x() + std::round(previous - p.x()));
+        }
+        mercatorPath_.append(p);
+    }
+    // Closes polygons, and makes a single vertex a segment of length zero
+    if (!mercatorPath_.isEmpty() && (region.type() == QGeoShape::PolygonType || mercatorPath_.size() == 1)) {
+        QDoubleVector2D p = mercatorPath_.first();
+        p.setX(p.x() + std::round(mercatorPath_.last().x() - p.x()));
+        mercatorPath_.append(p);
+    }
+
+    if (region.isValid()) {
+        const QGeoRectangle box = region.boundingGeoRectangle();
+        const QDoubleVector2D topLeft = QWebMercator::coordToMercator(box.topLeft());
+        const QDoubleVector2D bottomRight = QWebMercator::coordToMercator(box.bottomRight());
+        const bool crossesDateline = box.topLeft().longitude() > box.bottomRight().longitude();
+
+        for (int zoom = minimumZoomLevel; zoom <= maximumZoomLevel; ++zoom) {
+            const int side = 1 << zoom;
+            Level level;
+            level.zoom = zoom;
+            level.x0 = tileIndex(topLeft.x(), side);
+            level.y0 = tileIndex(topLeft.y(), side);
+            int x1 = tileIndex(bottomRight.x(), side);
+            if (crossesDateline)
+                x1 += side;
+            level.width = qMin(x1 - level.x0 + 1, side);
+            level.height = tileIndex(bottomRight.y(), side) - level.y0 + 1;
+            levels_.append(level);
+            tileCount_ += quint64(level.width) * quint64(level.height);
+        }
+    }
+    next_ = qMin(startPosition, tileCount_);
+
+    // Leave the caller a chance to configure the job and connect to it
+    timer_.start(0, this);
+}
+
+QGeoTileSeedJob::~QGeoTileSeedJob()
+{
+    if (!pendingIndex_.isEmpty())
+        engine_->releaseSeedTiles(this, pendingIndex_.keys());
+}
+
+QGeoShape QGeoTileSeedJob::region() const
+{
+    return region_;
+}
+
+int QGeoTileSeedJob::minimumZoomLevel() const
+{
+    return minimumZoomLevel_;
+}
+
+int QGeoTileSeedJob::maximumZoomLevel() const
+{
+    return maximumZoomLevel_;
+}
+
+int QGeoTileSeedJob::mapId() const
+{
+    return mapId_;
+}
+
+QGeoTileSeedJob::State QGeoTileSeedJob::state() const
+{
+    return state_;
+}
+
+quint64 QGeoTileSeedJob::tileCount() const
+{
+    return tileCount_;
+}
+
+/*
+    Returns the number of candidates handled so far, all of them before the
+    first tile still in flight. Passing it to seedRegion() resumes the job
+    without losing any tile.
+*/
+quint64 QGeoTileSeedJob::position() const
+{
+    return pending_.isEmpty() ? next_ : pending_.firstKey();
+}
+
+quint64 QGeoTileSeedJob::fetchedCount() const
+{
+    return fetched_;
+}
+
+quint64 QGeoTileSeedJob::skippedCount() const
+{
+    return skipped_;
+}
+
+quint64 QGeoTileSeedJob::failedCount() const
+{
+    return failed_;
+}
+
+void QGeoTileSeedJob::setTilesPerSecond(int tilesPerSecond)
+{
+    tilesPerSecond_ = qMax(0, tilesPerSecond);
+}
+
+int QGeoTileSeedJob::tilesPerSecond() const
+{
+    return tilesPerSecond_;
+}
+
+void QGeoTileSeedJob::setMaxPendingTiles(int maxPendingTiles)
+{
+    maxPendingTiles_ = qMax(1, maxPendingTiles);
+}
+
+int QGeoTileSeedJob::maxPendingTiles() const
+{
+    return maxPendingTiles_;
+}
+
+void QGeoTileSeedJob::pause()
+{
+    if (state_ != Running)
+        return;
+    timer_.stop();
+    setState(Paused);
+}
+
+void QGeoTileSeedJob::resume()
+{
+    if (state_ != Paused)
+        return;
+    setState(Running);
+    scheduleNext(0);
+}
+
+/*
+    Stops the job and drops the tiles still in flight, unless a map waits for
+    them. position() is kept for resuming later.
+*/
+void QGeoTileSeedJob::cancel()
+{
+    if (state_ == Finished || state_ == Canceled)
+        return;
+    timer_.stop();
+    next_ = position();
+    const QList<QGeoTileSpec> tiles = pendingIndex_.keys();
+    pending_.clear();
+    pendingIndex_.clear();
+    engine_->releaseSeedTiles(this, tiles);
+    setState(Canceled);
+}
+
+void QGeoTileSeedJob::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != timer_.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+    timer_.stop();
+    issue();
+}
+
+QGeoTileSpec QGeoTileSeedJob::candidate(quint64 index) const
+{
+    for (const Level &level : levels_) {
+        const quint64 size = quint64(level.width) * quint64(level.height);
+        if (index >= size) {
+            index -= size;
+            continue;
+        }
+        const int side = 1 << level.zoom;
+        const int x = (level.x0 + int(index % level.width)) % side;
+        const int y = level.y0 + int(index / level.width);
+        return QGeoTileSpec(pluginString_, mapId_, level.zoom, x, y, version_);
+    }
+    return QGeoTileSpec();
+}
+
+/*
+    Returns whether the tile \a spec overlaps the region. Exact for rectangles,
+    and for paths and polygons as drawn on the map, with straight segments in
+    Mercator space: a tile is covered if a segment crosses it, or if it lies
+    inside the polygon. Other shapes are sampled at the corners, edge
+    midpoints and center of the tile, and at their own center.
+*/
+bool QGeoTileSeedJob::covers(const QGeoTileSpec &spec) const
+{
+    if (region_.type() == QGeoShape::RectangleType)
+        return true;
+
+    const double side = 1 << spec.zoom();
+    if (!mercatorPath_.isEmpty()) {
+        double x0 = spec.x() / side;
+        double y0 = spec.y() / side;
+        double x1 = (spec.x() + 1) / side;
+        double y1 = (spec.y() + 1) / side;
+        if (region_.type() == QGeoShape::PathType) {
+            // Half the width of the path, in Mercator units at the tile's latitude
+            const double latitude = QWebMercator::mercatorToCoord(QDoubleVector2D(x0, (y0 + y1) / 2)).latitude();
+            const double margin = 0.5 * QGeoPath(region_).width()
+                    / (QLocationUtils::earthMeanDiameter() * std::cos(qDegreesToRadians(latitude)));
+            x0 -= margin;
+            y0 -= margin;
+            x1 += margin;
+            y1 += margin;
+        }
+
+        // The unwrapped path may extend past the dateline on either side
+        for (int wrap = -1; wrap <= 1; ++wrap) {
+            for (int i = 1; i < mercatorPath_.size(); ++i) {
+                if (segmentIntersects(mercatorPath_.at(i - 1), mercatorPath_.at(i), x0 + wrap, y0, x1 + wrap, y1))
+                    return true;
+            }
+        }
+
+        // A tile no edge crosses is either wholly inside the polygon or outside
+        return region_.type() == QGeoShape::PolygonType
+                && region_.contains(QWebMercator::mercatorToCoord(QDoubleVector2D((spec.x() + 0.5) / side,
+                                                                                  (spec.y() + 0.5) / side)));
+    }
+
+    for (int i = 0; i <= 2; ++i) {
+        for (int j = 0; j <= 2; ++j) {
+            const QDoubleVector2D sample((spec.x() + 0.5 * i) / side, (spec.y() + 0.5 * j) / side);
+            if (region_.contains(QWebMercator::mercatorToCoord(sample)))
+                return true;
+        }
+    }
+
+    const QGeoRectangle tile(QWebMercator::mercatorToCoord(QDoubleVector2D(spec.x() / side, spec.y() / side)),
+                             QWebMercator::mercatorToCoord(QDoubleVector2D((spec.x() + 1) / side, (spec.y() + 1) / side)));
+    return tile.contains(region_.center());
+}
+
+/*
+    Walks the candidates until the next tile to download is handed to the
+    engine, or the window of pending tiles is full.
+*/
+void QGeoTileSeedJob::issue()
+{
+    QAbstractGeoTileCache *cache = engine_->tileCache();
+    int budget = tilesPerSecond_ > 0 ? 1 : maxPendingTiles_;
+    int scanned = 0;
+    const quint64 start = position();
+    while (state_ == Running && next_ < tileCount_ && pending_.size() < maxPendingTiles_
+           && budget > 0 && scanned < maxScannedPerTick) {
+        const quint64 index = next_++;
+        ++scanned;
+        const QGeoTileSpec spec = candidate(index);
+        if (!covers(spec))
+            continue;
+        if (cache->isCached(spec, QAbstractGeoTileCache::DiskCache)
+                || !engine_->requestSeedTile(this, spec)) {
+            ++skipped_;
+            continue;
+        }
+        pending_.insert(index, spec);
+        pendingIndex_.insert(spec, index);
+        --budget;
+    }
+
+    if (position() != start)
+        emit progressChanged(position(), tileCount_);
+    checkFinished();
+
+    // Only the tiles actually downloaded count against the rate limit
+    scheduleNext(budget == 0 && tilesPerSecond_ > 0 ? qMax(1, 1000 / tilesPerSecond_) : 0);
+}
+
+void QGeoTileSeedJob::scheduleNext(int interval)
+{
+    // Restarted by tileDone() once the window has room again
+    if (state_ != Running || next_ >= tileCount_ || pending_.size() >= maxPendingTiles_)
+        return;
+    if (!timer_.isActive())
+        timer_.start(interval, this);
+}
+
+/*
+    Called by the engine when the download of \a spec completed or failed.
+*/
+void QGeoTileSeedJob::tileDone(const QGeoTileSpec &spec, bool success)
+{
+    QHash<QGeoTileSpec, quint64>::iterator it = pendingIndex_.find(spec);
+    if (it == pendingIndex_.end())
+        return;
+    pending_.remove(*it);
+    pendingIndex_.erase(it);
+    if (success)
+        ++fetched_;
+    else
+        ++failed_;
+
+    emit progressChanged(position(), tileCount_);
+    checkFinished();
+    if (tilesPerSecond_ > 0)
+        scheduleNext(qMax(1, 1000 / tilesPerSecond_));
+    else
+        scheduleNext(0);
+}
+
+void QGeoTileSeedJob::setState(State state)
+{
+    if (state_ == state)
+        return;
+    state_ = state;
+    emit stateChanged(state);
+}
+
+void QGeoTileSeedJob::checkFinished()
+{
+    if (state_ != Running || next_ < tileCount_ || !pending_.isEmpty())
+        return;
+    setState(Finished);
+    emit finished();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,175 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILESEEDJOB_P_H
+#define QGEOTILESEEDJOB_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/private/qlocationglobal_p.h>
+#include <QtLocation/private/qgeotilespec_p.h>
+#include <QtPositioning/QGeoShape>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <QObject>
+#include <QBasicTimer>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QGeoTiledMappingManagerEngine;
+
+/*
+ * QGeoTileSeedJob
+ *
+ * Downloads every tile of a region over a range of zoom levels into the disk
+ * cache of an engine, for use out of coverage. Created by
+ * QGeoTiledMappingManagerEngine::seedRegion() and owned by the engine.
+ *
+ * The candidate tiles, those covering the bounding box of the region, are
+ * enumerated level by level in a fixed order, so a job can be resumed from
+ * the position() of an earlier one. Candidates outside the region or already
+ * on disk are skipped; the others are queued on the engine's fetcher behind
+ * the tiles maps are waiting for, at most tilesPerSecond() a second and
+ * maxPendingTiles() at a time.
+ */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileSeedJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Running,
+        Paused,
+        Finished,
+        Canceled
+    };
+    Q_ENUM(State)
+
+    ~QGeoTileSeedJob();
+
+    QGeoShape region() const;
+    int minimumZoomLevel() const;
+    int maximumZoomLevel() const;
+    int mapId() const;
+    State state() const;
+
+    // Candidate tiles, and the ones handled in enumeration order so far
+    quint64 tileCount() const;
+    quint64 position() const;
+
+    quint64 fetchedCount() const;
+    quint64 skippedCount() const;
+    quint64 failedCount() const;
+
+    // 0 means as fast as the fetcher goes
+    void setTilesPerSecond(int tilesPerSecond);
+    int tilesPerSecond() const;
+    void setMaxPendingTiles(int maxPendingTiles);
+    int maxPendingTiles() const;
+
+public Q_SLOTS:
+    void pause();
+    void resume();
+    void cancel();
+
+Q_SIGNALS:
+    void progressChanged(quint64 position, quint64 tileCount);
+    void stateChanged(QGeoTileSeedJob::State state);
+    void finished();
+
+protected:
+    void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
+
+private:
+    struct Level
+    {
+        int zoom;
+        int x0;       // may exceed the side of the level when crossing the dateline
+        int y0;
+        int width;
+        int height;
+    };
+
+    QGeoTileSeedJob(QGeoTiledMappingManagerEngine *engine, const QGeoShape &region,
+                    int minimumZoomLevel, int maximumZoomLevel, int mapId, quint64 startPosition);
+
+    QGeoTileSpec candidate(quint64 index) const;
+    bool covers(const QGeoTileSpec &spec) const;
+    void issue();
+    void scheduleNext(int interval);
+    void tileDone(const QGeoTileSpec &spec, bool success);
+    void setState(State state);
+    void checkFinished();
+
+    QGeoTiledMappingManagerEngine *engine_;
+    QString pluginString_;
+    int version_;
+    QGeoShape region_;
+    int minimumZoomLevel_;
+    int maximumZoomLevel_;
+    int mapId_;
+    State state_;
+    QVector<Level> levels_;
+    QVector<QDoubleVector2D> mercatorPath_;     // segments of a path or closed polygon
+    quint64 tileCount_;
+    quint64 next_;
+    QMap<quint64, QGeoTileSpec> pending_;           // by candidate index
+    QHash<QGeoTileSpec, quint64> pendingIndex_;
+    quint64 fetched_;
+    quint64 skipped_;
+    quint64 failed_;
+    int tilesPerSecond_;
+    int maxPendingTiles_;
+    QBasicTimer timer_;
+
+    friend class QGeoTiledMappingManagerEngine;
+    Q_DISABLE_COPY(QGeoTileSeedJob)
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILESEEDJOB_P_H
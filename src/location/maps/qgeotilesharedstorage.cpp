@@ -0,0 +1,581 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilesharedstorage_p.h"
+
+#if QT_CONFIG(sharedmemory)
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 SharedStorageMagic = 0x51475453; // "QGTS"
+static const quint32 SharedStorageVersion = 1;
+static const int MaxNameLength = 100;
+static const int EvictionSamples = 32;
+static const int AverageTileBytes = 4096;
+static const int MaxSlotCount = 256 * 1024;
+
+struct QGeoTileSharedStorage::Header
+{
+    quint32 magic;
+    quint32 version;
+    qint32 slotCount;
+    qint32 usedSlots;
+    qint64 arenaSize;
+    quint64 arenaHead;   // logical write position, only ever grows
+    quint64 clock;       // last use stamp
+    qint64 totalCost;
+    qint64 maxCost;      // 0 if unlimited
+    qint32 byteCost;
+    qint32 reserved;
+    quint64 evictions;
+};
+
+/*
+    A slot of the open addressing table, keyed by the file name without its
+    suffix. hash is 0 for empty slots, and arenaLength is -1 if the content
+    is not in the arena.
+*/
+struct QGeoTileSharedStorage::Slot
+{
+    quint64 hash;
+    quint64 lastUse;
+    quint64 arenaOffset;
+    qint64 size;
+    qint32 arenaLength;
+    quint16 nameLength;
+    quint16 reserved;
+    ushort name[MaxNameLength];
+};
+
+class QGeoTileSharedStorage::Locker
+{
+public:
+    explicit Locker(QGeoTileSharedStorage *storage)
+        : m_storage(storage), m_locked(false)
+    {
+        m_storage->m_mutex.lock();
+        m_locked = m_storage->m_memory.lock();
+        if (!m_locked)
+            qWarning("QGeoTileSharedStorage: cannot lock shared memory: %s",
+                     qPrintable(m_storage->m_memory.errorString()));
+    }
+    ~Locker()
+    {
+        if (m_locked)
+            m_storage->m_memory.unlock();
+        m_storage->m_mutex.unlock();
+    }
+    bool isLocked() const { return m_locked; }
+
+private:
+    QGeoTileSharedStorage *m_storage;
+    bool m_locked;
+};
+
+QGeoTileSharedStorage::QGeoTileSharedStorage(int maxTiles, int arenaBytes)
+    : m_maxTiles(qMax(maxTiles, 16)), m_arenaBytes(qMax(arenaBytes, 0)),
+      m_maxCost(0), m_byteCost(true), m_header(0)
+{
+}
+
+QGeoTileSharedStorage::~QGeoTileSharedStorage()
+{
+    if (m_memory.isAttached())
+        m_memory.detach();
+}
+
+/* FNV-1a over the UTF-16 name. 0 marks empty slots. */
+quint64 QGeoTileSharedStorage::nameHash(const QString &stem)
+{
+    quint64 h = Q_UINT64_C(14695981039346656037);
+    const ushort *c = stem.utf16();
+    for (int i = 0; i < stem.size(); ++i) {
+        h ^= c[i];
+        h *= Q_UINT64_C(1099511628211);
+    }
+    return h ? h : 1;
+}
+
+QString QGeoTileSharedStorage::baseName(const QString &fileName)
+{
+    const int dot = fileName.lastIndexOf(QLatin1Char('.'));
+    return dot < 0 ? fileName : fileName.left(dot);
+}
+
+/*
+    Returns the number of slots for the segment: enough to hold as many tiles
+    as fit in the budget set before open(), assuming AverageTileBytes per
+    tile for a budget in bytes, below the 7/8 load at which insertSlot()
+    starts evicting. Never less than the count given to the constructor,
+    and never more than MaxSlotCount unless the constructor asked for more.
+*/
+int QGeoTileSharedStorage::slotCapacity() const
+{
+    const qint64 tiles = m_maxCost <= 0 ? 0 : m_byteCost ? m_maxCost / AverageTileBytes : m_maxCost;
+    const qint64 wanted = tiles + tiles / 7 + 1;
+    return int(qBound<qint64>(m_maxTiles, wanted, qMax(m_maxTiles, MaxSlotCount)));
+}
+
+bool QGeoTileSharedStorage::open(const QString &directory)
+{
+    if (!QGeoTileFileStorage::open(directory))
+        return false;
+    m_directory = directory;
+
+    if (m_memory.isAttached())
+        m_memory.detach();
+    m_header = 0;
+
+    const QByteArray path = QFileInfo(directory).canonicalFilePath().toUtf8();
+    m_memory.setKey(QLatin1String("qtlocation-tilecache-")
+                    + QString::fromLatin1(QCryptographicHash::hash(path, QCryptographicHash::Sha1).toHex()));
+
+    const int size = int(sizeof(Header)) + slotCapacity() * int(sizeof(Slot)) + m_arenaBytes;
+    if (!m_memory.create(size)) {
+        if (m_memory.error() != QSharedMemory::AlreadyExists || !m_memory.attach()) {
+            qWarning("QGeoTileSharedStorage: shared memory unavailable, tiles are not shared: %s",
+                     qPrintable(m_memory.errorString()));
+            return true;
+        }
+    }
+
+    m_header = static_cast<Header *>(m_memory.data());
+    Locker lock(this);
+    if (!lock.isLocked())
+        return true;
+    if (m_header->magic != SharedStorageMagic || m_header->version != SharedStorageVersion)
+        return initialize();
+    return true;
+}
+
+/*
+    Lays out the segment, which may have been created by another process with
+    a different size, and indexes the tiles already in the directory.
+    Called with the lock held.
+*/
+bool QGeoTileSharedStorage::initialize()
+{
+    const qint64 available = m_memory.size() - qint64(sizeof(Header));
+    const int slotCount = int(qMin<qint64>(slotCapacity(), available / qint64(sizeof(Slot))));
+    if (slotCount < 16) {
+        m_header = 0;
+        return true;
+    }
+
+    m_header->magic = 0;
+    m_header->version = SharedStorageVersion;
+    m_header->slotCount = slotCount;
+    m_header->usedSlots = 0;
+    m_header->arenaSize = available - qint64(slotCount) * qint64(sizeof(Slot));
+    m_header->arenaHead = 0;
+    m_header->clock = 0;
+    m_header->totalCost = 0;
+    m_header->maxCost = 0;
+    m_header->byteCost = 1;
+    m_header->evictions = 0;
+    memset(slots(), 0, size_t(slotCount) * sizeof(Slot));
+
+    QVector<Entry> entries;
+    QGeoTileFileStorage::list(&entries, true);
+    for (const Entry &e : qAsConst(entries)) {
+        if (!QDir::match(QLatin1String("*-*-*-*.*"), e.fileName))
+            continue;
+        const quint64 hash = nameHash(baseName(e.fileName));
+        if (find(baseName(e.fileName), hash) < 0)
+            insertSlot(e.fileName, hash, e.size);
+    }
+
+    m_header->magic = SharedStorageMagic;
+    return true;
+}
+
+QGeoTileSharedStorage::Slot *QGeoTileSharedStorage::slots() const
+{
+    return reinterpret_cast<Slot *>(m_header + 1);
+}
+
+uchar *QGeoTileSharedStorage::arena() const
+{
+    return reinterpret_cast<uchar *>(slots() + m_header->slotCount);
+}
+
+int QGeoTileSharedStorage::find(const QString &stem, quint64 hash) const
+{
+    Slot *table = slots();
+    const int n = m_header->slotCount;
+    for (int i = int(hash % quint64(n)), probes = 0; probes < n; i = (i + 1) % n, ++probes) {
+        const Slot &s = table[i];
+        if (!s.hash)
+            return -1;
+        if (s.hash != hash || s.nameLength <= stem.size())
+            continue;
+        if (s.name[stem.size()] == '.'
+                && memcmp(s.name, stem.utf16(), size_t(stem.size()) * sizeof(ushort)) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/*
+    Inserts a new slot, first evicting the least recently used tiles if the
+    table is getting full, whatever their cost: tileCapacity() bounds the
+    tile count independently of the budget. Returns -1 for names that do not
+    fit in a slot.
+*/
+int QGeoTileSharedStorage::insertSlot(const QString &fileName, quint64 hash, qint64 size)
+{
+    if (fileName.size() > MaxNameLength)
+        return -1;
+    while (m_header->usedSlots >= m_header->slotCount - m_header->slotCount / 8)
+        evictOne();
+
+    Slot *table = slots();
+    const int n = m_header->slotCount;
+    int i = int(hash % quint64(n));
+    while (table[i].hash)
+        i = (i + 1) % n;
+
+    Slot &s = table[i];
+    s.hash = hash;
+    s.lastUse = ++m_header->clock;
+    s.arenaOffset = 0;
+    s.size = size;
+    s.arenaLength = -1;
+    s.nameLength = quint16(fileName.size());
+    memcpy(s.name, fileName.utf16(), size_t(fileName.size()) * sizeof(ushort));
+    ++m_header->usedSlots;
+    m_header->totalCost += cost(s);
+    return i;
+}
+
+/* Backward shift deletion, so that probing never needs tombstones. */
+void QGeoTileSharedStorage::removeSlot(int index)
+{
+    Slot *table = slots();
+    const int n = m_header->slotCount;
+    m_header->totalCost -= cost(table[index]);
+    --m_header->usedSlots;
+
+    int i = index;
+    int j = index;
+    for (;;) {
+        j = (j + 1) % n;
+        if (!table[j].hash)
+            break;
+        const int k = int(table[j].hash % quint64(n));
+        // Move j into the hole at i unless its home k lies cyclically in (i, j]
+        const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (!stays) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i].hash = 0;
+}
+
+qint64 QGeoTileSharedStorage::cost(const Slot &slot) const
+{
+    return m_header->byteCost ? qMax<qint64>(slot.size, 0) : 1;
+}
+
+bool QGeoTileSharedStorage::arenaHolds(const Slot &slot) const
+{
+    return slot.arenaLength >= 0
+            && slot.arenaOffset + quint64(m_header->arenaSize) >= m_header->arenaHead;
+}
+
+void QGeoTileSharedStorage::storeInArena(Slot &slot, const QByteArray &bytes)
+{
+    const qint64 arenaSize = m_header->arenaSize;
+    if (bytes.isEmpty() || bytes.size() > arenaSize / 4) {
+        slot.arenaLength = -1;
+        return;
+    }
+    // Entries never wrap around the end of the arena
+    qint64 offset = qint64(m_header->arenaHead % quint64(arenaSize));
+    if (offset + bytes.size() > arenaSize) {
+        m_header->arenaHead += quint64(arenaSize - offset);
+        offset = 0;
+    }
+    memcpy(arena() + offset, bytes.constData(), size_t(bytes.size()));
+    slot.arenaOffset = m_header->arenaHead;
+    slot.arenaLength = bytes.size();
+    m_header->arenaHead += quint64(bytes.size());
+}
+
+/*
+    Evicts the least recently used of a few slots sampled from a moving
+    position, and removes its file.
+*/
+void QGeoTileSharedStorage::evictOne()
+{
+    Slot *table = slots();
+    const int n = m_header->slotCount;
+    const int start = int((m_header->clock * Q_UINT64_C(2654435761)) % quint64(n));
+    int victim = -1;
+    int sampled = 0;
+    for (int probes = 0, i = start; probes < n && sampled < EvictionSamples; ++probes, i = (i + 1) % n) {
+        if (!table[i].hash)
+            continue;
+        ++sampled;
+        if (victim < 0 || table[i].lastUse < table[victim].lastUse)
+            victim = i;
+    }
+    if (victim < 0)
+        return;
+
+    const Slot &s = table[victim];
+    QGeoTileFileStorage::remove(m_directory + QLatin1Char('/')
+                                + QString::fromUtf16(s.name, s.nameLength));
+    removeSlot(victim);
+    ++m_header->evictions;
+}
+
+/* The most recently used tile is always kept, whatever its cost. */
+void QGeoTileSharedStorage::evictToFit()
+{
+    while (m_header->maxCost > 0 && m_header->totalCost > m_header->maxCost && m_header->usedSlots > 1)
+        evictOne();
+}
+
+bool QGeoTileSharedStorage::write(const QString &filename, const QByteArray &bytes)
+{
+    if (!m_header)
+        return QGeoTileFileStorage::write(filename, bytes);
+
+    // Written under the lock, so that the index never disagrees with the
+    // directory because another process evicted the tile meanwhile
+    Locker lock(this);
+    if (!QGeoTileFileStorage::write(filename, bytes))
+        return false;
+    if (!lock.isLocked())
+        return true;
+    const QString name = QFileInfo(filename).fileName();
+    const QString base = baseName(name);
+    const quint64 hash = nameHash(base);
+    int i = find(base, hash);
+    if (i >= 0 && name.size() > MaxNameLength) {
+        // The new name does not fit: leave the tile out of the index, as
+        // insertSlot() does, rather than keep the slot under its old name
+        removeSlot(i);
+        i = -1;
+    } else if (i >= 0) {
+        Slot &s = slots()[i];
+        m_header->totalCost -= cost(s);
+        s.size = bytes.size();
+        s.nameLength = quint16(name.size()); // the format may have changed
+        memcpy(s.name, name.utf16(), size_t(name.size()) * sizeof(ushort));
+        m_header->totalCost += cost(s);
+        s.lastUse = ++m_header->clock;
+    } else {
+        i = insertSlot(name, hash, bytes.size());
+    }
+    if (i >= 0)
+        storeInArena(slots()[i], bytes);
+    evictToFit();
+    return true;
+}
+
+bool QGeoTileSharedStorage::read(const QString &filename, QByteArray *bytes)
+{
+    const QString name = QFileInfo(filename).fileName();
+    const QString base = baseName(name);
+    const quint64 hash = m_header ? nameHash(base) : 0;
+
+    if (m_header) {
+        Locker lock(this);
+        const int i = lock.isLocked() ? find(base, hash) : -1;
+        if (i >= 0) {
+            Slot &s = slots()[i];
+            s.lastUse = ++m_header->clock;
+            if (arenaHolds(s)) {
+                const qint64 offset = qint64(s.arenaOffset % quint64(m_header->arenaSize));
+                *bytes = QByteArray(reinterpret_cast<const char *>(arena() + offset), s.arenaLength);
+                // Copy tiles about to be overwritten to the front again
+                if (s.arenaOffset + quint64(m_header->arenaSize / 2) < m_header->arenaHead)
+                    storeInArena(s, *bytes);
+                return true;
+            }
+        }
+    }
+
+    if (!QGeoTileFileStorage::read(filename, bytes))
+        return false;
+
+    if (m_header) {
+        Locker lock(this);
+        if (!lock.isLocked())
+            return true;
+        int i = find(base, hash);
+        if (i < 0) {
+            i = insertSlot(name, hash, bytes->size());
+            evictToFit();
+        }
+        if (i >= 0)
+            storeInArena(slots()[i], *bytes);
+    }
+    return true;
+}
+
+qint64 QGeoTileSharedStorage::size(const QString &filename)
+{
+    if (m_header) {
+        Locker lock(this);
+        const QString base = baseName(QFileInfo(filename).fileName());
+        const int i = lock.isLocked() ? find(base, nameHash(base)) : -1;
+        if (i >= 0)
+            return slots()[i].size;
+    }
+    return QGeoTileFileStorage::size(filename);
+}
+
+void QGeoTileSharedStorage::remove(const QString &filename)
+{
+    if (m_header) {
+        Locker lock(this);
+        const QString base = baseName(QFileInfo(filename).fileName());
+        const int i = lock.isLocked() ? find(base, nameHash(base)) : -1;
+        if (i >= 0)
+            removeSlot(i);
+    }
+    QGeoTileFileStorage::remove(filename);
+}
+
+void QGeoTileSharedStorage::clear()
+{
+    if (!m_header) {
+        QGeoTileFileStorage::clear();
+        return;
+    }
+    Locker lock(this);
+    QGeoTileFileStorage::clear();
+    if (!lock.isLocked())
+        return;
+    memset(slots(), 0, size_t(m_header->slotCount) * sizeof(Slot));
+    m_header->usedSlots = 0;
+    m_header->totalCost = 0;
+}
+
+bool QGeoTileSharedStorage::isShared() const
+{
+    return m_header != 0;
+}
+
+QString QGeoTileSharedStorage::lookup(const QString &stem)
+{
+    if (!m_header)
+        return QString();
+    Locker lock(this);
+    const QFileInfo info(stem);
+    const QString base = info.fileName();
+    const int i = lock.isLocked() ? find(base, nameHash(base)) : -1;
+    if (i < 0)
+        return QString();
+    const Slot &s = slots()[i];
+    return info.path() + QLatin1Char('/') + QString::fromUtf16(s.name, s.nameLength);
+}
+
+/*
+    Sets the budget shared by all processes. The last process to call this
+    wins, which is fine as long as they use the same plugin parameters.
+    Called before open(), it also sizes the tile index of a new segment.
+*/
+void QGeoTileSharedStorage::setMaxCost(qint64 maxCost, bool byteSize)
+{
+    m_maxCost = maxCost;
+    m_byteCost = byteSize;
+    if (!m_header)
+        return;
+    Locker lock(this);
+    if (!lock.isLocked())
+        return;
+    m_header->maxCost = maxCost;
+    if (m_header->byteCost != int(byteSize)) {
+        m_header->byteCost = byteSize;
+        m_header->totalCost = 0;
+        const Slot *table = slots();
+        for (int i = 0; i < m_header->slotCount; ++i) {
+            if (table[i].hash)
+                m_header->totalCost += cost(table[i]);
+        }
+    }
+    evictToFit();
+}
+
+qint64 QGeoTileSharedStorage::totalCost()
+{
+    if (!m_header)
+        return -1;
+    Locker lock(this);
+    return m_header->totalCost;
+}
+
+int QGeoTileSharedStorage::tileCount()
+{
+    if (!m_header)
+        return 0;
+    Locker lock(this);
+    return m_header->usedSlots;
+}
+
+/*
+    Returns how many tiles the index holds before it evicts the least
+    recently used ones to make room, or 0 if the storage is not shared.
+*/
+int QGeoTileSharedStorage::tileCapacity()
+{
+    if (!m_header)
+        return 0;
+    Locker lock(this);
+    return m_header->slotCount - m_header->slotCount / 8;
+}
+
+quint64 QGeoTileSharedStorage::evictionCount()
+{
+    if (!m_header)
+        return 0;
+    Locker lock(this);
+    return m_header->evictions;
+}
+
+QT_END_NAMESPACE
+
+#endif // QT_CONFIG(sharedmemory)
@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILESHAREDSTORAGE_P_H
+#define QGEOTILESHAREDSTORAGE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qgeotilediskstorage_p.h"
+
+#include <QMutex>
+
+#if QT_CONFIG(sharedmemory)
+#include <QSharedMemory>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * QGeoTileSharedStorage
+ *
+ * One file per tile like QGeoTileFileStorage, for several processes caching
+ * in the same directory. A shared memory segment, named after the canonical
+ * directory path, holds:
+ *
+ * - an index of every tile file, with its size and last use, so that the
+ *   disk usage is accounted for once and evictions follow the least recently
+ *   used tile across all processes (approximated by sampling, as in Redis);
+ * - an arena with the compressed bytes of the recently read or written
+ *   tiles, so a tile read by one process is not read from disk again by the
+ *   others. The arena is a ring buffer: new tiles overwrite the oldest ones,
+ *   and tiles read in its older half are copied again to the front.
+ *
+ * The segment is created by the first process and initialized from the
+ * directory content. Each access takes the segment lock, which the system
+ * releases if its holder dies. The decoded images stay in each process,
+ * since they end up in textures of its own scene graph.
+ *
+ * The index is sized when the segment is created, from the budget set with
+ * setMaxCost() before open(), and is never resized: a segment created by a
+ * process with a smaller budget, or holding tiles much smaller than expected,
+ * evicts once its tileCapacity() is reached.
+ *
+ * Falls back to a plain QGeoTileFileStorage if shared memory is unavailable.
+ */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileSharedStorage : public QGeoTileFileStorage
+{
+public:
+    explicit QGeoTileSharedStorage(int maxTiles = 16384, int arenaBytes = 16 * 1024 * 1024);
+    ~QGeoTileSharedStorage();
+
+    bool open(const QString &directory) Q_DECL_OVERRIDE;
+    bool write(const QString &filename, const QByteArray &bytes) Q_DECL_OVERRIDE;
+    bool read(const QString &filename, QByteArray *bytes) Q_DECL_OVERRIDE;
+    qint64 size(const QString &filename) Q_DECL_OVERRIDE;
+    void remove(const QString &filename) Q_DECL_OVERRIDE;
+    void clear() Q_DECL_OVERRIDE;
+
+    bool isShared() const Q_DECL_OVERRIDE;
+    QString lookup(const QString &baseName) Q_DECL_OVERRIDE;
+    void setMaxCost(qint64 maxCost, bool byteSize) Q_DECL_OVERRIDE;
+    qint64 totalCost() Q_DECL_OVERRIDE;
+
+    int tileCount();
+    int tileCapacity();
+    quint64 evictionCount();
+
+private:
+    struct Header;
+    struct Slot;
+    class Locker;
+
+    static quint64 nameHash(const QString &stem);
+    static QString baseName(const QString &fileName);
+
+    int slotCapacity() const;
+    bool initialize();
+    Slot *slots() const;
+    uchar *arena() const;
+    int find(const QString &stem, quint64 hash) const;
+    int insertSlot(const QString &fileName, quint64 hash, qint64 size);
+    void removeSlot(int index);
+    qint64 cost(const Slot &slot) const;
+    bool arenaHolds(const Slot &slot) const;
+    void storeInArena(Slot &slot, const QByteArray &bytes);
+    void evictOne();
+    void evictToFit();
+
+    QString m_directory;
+    int m_maxTiles;
+    int m_arenaBytes;
+    qint64 m_maxCost;
+    bool m_byteCost;
+    QSharedMemory m_memory;
+    Header *m_header;
+    QMutex m_mutex;   // QSharedMemory itself is not thread-safe
+};
+
+QT_END_NAMESPACE
+
+#endif // QT_CONFIG(sharedmemory)
+
+#endif // QGEOTILESHAREDSTORAGE_P_H
@@ -35,207 +35,155 @@
 ****************************************************************************/
 
 #include "qgeotilespec_p.h"
-#include "qgeotilespec_p_p.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QVector>
 
 QT_BEGIN_NAMESPACE
 
-QGeoTileSpec::QGeoTileSpec()
-    : d(QSharedDataPointer<QGeoTileSpecPrivate>(new QGeoTileSpecPrivate())) {}
+namespace {
 
-QGeoTileSpec::QGeoTileSpec(const QString &plugin, int mapId, int zoom, int x, int y, int version)
-        : d(QSharedDataPointer<QGeoTileSpecPrivate>(new QGeoTileSpecPrivate(plugin, mapId, zoom, x, y, version))) {}
+struct QGeoTilePluginRegistry
+{
+    QGeoTilePluginRegistry()
+    {
+        // id 0 is the null plugin name
+        names.append(QString());
+        ids.insert(QString(), 0);
+    }
 
-QGeoTileSpec::QGeoTileSpec(const QGeoTileSpec &other)
-    : d(other.d) {}
+    QReadWriteLock lock;
+    QHash<QString, quint16> ids;
+    QVector<QString> names;
+};
 
-QGeoTileSpec::~QGeoTileSpec() {
 }
 
-QGeoTileSpec &QGeoTileSpec::operator = (const QGeoTileSpec &other)
+Q_GLOBAL_STATIC(QGeoTilePluginRegistry, pluginRegistry)
+
+/*
+    Returns the id standing for \a plugin in tile specs. Ids are assigned on
+    first use and stay valid for the lifetime of the process.
+*/
+quint16 QGeoTileSpec::internPlugin(const QString &plugin)
 {
-    if (this == &other)
-        return *this;
+    QGeoTilePluginRegistry *registry = pluginRegistry();
+    {
+        QReadLocker locker(&registry->lock);
+        QHash<QString, quint16>::const_iterator it = registry->ids.constFind(plugin);
+        if (it != registry->ids.constEnd())
+            return it.value();
+    }
 
-    d = other.d;
-    return *this;
+    QWriteLocker locker(&registry->lock);
+    QHash<QString, quint16>::const_iterator it = registry->ids.constFind(plugin);
+    if (it != registry->ids.constEnd())
+        return it.value();
+    if (registry->names.size() > 0xffff) {
+        qWarning("QGeoTileSpec: too many distinct plugin names");
+        return 0;
+    }
+    const quint16 id = quint16(registry->names.size());
+    registry->names.append(plugin);
+    registry->ids.insert(plugin, id);
+    return id;
 }
 
-QString QGeoTileSpec::plugin() const
+QGeoTileSpec::QGeoTileSpec()
+    : tile_(0), meta_(0)
 {
-    return d->plugin_;
+    setZoom(-1);
+    setX(-1);
+    setY(-1);
+    setVersion(-1);
 }
 
-void QGeoTileSpec::setZoom(int zoom)
+QGeoTileSpec::QGeoTileSpec(const QString &plugin, int mapId, int zoom, int x, int y, int version)
+    : tile_(0), meta_(quint64(internPlugin(plugin)) << PluginShift)
 {
-    d->zoom_ = zoom;
+    setZoom(zoom);
+    setX(x);
+    setY(y);
+    setMapId(mapId);
+    setVersion(version);
 }
 
-int QGeoTileSpec::zoom() const
+QString QGeoTileSpec::plugin() const
 {
-    return d->zoom_;
+    QGeoTilePluginRegistry *registry = pluginRegistry();
+    QReadLocker locker(&registry->lock);
+    return registry->names.value(pluginId());
 }
 
-void QGeoTileSpec::setX(int x)
+void QGeoTileSpec::setZoom(int zoom)
 {
-    d->x_ = x;
+    Q_ASSERT(zoom >= -128 && zoom < 128);
+    setField(tile_, ZoomShift, ZoomBits, zoom);
 }
 
-int QGeoTileSpec::x() const
+void QGeoTileSpec::setX(int x)
 {
-    return d->x_;
+    setField(tile_, XShift, CoordinateBits, x);
 }
 
 void QGeoTileSpec::setY(int y)
 {
-    d->y_ = y;
-}
-
-int QGeoTileSpec::y() const
-{
-    return d->y_;
+    setField(tile_, YShift, CoordinateBits, y);
 }
 
 void QGeoTileSpec::setMapId(int mapId)
 {
-    d->mapId_ = mapId;
-}
-
-int QGeoTileSpec::mapId() const
-{
-    return d->mapId_;
+    setField(meta_, MapIdShift, MetaBits, mapId);
 }
 
 void QGeoTileSpec::setVersion(int version)
 {
-    d->version_ = version;
-}
-
-int QGeoTileSpec::version() const
-{
-    return d->version_;
-}
-
-bool QGeoTileSpec::operator == (const QGeoTileSpec &rhs) const
-{
-    return (*(d.constData()) == *(rhs.d.constData()));
+    setField(meta_, VersionShift, MetaBits, version);
 }
 
 bool QGeoTileSpec::operator < (const QGeoTileSpec &rhs) const
 {
-    return (*(d.constData()) < *(rhs.d.constData()));
-}
+    if (pluginId() != rhs.pluginId())
+        return plugin() < rhs.plugin();
 
-unsigned int qHash(const QGeoTileSpec &spec)
-{
-    unsigned int result = (qHash(spec.plugin()) * 13) % 31;
-    result += ((spec.mapId() * 17) % 31) << 5;
-    result += ((spec.zoom() * 19) % 31) << 10;
-    result += ((spec.x() * 23) % 31) << 15;
-    result += ((spec.y() * 29) % 31) << 20;
-    result += (spec.version() % 3) << 25;
-    return result;
-}
+    if (mapId() != rhs.mapId())
+        return mapId() < rhs.mapId();
 
-QDebug operator<< (QDebug dbg, const QGeoTileSpec &spec)
-{
-    dbg << spec.plugin() << spec.mapId() << spec.zoom() << spec.x() << spec.y() << spec.version();
-    return dbg;
-}
+    if (zoom() != rhs.zoom())
+        return zoom() < rhs.zoom();
 
-QGeoTileSpecPrivate::QGeoTileSpecPrivate()
-    : mapId_(0),
-    zoom_(-1),
-    x_(-1),
-    y_(-1),
-    version_(-1) {}
-
-QGeoTileSpecPrivate::QGeoTileSpecPrivate(const QGeoTileSpecPrivate &other)
-    : QSharedData(other),
-      plugin_(other.plugin_),
-      mapId_(other.mapId_),
-      zoom_(other.zoom_),
-      x_(other.x_),
-      y_(other.y_),
-      version_(other.version_) {}
-
-QGeoTileSpecPrivate::QGeoTileSpecPrivate(const QString &plugin, int mapId, int zoom, int x, int y, int version)
-    : plugin_(plugin),
-      mapId_(mapId),
-      zoom_(zoom),
-      x_(x),
-      y_(y),
-      version_(version) {}
-
-QGeoTileSpecPrivate::~QGeoTileSpecPrivate() {}
-
-QGeoTileSpecPrivate &QGeoTileSpecPrivate::operator = (const QGeoTileSpecPrivate &other)
-{
-    if (this == &other)
-        return *this;
+    if (x() != rhs.x())
+        return x() < rhs.x();
 
-    plugin_ = other.plugin_;
-    mapId_ = other.mapId_;
-    zoom_ = other.zoom_;
-    x_ = other.x_;
-    y_ = other.y_;
-    version_ = other.version_;
+    if (y() != rhs.y())
+        return y() < rhs.y();
 
-    return *this;
+    return version() < rhs.version();
 }
 
-bool QGeoTileSpecPrivate::operator == (const QGeoTileSpecPrivate &rhs) const
+static inline quint64 mix64(quint64 k)
 {
-    if (plugin_ != rhs.plugin_)
-        return false;
-
-    if (mapId_ != rhs.mapId_)
-        return false;
-
-    if (zoom_ != rhs.zoom_)
-        return false;
-
-    if (x_ != rhs.x_)
-        return false;
-
-    if (y_ != rhs.y_)
-        return false;
-
-    if (version_ != rhs.version_)
-        return false;
+    // MurmurHash3 finalizer
+    k ^= k >> 33;
+    k *= Q_UINT64_C(0xff51afd7ed558ccd);
+    k ^= k >> 33;
+    k *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+    k ^= k >> 33;
+    return k;
+}
 
-    return true;
+uint qHash(const QGeoTileSpec &spec, uint seed)
+{
+    const quint64 h = mix64(spec.tile_ ^ mix64(spec.meta_ + seed));
+    return uint(h ^ (h >> 32));
 }
 
-bool QGeoTileSpecPrivate::operator < (const QGeoTileSpecPrivate &rhs) const
+QDebug operator<< (QDebug dbg, const QGeoTileSpec &spec)
 {
-    if (plugin_ < rhs.plugin_)
-        return true;
-    if (plugin_ > rhs.plugin_)
-        return false;
-
-    if (mapId_ < rhs.mapId_)
-        return true;
-    if (mapId_ > rhs.mapId_)
-        return false;
-
-    if (zoom_ < rhs.zoom_)
-        return true;
-    if (zoom_ > rhs.zoom_)
-        return false;
-
-    if (x_ < rhs.x_)
-        return true;
-    if (x_ > rhs.x_)
-        return false;
-
-    if (y_ < rhs.y_)
-        return true;
-    if (y_ > rhs.y_)
-        return false;
-
-    return (version_ < rhs.version_);
+    dbg << spec.plugin() << spec.mapId() << spec.zoom() << spec.x() << spec.y() << spec.version();
+    return dbg;
 }
 
 QT_END_NAMESPACE
@@ -52,47 +52,84 @@
 #include <QtCore/QMetaType>
 #include <QString>
 
-#include <QSharedDataPointer>
-
 QT_BEGIN_NAMESPACE
 
-class QGeoTileSpecPrivate;
+/*
+    Identifies a map tile. This is a small value type: the plugin name is
+    interned into a process wide id, zoom, x and y are packed into one word
+    and map id and version into another. Comparing, copying and hashing a
+    spec therefore never touches a string or the heap.
 
+    Packing limits zoom to [-128, 127], x and y to 28 bits and map id and
+    version to 24 bits, all signed.
+*/
 class Q_LOCATION_PRIVATE_EXPORT QGeoTileSpec
 {
 public:
     QGeoTileSpec();
-    QGeoTileSpec(const QGeoTileSpec &other);
     QGeoTileSpec(const QString &plugin, int mapId, int zoom, int x, int y, int version = -1);
-    ~QGeoTileSpec();
-
-    QGeoTileSpec &operator = (const QGeoTileSpec &other);
 
     QString plugin() const;
+    inline quint16 pluginId() const { return quint16(meta_ >> PluginShift); }
 
     void setZoom(int zoom);
-    int zoom() const;
+    inline int zoom() const { return field(tile_, ZoomShift, ZoomBits); }
 
     void setX(int x);
-    int x() const;
+    inline int x() const { return field(tile_, XShift, CoordinateBits); }
 
     void setY(int y);
-    int y() const;
+    inline int y() const { return field(tile_, YShift, CoordinateBits); }
 
     void setMapId(int mapId);
-    int mapId() const;
+    inline int mapId() const { return field(meta_, MapIdShift, MetaBits); }
 
     void setVersion(int version);
-    int version() const;
+    inline int version() const { return field(meta_, VersionShift, MetaBits); }
 
-    bool operator == (const QGeoTileSpec &rhs) const;
+    inline bool operator == (const QGeoTileSpec &rhs) const
+    {
+        return tile_ == rhs.tile_ && meta_ == rhs.meta_;
+    }
+    inline bool operator != (const QGeoTileSpec &rhs) const { return !operator==(rhs); }
     bool operator < (const QGeoTileSpec &rhs) const;
 
+    static quint16 internPlugin(const QString &plugin);
+
 private:
-    QSharedDataPointer<QGeoTileSpecPrivate> d;
+    enum {
+        CoordinateBits = 28,
+        ZoomBits = 8,
+        YShift = 0,
+        XShift = CoordinateBits,
+        ZoomShift = 2 * CoordinateBits,
+
+        MetaBits = 24,
+        VersionShift = 0,
+        MapIdShift = MetaBits,
+        PluginShift = 2 * MetaBits
+    };
+
+    static inline int field(quint64 word, int shift, int bits)
+    {
+        // Sign extend the field
+        return int(qint64(word << (64 - shift - bits)) >> (64 - bits));
+    }
+    static inline void setField(quint64 &word, int shift, int bits, int value)
+    {
+        const quint64 mask = ((Q_UINT64_C(1) << bits) - 1) << shift;
+        word = (word & ~mask) | ((quint64(qint64(value)) << shift) & mask);
+    }
+
+    quint64 tile_;
+    quint64 meta_;
+
+    friend Q_LOCATION_PRIVATE_EXPORT uint qHash(const QGeoTileSpec &spec, uint seed);
 };
 
-Q_LOCATION_PRIVATE_EXPORT unsigned int qHash(const QGeoTileSpec &spec);
+Q_DECLARE_TYPEINFO(QGeoTileSpec, Q_MOVABLE_TYPE);
+
+Q_LOCATION_PRIVATE_EXPORT uint qHash(const QGeoTileSpec &spec, uint seed = 0);
 
 Q_LOCATION_PRIVATE_EXPORT QDebug operator<<(QDebug, const QGeoTileSpec &);
 
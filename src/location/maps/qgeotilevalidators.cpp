@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilevalidators_p.h"
+
+#include <QDataStream>
+#include <QLocale>
+
+QT_BEGIN_NAMESPACE
+
+QGeoTileValidators::QGeoTileValidators()
+{
+}
+
+/*
+    Extracts the validators and the expiry from the \a headers of a response
+    \a received at the given time. Cache-Control max-age wins over Expires,
+    and no-cache or no-store make the tile expire right away.
+*/
+QGeoTileValidators QGeoTileValidators::fromHttpHeaders(const QGeoTileHttpHeaders &headers,
+                                                       const QDateTime &received)
+{
+    QGeoTileValidators v;
+    v.fetched = received.toUTC();
+
+    qint64 maxAge = -1;
+    qint64 age = 0;
+    QDateTime expires;
+    for (const QPair<QByteArray, QByteArray> &header : headers) {
+        const QByteArray name = header.first.toLower();
+        const QByteArray value = header.second.trimmed();
+        if (name == "etag") {
+            v.etag = value;
+        } else if (name == "last-modified") {
+            v.lastModified = parseHttpDate(value);
+        } else if (name == "expires") {
+            expires = parseHttpDate(value);
+            // Invalid dates, such as "0", mean already expired
+            if (!expires.isValid())
+                expires = v.fetched;
+        } else if (name == "age") {
+            age = qMax<qint64>(0, value.toLongLong());
+        } else if (name == "cache-control") {
+            for (const QByteArray &directive : value.split(',')) {
+                const QByteArray d = directive.trimmed().toLower();
+                if (d == "no-cache" || d == "no-store")
+                    maxAge = 0;
+                else if (d.startsWith("max-age=") && maxAge != 0)
+                    maxAge = qMax<qint64>(0, d.mid(8).toLongLong());
+            }
+        }
+    }
+
+    if (maxAge >= 0)
+        v.expires = v.fetched.addSecs(qMax<qint64>(0, maxAge - age));
+    else
+        v.expires = expires;
+    return v;
+}
+
+bool QGeoTileValidators::canRevalidate() const
+{
+    return !etag.isEmpty() || lastModified.isValid();
+}
+
+bool QGeoTileValidators::isExpired(const QDateTime &now) const
+{
+    return expires.isValid() && expires <= now;
+}
+
+/* If-None-Match takes precedence on the server side, both are sent anyway. */
+QGeoTileHttpHeaders QGeoTileValidators::conditionalHeaders() const
+{
+    QGeoTileHttpHeaders headers;
+    if (!etag.isEmpty())
+        headers.append(qMakePair(QByteArray("If-None-Match"), etag));
+    if (lastModified.isValid())
+        headers.append(qMakePair(QByteArray("If-Modified-Since"), toHttpDate(lastModified)));
+    return headers;
+}
+
+QGeoTileValidators QGeoTileValidators::refreshed(const QGeoTileValidators &notModified) const
+{
+    QGeoTileValidators v = *this;
+    if (!notModified.etag.isEmpty())
+        v.etag = notModified.etag;
+    if (notModified.lastModified.isValid())
+        v.lastModified = notModified.lastModified;
+    v.expires = notModified.expires;
+    v.fetched = notModified.fetched;
+    return v;
+}
+
+static const char httpDateFormat[] = "ddd, dd MMM yyyy hh:mm:ss 'GMT'";
+
+/* Parses the IMF-fixdate format of RFC 7231, falling back to RFC 2822. */
+QDateTime QGeoTileValidators::parseHttpDate(const QByteArray &value)
+{
+    const QString s = QString::fromLatin1(value.trimmed());
+    QDateTime dt = QLocale::c().toDateTime(s, QLatin1String(httpDateFormat));
+    if (!dt.isValid())
+        dt = QDateTime::fromString(s, Qt::RFC2822Date);
+    else
+        dt.setTimeSpec(Qt::UTC);
+    return dt.isValid() ? dt.toUTC() : QDateTime();
+}
+
+QByteArray QGeoTileValidators::toHttpDate(const QDateTime &dateTime)
+{
+    return QLocale::c().toString(dateTime.toUTC(), QLatin1String(httpDateFormat)).toLatin1();
+}
+
+QDataStream &operator<<(QDataStream &out, const QGeoTileValidators &validators)
+{
+    return out << validators.etag << validators.lastModified << validators.expires << validators.fetched;
+}
+
+QDataStream &operator>>(QDataStream &in, QGeoTileValidators &validators)
+{
+    return in >> validators.etag >> validators.lastModified >> validators.expires >> validators.fetched;
+}
+
+QT_END_NAMESPACE
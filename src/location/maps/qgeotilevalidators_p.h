@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEVALIDATORS_P_H
+#define QGEOTILEVALIDATORS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/private/qlocationglobal_p.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QMetaType>
+#include <QPair>
+
+QT_BEGIN_NAMESPACE
+
+class QDataStream;
+
+typedef QList<QPair<QByteArray, QByteArray> > QGeoTileHttpHeaders;
+
+/*
+ * QGeoTileValidators
+ *
+ * HTTP cache metadata of a tile: the validators used to revalidate it with a
+ * conditional request (ETag, Last-Modified), when it expires according to
+ * the server, and when it was fetched. Kept by QGeoFileTileCache for the
+ * tiles on disk.
+ *
+ * Tile fetchers fill it from the response headers with fromHttpHeaders(),
+ * and add conditionalHeaders() of QGeoTileFetcher::tileValidators() to
+ * their requests; no network module is needed here.
+ */
+class Q_LOCATION_PRIVATE_EXPORT QGeoTileValidators
+{
+public:
+    QGeoTileValidators();
+
+    static QGeoTileValidators fromHttpHeaders(const QGeoTileHttpHeaders &headers,
+                                              const QDateTime &received = QDateTime::currentDateTimeUtc());
+
+    bool canRevalidate() const;
+    bool isExpired(const QDateTime &now = QDateTime::currentDateTimeUtc()) const;
+    QGeoTileHttpHeaders conditionalHeaders() const;
+    // The validators after a 304 response carrying those of notModified
+    QGeoTileValidators refreshed(const QGeoTileValidators &notModified) const;
+
+    static QDateTime parseHttpDate(const QByteArray &value);
+    static QByteArray toHttpDate(const QDateTime &dateTime);
+
+    QByteArray etag;
+    QDateTime lastModified;
+    QDateTime expires;      // invalid if the server did not tell
+    QDateTime fetched;      // invalid for tiles cached before validators were kept
+};
+
+Q_LOCATION_PRIVATE_EXPORT QDataStream &operator<<(QDataStream &out, const QGeoTileValidators &validators);
+Q_LOCATION_PRIVATE_EXPORT QDataStream &operator>>(QDataStream &in, QGeoTileValidators &validators);
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QGeoTileValidators)
+
+#endif // QGEOTILEVALIDATORS_P_H
@@ -211,6 +211,8 @@ GeoTiledMappingManagerEngineEsri::GeoTiledMappingManagerEngineEsri(const QVarian
             m_prefetchStyle = QGeoTiledMap::PrefetchNeighbourLayer;
         else if (prefetchingMode == QStringLiteral("NoPrefetching"))
             m_prefetchStyle = QGeoTiledMap::NoPrefetching;
+        else if (prefetchingMode == QStringLiteral("Predictive"))
+            m_prefetchStyle = QGeoTiledMap::PrefetchPredictive;
     }
 
     setTileCache(tileCache);
@@ -40,6 +40,7 @@
 #include "geotiledmapreply_esri.h"
 
 #include <QtLocation/private/qgeotilespec_p.h>
+#include <QtLocation/private/qgeotilevalidators_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -74,6 +75,13 @@ void GeoTiledMapReplyEsri::networkReplyFinished()
     if (reply->error() != QNetworkReply::NoError)
         return;
 
+    setValidators(QGeoTileValidators::fromHttpHeaders(reply->rawHeaderPairs()));
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        setNotModified(true);
+        setFinished(true);
+        return;
+    }
+
     QByteArray const& imageData = reply->readAll();
 
     bool validFormat = true;
@@ -68,6 +68,9 @@ QGeoTiledMapReply *GeoTileFetcherEsri::getTileImage(const QGeoTileSpec &spec)
         qWarning("Unknown mapId %d\n", spec.mapId());
     else
         request.setUrl(mapSource->url().arg(spec.zoom()).arg(spec.x()).arg(spec.y()));
+    const QGeoTileHttpHeaders conditionalHeaders = tileValidators(spec).conditionalHeaders();
+    for (const auto &header : conditionalHeaders)
+        request.setRawHeader(header.first, header.second);
 
     QNetworkReply *reply = m_networkManager->get(request);
 
@@ -37,6 +37,7 @@
 #include "qgeomapreplymapbox.h"
 
 #include <QtLocation/private/qgeotilespec_p.h>
+#include <QtLocation/private/qgeotilevalidators_p.h>
 
 QGeoMapReplyMapbox::QGeoMapReplyMapbox(QNetworkReply *reply, const QGeoTileSpec &spec, const QString &format, QObject *parent)
 :   QGeoTiledMapReply(spec, parent), m_format (format)
@@ -64,6 +65,13 @@ void QGeoMapReplyMapbox::networkReplyFinished()
     if (reply->error() != QNetworkReply::NoError)
         return;
 
+    setValidators(QGeoTileValidators::fromHttpHeaders(reply->rawHeaderPairs()));
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        setNotModified(true);
+        setFinished(true);
+        return;
+    }
+
     setMapImageData(reply->readAll());
     setMapImageFormat(m_format);
     setFinished(true);
@@ -40,6 +40,7 @@
 #include <QtLocation/private/qgeocameracapabilities_p.h>
 #include <QtLocation/private/qgeomaptype_p.h>
 #include <QtLocation/private/qgeotiledmap_p.h>
+#include <QtLocation/private/qgeotilediskstorage_p.h>
 #include "qgeofiletilecachemapbox.h"
 
 QT_BEGIN_NAMESPACE
@@ -175,6 +176,10 @@ QGeoTiledMappingManagerEngineMapbox::QGeoTiledMappingManagerEngineMapbox(const Q
     } else {
         tileCache->setCostStrategyDisk(QGeoFileTileCache::Unitary);
     }
+    if (parameters.contains(QStringLiteral("mapbox.mapping.cache.disk.storage"))) {
+        const QString storage = parameters.value(QStringLiteral("mapbox.mapping.cache.disk.storage")).toString().toLower();
+        tileCache->setDiskStorage(QGeoTileDiskStorage::create(storage));
+    }
     if (parameters.contains(QStringLiteral("mapbox.mapping.cache.disk.size"))) {
         bool ok = false;
         int cacheSize = parameters.value(QStringLiteral("mapbox.mapping.cache.disk.size")).toString().toInt(&ok);
@@ -232,6 +237,8 @@ QGeoTiledMappingManagerEngineMapbox::QGeoTiledMappingManagerEngineMapbox(const Q
             m_prefetchStyle = QGeoTiledMap::PrefetchNeighbourLayer;
         else if (prefetchingMode == QStringLiteral("NoPrefetching"))
             m_prefetchStyle = QGeoTiledMap::NoPrefetching;
+        else if (prefetchingMode == QStringLiteral("Predictive"))
+            m_prefetchStyle = QGeoTiledMap::PrefetchPredictive;
     }
 
     setTileCache(tileCache);
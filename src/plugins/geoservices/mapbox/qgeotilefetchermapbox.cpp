@@ -94,6 +94,9 @@ QGeoTiledMapReply *QGeoTileFetcherMapbox::getTileImage(const QGeoTileSpec &spec)
                         ((m_scaleFactor > 1) ? (QLatin1Char('@') + QString::number(m_scaleFactor) + QLatin1String("x.")) : QLatin1String(".")) +
                         m_format + QLatin1Char('?') +
                         QStringLiteral("access_token=") + m_accessToken));
+    const QGeoTileHttpHeaders conditionalHeaders = tileValidators(spec).conditionalHeaders();
+    for (const auto &header : conditionalHeaders)
+        request.setRawHeader(header.first, header.second);
 
     QNetworkReply *reply = m_networkManager->get(request);
 
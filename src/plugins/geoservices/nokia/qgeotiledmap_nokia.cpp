@@ -44,11 +44,68 @@
 #include <QPainter>
 #include <QImage>
 #include <QRect>
+#include <QFontDatabase>
+#include <QThreadPool>
 
 #include <QStaticText>
 
+#define COPYRIGHTS_SLAB_CACHE_SIZE 4096 // KiB
+
 QT_BEGIN_NAMESPACE
 
+// Renders a copyrights slab on a pool thread, so that the blurred text passes
+// do not stall the GUI thread while panning.
+QGeoCopyrightsSlabRenderer::QGeoCopyrightsSlabRenderer(const QString &key, const QString &copyrights,
+                                                       const QImage &logo, const QSize &viewport)
+:   m_key(key), m_copyrights(copyrights), m_logo(logo), m_viewport(viewport)
+{
+    setAutoDelete(true);
+}
+
+void QGeoCopyrightsSlabRenderer::run()
+{
+    emit finished(m_key, m_copyrights, render(m_copyrights, m_logo, m_viewport));
+}
+
+QImage QGeoCopyrightsSlabRenderer::render(const QString &copyrights, const QImage &logo, const QSize &viewport)
+{
+    const int spaceToLogo = 4;
+    const int blurRate = 1;
+    const int fontSize = 10;
+
+    QFont font("Sans Serif");
+    font.setPixelSize(fontSize);
+    font.setStyleHint(QFont::SansSerif);
+    font.setWeight(QFont::Bold);
+
+    QRect textBounds = QFontMetrics(font).boundingRect(0, 0, viewport.width(), viewport.height(), Qt::AlignBottom | Qt::AlignLeft | Qt::TextWordWrap, copyrights);
+
+    QImage slab(logo.width() + textBounds.width() + spaceToLogo + blurRate * 2,
+                qMax(logo.height(), textBounds.height() + blurRate * 2),
+                QImage::Format_ARGB32_Premultiplied);
+    slab.fill(Qt::transparent);
+
+    QPainter painter(&slab);
+    painter.drawImage(QPoint(0, slab.height() - logo.height()), logo);
+    painter.setFont(font);
+    painter.setPen(QColor(0, 0, 0, 64));
+    painter.translate(spaceToLogo + logo.width(), -blurRate);
+    for (int x=-blurRate; x<=blurRate; ++x) {
+        for (int y=-blurRate; y<=blurRate; ++y) {
+            painter.drawText(x, y, textBounds.width(), slab.height(),
+                             Qt::AlignBottom | Qt::AlignLeft | Qt::TextWordWrap,
+                             copyrights);
+        }
+    }
+    painter.setPen(Qt::white);
+    painter.drawText(0, 0, textBounds.width(), slab.height(),
+                     Qt::AlignBottom | Qt::AlignLeft | Qt::TextWordWrap,
+                     copyrights);
+    painter.end();
+
+    return slab;
+}
+
 /*!
  Constructs a new tiled map data object, which stores the map data required by
  \a geoMap and makes use of the functionality provided by \a engine.
@@ -56,6 +113,7 @@ QT_BEGIN_NAMESPACE
 QGeoTiledMapNokia::QGeoTiledMapNokia(QGeoTiledMappingManagerEngineNokia *engine, QObject *parent /*= 0*/) :
     QGeoTiledMap(engine, parent),
     m_logo(":/nokia/logo.png"), // HERE logo image
+    m_copyrightsSlabs(COPYRIGHTS_SLAB_CACHE_SIZE),
     m_engine(engine)
 {}
 
@@ -63,50 +121,64 @@ QGeoTiledMapNokia::~QGeoTiledMapNokia() {}
 
 void QGeoTiledMapNokia::evaluateCopyrights(const QSet<QGeoTileSpec> &visibleTiles)
 {
-    const int spaceToLogo = 4;
-    const int blurRate = 1;
-    const int fontSize = 10;
-
     if (m_engine.isNull())
         return;
 
     const QString copyrightsString = m_engine->evaluateCopyrightsText(activeMapType(), cameraData().zoomLevel(), visibleTiles);
 
     if (viewportWidth() > 0 && viewportHeight() > 0 && ((copyrightsString.isNull() && m_copyrightsSlab.isNull()) || copyrightsString != m_lastCopyrightsString)) {
-        QFont font("Sans Serif");
-        font.setPixelSize(fontSize);
-        font.setStyleHint(QFont::SansSerif);
-        font.setWeight(QFont::Bold);
-
-        QRect textBounds = QFontMetrics(font).boundingRect(0, 0, viewportWidth(), viewportHeight(), Qt::AlignBottom | Qt::AlignLeft | Qt::TextWordWrap, copyrightsString);
-
-        m_copyrightsSlab = QImage(m_logo.width() + textBounds.width() + spaceToLogo + blurRate * 2,
-                                qMax(m_logo.height(), textBounds.height() + blurRate * 2),
-                                QImage::Format_ARGB32_Premultiplied);
-        m_copyrightsSlab.fill(Qt::transparent);
-
-        QPainter painter(&m_copyrightsSlab);
-        painter.drawImage(QPoint(0, m_copyrightsSlab.height() - m_logo.height()), m_logo);
-        painter.setFont(font);
-        painter.setPen(QColor(0, 0, 0, 64));
-        painter.translate(spaceToLogo + m_logo.width(), -blurRate);
-        for (int x=-blurRate; x<=blurRate; ++x) {
-            for (int y=-blurRate; y<=blurRate; ++y) {
-                painter.drawText(x, y, textBounds.width(), m_copyrightsSlab.height(),
-                                 Qt::AlignBottom | Qt::AlignLeft | Qt::TextWordWrap,
-                                 copyrightsString);
+        const QSize viewport(viewportWidth(), viewportHeight());
+        const QString key = QString::number(viewport.width()) + QLatin1Char('x')
+                + QString::number(viewport.height()) + QLatin1Char(':') + copyrightsString;
+
+        if (const QImage *slab = m_copyrightsSlabs.object(key)) {
+            m_copyrightsSlab = *slab;
+            m_lastCopyrightsString = copyrightsString;
+            m_pendingSlabKey.clear();
+        } else if (!QFontDatabase::supportsThreadedFontRendering()) {
+            m_copyrightsSlab = QGeoCopyrightsSlabRenderer::render(copyrightsString, m_logo, viewport);
+            m_lastCopyrightsString = copyrightsString;
+            m_pendingSlabKey.clear();
+            cacheCopyrightsSlab(key, m_copyrightsSlab);
+        } else {
+            // Keep showing the current slab until the new one has been rendered.
+            m_pendingSlabKey = key;
+            if (!m_renderingSlabs.contains(key)) {
+                m_renderingSlabs.insert(key);
+                QGeoCopyrightsSlabRenderer *renderer =
+                        new QGeoCopyrightsSlabRenderer(key, copyrightsString, m_logo, viewport);
+                connect(renderer, &QGeoCopyrightsSlabRenderer::finished,
+                        this, &QGeoTiledMapNokia::copyrightsSlabRendered);
+                QThreadPool::globalInstance()->start(renderer);
             }
         }
-        painter.setPen(Qt::white);
-        painter.drawText(0, 0, textBounds.width(), m_copyrightsSlab.height(),
-                         Qt::AlignBottom | Qt::AlignLeft | Qt::TextWordWrap,
-                         copyrightsString);
-        painter.end();
-
-        m_lastCopyrightsString = copyrightsString;
+    } else if (copyrightsString == m_lastCopyrightsString) {
+        m_pendingSlabKey.clear();
     }
 
     emit copyrightsChanged(m_copyrightsSlab);
 }
 
+void QGeoTiledMapNokia::copyrightsSlabRendered(const QString &key, const QString &copyrights, const QImage &slab)
+{
+    m_renderingSlabs.remove(key);
+    cacheCopyrightsSlab(key, slab);
+
+    // A newer text may have been requested in the meantime.
+    if (key != m_pendingSlabKey)
+        return;
+
+    m_pendingSlabKey.clear();
+    m_copyrightsSlab = slab;
+    m_lastCopyrightsString = copyrights;
+    emit copyrightsChanged(m_copyrightsSlab);
+}
+
+void QGeoTiledMapNokia::cacheCopyrightsSlab(const QString &key, const QImage &slab)
+{
+    // Cost in KiB, clamped to what QCache takes
+    const int cost = int(qBound<qsizetype>(1, slab.sizeInBytes() / 1024, INT_MAX));
+    m_copyrightsSlabs.insert(key, new QImage(slab), cost);
+}
+
 QT_END_NAMESPACE
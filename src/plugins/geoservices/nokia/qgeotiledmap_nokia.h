@@ -39,12 +39,36 @@
 
 #include "qgeotiledmap_p.h"
 #include <QtGui/QImage>
+#include <QtCore/QCache>
 #include <QtCore/QPointer>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
 
 QT_BEGIN_NAMESPACE
 
 class QGeoTiledMappingManagerEngineNokia;
 
+class QGeoCopyrightsSlabRenderer : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    QGeoCopyrightsSlabRenderer(const QString &key, const QString &copyrights,
+                               const QImage &logo, const QSize &viewport);
+
+    void run() Q_DECL_OVERRIDE;
+
+    static QImage render(const QString &copyrights, const QImage &logo, const QSize &viewport);
+
+Q_SIGNALS:
+    void finished(const QString &key, const QString &copyrights, const QImage &slab);
+
+private:
+    QString m_key;
+    QString m_copyrights;
+    QImage m_logo;
+    QSize m_viewport;
+};
+
 class QGeoTiledMapNokia: public QGeoTiledMap
 {
 Q_OBJECT
@@ -55,10 +79,18 @@ public:
     QString getViewCopyright();
     void evaluateCopyrights(const QSet<QGeoTileSpec> &visibleTiles);
 
+private Q_SLOTS:
+    void copyrightsSlabRendered(const QString &key, const QString &copyrights, const QImage &slab);
+
 private:
+    void cacheCopyrightsSlab(const QString &key, const QImage &slab);
+
     QImage m_logo;
     QImage m_copyrightsSlab;
     QString m_lastCopyrightsString;
+    QCache<QString, QImage> m_copyrightsSlabs;
+    QSet<QString> m_renderingSlabs;
+    QString m_pendingSlabKey;
     QPointer<QGeoTiledMappingManagerEngineNokia> m_engine;
 
     Q_DISABLE_COPY(QGeoTiledMapNokia)
@@ -51,6 +51,12 @@
 #include <QtCore/qmath.h>
 #include <QtCore/qstandardpaths.h>
 
+#include <cmath>
+
+#define COPYRIGHTS_GRID_SIZE 32
+#define COPYRIGHTS_MAX_LEVEL 30
+#define COPYRIGHTS_TEXT_CACHE_SIZE 256
+
 QT_BEGIN_NAMESPACE
 
 QGeoTiledMappingManagerEngineNokia::QGeoTiledMappingManagerEngineNokia(
@@ -58,7 +64,8 @@ QGeoTiledMappingManagerEngineNokia::QGeoTiledMappingManagerEngineNokia(
     const QVariantMap &parameters,
     QGeoServiceProvider::Error *error,
     QString *errorString)
-    : QGeoTiledMappingManagerEngine()
+    : QGeoTiledMappingManagerEngine(),
+      m_copyrightsTexts(COPYRIGHTS_TEXT_CACHE_SIZE)
 {
     Q_UNUSED(error);
     Q_UNUSED(errorString);
@@ -197,6 +204,8 @@ QGeoTiledMappingManagerEngineNokia::QGeoTiledMappingManagerEngineNokia(
             m_prefetchStyle = QGeoTiledMap::PrefetchNeighbourLayer;
         else if (prefetchingMode == QStringLiteral("NoPrefetching"))
             m_prefetchStyle = QGeoTiledMap::NoPrefetching;
+        else if (prefetchingMode == QStringLiteral("Predictive"))
+            m_prefetchStyle = QGeoTiledMap::PrefetchPredictive;
     }
 
     setTileCache(tileCache);
@@ -264,8 +273,9 @@ void QGeoTiledMappingManagerEngineNokia::loadCopyrightsDescriptorsFromJson(const
     QJsonObject jsonObj = doc.object();
 
     m_copyrights.clear();
+    m_copyrightsTexts.clear();
     for (auto it = jsonObj.constBegin(), end = jsonObj.constEnd(); it != end; ++it) {
-        QList<CopyrightDesc> copyrightDescList;
+        CopyrightIndex &copyrightIndex = m_copyrights[it.key()];
 
         QJsonArray descs = it.value().toArray();
         for (int descIndex = 0; descIndex < descs.count(); descIndex++) {
@@ -290,9 +300,74 @@ void QGeoTiledMappingManagerEngineNokia::loadCopyrightsDescriptorsFromJson(const
                                                            right));
                 copyrightDesc.boxes << boundingBox;
             }
-            copyrightDescList << copyrightDesc;
+            copyrightIndex.descriptors << copyrightDesc;
+        }
+        buildCopyrightIndex(copyrightIndex);
+    }
+}
+
+static void copyrightCellRange(double from, double to, int *first, int *last)
+{
+    *first = qBound(0, int(std::floor(from * COPYRIGHTS_GRID_SIZE)), COPYRIGHTS_GRID_SIZE - 1);
+    *last = qBound(0, int(std::ceil(to * COPYRIGHTS_GRID_SIZE)) - 1, COPYRIGHTS_GRID_SIZE - 1);
+    if (*last < *first)
+        *last = *first;
+}
+
+void QGeoTiledMappingManagerEngineNokia::buildCopyrightIndex(CopyrightIndex &index)
+{
+    int levelCount = 0;
+    foreach (const CopyrightDesc &desc, index.descriptors) {
+        if (desc.maxLevel >= 0)
+            levelCount = qMax(levelCount, qMin(int(std::floor(desc.maxLevel)), COPYRIGHTS_MAX_LEVEL) + 1);
+    }
+    index.levels.fill(CopyrightIndex::Level(), levelCount);
+
+    for (int level = 0; level < levelCount; ++level) {
+        CopyrightIndex::Level &bucket = index.levels[level];
+        bucket.cells.resize(COPYRIGHTS_GRID_SIZE * COPYRIGHTS_GRID_SIZE);
+
+        for (int descIndex = 0; descIndex < index.descriptors.count(); ++descIndex) {
+            const CopyrightDesc &desc = index.descriptors.at(descIndex);
+            if (desc.minLevel >= level + 1 || desc.maxLevel < level)
+                continue;
+            if (desc.minLevel > level || desc.maxLevel < level + 1)
+                bucket.partial = true;
+
+            if (desc.boxes.isEmpty()) {
+                bucket.unboxed.append(descIndex);
+                continue;
+            }
+
+            QVector<bool> covered(COPYRIGHTS_GRID_SIZE * COPYRIGHTS_GRID_SIZE, false);
+            foreach (const QGeoRectangle &box, desc.boxes) {
+                const QDoubleVector2D topLeft = QWebMercator::coordToMercator(box.topLeft());
+                const QDoubleVector2D bottomRight = QWebMercator::coordToMercator(box.bottomRight());
+                int row0, row1;
+                copyrightCellRange(topLeft.y(), bottomRight.y(), &row0, &row1);
+
+                // boxes crossing the dateline cover both ends of the grid
+                QVector<QPair<double, double> > spans;
+                if (box.topLeft().longitude() > box.bottomRight().longitude())
+                    spans << qMakePair(topLeft.x(), 1.0) << qMakePair(0.0, bottomRight.x());
+                else
+                    spans << qMakePair(topLeft.x(), bottomRight.x());
+
+                foreach (const auto &span, spans) {
+                    int col0, col1;
+                    copyrightCellRange(span.first, span.second, &col0, &col1);
+                    for (int row = row0; row <= row1; ++row) {
+                        for (int col = col0; col <= col1; ++col) {
+                            const int cell = row * COPYRIGHTS_GRID_SIZE + col;
+                            if (!covered.at(cell)) {
+                                covered[cell] = true;
+                                bucket.cells[cell].append(descIndex);
+                            }
+                        }
+                    }
+                }
+            }
         }
-        m_copyrights[it.key()] = copyrightDescList;
     }
 }
 
@@ -369,77 +444,98 @@ QString QGeoTiledMappingManagerEngineNokia::evaluateCopyrightsText(const QGeoMap
                                                                    const QSet<QGeoTileSpec> &tiles)
 {
     static const QChar copyrightSymbol(0x00a9);
-    typedef QSet<QGeoTileSpec>::const_iterator tile_iter;
-    QGeoRectangle viewport;
-    double viewX0, viewY0, viewX1, viewY1;
-
-    tile_iter tile = tiles.constBegin();
-    tile_iter lastTile = tiles.constEnd();
 
+    const auto indexIt = m_copyrights.constFind(getBaseScheme(mapType.mapId()));
+    const int level = int(std::floor(zoomLevel));
+    if (indexIt == m_copyrights.constEnd() || level < 0 || level >= indexIt->levels.size())
+        return QString();
+
+    // Within a level that every descriptor covers entirely the text only depends on the tiles,
+    // otherwise the exact zoom level is part of the key.
+    CopyrightKey key;
+    key.mapId = mapType.mapId();
+    key.zoom = indexIt->levels.at(level).partial ? zoomLevel : qreal(level);
+    key.tileZoom = 0;
+    key.x0 = key.y0 = key.x1 = key.y1 = 0;
+
+    // this approach establishes a geo-bounding box from passed tiles to test for intersecition
+    // with copyrights boxes.
+    QGeoRectangle viewport;
     if (tiles.count()) {
-        double divFactor = qPow(2.0, tile->zoom());
-        viewX0 = viewX1 = tile->x();
-        viewY0 = viewY1 = tile->y();
-
-        // this approach establishes a geo-bounding box from passed tiles to test for intersecition
-        // with copyrights boxes.
-        int numTiles = 0;
-        for (; tile != lastTile; ++tile) {
-            if (tile->x() < viewX0)
-                viewX0 = tile->x();
-            if (tile->x() > viewX1)
-                viewX1 = tile->x();
-            if (tile->y() < viewY0)
-                viewY0 = tile->y();
-            if (tile->y() > viewY1)
-                viewY1 = tile->y();
-            numTiles++;
+        auto tile = tiles.constBegin();
+        key.tileZoom = tile->zoom();
+        key.x0 = key.x1 = tile->x();
+        key.y0 = key.y1 = tile->y();
+        for (const auto end = tiles.constEnd(); tile != end; ++tile) {
+            key.x0 = qMin(key.x0, tile->x());
+            key.x1 = qMax(key.x1, tile->x());
+            key.y0 = qMin(key.y0, tile->y());
+            key.y1 = qMax(key.y1, tile->y());
         }
-
-        viewX1++;
-        viewY1++;
-
-        QDoubleVector2D pt;
-
-        pt.setX(viewX0 / divFactor);
-        pt.setY(viewY0 / divFactor);
-        viewport.setTopLeft(QWebMercator::mercatorToCoord(pt));
-        pt.setX(viewX1 / divFactor);
-        pt.setY(viewY1 / divFactor);
-        viewport.setBottomRight(QWebMercator::mercatorToCoord(pt));
+        key.x1++;
+        key.y1++;
     }
 
-    // TODO: the following invalidation detection algorithm may be improved later.
-    QList<CopyrightDesc> descriptorList = m_copyrights[ getBaseScheme(mapType.mapId()) ];
-    CopyrightDesc *descriptor;
-    int descIndex, boxIndex;
-    QString copyrightsText;
-    QSet<QString> copyrightStrings;
+    if (const QString *text = m_copyrightsTexts.object(key))
+        return *text;
 
-    for (descIndex = 0; descIndex < descriptorList.count(); descIndex++) {
-        if (descriptorList[descIndex].minLevel <= zoomLevel && zoomLevel <= descriptorList[descIndex].maxLevel) {
-            descriptor = &descriptorList[descIndex];
+    if (tiles.count()) {
+        const double divFactor = qPow(2.0, key.tileZoom);
+        viewport.setTopLeft(QWebMercator::mercatorToCoord(QDoubleVector2D(key.x0 / divFactor,
+                                                                          key.y0 / divFactor)));
+        viewport.setBottomRight(QWebMercator::mercatorToCoord(QDoubleVector2D(key.x1 / divFactor,
+                                                                              key.y1 / divFactor)));
+    }
 
-            for (boxIndex = 0; boxIndex < descriptor->boxes.count(); boxIndex++) {
-                QGeoRectangle box = descriptor->boxes[boxIndex];
+    const CopyrightIndex &index = *indexIt;
+    const CopyrightIndex::Level &bucket = index.levels.at(level);
+    QVector<bool> tested(index.descriptors.count(), false);
+    QVector<bool> candidates(index.descriptors.count(), false);
+    foreach (int descIndex, bucket.unboxed)
+        candidates[descIndex] = true;
 
-                if (box.intersects(viewport)) {
-                    copyrightStrings.insert(descriptor->label);
-                    break;
+    if (tiles.count()) {
+        const double divFactor = qPow(2.0, key.tileZoom);
+        int row0, row1, col0, col1;
+        copyrightCellRange(key.y0 / divFactor, key.y1 / divFactor, &row0, &row1);
+        copyrightCellRange(key.x0 / divFactor, key.x1 / divFactor, &col0, &col1);
+        for (int row = row0; row <= row1; ++row) {
+            for (int col = col0; col <= col1; ++col) {
+                foreach (int descIndex, bucket.cells.at(row * COPYRIGHTS_GRID_SIZE + col)) {
+                    if (tested.at(descIndex))
+                        continue;
+                    tested[descIndex] = true;
+                    foreach (const QGeoRectangle &box, index.descriptors.at(descIndex).boxes) {
+                        if (box.intersects(viewport)) {
+                            candidates[descIndex] = true;
+                            break;
+                        }
+                    }
                 }
             }
-            if (!descriptor->boxes.count())
-                copyrightStrings.insert(descriptor->label);
         }
     }
 
-    foreach (const QString &copyrightString, copyrightStrings) {
+    QString copyrightsText;
+    QSet<QString> copyrightStrings;
+
+    for (int descIndex = 0; descIndex < index.descriptors.count(); ++descIndex) {
+        if (!candidates.at(descIndex))
+            continue;
+        const CopyrightDesc &descriptor = index.descriptors.at(descIndex);
+        if (descriptor.minLevel > zoomLevel || zoomLevel > descriptor.maxLevel)
+            continue;
+        if (copyrightStrings.contains(descriptor.label))
+            continue;
+        copyrightStrings.insert(descriptor.label);
+
         if (copyrightsText.length())
             copyrightsText += QLatin1Char('\n');
         copyrightsText += copyrightSymbol;
-        copyrightsText += copyrightString;
+        copyrightsText += descriptor.label;
     }
 
+    m_copyrightsTexts.insert(key, new QString(copyrightsText));
     return copyrightsText;
 }
 
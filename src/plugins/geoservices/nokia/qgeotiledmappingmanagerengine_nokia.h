@@ -44,9 +44,11 @@
 
 #include <QGeoServiceProvider>
 
+#include <QCache>
 #include <QList>
 #include <QHash>
 #include <QSet>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 
@@ -92,13 +94,56 @@ private:
         QString label;
     };
 
+    // Descriptors of one base scheme, bucketed by integer zoom level and by
+    // cells of a regular grid over the mercator plane, so that evaluating the
+    // copyrights of a viewport only tests the boxes that can intersect it.
+    class CopyrightIndex
+    {
+    public:
+        class Level
+        {
+        public:
+            Level() : partial(false) {}
+
+            QVector<int> unboxed;
+            QVector<QVector<int> > cells;
+            bool partial; // some descriptor covers only part of [level, level + 1)
+        };
+
+        QList<CopyrightDesc> descriptors;
+        QVector<Level> levels;
+    };
+
+    class CopyrightKey
+    {
+    public:
+        bool operator==(const CopyrightKey &other) const
+        {
+            return mapId == other.mapId && zoom == other.zoom && tileZoom == other.tileZoom
+                    && x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+        }
+        friend uint qHash(const CopyrightKey &key, uint seed = 0)
+        {
+            return qHash(key.mapId, seed) ^ qHash(key.zoom) ^ (uint(key.tileZoom) << 27)
+                    ^ (uint(key.x0) << 16) ^ uint(key.y0) ^ (uint(key.x1) << 8) ^ (uint(key.y1) << 24);
+        }
+
+        int mapId;
+        qreal zoom;
+        int tileZoom;
+        int x0, y0, x1, y1;
+    };
+
+    static void buildCopyrightIndex(CopyrightIndex &index);
+
     void initialize();
     void populateMapSchemes();
     void updateVersion(const QJsonObject &newVersionData);
     void saveMapVersion();
     void loadMapVersion();
 
-    QHash<QString, QList<CopyrightDesc> > m_copyrights;
+    QHash<QString, CopyrightIndex> m_copyrights;
+    QCache<CopyrightKey, QString> m_copyrightsTexts;
     QHash<int, QString> m_mapSchemes;
     QGeoMapVersion m_mapVersion;
 
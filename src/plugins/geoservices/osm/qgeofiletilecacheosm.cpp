@@ -36,6 +36,7 @@
 
 #include "qgeofiletilecacheosm.h"
 #include <QtLocation/private/qgeotilespec_p.h>
+#include <QtLocation/private/qgeotilediskstorage_p.h>
 #include <QDir>
 #include <QDirIterator>
 #include <QPair>
@@ -45,6 +46,11 @@
 
 QT_BEGIN_NAMESPACE
 
+static QString offlineIndexFileName()
+{
+    return QStringLiteral("offline.index");
+}
+
 QGeoFileTileCacheOsm::QGeoFileTileCacheOsm(const QVector<QGeoTileProviderOsm *> &providers,
                                            const QString &offlineDirectory,
                                            const QString &directory,
@@ -55,8 +61,6 @@ QGeoFileTileCacheOsm::QGeoFileTileCacheOsm(const QVector<QGeoTileProviderOsm *>
     for (int i = 0; i < providers.size(); i++) {
         providers[i]->setParent(this);
         m_highDpi[i] = providers[i]->isHighDpi();
-        m_mapIdFutures[providers[i]->mapType().mapId()].isFinished(); // To construct a default future for this mapId
-        m_requestCancel[providers[i]->mapType().mapId()] = 0;
         connect(providers[i], &QGeoTileProviderOsm::resolutionFinished, this, &QGeoFileTileCacheOsm::onProviderResolutionFinished);
         connect(providers[i], &QGeoTileProviderOsm::resolutionError, this, &QGeoFileTileCacheOsm::onProviderResolutionFinished);
     }
@@ -64,20 +68,27 @@ QGeoFileTileCacheOsm::QGeoFileTileCacheOsm(const QVector<QGeoTileProviderOsm *>
 
 QGeoFileTileCacheOsm::~QGeoFileTileCacheOsm()
 {
-    for (const QGeoTileProviderOsm *p : m_providers) {
-        m_requestCancel[p->mapType().mapId()] = 1;
-        m_mapIdFutures[p->mapType().mapId()].waitForFinished();
-    }
+    m_offlineCancel = 1;
+    m_offlineFuture.waitForFinished();
+
+    // Persist the tileset timestamps with the disk index, to skip the scan in init()
+    QDataStream out(&indexMetadata_, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_8);
+    out << m_maxMapIdTimestamps;
 }
 
-QSharedPointer<QGeoTileTexture> QGeoFileTileCacheOsm::get(const QGeoTileSpec &spec)
+void QGeoFileTileCacheOsm::insert(const QGeoTileSpec &spec,
+                                  const QByteArray &bytes,
+                                  const QString &format,
+                                  QAbstractGeoTileCache::CacheAreas areas)
 {
-    QSharedPointer<QGeoTileTexture> tt = getFromMemory(spec);
-    if (tt)
-        return tt;
-    if ((tt = getFromOfflineStorage(spec)))
-        return tt;
-    return getFromDisk(spec);
+    QGeoFileTileCache::insert(spec, bytes, format, areas);
+
+    // Keep the newest tile timestamp of the tileset current, as it is persisted on shutdown
+    if (!bytes.isEmpty() && (areas & QAbstractGeoTileCache::DiskCache)
+            && spec.mapId() >= 0 && spec.mapId() < m_maxMapIdTimestamps.size()) {
+        m_maxMapIdTimestamps[spec.mapId()] = QDateTime::currentDateTime();
+    }
 }
 
 void QGeoFileTileCacheOsm::onProviderResolutionFinished(const QGeoTileProviderOsm *provider)
@@ -89,20 +100,19 @@ void QGeoFileTileCacheOsm::onProviderResolutionFinished(const QGeoTileProviderOs
             int mapId = m_providers[i]->mapType().mapId();
             m_highDpi[i] = m_providers[i]->isHighDpi();
 
-            // Terminate initOfflineRegistry future for mapId.
-            if (!m_offlineDirectory.isEmpty()) {
-                m_requestCancel[mapId] = 1;
-                m_mapIdFutures[mapId].waitForFinished();
-                m_requestCancel[mapId] = 0;
-            }
-
             // reload cache for mapId i
             dropTiles(mapId);
             loadTiles(mapId);
 
-            // reload offline registry for mapId i
-            if (!m_offlineDirectory.isEmpty())
-                m_mapIdFutures[mapId] = QtConcurrent::run(this, &QGeoFileTileCacheOsm::initOfflineRegistry, mapId);
+            // reload offline registry for mapId i, from the files found by the
+            // scan once it is done: the tile names depend on the dpi
+            if (!m_offlineDirectory.isEmpty()) {
+                const QFuture<void> previous = m_offlineFuture;
+                m_offlineFuture = QtConcurrent::run([this, previous, mapId]() {
+                    QFuture<void>(previous).waitForFinished();
+                    updateOfflineRegistry(mapId);
+                });
+            }
 
             // send signal to clear scene in all maps created through this provider that use the reloaded tiles
             emit mapDataUpdated(mapId);
@@ -134,55 +144,53 @@ void QGeoFileTileCacheOsm::init()
     // Create a mapId to maxTimestamp LUT..
     m_maxMapIdTimestamps.resize(max+1); // initializes to invalid QDateTime
 
-    // .. by finding the newest file in each tileset (tileset = mapId).
-    QDir dir(directory_);
-    QStringList formats;
-    formats << QLatin1String("*.*");
-    QStringList files = dir.entryList(formats, QDir::Files);
+    // Base class ::init()
+    QGeoFileTileCache::init();
 
-    for (const QString &tileFileName : files) {
-        QGeoTileSpec spec = filenameToTileSpec(tileFileName);
-        if (spec.zoom() == -1)
-            continue;
-        QFileInfo fi(dir.filePath(tileFileName));
-        if (fi.lastModified() > m_maxMapIdTimestamps[spec.mapId()])
-            m_maxMapIdTimestamps[spec.mapId()] = fi.lastModified();
+    // .. restoring it from the disk index if possible ..
+    bool timestampsLoaded = false;
+    if (diskIndexLoaded_ && !indexMetadata_.isEmpty()) {
+        QVector<QDateTime> timestamps;
+        QDataStream in(indexMetadata_);
+        in.setVersion(QDataStream::Qt_5_8);
+        in >> timestamps;
+        if (in.status() == QDataStream::Ok && timestamps.size() == m_maxMapIdTimestamps.size()) {
+            m_maxMapIdTimestamps = timestamps;
+            timestampsLoaded = true;
+        }
     }
 
-    // Base class ::init()
-    QGeoFileTileCache::init();
+    // .. or by finding the newest file in each tileset (tileset = mapId).
+    if (!timestampsLoaded) {
+        QDir dir(directory_);
+        QVector<QGeoTileDiskStorage::Entry> files;
+        diskStorage()->list(&files, false);
+
+        for (const QGeoTileDiskStorage::Entry &tileFile : qAsConst(files)) {
+            QGeoTileSpec spec = filenameToTileSpec(tileFile.fileName);
+            if (spec.zoom() == -1 || spec.mapId() >= m_maxMapIdTimestamps.size())
+                continue;
+            const QDateTime lastModified = diskStorage()->lastModified(dir.filePath(tileFile.fileName));
+            if (lastModified > m_maxMapIdTimestamps[spec.mapId()])
+                m_maxMapIdTimestamps[spec.mapId()] = lastModified;
+        }
+    }
 
-    for (QGeoTileProviderOsm * p: m_providers) {
+    for (QGeoTileProviderOsm * p: m_providers)
         clearObsoleteTiles(p);
-        if (!m_offlineDirectory.isEmpty())
-            m_mapIdFutures[p->mapType().mapId()] = QtConcurrent::run(this, &QGeoFileTileCacheOsm::initOfflineRegistry, p->mapType().mapId());
-    }
+
+    // A single scan of the offline directory serves all map ids
+    if (!m_offlineDirectory.isEmpty())
+        m_offlineFuture = QtConcurrent::run(this, &QGeoFileTileCacheOsm::initOfflineRegistry);
 }
 
-QSharedPointer<QGeoTileTexture> QGeoFileTileCacheOsm::getFromOfflineStorage(const QGeoTileSpec &spec)
+QString QGeoFileTileCacheOsm::offlineTileFilename(const QGeoTileSpec &spec) const
 {
-    QMutexLocker locker(&storageLock);
-    if (m_tilespecToOfflineFilepath.contains(spec)) {
-        const QString fileName = m_tilespecToOfflineFilepath[spec];
-        locker.unlock();
-        QFile file(fileName);
-        file.open(QIODevice::ReadOnly);
-        QByteArray bytes = file.readAll();
-        file.close();
-
-        QImage image;
-        if (!image.loadFromData(bytes)) {
-            handleError(spec, QLatin1String("Problem with tile image"));
-            return QSharedPointer<QGeoTileTexture>(0);
-        }
-
-        addToMemoryCache(spec, bytes, QString());
-        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(spec, image);
-        if (tt)
-            return tt;
-    }
+    if (m_offlineDirectory.isEmpty())
+        return QString();
 
-    return QSharedPointer<QGeoTileTexture>();
+    QReadLocker locker(&m_offlineLock);
+    return m_tilespecToOfflineFilepath.value(spec);
 }
 
 void QGeoFileTileCacheOsm::dropTiles(int mapId)
@@ -203,76 +211,75 @@ void QGeoFileTileCacheOsm::dropTiles(int mapId)
         if (k.mapId() == mapId)
             diskCache_.remove(k);
 
-    keys = m_tilespecToOfflineFilepath.keys();
-    for (const QGeoTileSpec &k : keys)
-        if (k.mapId() == mapId)
-            m_tilespecToOfflineFilepath.remove(k);
+    QWriteLocker locker(&m_offlineLock);
+    for (auto it = m_tilespecToOfflineFilepath.begin(); it != m_tilespecToOfflineFilepath.end(); ) {
+        if (it.key().mapId() == mapId)
+            it = m_tilespecToOfflineFilepath.erase(it);
+        else
+            ++it;
+    }
 }
 
 void QGeoFileTileCacheOsm::loadTiles(int mapId)
 {
-    QStringList formats;
-    formats << QLatin1String("*.*");
-
     QDir dir(directory_);
-    QStringList files = dir.entryList(formats, QDir::Files);
+    QVector<QGeoTileDiskStorage::Entry> files;
+    diskStorage()->list(&files, false);
 
-    for (int i = 0; i < files.size(); ++i) {
-        QGeoTileSpec spec = filenameToTileSpec(files.at(i));
+    for (const QGeoTileDiskStorage::Entry &tileFile : qAsConst(files)) {
+        QGeoTileSpec spec = filenameToTileSpec(tileFile.fileName);
         if (spec.zoom() == -1 || spec.mapId() != mapId)
             continue;
-        QString filename = dir.filePath(files.at(i));
+        QString filename = dir.filePath(tileFile.fileName);
         addToDiskCache(spec, filename);
     }
 }
 
-void QGeoFileTileCacheOsm::initOfflineRegistry(int mapId)
+/*
+    Lists the offline tiles, from the index persisted in the cache directory
+    when the offline directory tree did not change since it was written, and
+    publishes them for all map ids. Runs in the thread pool.
+*/
+void QGeoFileTileCacheOsm::initOfflineRegistry()
 {
-    if (mapId < 1) // map ids in osm start from 1
+    QGeoTileDirectoryIndex index;
+    if (!index.build(m_offlineDirectory, QDir(directory_).filePath(offlineIndexFileName()), &m_offlineCancel))
         return;
+    m_offlineFiles = index.entries();
+    updateOfflineRegistry(-1);
+}
 
-    // Dealing with duplicates: picking the newest
-    QMap<QString, QPair<QString, QDateTime> > fileDates; // key is filename, value is <filepath, lastmodified>
-    QDirIterator it(m_offlineDirectory, QStringList() << "*.*", QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks );
-    while (it.hasNext()) {
-        const QString &path = it.next();
-        QFileInfo f(path);
-        if (!fileDates.contains(f.fileName()) || fileDates[f.fileName()].second < f.lastModified())
-            fileDates[f.fileName()] = QPair<QString, QDateTime>(f.filePath(), f.lastModified());
-        if (m_requestCancel[mapId])
+/*
+    Maps the offline files to the tiles of \a mapId, or of all map ids if -1,
+    and replaces the ones previously registered for them. Runs in the thread
+    pool, after initOfflineRegistry().
+*/
+void QGeoFileTileCacheOsm::updateOfflineRegistry(int mapId)
+{
+    QHash<QGeoTileSpec, QString> tiles;
+    for (const QGeoTileDirectoryIndex::Entry &entry : qAsConst(m_offlineFiles)) {
+        const QGeoTileSpec spec = filenameToTileSpec(entry.fileName);
+        if (spec.zoom() == -1 || spec.mapId() < 1) // map ids in osm start from 1
+            continue;
+        if (mapId != -1 && spec.mapId() != mapId)
+            continue;
+        tiles.insert(spec, entry.filePath);
+        if (m_offlineCancel.load())
             return;
     }
 
-    // Clear the content of the index. Entirely (at startup), or selectively (when a provider resolution changes the highDpi status).
-    QList<QGeoTileSpec> toRemove;
-    for (auto i = m_tilespecToOfflineFilepath.constBegin(); i != m_tilespecToOfflineFilepath.constEnd(); ++i) {
-        if (i.key().mapId() == mapId)
-            toRemove.append(i.key());
-    }
-    storageLock.lock();
-    for (const auto &i : toRemove)
-        m_tilespecToOfflineFilepath.remove(i);
-    storageLock.unlock();
-
-    if (m_requestCancel[mapId])
+    QWriteLocker locker(&m_offlineLock);
+    if (mapId == -1) {
+        m_tilespecToOfflineFilepath.swap(tiles);
         return;
-
-    // Fill the index by mapId
-    int count = 0;
-    for (auto i= fileDates.constBegin(); i != fileDates.constEnd(); ++i) {
-        QGeoTileSpec spec = filenameToTileSpec(i.key());
-        if (spec.zoom() == -1)
-            continue;
-        if (spec.mapId() != mapId)
-            continue;
-        count++;
-        storageLock.lock();
-        m_tilespecToOfflineFilepath[spec] = i.value().first;
-        storageLock.unlock();
-        if (m_requestCancel[mapId])
-            return;
     }
-    //qInfo() << "OSM plugin has found and is using "<< count <<" offline tiles";
+    for (auto it = m_tilespecToOfflineFilepath.begin(); it != m_tilespecToOfflineFilepath.end(); ) {
+        if (it.key().mapId() == mapId)
+            it = m_tilespecToOfflineFilepath.erase(it);
+        else
+            ++it;
+    }
+    m_tilespecToOfflineFilepath.unite(tiles);
 }
 
 QString QGeoFileTileCacheOsm::tileSpecToFilename(const QGeoTileSpec &spec, const QString &format, const QString &directory) const
@@ -333,7 +340,7 @@ QGeoTileSpec QGeoFileTileCacheOsm::filenameToTileSpec(const QString &filename) c
         numbers.append(value);
     }
 
-    if (numbers.at(0) > m_providers.size())
+    if (numbers.at(0) < 1 || numbers.at(0) > m_providers.size())
         return emptySpec;
 
     bool highDpi = m_providers[numbers.at(0) - 1]->isHighDpi();
@@ -362,8 +369,9 @@ void QGeoFileTileCacheOsm::clearObsoleteTiles(const QGeoTileProviderOsm *p)
             if (m_maxMapIdTimestamps[p->mapType().mapId()].isValid() &&  // there are tiles in the cache
                 p->timestamp() > m_maxMapIdTimestamps[p->mapType().mapId()]) { // and they are older than the provider
                 qInfo() << "provider for " << p->mapType().name() << " timestamp: " << p->timestamp()
-                        << " -- data last modified: " << m_maxMapIdTimestamps[p->mapType().mapId()] << ". Clearing.";
-                clearMapId(p->mapType().mapId());
+                        << " -- data last modified: " << m_maxMapIdTimestamps[p->mapType().mapId()] << ". Revalidating.";
+                // Tiles are kept and shown until the server says they changed
+                setStaleBefore(p->mapType().mapId(), p->timestamp());
                 m_maxMapIdTimestamps[p->mapType().mapId()] = p->timestamp(); // don't do it again.
             }
         } else {
@@ -39,7 +39,9 @@
 
 #include "qgeotileproviderosm.h"
 #include <QtLocation/private/qgeofiletilecache_p.h>
+#include <QtLocation/private/qgeotiledirectoryindex_p.h>
 #include <QHash>
+#include <QReadWriteLock>
 #include <QtConcurrent>
 #include <qatomic.h>
 
@@ -55,7 +57,10 @@ public:
                          QObject *parent = 0);
     ~QGeoFileTileCacheOsm();
 
-    QSharedPointer<QGeoTileTexture> get(const QGeoTileSpec &spec) Q_DECL_OVERRIDE;
+    void insert(const QGeoTileSpec &spec,
+                const QByteArray &bytes,
+                const QString &format,
+                QAbstractGeoTileCache::CacheAreas areas = QAbstractGeoTileCache::AllCaches) Q_DECL_OVERRIDE;
 
 Q_SIGNALS:
     void mapDataUpdated(int mapId);
@@ -68,18 +73,21 @@ protected:
     void init() Q_DECL_OVERRIDE;
     QString tileSpecToFilename(const QGeoTileSpec &spec, const QString &format, const QString &directory) const Q_DECL_OVERRIDE;
     QGeoTileSpec filenameToTileSpec(const QString &filename) const Q_DECL_OVERRIDE;
-    QSharedPointer<QGeoTileTexture> getFromOfflineStorage(const QGeoTileSpec &spec);
+    QString offlineTileFilename(const QGeoTileSpec &spec) const Q_DECL_OVERRIDE;
     void dropTiles(int mapId);
     void loadTiles(int mapId);
 
-    void initOfflineRegistry(int mapId);
+    void initOfflineRegistry();
+    void updateOfflineRegistry(int mapId);
     void clearObsoleteTiles(const QGeoTileProviderOsm *p);
 
     QString m_offlineDirectory;
+    // Offline tiles of all map ids, read on every lookup and replaced in one go
     QHash<QGeoTileSpec, QString> m_tilespecToOfflineFilepath;
-    QMap<int, QAtomicInt> m_requestCancel;
-    QMap<int, QFuture<void>> m_mapIdFutures;
-    QMutex storageLock;
+    mutable QReadWriteLock m_offlineLock;
+    QVector<QGeoTileDirectoryIndex::Entry> m_offlineFiles;  // only touched by the registry jobs
+    QFuture<void> m_offlineFuture;
+    QAtomicInt m_offlineCancel;
     QVector<QGeoTileProviderOsm *> m_providers;
     QVector<bool> m_highDpi;
     QVector<QDateTime> m_maxMapIdTimestamps;
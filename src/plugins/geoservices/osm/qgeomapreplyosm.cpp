@@ -40,6 +40,7 @@
 #include "qgeomapreplyosm.h"
 
 #include <QtLocation/private/qgeotilespec_p.h>
+#include <QtLocation/private/qgeotilevalidators_p.h>
 
 QGeoMapReplyOsm::QGeoMapReplyOsm(QNetworkReply *reply,
                                  const QGeoTileSpec &spec,
@@ -71,6 +72,13 @@ void QGeoMapReplyOsm::networkReplyFinished()
     if (reply->error() != QNetworkReply::NoError) // Already handled in networkReplyError
         return;
 
+    setValidators(QGeoTileValidators::fromHttpHeaders(reply->rawHeaderPairs()));
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        setNotModified(true);
+        setFinished(true);
+        return;
+    }
+
     QByteArray a = reply->readAll();
 
     setMapImageData(a);
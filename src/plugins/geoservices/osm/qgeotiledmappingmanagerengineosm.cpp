@@ -46,6 +46,7 @@
 #include <QtLocation/private/qgeomaptype_p.h>
 #include <QtLocation/private/qgeotiledmap_p.h>
 #include <QtLocation/private/qgeofiletilecache_p.h>
+#include <QtLocation/private/qgeotilediskstorage_p.h>
 
 #include <QtNetwork/QNetworkAccessManager>
 
@@ -257,6 +258,10 @@ QGeoTiledMappingManagerEngineOsm::QGeoTiledMappingManagerEngineOsm(const QVarian
     } else {
         tileCache->setCostStrategyDisk(QGeoFileTileCache::ByteSize);
     }
+    if (parameters.contains(QStringLiteral("osm.mapping.cache.disk.storage"))) {
+        const QString storage = parameters.value(QStringLiteral("osm.mapping.cache.disk.storage")).toString().toLower();
+        tileCache->setDiskStorage(QGeoTileDiskStorage::create(storage));
+    }
     if (parameters.contains(QStringLiteral("osm.mapping.cache.disk.size"))) {
         bool ok = false;
         int cacheSize = parameters.value(QStringLiteral("osm.mapping.cache.disk.size")).toString().toInt(&ok);
@@ -301,6 +306,12 @@ QGeoTiledMappingManagerEngineOsm::QGeoTiledMappingManagerEngineOsm(const QVarian
         if (ok)
             tileCache->setExtraTextureUsage(cacheSize);
     }
+    if (parameters.contains(QStringLiteral("osm.mapping.cache.statistics_interval"))) {
+        bool ok = false;
+        const int interval = parameters.value(QStringLiteral("osm.mapping.cache.statistics_interval")).toString().toInt(&ok);
+        if (ok)
+            tileCache->setStatisticsLogInterval(interval);
+    }
 
 
     setTileCache(tileCache);
@@ -312,6 +323,12 @@ QGeoTiledMappingManagerEngineOsm::QGeoTiledMappingManagerEngineOsm(const QVarian
         const QByteArray ua = parameters.value(QStringLiteral("osm.useragent")).toString().toLatin1();
         tileFetcher->setUserAgent(ua);
     }
+    if (parameters.contains(QStringLiteral("osm.mapping.max_requests_per_host"))) {
+        bool ok = false;
+        const int maxRequests = parameters.value(QStringLiteral("osm.mapping.max_requests_per_host")).toString().toInt(&ok);
+        if (ok && maxRequests > 0)
+            tileFetcher->setMaxRequestsPerHost(maxRequests);
+    }
     setTileFetcher(tileFetcher);
 
     /* PREFETCHING */
@@ -323,6 +340,8 @@ QGeoTiledMappingManagerEngineOsm::QGeoTiledMappingManagerEngineOsm(const QVarian
             m_prefetchStyle = QGeoTiledMap::PrefetchNeighbourLayer;
         else if (prefetchingMode == QStringLiteral("NoPrefetching"))
             m_prefetchStyle = QGeoTiledMap::NoPrefetching;
+        else if (prefetchingMode == QStringLiteral("Predictive"))
+            m_prefetchStyle = QGeoTiledMap::PrefetchPredictive;
     }
 
     *error = QGeoServiceProvider::NoError;
@@ -114,6 +114,14 @@ bool QGeoTileFetcherOsm::initialized() const
     return m_ready;
 }
 
+QString QGeoTileFetcherOsm::tileHost(const QGeoTileSpec &spec) const
+{
+    const int id = spec.mapId() - 1;
+    if (id < 0 || id >= m_providers.size())
+        return QString();
+    return m_providers[id]->tileAddress(spec.x(), spec.y(), spec.zoom()).host();
+}
+
 void QGeoTileFetcherOsm::onProviderResolutionFinished(const QGeoTileProviderOsm *provider)
 {
     if ((m_ready = providersResolved(m_providers))) {
@@ -159,6 +167,9 @@ QGeoTiledMapReply *QGeoTileFetcherOsm::getTileImage(const QGeoTileSpec &spec)
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::UserAgentHeader, m_userAgent);
     request.setUrl(url);
+    const QGeoTileHttpHeaders conditionalHeaders = tileValidators(spec).conditionalHeaders();
+    for (const auto &header : conditionalHeaders)
+        request.setRawHeader(header.first, header.second);
     QNetworkReply *reply = m_nm->get(request);
     return new QGeoMapReplyOsm(reply, spec, m_providers[id]->format());
 }
@@ -68,6 +68,7 @@ Q_SIGNALS:
 
 protected:
     bool initialized() const Q_DECL_OVERRIDE;
+    QString tileHost(const QGeoTileSpec &spec) const Q_DECL_OVERRIDE;
 
 protected Q_SLOTS:
     void onProviderResolutionFinished(const QGeoTileProviderOsm *provider);
@@ -46,11 +46,155 @@
 #include <QtCore/qtimer.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qmutex.h>
+#include <QtCore/qvector.h>
+
+#include <algorithm>
+#include <cmath>
 
 #define UPDATE_INTERVAL_5S  5000
 
 typedef QHash<QString, QGeoAreaMonitorInfo> MonitorTable;
 
+/*
+ * Hierarchical lat/lon grid over the bounding boxes of the monitored areas.
+ *
+ * Level k splits the globe into 2^k x 2^k cells. Every monitor is stored
+ * at the finest level where its bounding box touches at most
+ * MaxCellsPerMonitor cells, so a position only has to look at one cell
+ * per populated level to find every monitor whose box may contain it.
+ * The candidates still have to be confirmed with QGeoShape::contains().
+ */
+class QGeoAreaMonitorIndex
+{
+public:
+    enum {
+        MaxLevel = 16,          // cells of ~0.003 x 0.005 degrees
+        MaxCellsPerMonitor = 4
+    };
+
+    QGeoAreaMonitorIndex() : m_levels(0) {}
+
+    void insert(const QString &identifier, const QGeoShape &area)
+    {
+        remove(identifier);
+
+        const QGeoRectangle box = area.boundingGeoRectangle();
+        Entry entry;
+        entry.level = 0;
+        if (box.isValid()) {
+            for (int level = MaxLevel; level > 0; --level) {
+                if (cellCount(box, level) <= MaxCellsPerMonitor) {
+                    entry.level = level;
+                    break;
+                }
+            }
+        }
+        entry.box = box;
+        m_entries.insert(identifier, entry);
+        m_levels |= 1u << entry.level;
+        forEachCell(entry, [&](quint64 key) { m_cells[key].append(identifier); });
+    }
+
+    void remove(const QString &identifier)
+    {
+        const auto it = m_entries.find(identifier);
+        if (it == m_entries.end())
+            return;
+        forEachCell(*it, [&](quint64 key) {
+            const auto cell = m_cells.find(key);
+            if (cell == m_cells.end())
+                return;
+            cell->removeOne(identifier);
+            if (cell->isEmpty())
+                m_cells.erase(cell);
+        });
+        m_entries.erase(it);
+    }
+
+    // Identifiers of all monitors whose bounding box may contain \a coordinate,
+    // each reported once.
+    QVector<QString> candidates(const QGeoCoordinate &coordinate) const
+    {
+        QVector<QString> result;
+        if (!coordinate.isValid())
+            return result;
+        for (int level = 0; level <= MaxLevel; ++level) {
+            if (!(m_levels & (1u << level)))
+                continue;
+            const auto cell = m_cells.constFind(key(level, row(coordinate.latitude(), level),
+                                                    column(coordinate.longitude(), level)));
+            if (cell != m_cells.constEnd())
+                result += *cell;
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        QGeoRectangle box;
+        int level;
+    };
+
+    static int row(double latitude, int level)
+    {
+        const int n = 1 << level;
+        return qBound(0, int(std::floor((latitude + 90.0) / 180.0 * n)), n - 1);
+    }
+
+    static int column(double longitude, int level)
+    {
+        const int n = 1 << level;
+        return qBound(0, int(std::floor((longitude + 180.0) / 360.0 * n)), n - 1);
+    }
+
+    static quint64 key(int level, int row, int column)
+    {
+        return (quint64(level) << 48) | (quint64(row) << 24) | quint64(column);
+    }
+
+    static int columnSpan(const QGeoRectangle &box, int level)
+    {
+        const int first = column(box.topLeft().longitude(), level);
+        const int last = column(box.bottomRight().longitude(), level);
+        // a box crossing the dateline wraps around the last column, and may
+        // share it with the first one
+        if (box.topLeft().longitude() > box.bottomRight().longitude())
+            return qMin((1 << level) - first + last + 1, 1 << level);
+        return last - first + 1;
+    }
+
+    // Up to 2^32 at the finest level, hence 64 bits
+    static qint64 cellCount(const QGeoRectangle &box, int level)
+    {
+        const int rows = row(box.topLeft().latitude(), level)
+                       - row(box.bottomRight().latitude(), level) + 1;
+        return qint64(rows) * qint64(columnSpan(box, level));
+    }
+
+    template <typename Visitor>
+    static void forEachCell(const Entry &entry, Visitor visit)
+    {
+        const int level = entry.level;
+        if (level == 0 || !entry.box.isValid()) {
+            visit(key(0, 0, 0));
+            return;
+        }
+        const int n = 1 << level;
+        const int firstRow = row(entry.box.bottomRight().latitude(), level);
+        const int lastRow = row(entry.box.topLeft().latitude(), level);
+        const int firstColumn = column(entry.box.topLeft().longitude(), level);
+        const int columns = columnSpan(entry.box, level);
+        for (int r = firstRow; r <= lastRow; ++r) {
+            for (int c = 0; c < columns; ++c)
+                visit(key(level, r, (firstColumn + c) % n));
+        }
+    }
+
+    QHash<QString, Entry> m_entries;
+    QHash<quint64, QVector<QString> > m_cells;
+    quint32 m_levels;
+};
+
 
 static QMetaMethod areaEnteredSignal()
 {
@@ -86,7 +230,7 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        activeMonitorAreas.insert(monitor.identifier(), monitor);
+        addMonitor(monitor);
         singleShotTrigger.remove(monitor.identifier());
 
         checkStartStop();
@@ -97,7 +241,7 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        activeMonitorAreas.insert(monitor.identifier(), monitor);
+        addMonitor(monitor);
         singleShotTrigger.insert(monitor.identifier(), signalId);
 
         checkStartStop();
@@ -108,7 +252,7 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        QGeoAreaMonitorInfo mon = activeMonitorAreas.take(monitor.identifier());
+        QGeoAreaMonitorInfo mon = takeMonitor(monitor.identifier());
 
         checkStartStop();
         setupNextExpiryTimeout();
@@ -205,28 +349,69 @@ public:
     }
 
 private:
+    struct Expiry {
+        QDateTime expiration;
+        QString identifier;
+    };
+
+    // std heap algorithms build a max-heap, so order by later expiration
+    static bool expiresLater(const Expiry &lhs, const Expiry &rhs)
+    {
+        return rhs.expiration < lhs.expiration;
+    }
+
+    void addMonitor(const QGeoAreaMonitorInfo &monitor)
+    {
+        activeMonitorAreas.insert(monitor.identifier(), monitor);
+        monitorIndex.insert(monitor.identifier(), monitor.area());
+
+        if (monitor.expiration().isValid()) {
+            const Expiry expiry = { monitor.expiration(), monitor.identifier() };
+            expiryHeap.append(expiry);
+            std::push_heap(expiryHeap.begin(), expiryHeap.end(), expiresLater);
+        }
+    }
+
+    QGeoAreaMonitorInfo takeMonitor(const QString &identifier)
+    {
+        // the expiry heap entry goes stale and is dropped lazily
+        monitorIndex.remove(identifier);
+        return activeMonitorAreas.take(identifier);
+    }
+
+    // A heap entry is stale once its monitor was removed or re-added
+    // with a different expiration.
+    bool isStale(const Expiry &expiry) const
+    {
+        const auto it = activeMonitorAreas.constFind(expiry.identifier);
+        return it == activeMonitorAreas.constEnd() || it->expiration() != expiry.expiration;
+    }
+
     void setupNextExpiryTimeout()
     {
         nextExpiryTimer->stop();
         activeExpiry.first = QDateTime();
         activeExpiry.second = QString();
 
-        foreach (const QGeoAreaMonitorInfo &info, activeMonitors()) {
-            if (info.expiration().isValid()) {
-                if (!activeExpiry.first.isValid()) {
-                    activeExpiry.first = info.expiration();
-                    activeExpiry.second = info.identifier();
-                    continue;
-                }
-                if (info.expiration() < activeExpiry.first) {
-                    activeExpiry.first = info.expiration();
-                    activeExpiry.second = info.identifier();
-                }
-            }
+        // rebuild rather than let stale entries pile up when monitors are
+        // replaced much more often than they expire
+        if (expiryHeap.size() > 2 * activeMonitorAreas.size() + 16) {
+            expiryHeap.erase(std::remove_if(expiryHeap.begin(), expiryHeap.end(),
+                                            [this](const Expiry &e) { return isStale(e); }),
+                             expiryHeap.end());
+            std::make_heap(expiryHeap.begin(), expiryHeap.end(), expiresLater);
         }
 
-        if (activeExpiry.first.isValid())
+        while (!expiryHeap.isEmpty() && isStale(expiryHeap.first())) {
+            std::pop_heap(expiryHeap.begin(), expiryHeap.end(), expiresLater);
+            expiryHeap.removeLast();
+        }
+
+        if (!expiryHeap.isEmpty()) {
+            activeExpiry.first = expiryHeap.first().expiration;
+            activeExpiry.second = expiryHeap.first().identifier;
             nextExpiryTimer->start(QDateTime::currentDateTime().msecsTo(activeExpiry.first));
+        }
     }
 
 
@@ -237,7 +422,7 @@ private:
             if (singleShotTrigger.value(monitorIdent, -1) == areaEnteredSignal().methodIndex()) {
                 //this is the finishing singleshot event
                 singleShotTrigger.remove(monitorIdent);
-                activeMonitorAreas.remove(monitorIdent);
+                takeMonitor(monitorIdent);
                 setupNextExpiryTimeout();
             } else {
                 insideArea.insert(monitorIdent);
@@ -255,7 +440,7 @@ private:
             if (singleShotTrigger.value(monitorIdent, -1) == areaExitedSignal().methodIndex()) {
                 //this is the finishing singleShot event
                 singleShotTrigger.remove(monitorIdent);
-                activeMonitorAreas.remove(monitorIdent);
+                takeMonitor(monitorIdent);
                 setupNextExpiryTimeout();
             } else {
                 insideArea.remove(monitorIdent);
@@ -279,7 +464,7 @@ private Q_SLOTS:
          * Don't block timer firing even if monitorExpiredSignal is not connected.
          * This allows us to continue to remove the existing monitors as they expire.
          **/
-        const QGeoAreaMonitorInfo info = activeMonitorAreas.take(activeExpiry.second);
+        const QGeoAreaMonitorInfo info = takeMonitor(activeExpiry.second);
         setupNextExpiryTimeout();
         emit timeout(info);
 
@@ -287,7 +472,36 @@ private Q_SLOTS:
 
     void positionUpdated(const QGeoPositionInfo &info)
     {
-        foreach (const QGeoAreaMonitorInfo &monInfo, activeMonitors()) {
+        /*
+         * Only monitors whose bounding box covers the position can be entered,
+         * and only monitors we are currently inside of can be exited. Every
+         * other monitor would be a no-op in processOutsideArea().
+         */
+        QVector<QGeoAreaMonitorInfo> affected;
+        {
+            QMutexLocker locker(&mutex);
+
+            const QVector<QString> candidates = monitorIndex.candidates(info.coordinate());
+            QSet<QString> seen;
+            seen.reserve(candidates.size());
+            affected.reserve(candidates.size() + insideArea.size());
+            for (const QString &identifier : candidates) {
+                const auto it = activeMonitorAreas.constFind(identifier);
+                if (it != activeMonitorAreas.constEnd()) {
+                    affected.append(*it);
+                    seen.insert(identifier);
+                }
+            }
+            for (const QString &identifier : qAsConst(insideArea)) {
+                if (seen.contains(identifier))
+                    continue;
+                const auto it = activeMonitorAreas.constFind(identifier);
+                if (it != activeMonitorAreas.constEnd())
+                    affected.append(*it);
+            }
+        }
+
+        for (const QGeoAreaMonitorInfo &monInfo : qAsConst(affected)) {
             const QString identifier = monInfo.identifier();
             if (monInfo.area().contains(info.coordinate())) {
                 if (processInsideArea(identifier))
@@ -301,6 +515,8 @@ private Q_SLOTS:
 
 private:
     QPair<QDateTime, QString> activeExpiry;
+    QVector<Expiry> expiryHeap;
+    QGeoAreaMonitorIndex monitorIndex;
     QHash<QString, int> singleShotTrigger;
     QTimer* nextExpiryTimer;
     QSet<QString> insideArea;
@@ -40,16 +40,144 @@
 ****************************************************************************/
 #include "qlocationutils_p.h"
 #include "qgeopositioninfo.h"
+#include "qgeosatelliteinfo.h"
 
 #include <QTime>
 #include <QList>
 #include <QByteArray>
+#include <QString>
 #include <QDebug>
 
 #include <math.h>
 
 QT_BEGIN_NAMESPACE
 
+namespace {
+
+/*
+    Splits an NMEA sentence into its comma separated fields without copying
+    it. The fields are views into the caller's buffer and stay valid only as
+    long as that buffer does. Fields past the last one read as empty.
+*/
+class QNmeaFields
+{
+public:
+    enum { MaxFields = 32 };
+
+    QNmeaFields(const char *data, int size)
+        : m_count(0)
+    {
+        int begin = 0;
+        for (int i = 0; i <= size && m_count < MaxFields; ++i) {
+            if (i == size || data[i] == ',') {
+                m_fields[m_count++] = QLatin1String(data + begin, i - begin);
+                begin = i + 1;
+            }
+        }
+    }
+
+    int count() const { return m_count; }
+
+    QLatin1String operator[](int index) const
+    {
+        return index < m_count ? m_fields[index] : QLatin1String();
+    }
+
+private:
+    QLatin1String m_fields[MaxFields];
+    int m_count;
+};
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Parses exactly \a count digits starting at \a data.
+inline bool readDigits(const char *data, int count, int *value)
+{
+    int result = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!isDigit(data[i]))
+            return false;
+        result = result * 10 + (data[i] - '0');
+    }
+    *value = result;
+    return true;
+}
+
+inline bool readInt(QLatin1String field, int *value)
+{
+    const char *data = field.data();
+    int size = field.size();
+    bool negative = false;
+    if (size > 0 && (data[0] == '-' || data[0] == '+')) {
+        negative = data[0] == '-';
+        ++data;
+        --size;
+    }
+    if (size == 0 || size > 9 || !readDigits(data, size, value))
+        return false;
+    if (negative)
+        *value = -*value;
+    return true;
+}
+
+inline bool readDouble(QLatin1String field, double *value)
+{
+    static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                         1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+    const char *data = field.data();
+    const int size = field.size();
+    if (size == 0)
+        return false;
+
+    // NMEA numbers are plain [-]ddd[.ddd]. As long as the digits fit into the
+    // 53 bit mantissa, dividing by an exact power of ten is correctly rounded,
+    // which is what the full parser would produce as well.
+    int i = 0;
+    const bool negative = data[0] == '-';
+    if (negative || data[0] == '+')
+        ++i;
+    qint64 mantissa = 0;
+    int digits = 0;
+    int decimals = -1;
+    for (; i < size; ++i) {
+        const char c = data[i];
+        if (isDigit(c)) {
+            mantissa = mantissa * 10 + (c - '0');
+            ++digits;
+            if (decimals >= 0)
+                ++decimals;
+        } else if (c == '.' && decimals < 0) {
+            decimals = 0;
+        } else {
+            break;
+        }
+    }
+
+    if (i == size && digits > 0 && digits <= 15) {
+        const double result = double(mantissa) / powersOf10[qMax(decimals, 0)];
+        *value = negative ? -result : result;
+        return true;
+    }
+
+    // exponents, whitespace, overlong numbers: leave them to the full parser
+    bool ok = false;
+    const double result = QByteArray::fromRawData(data, size).toDouble(&ok);
+    if (ok)
+        *value = result;
+    return ok;
+}
+
+inline char singleChar(QLatin1String field)
+{
+    return field.size() == 1 ? field.data()[0] : '\0';
+}
+
+} // namespace
+
 // converts e.g. 15306.0235 from NMEA sentence to 153.100392
 static double qlocationutils_nmeaDegreesToDecimal(double nmeaDegrees)
 {
@@ -58,91 +186,148 @@ static double qlocationutils_nmeaDegreesToDecimal(double nmeaDegrees)
     return deg + (min / 60.0);
 }
 
-static void qlocationutils_readGga(const char *data, int size, QGeoPositionInfo *info, double uere,
+static void qlocationutils_readGga(const QNmeaFields &parts, QGeoPositionInfo *info, double uere,
                                    bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
     QGeoCoordinate coord;
 
-    if (hasFix && parts.count() > 6 && parts[6].count() > 0)
-        *hasFix = parts[6].toInt() > 0;
+    if (hasFix && parts[6].size() > 0) {
+        int quality = 0;
+        *hasFix = readInt(parts[6], &quality) && quality > 0;
+    }
 
-    if (parts.count() > 1 && parts[1].count() > 0) {
+    if (parts[1].size() > 0) {
         QTime time;
         if (QLocationUtils::getNmeaTime(parts[1], &time))
             info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 5 && parts[3].count() == 1 && parts[5].count() == 1) {
+    if (parts[3].size() == 1 && parts[5].size() == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[2], parts[3][0], parts[4], parts[5][0], &lat, &lng)) {
+        if (QLocationUtils::getNmeaLatLong(parts[2], singleChar(parts[3]), parts[4],
+                                           singleChar(parts[5]), &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
     }
 
-    if (parts.count() > 8 && !parts[8].isEmpty()) {
-        bool hasHdop = false;
-        double hdop = parts[8].toDouble(&hasHdop);
-        if (hasHdop)
-            info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
+    double hdop;
+    if (readDouble(parts[8], &hdop))
+        info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
+
+    double alt;
+    if (readDouble(parts[9], &alt))
+        coord.setAltitude(alt);
+
+    if (coord.type() != QGeoCoordinate::InvalidCoordinate)
+        info->setCoordinate(coord);
+}
+
+static void qlocationutils_readGns(const QNmeaFields &parts, QGeoPositionInfo *info, double uere,
+                                   bool *hasFix)
+{
+    QGeoCoordinate coord;
+
+    // one mode character per constellation, 'N' meaning no fix
+    if (hasFix) {
+        const QLatin1String mode = parts[6];
+        for (int i = 0; i < mode.size(); ++i) {
+            if (mode.data()[i] != 'N') {
+                *hasFix = true;
+                break;
+            }
+        }
+    }
+
+    if (parts[1].size() > 0) {
+        QTime time;
+        if (QLocationUtils::getNmeaTime(parts[1], &time))
+            info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 9 && parts[9].count() > 0) {
-        bool hasAlt = false;
-        double alt = parts[9].toDouble(&hasAlt);
-        if (hasAlt)
-            coord.setAltitude(alt);
+    if (parts[3].size() == 1 && parts[5].size() == 1) {
+        double lat;
+        double lng;
+        if (QLocationUtils::getNmeaLatLong(parts[2], singleChar(parts[3]), parts[4],
+                                           singleChar(parts[5]), &lat, &lng)) {
+            coord.setLatitude(lat);
+            coord.setLongitude(lng);
+        }
     }
 
+    double hdop;
+    if (readDouble(parts[8], &hdop))
+        info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
+
+    double alt;
+    if (readDouble(parts[9], &alt))
+        coord.setAltitude(alt);
+
     if (coord.type() != QGeoCoordinate::InvalidCoordinate)
         info->setCoordinate(coord);
 }
 
-static void qlocationutils_readGsa(const char *data, int size, QGeoPositionInfo *info, double uere,
+static void qlocationutils_readGsa(const QNmeaFields &parts, QGeoPositionInfo *info, double uere,
                                    bool *hasFix)
 {
-    QList<QByteArray> parts = QByteArray::fromRawData(data, size).split(',');
+    if (hasFix && parts[2].size() > 0) {
+        int mode = 0;
+        *hasFix = readInt(parts[2], &mode) && mode > 0;
+    }
+
+    double hdop;
+    if (readDouble(parts[16], &hdop))
+        info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
 
-    if (hasFix && parts.count() > 2 && !parts[2].isEmpty())
-        *hasFix = parts[2].toInt() > 0;
+    double vdop;
+    if (readDouble(parts[17], &vdop))
+        info->setAttribute(QGeoPositionInfo::VerticalAccuracy, 2 * vdop * uere);
+}
 
-    if (parts.count() > 16 && !parts[16].isEmpty()) {
-        bool hasHdop = false;
-        double hdop = parts[16].toDouble(&hasHdop);
-        if (hasHdop)
-            info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
+static void qlocationutils_readGst(const QNmeaFields &parts, QGeoPositionInfo *info, bool *hasFix)
+{
+    if (hasFix)
+        *hasFix = false;
+
+    if (parts[1].size() > 0) {
+        QTime time;
+        if (QLocationUtils::getNmeaTime(parts[1], &time))
+            info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 17 && !parts[17].isEmpty()) {
-        bool hasVdop = false;
-        double vdop = parts[17].toDouble(&hasVdop);
-        if (hasVdop)
-            info->setAttribute(QGeoPositionInfo::VerticalAccuracy, 2 * vdop * uere);
+    // Standard deviations in meters. Reported as 2DRMS, like the DOP based
+    // estimates of GGA and GSA.
+    double latError;
+    double lngError;
+    if (readDouble(parts[6], &latError) && readDouble(parts[7], &lngError)) {
+        info->setAttribute(QGeoPositionInfo::HorizontalAccuracy,
+                           2 * sqrt(latError * latError + lngError * lngError));
     }
+
+    double altError;
+    if (readDouble(parts[8], &altError))
+        info->setAttribute(QGeoPositionInfo::VerticalAccuracy, 2 * altError);
 }
 
-static void qlocationutils_readGll(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
+static void qlocationutils_readGll(const QNmeaFields &parts, QGeoPositionInfo *info, bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
     QGeoCoordinate coord;
 
-    if (hasFix && parts.count() > 6 && parts[6].count() > 0)
-        *hasFix = (parts[6][0] == 'A');
+    if (hasFix && parts[6].size() > 0)
+        *hasFix = (parts[6].data()[0] == 'A');
 
-    if (parts.count() > 5 && parts[5].count() > 0) {
+    if (parts[5].size() > 0) {
         QTime time;
         if (QLocationUtils::getNmeaTime(parts[5], &time))
             info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 4 && parts[2].count() == 1 && parts[4].count() == 1) {
+    if (parts[2].size() == 1 && parts[4].size() == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[1], parts[2][0], parts[3], parts[4][0], &lat, &lng)) {
+        if (QLocationUtils::getNmeaLatLong(parts[1], singleChar(parts[2]), parts[3],
+                                           singleChar(parts[4]), &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
@@ -152,57 +337,46 @@ static void qlocationutils_readGll(const char *data, int size, QGeoPositionInfo
         info->setCoordinate(coord);
 }
 
-static void qlocationutils_readRmc(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
+static void qlocationutils_readRmc(const QNmeaFields &parts, QGeoPositionInfo *info, bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
     QGeoCoordinate coord;
     QDate date;
     QTime time;
 
-    if (hasFix && parts.count() > 2 && parts[2].count() > 0)
-        *hasFix = (parts[2][0] == 'A');
+    if (hasFix && parts[2].size() > 0)
+        *hasFix = (parts[2].data()[0] == 'A');
 
-    if (parts.count() > 9 && parts[9].count() == 6) {
-        date = QDate::fromString(QString::fromLatin1(parts[9]), QStringLiteral("ddMMyy"));
-        if (date.isValid())
-            date = date.addYears(100);     // otherwise starts from 1900
-        else
-            date = QDate();
+    if (parts[9].size() == 6) {
+        // ddmmyy, the year is assumed to be after 2000
+        const char *d = parts[9].data();
+        int day, month, year;
+        if (readDigits(d, 2, &day) && readDigits(d + 2, 2, &month) && readDigits(d + 4, 2, &year))
+            date = QDate(2000 + year, month, day);
     }
 
-    if (parts.count() > 1 && parts[1].count() > 0)
+    if (parts[1].size() > 0)
         QLocationUtils::getNmeaTime(parts[1], &time);
 
-    if (parts.count() > 6 && parts[4].count() == 1 && parts[6].count() == 1) {
+    if (parts[4].size() == 1 && parts[6].size() == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[3], parts[4][0], parts[5], parts[6][0], &lat, &lng)) {
+        if (QLocationUtils::getNmeaLatLong(parts[3], singleChar(parts[4]), parts[5],
+                                           singleChar(parts[6]), &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
     }
 
-    bool parsed = false;
     double value = 0.0;
-    if (parts.count() > 7 && parts[7].count() > 0) {
-        value = parts[7].toDouble(&parsed);
-        if (parsed)
-            info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value * 1.852 / 3.6));    // knots -> m/s
-    }
-    if (parts.count() > 8 && parts[8].count() > 0) {
-        value = parts[8].toDouble(&parsed);
-        if (parsed)
-            info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
-    }
-    if (parts.count() > 11 && parts[11].count() == 1
-            && (parts[11][0] == 'E' || parts[11][0] == 'W')) {
-        value = parts[10].toDouble(&parsed);
-        if (parsed) {
-            if (parts[11][0] == 'W')
-                value *= -1;
-            info->setAttribute(QGeoPositionInfo::MagneticVariation, qreal(value));
-        }
+    if (readDouble(parts[7], &value))
+        info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value * 1.852 / 3.6));    // knots -> m/s
+    if (readDouble(parts[8], &value))
+        info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
+    const char variationDirection = singleChar(parts[11]);
+    if ((variationDirection == 'E' || variationDirection == 'W') && readDouble(parts[10], &value)) {
+        if (variationDirection == 'W')
+            value *= -1;
+        info->setAttribute(QGeoPositionInfo::MagneticVariation, qreal(value));
     }
 
     if (coord.type() != QGeoCoordinate::InvalidCoordinate)
@@ -211,53 +385,69 @@ static void qlocationutils_readRmc(const char *data, int size, QGeoPositionInfo
     info->setTimestamp(QDateTime(date, time, Qt::UTC));
 }
 
-static void qlocationutils_readVtg(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
+static void qlocationutils_readVtg(const QNmeaFields &parts, QGeoPositionInfo *info, bool *hasFix)
 {
     if (hasFix)
         *hasFix = false;
 
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
-
-    bool parsed = false;
     double value = 0.0;
-    if (parts.count() > 1 && parts[1].count() > 0) {
-        value = parts[1].toDouble(&parsed);
-        if (parsed)
-            info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
-    }
-    if (parts.count() > 7 && parts[7].count() > 0) {
-        value = parts[7].toDouble(&parsed);
-        if (parsed)
-            info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value / 3.6));    // km/h -> m/s
-    }
+    if (readDouble(parts[1], &value))
+        info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
+    if (readDouble(parts[7], &value))
+        info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value / 3.6));    // km/h -> m/s
 }
 
-static void qlocationutils_readZda(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
+static void qlocationutils_readZda(const QNmeaFields &parts, QGeoPositionInfo *info, bool *hasFix)
 {
     if (hasFix)
         *hasFix = false;
 
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
     QDate date;
     QTime time;
 
-    if (parts.count() > 1 && parts[1].count() > 0)
+    if (parts[1].size() > 0)
         QLocationUtils::getNmeaTime(parts[1], &time);
 
-    if (parts.count() > 4 && parts[2].count() > 0 && parts[3].count() > 0
-            && parts[4].count() == 4) {     // must be full 4-digit year
-        int day = parts[2].toUInt();
-        int month = parts[3].toUInt();
-        int year = parts[4].toUInt();
-        if (day > 0 && month > 0 && year > 0)
+    if (parts[2].size() > 0 && parts[3].size() > 0
+            && parts[4].size() == 4) {     // must be full 4-digit year
+        int day = 0;
+        int month = 0;
+        int year = 0;
+        if (readInt(parts[2], &day) && readInt(parts[3], &month) && readInt(parts[4], &year)
+                && day > 0 && month > 0 && year > 0) {
             date.setDate(year, month, day);
+        }
     }
 
     info->setTimestamp(QDateTime(date, time, Qt::UTC));
 }
 
+// Strips the checksum and locates the three letter sentence type that
+// follows the talker ID, e.g. "GGA" in "$GPGGA" or "$GNGGA".
+static const char *qlocationutils_nmeaSentenceType(const char *data, int *size)
+{
+    int typeEnd = -1;
+    for (int i = 0; i < *size; ++i) {
+        if (data[i] == '*') {
+            *size = i;
+            break;
+        }
+        if (data[i] == ',' && typeEnd < 0)
+            typeEnd = i;
+    }
+    if (typeEnd < 0)
+        typeEnd = *size;
+    // at least one talker character between '$' and the type
+    if (typeEnd < 5)
+        return 0;
+    return data + typeEnd - 3;
+}
+
+static inline bool qlocationutils_isType(const char *type, const char *name)
+{
+    return type[0] == name[0] && type[1] == name[1] && type[2] == name[2];
+}
+
 bool QLocationUtils::getPosInfoFromNmea(const char *data, int size, QGeoPositionInfo *info,
                                         double uere, bool *hasFix)
 {
@@ -269,53 +459,124 @@ bool QLocationUtils::getPosInfoFromNmea(const char *data, int size, QGeoPosition
     if (size < 6 || data[0] != '$' || !hasValidNmeaChecksum(data, size))
         return false;
 
-    // Adjust size so that * and following characters are not parsed by the following functions.
-    for (int i = 0; i < size; ++i) {
-        if (data[i] == '*') {
-            size = i;
-            break;
-        }
+    // Adjusts size so that * and following characters are not parsed.
+    const char *type = qlocationutils_nmeaSentenceType(data, &size);
+    if (!type)
+        return false;
+
+    if (qlocationutils_isType(type, "GGA")) {
+        qlocationutils_readGga(QNmeaFields(data, size), info, uere, hasFix);
+        return true;
+    }
+
+    if (qlocationutils_isType(type, "GSA")) {
+        qlocationutils_readGsa(QNmeaFields(data, size), info, uere, hasFix);
+        return true;
     }
 
-    if (data[3] == 'G' && data[4] == 'G' && data[5] == 'A') {
-        // "$--GGA" sentence.
-        qlocationutils_readGga(data, size, info, uere, hasFix);
+    if (qlocationutils_isType(type, "GLL")) {
+        qlocationutils_readGll(QNmeaFields(data, size), info, hasFix);
         return true;
     }
 
-    if (data[3] == 'G' && data[4] == 'S' && data[5] == 'A') {
-        // "$--GSA" sentence.
-        qlocationutils_readGsa(data, size, info, uere, hasFix);
+    if (qlocationutils_isType(type, "RMC")) {
+        qlocationutils_readRmc(QNmeaFields(data, size), info, hasFix);
         return true;
     }
 
-    if (data[3] == 'G' && data[4] == 'L' && data[5] == 'L') {
-        // "$--GLL" sentence.
-        qlocationutils_readGll(data, size, info, hasFix);
+    if (qlocationutils_isType(type, "VTG")) {
+        qlocationutils_readVtg(QNmeaFields(data, size), info, hasFix);
         return true;
     }
 
-    if (data[3] == 'R' && data[4] == 'M' && data[5] == 'C') {
-        // "$--RMC" sentence.
-        qlocationutils_readRmc(data, size, info, hasFix);
+    if (qlocationutils_isType(type, "ZDA")) {
+        qlocationutils_readZda(QNmeaFields(data, size), info, hasFix);
         return true;
     }
 
-    if (data[3] == 'V' && data[4] == 'T' && data[5] == 'G') {
-        // "$--VTG" sentence.
-        qlocationutils_readVtg(data, size, info, hasFix);
+    if (qlocationutils_isType(type, "GNS")) {
+        qlocationutils_readGns(QNmeaFields(data, size), info, uere, hasFix);
         return true;
     }
 
-    if (data[3] == 'Z' && data[4] == 'D' && data[5] == 'A') {
-        // "$--ZDA" sentence.
-        qlocationutils_readZda(data, size, info, hasFix);
+    if (qlocationutils_isType(type, "GST")) {
+        qlocationutils_readGst(QNmeaFields(data, size), info, hasFix);
         return true;
     }
 
     return false;
 }
 
+bool QLocationUtils::getSatInfoFromNmea(const char *data, int size, QList<QGeoSatelliteInfo> *infos,
+                                        int *messageNumber, int *messageCount)
+{
+    if (!infos)
+        return false;
+
+    if (size < 6 || data[0] != '$' || !hasValidNmeaChecksum(data, size))
+        return false;
+
+    const char *type = qlocationutils_nmeaSentenceType(data, &size);
+    if (!type || !qlocationutils_isType(type, "GSV"))
+        return false;
+
+    const QNmeaFields parts(data, size);
+    int total = 0;
+    int number = 0;
+    if (!readInt(parts[1], &total) || !readInt(parts[2], &number))
+        return false;
+    if (messageCount)
+        *messageCount = total;
+    if (messageNumber)
+        *messageNumber = number;
+
+    // only talkers with a single constellation tell which one it is
+    QGeoSatelliteInfo::SatelliteSystem system = QGeoSatelliteInfo::Undefined;
+    if (type - data == 3 && data[1] == 'G' && data[2] == 'P')
+        system = QGeoSatelliteInfo::GPS;
+    else if (type - data == 3 && data[1] == 'G' && data[2] == 'L')
+        system = QGeoSatelliteInfo::GLONASS;
+
+    // four fields per satellite, NMEA 4.1 appends a single signal ID
+    for (int i = 4; i + 4 <= parts.count(); i += 4) {
+        int id = 0;
+        if (!readInt(parts[i], &id))
+            continue;
+
+        QGeoSatelliteInfo info;
+        info.setSatelliteIdentifier(id);
+        if (system != QGeoSatelliteInfo::Undefined)
+            info.setSatelliteSystem(system);
+        else if (id >= 1 && id <= 32)
+            info.setSatelliteSystem(QGeoSatelliteInfo::GPS);
+        else if (id >= 65 && id <= 96)
+            info.setSatelliteSystem(QGeoSatelliteInfo::GLONASS);
+
+        double value;
+        if (readDouble(parts[i + 1], &value))
+            info.setAttribute(QGeoSatelliteInfo::Elevation, qreal(value));
+        if (readDouble(parts[i + 2], &value))
+            info.setAttribute(QGeoSatelliteInfo::Azimuth, qreal(value));
+        int snr;
+        if (readInt(parts[i + 3], &snr))
+            info.setSignalStrength(snr);
+
+        infos->append(info);
+    }
+    return true;
+}
+
+static inline int qlocationutils_hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
 bool QLocationUtils::hasValidNmeaChecksum(const char *data, int size)
 {
     int asteriskIndex = -1;
@@ -334,55 +595,69 @@ bool QLocationUtils::hasValidNmeaChecksum(const char *data, int size)
     int result = 0;
     for (int i = 1; i < asteriskIndex; ++i)
         result ^= data[i];
-    /*
-        char calc[CSUM_LEN + 1];
-        ::snprintf(calc, CSUM_LEN + 1, "%02x", result);
-        return ::strncmp(calc, &data[asteriskIndex+1], 2) == 0;
-        */
 
-    QByteArray checkSumBytes(&data[asteriskIndex + 1], 2);
-    bool ok = false;
-    int checksum = checkSumBytes.toInt(&ok,16);
-    return ok && checksum == result;
+    const int high = qlocationutils_hexValue(data[asteriskIndex + 1]);
+    const int low = qlocationutils_hexValue(data[asteriskIndex + 2]);
+    return high >= 0 && low >= 0 && (high << 4 | low) == result;
 }
 
 bool QLocationUtils::getNmeaTime(const QByteArray &bytes, QTime *time)
 {
-    int dotIndex = bytes.indexOf('.');
-    QTime tempTime;
-
-    if (dotIndex < 0) {
-        tempTime = QTime::fromString(QString::fromLatin1(bytes.constData()),
-                                     QStringLiteral("hhmmss"));
-    } else {
-        tempTime = QTime::fromString(QString::fromLatin1(bytes.mid(0, dotIndex)),
-                                     QStringLiteral("hhmmss"));
-        bool hasMsecs = false;
-        int midLen = qMin(3, bytes.size() - dotIndex - 1);
-        int msecs = bytes.mid(dotIndex + 1, midLen).toUInt(&hasMsecs);
-        if (hasMsecs)
-            tempTime = tempTime.addMSecs(msecs*(midLen == 3 ? 1 : midLen == 2 ? 10 : 100));
-    }
-
-    if (tempTime.isValid()) {
-        *time = tempTime;
-        return true;
+    return getNmeaTime(QLatin1String(bytes.constData(), bytes.size()), time);
+}
+
+bool QLocationUtils::getNmeaTime(QLatin1String field, QTime *time)
+{
+    const char *data = field.data();
+    int dotIndex = -1;
+    for (int i = 0; i < field.size(); ++i) {
+        if (data[i] == '.') {
+            dotIndex = i;
+            break;
+        }
     }
-    return false;
+
+    // hhmmss, optionally followed by fractions of a second
+    if ((dotIndex < 0 ? field.size() : dotIndex) != 6)
+        return false;
+
+    int hours, minutes, seconds;
+    if (!readDigits(data, 2, &hours) || !readDigits(data + 2, 2, &minutes)
+            || !readDigits(data + 4, 2, &seconds)) {
+        return false;
+    }
+    if (!QTime::isValid(hours, minutes, seconds))
+        return false;
+
+    int msecs = 0;
+    if (dotIndex >= 0) {
+        const int midLen = qMin(3, field.size() - dotIndex - 1);
+        int fraction;
+        if (midLen > 0 && readDigits(data + dotIndex + 1, midLen, &fraction))
+            msecs = fraction * (midLen == 3 ? 1 : midLen == 2 ? 10 : 100);
+    }
+
+    *time = QTime(hours, minutes, seconds, msecs);
+    return true;
 }
 
 bool QLocationUtils::getNmeaLatLong(const QByteArray &latString, char latDirection, const QByteArray &lngString, char lngDirection, double *lat, double *lng)
+{
+    return getNmeaLatLong(QLatin1String(latString.constData(), latString.size()), latDirection,
+                          QLatin1String(lngString.constData(), lngString.size()), lngDirection,
+                          lat, lng);
+}
+
+bool QLocationUtils::getNmeaLatLong(QLatin1String latString, char latDirection, QLatin1String lngString, char lngDirection, double *lat, double *lng)
 {
     if ((latDirection != 'N' && latDirection != 'S')
             || (lngDirection != 'E' && lngDirection != 'W')) {
         return false;
     }
 
-    bool hasLat = false;
-    bool hasLong = false;
-    double tempLat = latString.toDouble(&hasLat);
-    double tempLng = lngString.toDouble(&hasLong);
-    if (hasLat && hasLong) {
+    double tempLat;
+    double tempLng;
+    if (readDouble(latString, &tempLat) && readDouble(lngString, &tempLng)) {
         tempLat = qlocationutils_nmeaDegreesToDecimal(tempLat);
         if (latDirection == 'S')
             tempLat *= -1;
@@ -51,6 +51,7 @@
 //
 
 #include <QtCore/QtGlobal>
+#include <QtCore/qlist.h>
 #include <math.h> // needed for non-std:: versions of functions
 #include <qmath.h>
 #include <QtPositioning/QGeoCoordinate>
@@ -62,8 +63,10 @@ static const double rightOffset = 180.0 - offsetEpsilon;
 QT_BEGIN_NAMESPACE
 class QTime;
 class QByteArray;
+class QLatin1String;
 
 class QGeoPositionInfo;
+class QGeoSatelliteInfo;
 class QLocationUtils
 {
 public:
@@ -246,18 +249,30 @@ public:
     }
 
     /*
-        Creates a QGeoPositionInfo from a GGA, GLL, RMC, VTG or ZDA sentence.
+        Creates a QGeoPositionInfo from a GGA, GNS, GLL, GSA, GST, RMC, VTG or
+        ZDA sentence of any talker (GP, GL, GA, GB, GN, ...).
 
         Note:
-        - GGA and GLL sentences have time but not date so the update's
-          QDateTime object will have an invalid date.
+        - GGA, GNS, GST and GLL sentences have time but not date so the
+          update's QDateTime object will have an invalid date.
         - RMC reports date with a two-digit year so in this case the year
           is assumed to be after the year 2000.
+        - The sentence is parsed in place; nothing is allocated per field.
     */
     Q_AUTOTEST_EXPORT static bool getPosInfoFromNmea(const char *data, int size,
                                                      QGeoPositionInfo *info, double uere,
                                                      bool *hasFix = 0);
 
+    /*
+        Appends the satellites reported by a GSV sentence to \a infos.
+        A full satellite list spans \a messageCount sentences, of which this
+        one is number \a messageNumber.
+    */
+    Q_AUTOTEST_EXPORT static bool getSatInfoFromNmea(const char *data, int size,
+                                                     QList<QGeoSatelliteInfo> *infos,
+                                                     int *messageNumber = 0,
+                                                     int *messageCount = 0);
+
     /*
         Returns true if the given NMEA sentence has a valid checksum.
     */
@@ -267,12 +282,14 @@ public:
         Returns time from a string in hhmmss or hhmmss.z+ format.
     */
     Q_AUTOTEST_EXPORT static bool getNmeaTime(const QByteArray &bytes, QTime *time);
+    Q_AUTOTEST_EXPORT static bool getNmeaTime(QLatin1String field, QTime *time);
 
     /*
         Accepts for example ("2734.7964", 'S', "15306.0124", 'E') and returns the
         lat-long values. Fails if lat or long fail isValidLat() or isValidLong().
     */
     Q_AUTOTEST_EXPORT static bool getNmeaLatLong(const QByteArray &latString, char latDirection, const QByteArray &lngString, char lngDirection, double *lat, double *lon);
+    Q_AUTOTEST_EXPORT static bool getNmeaLatLong(QLatin1String latString, char latDirection, QLatin1String lngString, char lngDirection, double *lat, double *lon);
 };
 
 QT_END_NAMESPACE
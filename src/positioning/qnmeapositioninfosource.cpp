@@ -79,13 +79,15 @@ QGeoPositionInfoPrivate *QGeoPositionInfoPrivateNmea::clone() const
 typedef QGeoPositionInfoPrivate QGeoPositionInfoPrivateNmea;
 #endif
 
-static void mergePositions(QGeoPositionInfo &dst, const QGeoPositionInfo &src, QByteArray nmeaSentence)
+static void mergePositions(QGeoPositionInfo &dst, const QGeoPositionInfo &src,
+                           const char *nmeaSentence, qint64 size)
 {
 #if USE_NMEA_PIMPL
     QGeoPositionInfoPrivateNmea *dstPimpl = static_cast<QGeoPositionInfoPrivateNmea *>(QGeoPositionInfoPrivate::getPimpl(dst));
-    dstPimpl->nmeaSentences.append(nmeaSentence);
+    dstPimpl->nmeaSentences.append(QByteArray(nmeaSentence, size));
 #else
     Q_UNUSED(nmeaSentence)
+    Q_UNUSED(size)
 #endif
 
     QGeoCoordinate c = dst.coordinate();
@@ -115,6 +117,18 @@ static void mergePositions(QGeoPositionInfo &dst, const QGeoPositionInfo &src, Q
 
 }
 
+// Clears a parse target so that it can be reused for the next sentence.
+static void resetPosition(QGeoPositionInfo &info)
+{
+    QGeoPositionInfoPrivate *pimpl = QGeoPositionInfoPrivate::getPimpl(info);
+    pimpl->timestamp = QDateTime();
+    pimpl->coord = QGeoCoordinate();
+    pimpl->doubleAttribs.clear();
+#if USE_NMEA_PIMPL
+    static_cast<QGeoPositionInfoPrivateNmea *>(pimpl)->nmeaSentences.clear();
+#endif
+}
+
 static qint64 msecsTo(const QDateTime &from, const QDateTime &to)
 {
     if (!from.time().isValid() || !to.time().isValid())
@@ -194,6 +208,10 @@ static int processSentence(QGeoPositionInfo &info,
     if (m_pendingUpdates.size() > 0)
         prevTs = m_pendingUpdates.head().info.timestamp();
 
+    // one parse target for all lines; the sentences of an update are merged
+    // into info, so pos never escapes this function
+    QGeoPositionInfo pos(*new QGeoPositionInfoPrivateNmea);
+
     // find the next update with a valid time (as long as the time is valid,
     // we can calculate when the update should be emitted)
     while (m_nextLine.size() || (m_proxy->m_device && m_proxy->m_device->bytesAvailable() > 0)) {
@@ -221,7 +239,9 @@ static int processSentence(QGeoPositionInfo &info,
              Packets containing time information are GGA, RMC, ZDA, GLL:
 
              GGA : GPS fix data                           - only time
+             GNS : GNSS fix data                          - only time
              GLL : geographic latitude and longitude      - only time
+             GST : pseudorange error statistics           - only time
              RMC : recommended minimum FPOS/transit data  - date/time
              ZDA : only timestamp                         - date/time
 
@@ -234,8 +254,7 @@ static int processSentence(QGeoPositionInfo &info,
              from any prior sentence that had timestamp info, if any is available.
          */
 
-        QGeoPositionInfoPrivateNmea *pimpl = new QGeoPositionInfoPrivateNmea;
-        QGeoPositionInfo pos(*pimpl);
+        resetPosition(pos);
         if (m_proxy->parsePosInfoFromNmeaData(buf, size, &pos, &hasFix)) {
             // Date may or may not be valid, as some packets do not have date.
             // If date isn't valid, match is performed on time only.
@@ -249,16 +268,17 @@ static int processSentence(QGeoPositionInfo &info,
                         break;
                     } else {
                         // timestamps match -- merge into info
-                        mergePositions(info, pos, QByteArray(buf, size));
+                        mergePositions(info, pos, buf, size);
                     }
                 } else {
                     // no timestamp available -- merge into info
-                    mergePositions(info, pos, QByteArray(buf, size));
+                    mergePositions(info, pos, buf, size);
                 }
             } else {
                 // there was no info with valid TS. Overwrite with whatever is parsed.
 #if USE_NMEA_PIMPL
-                pimpl->nmeaSentences.append(QByteArray(buf, size));
+                static_cast<QGeoPositionInfoPrivateNmea *>(QGeoPositionInfoPrivate::getPimpl(pos))
+                        ->nmeaSentences.append(QByteArray(buf, size));
 #endif
                 info = pos;
             }
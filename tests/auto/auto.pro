@@ -52,14 +52,21 @@ qtHaveModule(location) {
            qgeoserviceprovider \
            qgeotiledmap \
            qgeotilespec \
+           qgeofiletilecache \
+           qcache3q \
+           qgeotilesharedstorage \
+           qgeotilevalidators \
            qgeoroutexmlparser \
            maptype \
            nokia_services \
-           qgeocameratiles
+           qgeocameratiles \
+           qgeopathsimplification \
+           qgeomapitemindex
 
     qtHaveModule(quick) {
         SUBDIRS += declarative_core \
-                declarative_geoshape
+                declarative_geoshape \
+                qgeotiledmapscenegraph
 
         !mac: SUBDIRS += declarative_ui
     }
@@ -82,4 +89,5 @@ SUBDIRS += \
            qgeopositioninfosource \
            qgeosatelliteinfo \
            qgeosatelliteinfosource \
+           qlocationutils \
            qnmeapositioninfosource
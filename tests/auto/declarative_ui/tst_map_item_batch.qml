@@ -0,0 +1,169 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+import QtQuick 2.0
+import QtTest 1.0
+import QtLocation 5.11
+import QtPositioning 5.5
+
+Item {
+    id: page
+    width: 400
+    height: 400
+    Plugin { id: testPlugin; name: "qmlgeo.test.plugin"; allowExperimental: true }
+
+    Map {
+        id: map
+        plugin: testPlugin
+        anchors.fill: parent
+        center: QtPositioning.coordinate(20, 20)
+        zoomLevel: 6
+    }
+
+    MapItemBatch { id: batch }
+
+    Component {
+        id: circleComponent
+        MapCircle { }
+    }
+    Component {
+        id: polylineComponent
+        MapPolyline { }
+    }
+
+    TestCase {
+        name: "MapItemBatch"
+        when: windowShown
+
+        property var perItem: []
+        property int frame: 0
+
+        function clearPerItem() {
+            for (var i = 0; i < perItem.length; ++i) {
+                map.removeMapItem(perItem[i])
+                perItem[i].destroy()
+            }
+            perItem = []
+        }
+
+        function test_items() {
+            map.center = QtPositioning.coordinate(20, 20)
+            map.zoomLevel = 6
+            map.addMapItem(batch)
+            var circle = batch.addCircle(QtPositioning.coordinate(20, 20), 50000, "red")
+            var rectangle = batch.addRectangle(QtPositioning.coordinate(19, 22),
+                                               QtPositioning.coordinate(18, 23), "blue")
+            var polyline = batch.addPolyline([QtPositioning.coordinate(22, 17),
+                                              QtPositioning.coordinate(22, 19)], 10, "green")
+            compare(batch.count, 3)
+            compare(batch.addPolyline("not a path", 1, "green"), -1)
+            compare(batch.count, 3)
+            waitForRendering(map)
+
+            var center = map.fromCoordinate(QtPositioning.coordinate(20, 20))
+            compare(batch.itemAt(Qt.point(center.x, center.y)), circle)
+            var inside = map.fromCoordinate(QtPositioning.coordinate(18.5, 22.5))
+            compare(batch.itemAt(Qt.point(inside.x, inside.y)), rectangle)
+            var onLine = map.fromCoordinate(QtPositioning.coordinate(22, 18))
+            compare(batch.itemAt(Qt.point(onLine.x, onLine.y)), polyline)
+            var outside = map.fromCoordinate(QtPositioning.coordinate(16, 16))
+            compare(batch.itemAt(Qt.point(outside.x, outside.y)), -1)
+
+            // Items follow the camera
+            map.center = QtPositioning.coordinate(21, 21)
+            waitForRendering(map)
+            center = map.fromCoordinate(QtPositioning.coordinate(20, 20))
+            compare(batch.itemAt(Qt.point(center.x, center.y)), circle)
+
+            batch.setCircle(circle, QtPositioning.coordinate(20, 24), 50000)
+            waitForRendering(map)
+            compare(batch.itemAt(Qt.point(center.x, center.y)), -1)
+            var moved = map.fromCoordinate(QtPositioning.coordinate(20, 24))
+            compare(batch.itemAt(Qt.point(moved.x, moved.y)), circle)
+
+            // Overlapping items hit the topmost one
+            var top = batch.addCircle(QtPositioning.coordinate(20, 24), 20000, "yellow")
+            waitForRendering(map)
+            compare(batch.itemAt(Qt.point(moved.x, moved.y)), top)
+
+            batch.removeItem(top)
+            compare(batch.count, 3)
+            waitForRendering(map)
+            compare(batch.itemAt(Qt.point(moved.x, moved.y)), circle)
+
+            // Identifiers of removed items are reused
+            compare(batch.addCircle(QtPositioning.coordinate(0, 0), 1000, "red"), top)
+            batch.clear()
+            compare(batch.count, 0)
+            map.removeMapItem(batch)
+        }
+
+        function addVehicles(count, batched) {
+            for (var i = 0; i < count; ++i) {
+                var lat = 15 + (i % 100) * 0.1
+                var lon = 15 + Math.floor(i / 100) * 0.1
+                var center = QtPositioning.coordinate(lat, lon)
+                var path = [center, QtPositioning.coordinate(lat + 0.05, lon + 0.05)]
+                if (batched) {
+                    batch.addCircle(center, 2000, "#8000a000")
+                    batch.addPolyline(path, 2, "blue")
+                } else {
+                    perItem.push(circleComponent.createObject(map, { center: center, radius: 2000, color: "#8000a000" }))
+                    perItem.push(polylineComponent.createObject(map, { path: path, "line.width": 2, "line.color": "blue" }))
+                }
+            }
+            if (batched) {
+                map.addMapItem(batch)
+            } else {
+                for (var j = 0; j < perItem.length; ++j)
+                    map.addMapItem(perItem[j])
+            }
+        }
+
+        function benchmark_frameTime_data() {
+            return [
+                { tag: "1000 per item", count: 1000, batched: false },
+                { tag: "1000 batched", count: 1000, batched: true },
+                { tag: "5000 per item", count: 5000, batched: false },
+                { tag: "5000 batched", count: 5000, batched: true }
+            ]
+        }
+
+        // Each frame pans the map slightly, which updates every item
+        function benchmark_frameTime(data) {
+            if (data.batched ? batch.count !== data.count * 2 : perItem.length !== data.count * 2) {
+                batch.clear()
+                map.removeMapItem(batch)
+                clearPerItem()
+                addVehicles(data.count, data.batched)
+            }
+            ++frame
+            map.center = QtPositioning.coordinate(20 + (frame % 2) * 0.01, 20)
+            waitForRendering(map)
+        }
+    }
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+import QtQuick 2.0
+import QtTest 1.0
+import QtLocation 5.6
+import QtPositioning 5.5
+import QtLocation.Test 5.6
+
+Item {
+    id: page
+    width: 400
+    height: 400
+    Plugin { id: testPlugin; name: "qmlgeo.test.plugin"; allowExperimental: true }
+
+    Map {
+        id: map
+        plugin: testPlugin
+        anchors.fill: parent
+        center: QtPositioning.coordinate(48, 8)
+        zoomLevel: 10
+
+        MapCircle {
+            id: nearCircle
+            center: QtPositioning.coordinate(48.01, 8.02)
+            radius: 1000
+            color: "green"
+        }
+
+        MapCircle {
+            id: farCircle
+            center: QtPositioning.coordinate(60, 30)
+            radius: 1000
+            color: "red"
+        }
+    }
+
+    Component {
+        id: circleComponent
+        MapCircle { }
+    }
+
+    TestCase {
+        name: "MapItemCulling"
+        when: windowShown
+
+        property var items: []
+        property int frame: 0
+
+        // The middle of the item is where its center coordinate is shown
+        function compareCenter(item) {
+            verify(LocationTestHelper.waitForPolished(map))
+            var expected = map.fromCoordinate(item.center, false)
+            var shown = map.mapFromItem(item, item.width / 2, item.height / 2)
+            fuzzyCompare(shown.x, expected.x, 2)
+            fuzzyCompare(shown.y, expected.y, 2)
+        }
+
+        function test_culling() {
+            map.center = QtPositioning.coordinate(48, 8)
+            compareCenter(nearCircle)
+
+            // Items far from the viewport are left where they are
+            var farX = farCircle.x
+            var nearX = nearCircle.x
+            map.center = QtPositioning.coordinate(48, 8.05)
+            compareCenter(nearCircle)
+            verify(nearCircle.x !== nearX)
+            compare(farCircle.x, farX)
+
+            // and catch up once the map gets to them
+            map.center = QtPositioning.coordinate(60, 30.01)
+            compareCenter(farCircle)
+            map.center = QtPositioning.coordinate(48, 8)
+            compareCenter(nearCircle)
+
+            // Moving an item updates its place in the index
+            farCircle.center = QtPositioning.coordinate(48.02, 7.98)
+            map.center = QtPositioning.coordinate(48, 7.99)
+            compareCenter(farCircle)
+            farCircle.center = QtPositioning.coordinate(60, 30)
+        }
+
+        function benchmark_pan_data() {
+            return [
+                { tag: "1000 items", count: 1000 },
+                { tag: "10000 items", count: 10000 }
+            ]
+        }
+
+        // Items are scattered across Europe, and each frame pans the map a bit
+        function benchmark_pan(data) {
+            if (items.length !== data.count) {
+                for (var i = 0; i < items.length; ++i) {
+                    map.removeMapItem(items[i])
+                    items[i].destroy()
+                }
+                items = []
+                for (i = 0; i < data.count; ++i) {
+                    var lat = 36 + 34 * ((i * 0.6180339887) % 1)
+                    var lon = -10 + 50 * ((i * 0.7548776662) % 1)
+                    var item = circleComponent.createObject(map, {
+                        center: QtPositioning.coordinate(lat, lon), radius: 500, color: "blue" })
+                    items.push(item)
+                    map.addMapItem(item)
+                }
+                map.center = QtPositioning.coordinate(48, 8)
+                map.zoomLevel = 10
+            }
+            ++frame
+            map.center = QtPositioning.coordinate(48, 8 + (frame % 10) * 0.01)
+            waitForRendering(map)
+        }
+    }
+}
@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+import QtQuick 2.0
+import QtTest 1.0
+import QtLocation 5.6
+import QtPositioning 5.5
+import QtLocation.Test 5.6
+
+Item {
+    id: page
+    width: 400
+    height: 400
+    Plugin { id: testPlugin; name: "qmlgeo.test.plugin"; allowExperimental: true }
+
+    Map {
+        id: map
+        plugin: testPlugin
+        anchors.fill: parent
+        center: QtPositioning.coordinate(20, 20.01)
+        zoomLevel: 14
+
+        MapPolyline {
+            id: track
+            line.width: 2
+            line.color: "red"
+        }
+        MapPolygon {
+            id: area
+            color: "green"
+            border.width: 2
+            border.color: "black"
+        }
+        MapPolyline {
+            id: reference
+            line.width: 2
+            line.color: "blue"
+        }
+    }
+
+    TestCase {
+        name: "MapItemGeometryJob"
+        when: windowShown
+
+        property int frame: 0
+
+        // A saw tooth whose vertices all survive simplification at zoom 14,
+        // long enough to be processed on a worker thread
+        function makePath(size) {
+            var path = []
+            for (var i = 0; i < size; ++i)
+                path.push(QtPositioning.coordinate(20 + (i % 2) * 0.01, 20 + 0.02 * i / size))
+            return path
+        }
+
+        function waitForX(item, x) {
+            for (var i = 0; i < 100 && Math.abs(item.x - x) > 1.5; ++i)
+                wait(20)
+            fuzzyCompare(item.x, x, 1.5)
+        }
+
+        function test_resultFollowsCamera() {
+            map.center = QtPositioning.coordinate(20, 20.01)
+            track.path = makePath(2000)
+            for (var i = 0; i < 100 && track.width <= 0; ++i)
+                wait(20)
+            verify(track.width > 0)
+            verify(track.height > 0)
+
+            // Panning by 50 pixels moves the generated geometry by as much
+            var x = track.x
+            map.center = map.toCoordinate(Qt.point(map.width / 2 + 50, map.height / 2))
+            waitForX(track, x - 50)
+            track.path = []
+        }
+
+        function test_polygon() {
+            map.center = QtPositioning.coordinate(20, 20.01)
+            area.path = makePath(2000)
+            for (var i = 0; i < 100 && area.width <= 0; ++i)
+                wait(20)
+            verify(area.width > 0)
+            verify(area.height > 0)
+            area.path = []
+        }
+
+        // A short path set while a long one is being processed wins
+        function test_supersededJob() {
+            map.center = QtPositioning.coordinate(20, 20.01)
+            var shortPath = [QtPositioning.coordinate(20, 20),
+                             QtPositioning.coordinate(20.001, 20.001)]
+            track.path = makePath(20000)
+            waitForRendering(map)
+            track.path = shortPath
+            reference.path = shortPath
+            waitForRendering(map)
+            wait(200)
+            fuzzyCompare(track.x, reference.x, 0.5)
+            fuzzyCompare(track.width, reference.width, 0.5)
+            fuzzyCompare(track.height, reference.height, 0.5)
+            track.path = []
+            reference.path = []
+        }
+
+        // A new zoom level that arrives while a job runs is not lost when its
+        // result, generated for the previous level, lands
+        function test_zoomDuringJob() {
+            map.zoomLevel = 14
+            map.center = QtPositioning.coordinate(20, 20.01)
+            track.path = makePath(20000)
+            verify(LocationTestHelper.waitForPolished(map))
+            map.zoomLevel = 15
+
+            var left = map.fromCoordinate(QtPositioning.coordinate(20, 20), false)
+            var right = map.fromCoordinate(QtPositioning.coordinate(20, 20.02), false)
+            var expected = right.x - left.x
+            for (var i = 0; i < 250 && Math.abs(track.width - expected) > 4; ++i)
+                wait(20)
+            fuzzyCompare(track.width, expected, 4)
+            fuzzyCompare(map.mapFromItem(track, 0, 0).x, left.x, 4)
+
+            track.path = []
+            map.zoomLevel = 14
+        }
+
+        function benchmark_pan_data() {
+            return [
+                { tag: "10k points", size: 10000 },
+                { tag: "100k points", size: 100000 }
+            ]
+        }
+
+        // Each frame pans the map slightly; the GUI thread only waits for
+        // the results that are ready
+        function benchmark_pan(data) {
+            if (track.pathLength() !== data.size)
+                track.path = makePath(data.size)
+            ++frame
+            map.center = QtPositioning.coordinate(20 + (frame % 2) * 0.0001, 20.01)
+            waitForRendering(map)
+        }
+    }
+}
@@ -0,0 +1,250 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+import QtQuick 2.0
+import QtTest 1.0
+import QtLocation 5.6
+import QtPositioning 5.5
+import QtLocation.Test 5.6
+
+Item {
+    id: page
+    width: 400
+    height: 400
+    Plugin { id: testPlugin; name: "qmlgeo.test.plugin"; allowExperimental: true }
+
+    Map {
+        id: map
+        plugin: testPlugin
+        anchors.fill: parent
+        center: QtPositioning.coordinate(20, 20)
+        zoomLevel: 12
+
+        MapCircle {
+            id: circle
+            center: QtPositioning.coordinate(20.01, 20.02)
+            radius: 1000
+            color: "green"
+            border.width: 2
+        }
+    }
+
+    Component {
+        id: polylineComponent
+        MapPolyline { }
+    }
+
+    Component {
+        id: circleComponent
+        MapCircle { }
+    }
+
+    SignalSpy { id: scaleSpy; target: circle; signalName: "scaleChanged" }
+    SignalSpy { id: rotationSpy; target: circle; signalName: "rotationChanged" }
+
+    TestCase {
+        name: "MapItemTransform"
+        when: windowShown
+
+        property var items: []
+        property int frame: 0
+
+        // The middle of the circle item is where its center coordinate is shown
+        function compareCenter() {
+            verify(LocationTestHelper.waitForPolished(map))
+            var expected = map.fromCoordinate(circle.center, false)
+            var shown = map.mapFromItem(circle, circle.width / 2, circle.height / 2)
+            fuzzyCompare(shown.x, expected.x, 2)
+            fuzzyCompare(shown.y, expected.y, 2)
+        }
+
+        // Scale and rotation the circle geometry is shown with, whatever
+        // applies them, from where its top edge lands on the map
+        function shownScale() {
+            var a = map.mapFromItem(circle, 0, 0)
+            var b = map.mapFromItem(circle, circle.width, 0)
+            return Math.sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y)) / circle.width
+        }
+
+        function shownRotation() {
+            var a = map.mapFromItem(circle, 0, 0)
+            var b = map.mapFromItem(circle, circle.width, 0)
+            return Math.atan2(b.y - a.y, b.x - a.x) * 180 / Math.PI
+        }
+
+        function test_transform() {
+            map.center = QtPositioning.coordinate(20, 20)
+            map.zoomLevel = 12
+            map.bearing = 0
+            map.tilt = 0
+            compareCenter()
+            fuzzyCompare(shownScale(), 1, 0.001)
+            fuzzyCompare(shownRotation(), 0, 0.001)
+
+            // Pans only move the item
+            map.center = QtPositioning.coordinate(20.005, 20.01)
+            compareCenter()
+            fuzzyCompare(shownScale(), 1, 0.001)
+
+            // Zooming within the level scales it
+            map.zoomLevel = 12.5
+            compareCenter()
+            fuzzyCompare(shownScale(), Math.pow(2, 0.5), 0.001)
+
+            // and a bearing rotates it
+            map.bearing = 30
+            compareCenter()
+            fuzzyCompare(shownRotation(), -30, 0.001)
+
+            // without touching the properties of the item
+            compare(circle.scale, 1)
+            compare(circle.rotation, 0)
+
+            // A new zoom level generates the geometry again
+            map.zoomLevel = 13.2
+            compareCenter()
+            fuzzyCompare(shownScale(), 1, 0.001)
+            fuzzyCompare(shownRotation(), 0, 0.001)
+
+            // and so does tilting
+            map.bearing = 0
+            map.zoomLevel = 13.5
+            verify(LocationTestHelper.waitForPolished(map))
+            fuzzyCompare(shownScale(), Math.pow(2, 0.3), 0.001)
+            map.tilt = 20
+            verify(LocationTestHelper.waitForPolished(map))
+            fuzzyCompare(shownScale(), 1, 0.001)
+            fuzzyCompare(shownRotation(), 0, 0.001)
+            map.tilt = 0
+        }
+
+        // Scale and rotation set on the item stay as they are and apply on
+        // top of the geometry transform
+        function test_userTransform() {
+            map.center = QtPositioning.coordinate(20, 20)
+            map.zoomLevel = 12
+            map.bearing = 0
+            map.tilt = 0
+            verify(LocationTestHelper.waitForPolished(map))
+            circle.scale = 2
+            circle.rotation = 10
+            scaleSpy.clear()
+            rotationSpy.clear()
+
+            map.center = QtPositioning.coordinate(20.005, 20.01)
+            map.zoomLevel = 12.5
+            map.bearing = 30
+            compareCenter()
+            fuzzyCompare(shownScale(), 2 * Math.pow(2, 0.5), 0.001)
+            fuzzyCompare(shownRotation(), -20, 0.001)
+            compare(scaleSpy.count, 0)
+            compare(rotationSpy.count, 0)
+            compare(circle.scale, 2)
+            compare(circle.rotation, 10)
+            compare(circle.transformOrigin, Item.Center)
+
+            map.zoomLevel = 13.2
+            compareCenter()
+            fuzzyCompare(shownScale(), 2, 0.001)
+            compare(scaleSpy.count, 0)
+
+            circle.scale = 1
+            circle.rotation = 0
+            map.bearing = 0
+        }
+
+        // The fill of a circle around a pole is clipped to the viewport, so
+        // panning and rotating generate it again instead of moving it
+        function test_polarCircle() {
+            map.zoomLevel = 3
+            map.bearing = 0
+            map.tilt = 0
+            map.center = QtPositioning.coordinate(75, 0)
+            var polar = circleComponent.createObject(map, { center: QtPositioning.coordinate(88, 0),
+                                                            radius: 2000000, color: "blue" })
+            map.addMapItem(polar)
+            verify(LocationTestHelper.waitForPolished(map))
+            var top = map.mapToItem(polar, map.width / 2, 10)
+            verify(polar.contains(Qt.point(top.x, top.y)))
+
+            map.center = QtPositioning.coordinate(75, 120)
+            verify(LocationTestHelper.waitForPolished(map))
+            top = map.mapToItem(polar, map.width / 2, 10)
+            verify(polar.contains(Qt.point(top.x, top.y)))
+            var corner = map.mapToItem(polar, map.width - 10, 10)
+            verify(polar.contains(Qt.point(corner.x, corner.y)))
+
+            map.bearing = 45
+            verify(LocationTestHelper.waitForPolished(map))
+            corner = map.mapToItem(polar, 10, 10)
+            verify(polar.contains(Qt.point(corner.x, corner.y)))
+
+            map.removeMapItem(polar)
+            polar.destroy()
+            map.bearing = 0
+            map.zoomLevel = 12
+            map.center = QtPositioning.coordinate(20, 20)
+        }
+
+        function addTracks(count) {
+            for (var i = 0; i < count; ++i) {
+                var lat = 19.5 + (i % 100) * 0.01
+                var lon = 19.5 + Math.floor(i / 100) * 0.01
+                var path = []
+                for (var j = 0; j < 20; ++j)
+                    path.push(QtPositioning.coordinate(lat + 0.0005 * j, lon + 0.0005 * (j % 3)))
+                var item = polylineComponent.createObject(map, { path: path, "line.width": 2, "line.color": "blue" })
+                items.push(item)
+                map.addMapItem(item)
+            }
+        }
+
+        function benchmark_pan_data() {
+            return [
+                { tag: "1000 items", count: 1000 },
+                { tag: "10000 items", count: 10000 }
+            ]
+        }
+
+        // Each frame pans and slightly zooms the map within the same zoom level
+        function benchmark_pan(data) {
+            if (items.length !== data.count) {
+                for (var i = 0; i < items.length; ++i) {
+                    map.removeMapItem(items[i])
+                    items[i].destroy()
+                }
+                items = []
+                addTracks(data.count)
+                map.zoomLevel = 12
+            }
+            ++frame
+            map.center = QtPositioning.coordinate(20 + (frame % 2) * 0.01, 20)
+            map.zoomLevel = 12 + (frame % 2) * 0.1
+            waitForRendering(map)
+        }
+    }
+}
@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+import QtQuick 2.0
+import QtTest 1.0
+import QtLocation 5.6
+import QtPositioning 5.5
+
+Item {
+    id: page
+    width: 400
+    height: 400
+    Plugin { id: testPlugin; name: "qmlgeo.test.plugin"; allowExperimental: true }
+
+    Map {
+        id: map
+        plugin: testPlugin
+        anchors.fill: parent
+        center: QtPositioning.coordinate(20, 20)
+        zoomLevel: 14
+
+        MapPolyline {
+            id: track
+            line.width: 3
+            line.color: "red"
+        }
+        MapPolyline {
+            id: reference
+            line.width: 3
+            line.color: "blue"
+        }
+    }
+
+    TestCase {
+        name: "MapPolylineAppend"
+        when: windowShown
+
+        property real heading: 0
+
+        function nextCoordinate(last, i) {
+            heading += Math.sin(i * 0.37) * 0.6
+            return QtPositioning.coordinate(last.latitude + 0.0002 * Math.sin(heading),
+                                            last.longitude + 0.0002 * Math.cos(heading))
+        }
+
+        function test_appendMatchesRebuild_data() {
+            return [
+                { tag: "east", start: QtPositioning.coordinate(20, 20), heading: 0 },
+                { tag: "north west", start: QtPositioning.coordinate(20, 20), heading: 2.3 }
+            ]
+        }
+
+        // A track grown point by point has the same extent as the same path set at once
+        function test_appendMatchesRebuild(data) {
+            map.center = data.start
+            heading = data.heading
+            var path = [data.start]
+            track.path = path
+            waitForRendering(map)
+            for (var i = 1; i < 40; ++i) {
+                path.push(nextCoordinate(path[path.length - 1], i))
+                track.addCoordinate(path[path.length - 1])
+                waitForRendering(map)
+            }
+            reference.path = path
+            waitForRendering(map)
+
+            compare(track.pathLength(), reference.pathLength())
+            fuzzyCompare(track.x, reference.x, 1.5)
+            fuzzyCompare(track.y, reference.y, 1.5)
+            fuzzyCompare(track.width, reference.width, 1.5)
+            fuzzyCompare(track.height, reference.height, 1.5)
+
+            // A camera change rebuilds the whole path
+            map.center = path[path.length - 1]
+            waitForRendering(map)
+            fuzzyCompare(track.x, reference.x, 1.5)
+            fuzzyCompare(track.y, reference.y, 1.5)
+            fuzzyCompare(track.width, reference.width, 1.5)
+            fuzzyCompare(track.height, reference.height, 1.5)
+        }
+
+        function along(from, to, t) {
+            return QtPositioning.coordinate(from.latitude + t * (to.latitude - from.latitude),
+                                            from.longitude + t * (to.longitude - from.longitude))
+        }
+
+        function onMap(coordinate) {
+            var p = map.fromCoordinate(coordinate, false)
+            return p.x > 10 && p.y > 10 && p.x < map.width - 10 && p.y < map.height - 10
+        }
+
+        function hits(item, coordinate) {
+            var p = map.fromCoordinate(coordinate, false)
+            var local = map.mapToItem(item, p.x, p.y)
+            return item.contains(Qt.point(local.x, local.y))
+        }
+
+        // The appended segments are hit where the rebuilt path is: on the
+        // lines themselves, next to the joins, and off to their side
+        function compareHits(path) {
+            var checked = 0
+            for (var i = 1; i < path.length; ++i) {
+                var from = path[i - 1]
+                var to = path[i]
+                if (!onMap(from) || !onMap(to))
+                    continue
+                ++checked
+                var ts = [0.3, 0.7, 0.95]
+                for (var j = 0; j < ts.length; ++j) {
+                    var c = along(from, to, ts[j])
+                    verify(hits(track, c), "segment " + i + " at " + ts[j])
+                    verify(hits(reference, c), "segment " + i + " at " + ts[j])
+                }
+                compare(hits(track, to), hits(reference, to), "join " + i)
+                var side = QtPositioning.coordinate(c.latitude - 0.0001, c.longitude - 0.0001)
+                compare(hits(track, side), hits(reference, side), "side of segment " + i)
+            }
+            verify(checked > 10)
+        }
+
+        function test_appendHitTest_data() {
+            return [
+                { tag: "east", north: 0, east: 1 },
+                { tag: "north west", north: 1, east: -1 }
+            ]
+        }
+
+        // At a zoom level where segments span several pixels, a zigzag grown
+        // point by point is hit-tested like the same path set at once,
+        // including when each point grows its bounds to the north west
+        function test_appendHitTest(data) {
+            var start = QtPositioning.coordinate(20, 20)
+            map.zoomLevel = 17
+            map.center = start
+            track.line.width = 9
+            reference.line.width = 9
+            var path = [start]
+            track.path = path
+            reference.path = []
+            waitForRendering(map)
+            var x = 0
+            var y = 0
+            for (var i = 1; i < 20; ++i) {
+                var zigzag = (i % 2) * 0.00003
+                path.push(QtPositioning.coordinate(start.latitude + i * 0.0001 * data.north + zigzag * data.east,
+                                                   start.longitude + i * 0.0001 * data.east - zigzag * data.north))
+                track.addCoordinate(path[i])
+                waitForRendering(map)
+                if (i === 1) {
+                    x = track.x
+                    y = track.y
+                }
+            }
+            reference.path = path
+            waitForRendering(map)
+
+            if (data.north > 0) {
+                verify(track.x < x - 100)
+                verify(track.y < y - 100)
+            }
+            fuzzyCompare(track.x, reference.x, 1.5)
+            fuzzyCompare(track.y, reference.y, 1.5)
+            compareHits(path)
+
+            track.path = []
+            reference.path = []
+            track.line.width = 3
+            reference.line.width = 3
+            map.zoomLevel = 14
+        }
+
+        function benchmark_append_data() {
+            return [
+                { tag: "1k points", size: 1000 },
+                { tag: "10k points", size: 10000 },
+                { tag: "50k points", size: 50000 }
+            ]
+        }
+
+        // Each frame appends one point to a track of the given length
+        function benchmark_append(data) {
+            if (track.pathLength() < data.size || track.pathLength() > data.size * 1.1) {
+                map.center = QtPositioning.coordinate(20, 20)
+                heading = 0
+                var path = [QtPositioning.coordinate(20, 20)]
+                for (var i = 1; i < data.size; ++i)
+                    path.push(nextCoordinate(path[i - 1], i))
+                track.path = path
+                reference.path = []
+                waitForRendering(map)
+            }
+            var n = track.pathLength()
+            track.addCoordinate(nextCoordinate(track.coordinateAt(n - 1), n))
+            waitForRendering(map)
+        }
+    }
+}
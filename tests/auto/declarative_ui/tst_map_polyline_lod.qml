@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+import QtQuick 2.0
+import QtTest 1.0
+import QtLocation 5.6
+import QtPositioning 5.5
+
+Item {
+    id: page
+    width: 400
+    height: 400
+    Plugin { id: testPlugin; name: "qmlgeo.test.plugin"; allowExperimental: true }
+
+    Map {
+        id: map
+        plugin: testPlugin
+        anchors.fill: parent
+        center: QtPositioning.coordinate(20, 20)
+
+        MapPolyline {
+            id: track
+            line.width: 2
+            line.color: "red"
+        }
+    }
+
+    TestCase {
+        name: "MapPolylineLevelOfDetail"
+        when: windowShown
+
+        property int frame: 0
+
+        // A meandering GPS track starting at the map center
+        function makePath(size) {
+            var path = []
+            var lat = 20
+            var lon = 20
+            var heading = 0
+            for (var i = 0; i < size; ++i) {
+                heading += Math.sin(i * 0.37) * 0.3
+                lat += 0.00002 * Math.sin(heading)
+                lon += 0.00002 * Math.cos(heading)
+                path.push(QtPositioning.coordinate(lat, lon))
+            }
+            return path
+        }
+
+        function benchmark_polish_data() {
+            return [
+                { tag: "1k points, zoom 5", size: 1000, zoom: 5 },
+                { tag: "1k points, zoom 14", size: 1000, zoom: 14 },
+                { tag: "50k points, zoom 5", size: 50000, zoom: 5 },
+                { tag: "50k points, zoom 14", size: 50000, zoom: 14 },
+                { tag: "200k points, zoom 5", size: 200000, zoom: 5 },
+                { tag: "200k points, zoom 14", size: 200000, zoom: 14 }
+            ]
+        }
+
+        // Each frame pans the map slightly, which re-polishes the polyline
+        function benchmark_polish(data) {
+            if (track.pathLength() !== data.size)
+                track.path = makePath(data.size)
+            map.zoomLevel = data.zoom
+            ++frame
+            map.center = QtPositioning.coordinate(20 + (frame % 2) * 0.0001, 20)
+            waitForRendering(map)
+        }
+    }
+}
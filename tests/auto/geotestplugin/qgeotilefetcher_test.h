@@ -67,7 +67,7 @@ class QGeoTileFetcherTest: public QGeoTileFetcher
     Q_OBJECT
 public:
     QGeoTileFetcherTest(QGeoMappingManagerEngine *parent)
-    :    QGeoTileFetcher(parent), finishRequestImmediately_(false), errorCode_(QGeoTiledMapReply::NoError)
+    :    QGeoTileFetcher(parent), finishRequestImmediately_(false), latency_(0), errorCode_(QGeoTiledMapReply::NoError)
     {
     }
 
@@ -110,7 +110,11 @@ public:
         mappingReply->callSetMapImageData(bytes);
         mappingReply->callSetMapImageFormat("png");
 
-        if (finishRequestImmediately_) {
+        if (latency_ > 0) {
+            // Replies in flight finish independently, like network requests
+            QTimer::singleShot(latency_, mappingReply, [this, mappingReply]() { updateRequest(mappingReply); });
+            return mappingReply;
+        } else if (finishRequestImmediately_) {
             updateRequest(mappingReply);
             return mappingReply;
         } else {
@@ -127,6 +131,12 @@ public:
         finishRequestImmediately_ = enabled;
     }
 
+    // Round trip of each request in msec, 0 falls back to finishRequestImmediately
+    void setLatency(int msecs)
+    {
+        latency_ = msecs;
+    }
+
     void setTileSize(QSize tileSize)
     {
         tileSize_ = tileSize;
@@ -169,6 +179,7 @@ protected:
 
 private:
     bool finishRequestImmediately_;
+    int latency_;
     QBasicTimer timer_;
     QGeoTiledMapReply::Error errorCode_;
     QString errorString_;
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qcache3q
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qcache3q.cpp
+
+QT += location-private testlib
@@ -0,0 +1,315 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include "qcache3q_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+struct Value
+{
+    explicit Value(int v = 0) : value(v) {}
+    int value;
+};
+
+static int evictedCount = 0;
+static int removedCount = 0;
+
+class CountingPolicy
+{
+protected:
+    void aboutToBeEvicted(int, QSharedPointer<Value>) { ++evictedCount; }
+    void aboutToBeRemoved(int, QSharedPointer<Value> obj)
+    {
+        QVERIFY(obj); // never called for ghosts
+        ++removedCount;
+    }
+};
+
+typedef QCache3Q<int, Value, CountingPolicy> Cache;
+typedef QCache3Q<QGeoTileSpec, Value> TileCache;
+
+class tst_QCache3Q : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void insertAndLookup();
+    void promotion();
+    void ghosts();
+    void policyHooks();
+    void serializeRoundTrip();
+    void churn();
+    void insertThroughput_data();
+    void insertThroughput();
+    void objectThroughput_data();
+    void objectThroughput();
+    void evictThroughput_data();
+    void evictThroughput();
+
+private:
+    static QGeoTileSpec spec(int i);
+    static void addSizeRows();
+};
+
+QGeoTileSpec tst_QCache3Q::spec(int i)
+{
+    return QGeoTileSpec(QStringLiteral("test"), 1, 20, i % 4096, i / 4096);
+}
+
+void tst_QCache3Q::addSizeRows()
+{
+    QTest::addColumn<int>("entries");
+    QTest::newRow("10^4") << 10000;
+    QTest::newRow("10^5") << 100000;
+    QTest::newRow("10^6") << 1000000;
+}
+
+void tst_QCache3Q::init()
+{
+    evictedCount = 0;
+    removedCount = 0;
+}
+
+void tst_QCache3Q::insertAndLookup()
+{
+    Cache cache(100);
+    for (int i = 0; i < 50; ++i)
+        QVERIFY(cache.insert(i, QSharedPointer<Value>(new Value(i)), 2));
+    QCOMPARE(cache.totalCost(), 100);
+    QVERIFY(!cache.insert(1000, QSharedPointer<Value>(new Value), 101));
+
+    for (int i = 0; i < 50; ++i) {
+        QVERIFY(cache.contains(i));
+        QCOMPARE(cache.object(i)->value, i);
+    }
+    QVERIFY(!cache.contains(50));
+    QVERIFY(!cache.object(50));
+    QCOMPARE(cache.hitCount(), quint64(50));
+    QCOMPARE(cache.missCount(), quint64(1));
+
+    // replacing updates the value and the cost
+    QVERIFY(cache.insert(7, QSharedPointer<Value>(new Value(-7)), 1));
+    QCOMPARE(cache.object(7)->value, -7);
+    QCOMPARE(cache.totalCost(), 99);
+    QCOMPARE(cache.keys().size(), 50);
+}
+
+void tst_QCache3Q::promotion()
+{
+    Cache cache(30, 10, 6);
+    cache.setPromoteAt(1);
+    for (int i = 0; i < 10; ++i)
+        cache.insert(i, QSharedPointer<Value>(new Value(i)));
+
+    // 0..4 are used twice and become regulars, 5..9 remain newbies
+    for (int i = 0; i < 5; ++i) {
+        cache.object(i);
+        cache.object(i);
+    }
+    // newbies above minRecent go first, least recently added first
+    for (int i = 10; i < 35; ++i)
+        cache.insert(i, QSharedPointer<Value>(new Value(i)));
+    for (int i = 0; i < 5; ++i)
+        QVERIFY(cache.contains(i));
+    for (int i = 5; i < 10; ++i)
+        QVERIFY(!cache.contains(i));
+    QCOMPARE(cache.totalCost(), 30);
+    QCOMPARE(cache.evictionCount(), quint64(5));
+}
+
+void tst_QCache3Q::ghosts()
+{
+    Cache cache(10);
+    cache.setPromoteAt(1);
+    cache.insert(1, QSharedPointer<Value>(new Value(1)));
+    cache.object(1); // pop 1, not yet promoted
+    for (int i = 2; i < 12; ++i)
+        cache.insert(i, QSharedPointer<Value>(new Value(i)));
+    QVERIFY(!cache.contains(1));
+    QCOMPARE(evictedCount, 1);
+
+    // the ghost remembers the popularity: a second ping promotes it on insertion
+    QVERIFY(!cache.object(1));
+    cache.insert(1, QSharedPointer<Value>(new Value(1)));
+    QVERIFY(cache.contains(1));
+
+    // removing a ghost does not notify the policy
+    cache.insert(100, QSharedPointer<Value>(new Value(100)));
+    QVERIFY(cache.keys().size() > cache.totalCost());
+    const QList<int> keys = cache.keys();
+    for (int key : keys) {
+        if (!cache.contains(key))
+            cache.remove(key);
+    }
+    QCOMPARE(removedCount, 0);
+    QCOMPARE(cache.keys().size(), cache.totalCost());
+}
+
+void tst_QCache3Q::policyHooks()
+{
+    {
+        Cache cache(5);
+        for (int i = 0; i < 8; ++i)
+            cache.insert(i, QSharedPointer<Value>(new Value(i)));
+        QCOMPARE(evictedCount, 3);
+        cache.remove(7);
+        QCOMPARE(removedCount, 1);
+        cache.remove(6, true);
+        QCOMPARE(removedCount, 1);
+    }
+    // the destructor removes what is left
+    QCOMPARE(removedCount, 4);
+}
+
+void tst_QCache3Q::serializeRoundTrip()
+{
+    Cache cache(20);
+    cache.setPromoteAt(0);
+    for (int i = 0; i < 20; ++i)
+        cache.insert(i, QSharedPointer<Value>(new Value(i)));
+    for (int i = 0; i < 20; i += 2)
+        cache.object(i);
+
+    Cache copy(20);
+    for (int queue = 1; queue <= 3; ++queue) {
+        QList<QSharedPointer<Value> > values;
+        cache.serializeQueue(queue, values);
+        QList<int> keys;
+        QList<int> costs;
+        for (const QSharedPointer<Value> &v : qAsConst(values)) {
+            keys.append(v->value);
+            costs.append(1);
+        }
+        copy.deserializeQueue(queue, keys, values, costs);
+
+        QList<QSharedPointer<Value> > copied;
+        copy.serializeQueue(queue, copied);
+        QCOMPARE(copied, values);
+    }
+    QCOMPARE(copy.totalCost(), cache.totalCost());
+}
+
+// Nodes and index slots are recycled; every key stays reachable
+void tst_QCache3Q::churn()
+{
+    TileCache cache(1000);
+    quint32 seed = 1;
+    for (int n = 0; n < 200000; ++n) {
+        seed = seed * 1103515245 + 12345;
+        const int i = int((seed >> 8) % 5000);
+        switch ((seed >> 4) % 4) {
+        case 0:
+        case 1:
+            cache.insert(spec(i), QSharedPointer<Value>(new Value(i)));
+            break;
+        case 2: {
+            QSharedPointer<Value> v = cache.object(spec(i));
+            QVERIFY(!v || v->value == i);
+            break;
+        }
+        default:
+            cache.remove(spec(i));
+        }
+        QVERIFY(cache.totalCost() <= 1000);
+    }
+
+    const QList<QGeoTileSpec> keys = cache.keys();
+    QCOMPARE(keys.toSet().size(), keys.size());
+    int live = 0;
+    for (const QGeoTileSpec &key : keys) {
+        if (cache.contains(key))
+            ++live;
+    }
+    QCOMPARE(live, cache.totalCost());
+}
+
+void tst_QCache3Q::insertThroughput_data()
+{
+    addSizeRows();
+}
+
+void tst_QCache3Q::insertThroughput()
+{
+    QFETCH(int, entries);
+    const QSharedPointer<Value> value(new Value);
+
+    QBENCHMARK {
+        TileCache cache(entries);
+        for (int i = 0; i < entries; ++i)
+            cache.insert(spec(i), value);
+    }
+}
+
+void tst_QCache3Q::objectThroughput_data()
+{
+    addSizeRows();
+}
+
+void tst_QCache3Q::objectThroughput()
+{
+    QFETCH(int, entries);
+    const QSharedPointer<Value> value(new Value);
+    TileCache cache(entries);
+    for (int i = 0; i < entries; ++i)
+        cache.insert(spec(i), value);
+
+    QBENCHMARK {
+        for (int i = 0; i < entries; ++i)
+            cache.object(spec((i * 7919) % entries));
+    }
+}
+
+void tst_QCache3Q::evictThroughput_data()
+{
+    addSizeRows();
+}
+
+void tst_QCache3Q::evictThroughput()
+{
+    QFETCH(int, entries);
+    const QSharedPointer<Value> value(new Value);
+    TileCache cache(entries);
+    int i = 0;
+    for (; i < entries; ++i)
+        cache.insert(spec(i), value);
+
+    // the cache is full, every insert evicts a tile
+    QBENCHMARK {
+        for (int n = 0; n < entries; ++n, ++i)
+            cache.insert(spec(i), value);
+    }
+}
+
+QTEST_MAIN(tst_QCache3Q)
+
+#include "tst_qcache3q.moc"
@@ -37,6 +37,7 @@
 
 #include <QDebug>
 #include <QDataStream>
+#include <QRandomGenerator>
 
 #include <QtPositioning/qgeoareamonitorinfo.h>
 #include <QtPositioning/qgeoareamonitorsource.h>
@@ -70,6 +71,42 @@ void tst_qgeoareamonitorinfo_messageHandler(QtMsgType type,
     }
 }
 
+// Delivers positions synchronously when asked to, for deterministic replay.
+class ManualPositionSource : public QGeoPositionInfoSource
+{
+    Q_OBJECT
+public:
+    ManualPositionSource(QObject *parent = 0) : QGeoPositionInfoSource(parent) {}
+
+    QGeoPositionInfo lastKnownPosition(bool = false) const Q_DECL_OVERRIDE { return m_last; }
+    PositioningMethods supportedPositioningMethods() const Q_DECL_OVERRIDE
+    { return AllPositioningMethods; }
+    int minimumUpdateInterval() const Q_DECL_OVERRIDE { return 0; }
+    Error error() const Q_DECL_OVERRIDE { return NoError; }
+
+    void moveTo(const QGeoCoordinate &coordinate)
+    {
+        m_last = QGeoPositionInfo(coordinate, QDateTime::currentDateTime());
+        emit positionUpdated(m_last);
+    }
+
+public slots:
+    void startUpdates() Q_DECL_OVERRIDE {}
+    void stopUpdates() Q_DECL_OVERRIDE {}
+    void requestUpdate(int = 0) Q_DECL_OVERRIDE {}
+
+private:
+    QGeoPositionInfo m_last;
+};
+
+static QGeoShape randomArea(QRandomGenerator &rng, int i)
+{
+    const QGeoCoordinate center(rng.bounded(2.0) - 28.5, rng.bounded(2.0) + 152.5);
+    if (i % 2)
+        return QGeoCircle(center, 200 + rng.bounded(5000.0));
+    return QGeoRectangle(center, 0.005 + rng.bounded(0.1), 0.005 + rng.bounded(0.1));
+}
+
 class tst_QGeoAreaMonitorSource : public QObject
 {
     Q_OBJECT
@@ -711,6 +748,194 @@ private slots:
         delete obj2;
     }
 
+    void tst_manyMonitors()
+    {
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        ManualPositionSource *source = new ManualPositionSource;
+        obj->setPositionInfoSource(source);
+        QSignalSpy enteredSpy(obj, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+        QSignalSpy exitedSpy(obj, SIGNAL(areaExited(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+
+        QRandomGenerator rng(42);
+        QHash<QString, QGeoAreaMonitorInfo> monitors;
+        QHash<QString, QGeoShape> areas;
+        for (int i = 0; i < 500; ++i) {
+            QGeoAreaMonitorInfo mon(QString::number(i));
+            mon.setArea(randomArea(rng, i));
+            QVERIFY(obj->startMonitoring(mon));
+            monitors.insert(mon.identifier(), mon);
+            areas.insert(mon.identifier(), mon.area());
+        }
+        // large areas and one crossing the dateline
+        QGeoAreaMonitorInfo large(QStringLiteral("large"));
+        large.setArea(QGeoRectangle(QGeoCoordinate(-20, 140), QGeoCoordinate(-40, 160)));
+        QVERIFY(obj->startMonitoring(large));
+        monitors.insert(large.identifier(), large);
+        areas.insert(large.identifier(), large.area());
+        QGeoAreaMonitorInfo dateline(QStringLiteral("dateline"));
+        dateline.setArea(QGeoRectangle(QGeoCoordinate(-27, 179.5), QGeoCoordinate(-29, -179.5)));
+        QVERIFY(obj->startMonitoring(dateline));
+        monitors.insert(dateline.identifier(), dateline);
+        areas.insert(dateline.identifier(), dateline.area());
+
+        // random walk, checked against testing every area
+        QSet<QString> inside;
+        QGeoCoordinate position(-27.5, 153.5);
+        for (int step = 0; step < 400; ++step) {
+            if (step == 300)
+                position = QGeoCoordinate(-28, 179.9);
+            position = QGeoCoordinate(qBound(-29.0, position.latitude() + rng.bounded(0.04) - 0.02, -26.0),
+                                      position.longitude() + rng.bounded(0.04) - 0.02);
+            if (position.longitude() > 180.0)
+                position.setLongitude(position.longitude() - 360.0);
+
+            QSet<QString> expectedEntered;
+            QSet<QString> expectedExited;
+            for (auto it = areas.cbegin(); it != areas.cend(); ++it) {
+                const bool contains = it.value().contains(position);
+                if (contains && !inside.contains(it.key()))
+                    expectedEntered.insert(it.key());
+                else if (!contains && inside.contains(it.key()))
+                    expectedExited.insert(it.key());
+            }
+            inside += expectedEntered;
+            inside -= expectedExited;
+
+            source->moveTo(position);
+
+            QSet<QString> entered;
+            while (!enteredSpy.isEmpty())
+                entered.insert(enteredSpy.takeFirst().at(0).value<QGeoAreaMonitorInfo>().identifier());
+            QSet<QString> exited;
+            while (!exitedSpy.isEmpty())
+                exited.insert(exitedSpy.takeFirst().at(0).value<QGeoAreaMonitorInfo>().identifier());
+            QCOMPARE(entered, expectedEntered);
+            QCOMPARE(exited, expectedExited);
+        }
+
+        // stopped monitors are neither entered nor exited
+        foreach (const QString &identifier, inside) {
+            QVERIFY(obj->stopMonitoring(monitors.value(identifier)));
+        }
+        source->moveTo(QGeoCoordinate(-45, 100));
+        QCOMPARE(exitedSpy.count(), 0);
+
+        delete obj;
+    }
+
+    // Areas spanning most of the globe are indexed at a coarse level, instead
+    // of once per cell of the finest one
+    void tst_hugeMonitors()
+    {
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        ManualPositionSource *source = new ManualPositionSource;
+        obj->setPositionInfoSource(source);
+        QSignalSpy enteredSpy(obj, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+        QSignalSpy exitedSpy(obj, SIGNAL(areaExited(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+
+        QGeoAreaMonitorInfo world(QStringLiteral("world"));
+        world.setArea(QGeoRectangle(QGeoCoordinate(90, -180), QGeoCoordinate(-90, 180)));
+        QVERIFY(obj->startMonitoring(world));
+        QGeoAreaMonitorInfo circle(QStringLiteral("circle"));
+        circle.setArea(QGeoCircle(QGeoCoordinate(10, 20), 8000000));
+        QVERIFY(obj->startMonitoring(circle));
+        QGeoAreaMonitorInfo wrapped(QStringLiteral("wrapped"));
+        wrapped.setArea(QGeoRectangle(QGeoCoordinate(60, 10), QGeoCoordinate(-60, 9.99)));
+        QVERIFY(obj->startMonitoring(wrapped));
+        QCOMPARE(obj->activeMonitors().size(), 3);
+
+        source->moveTo(QGeoCoordinate(12, 25));
+        QCOMPARE(enteredSpy.count(), 3);
+        source->moveTo(QGeoCoordinate(-80, -150));
+        QSet<QString> exited;
+        while (!exitedSpy.isEmpty())
+            exited.insert(exitedSpy.takeFirst().at(0).value<QGeoAreaMonitorInfo>().identifier());
+        QCOMPARE(exited, QSet<QString>() << QStringLiteral("circle") << QStringLiteral("wrapped"));
+
+        QVERIFY(obj->stopMonitoring(world));
+        QVERIFY(obj->stopMonitoring(circle));
+        QVERIFY(obj->stopMonitoring(wrapped));
+        delete obj;
+    }
+
+    void tst_expiryOrder()
+    {
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        obj->setPositionInfoSource(new ManualPositionSource);
+        QSignalSpy expirySpy(obj, SIGNAL(monitorExpired(QGeoAreaMonitorInfo)));
+
+        const QDateTime now = QDateTime::currentDateTime();
+        const int monitorCount = 200;
+        QList<QGeoAreaMonitorInfo> monitors;
+        for (int i = 0; i < monitorCount; ++i) {
+            QGeoAreaMonitorInfo mon(QString::number(i));
+            mon.setArea(QGeoRectangle(QGeoCoordinate(0, 0), 1, 1));
+            mon.setExpiration(now.addSecs(60));
+            QVERIFY(obj->startMonitoring(mon));
+            monitors.append(mon);
+        }
+        // re-adding replaces the expiry of the last three
+        for (int i = monitorCount - 1; i >= monitorCount - 3; --i) {
+            monitors[i].setExpiration(now.addMSecs(300 * (monitorCount - i)));
+            QVERIFY(obj->startMonitoring(monitors.at(i)));
+        }
+        // the one expiring first was stopped, the others keep their order
+        QVERIFY(obj->stopMonitoring(monitors.last()));
+
+        QTRY_COMPARE_WITH_TIMEOUT(expirySpy.count(), 2, 3000);
+        QCOMPARE(expirySpy.at(0).at(0).value<QGeoAreaMonitorInfo>().name(),
+                 QString::number(monitorCount - 2));
+        QCOMPARE(expirySpy.at(1).at(0).value<QGeoAreaMonitorInfo>().name(),
+                 QString::number(monitorCount - 3));
+        QCOMPARE(obj->activeMonitors().count(), monitorCount - 3);
+
+        delete obj;
+    }
+
+    void positionUpdateBenchmark_data()
+    {
+        QTest::addColumn<int>("monitorCount");
+
+        QTest::newRow("100") << 100;
+        QTest::newRow("1000") << 1000;
+        QTest::newRow("5000") << 5000;
+        QTest::newRow("20000") << 20000;
+    }
+
+    void positionUpdateBenchmark()
+    {
+        QFETCH(int, monitorCount);
+
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        ManualPositionSource *source = new ManualPositionSource;
+        obj->setPositionInfoSource(source);
+        // monitoring only runs while someone listens
+        QSignalSpy enteredSpy(obj, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+
+        QRandomGenerator rng(7);
+        for (int i = 0; i < monitorCount; ++i) {
+            QGeoAreaMonitorInfo mon(QString::number(i));
+            mon.setArea(randomArea(rng, i));
+            mon.setExpiration(QDateTime::currentDateTime().addSecs(3600 + i));
+            QVERIFY(obj->startMonitoring(mon));
+        }
+
+        QVector<QGeoCoordinate> track;
+        for (int i = 0; i < 64; ++i)
+            track.append(QGeoCoordinate(-28.5 + i * 2.0 / 64, 152.5 + i * 2.0 / 64));
+
+        int step = 0;
+        QBENCHMARK {
+            source->moveTo(track.at(step++ % track.size()));
+        }
+
+        delete obj;
+    }
+
     void debug_data()
     {
         QTest::addColumn<QGeoAreaMonitorInfo>("info");
@@ -70,6 +70,10 @@ private slots:
     void tilesPositions();
     void tilesPositions_data();
     void test_tilted_frustum();
+    void incrementalPan_data();
+    void incrementalPan();
+    void panBenchmark_data();
+    void panBenchmark();
 };
 
 void tst_QGeoCameraTiles::row(const PositionTestInfo &pti, int xOffset, int yOffset, int tileX, int tileY, int tileW, int tileH)
@@ -140,6 +144,114 @@ void tst_QGeoCameraTiles::test_tilted_frustum()
     QCOMPARE(ct.createTiles(), ctFull.createTiles());
 }
 
+static QList<QGeoCameraData> panSequence(double zoomLevel, int steps)
+{
+    // A drag along a diagonal, with sub-tile steps
+    QList<QGeoCameraData> cameras;
+    const double side = std::pow(2.0, zoomLevel);
+    for (int i = 0; i < steps; ++i) {
+        QGeoCameraData camera;
+        camera.setZoomLevel(zoomLevel);
+        const QDoubleVector2D center(0.31 + i * 0.37 / side, 0.42 + i * 0.23 / side);
+        camera.setCenter(QWebMercator::mercatorToCoord(center));
+        cameras << camera;
+    }
+    return cameras;
+}
+
+void tst_QGeoCameraTiles::incrementalPan_data()
+{
+    QTest::addColumn<double>("zoomLevel");
+    QTest::newRow("zoom 4") << 4.0;
+    QTest::newRow("zoom 8.5") << 8.5;
+    QTest::newRow("zoom 14") << 14.0;
+}
+
+void tst_QGeoCameraTiles::incrementalPan()
+{
+    QFETCH(double, zoomLevel);
+
+    const QList<QGeoCameraData> cameras = panSequence(zoomLevel, 40);
+    QGeoCameraTiles ct;
+    ct.setTileSize(256);
+    ct.setScreenSize(QSize(1024, 600));
+    ct.setPluginString("pluginA");
+
+    QSet<QGeoTileSpec> previous;
+    int deltas = 0;
+    for (const QGeoCameraData &camera : cameras) {
+        const int generation = ct.tilesGeneration();
+        ct.setCameraData(camera);
+        const QSet<QGeoTileSpec> tiles = ct.createTiles();
+
+        // Same result as a full computation
+        QGeoCameraTiles full;
+        full.setTileSize(256);
+        full.setScreenSize(QSize(1024, 600));
+        full.setPluginString("pluginA");
+        full.setCameraData(camera);
+        QCOMPARE(tiles, full.createTiles());
+
+        if (ct.hasTilesDelta() && ct.tilesGeneration() == generation + 1) {
+            QCOMPARE(ct.addedTiles(), tiles - previous);
+            QCOMPARE(ct.removedTiles(), previous - tiles);
+            ++deltas;
+        } else if (ct.tilesGeneration() == generation) {
+            QCOMPARE(tiles, previous);
+        }
+        previous = tiles;
+    }
+    QVERIFY(deltas > 0);
+
+    // Tilting falls back to the full computation
+    QGeoCameraData tilted = cameras.last();
+    tilted.setTilt(30);
+    ct.setCameraData(tilted);
+    ct.createTiles();
+    QVERIFY(!ct.hasTilesDelta());
+}
+
+void tst_QGeoCameraTiles::panBenchmark_data()
+{
+    QTest::addColumn<bool>("incremental");
+    QTest::newRow("full") << false;
+    QTest::newRow("incremental") << true;
+}
+
+/*
+    Cost of the visible tiles over a pan, with a single QGeoCameraTiles as
+    QGeoTiledMap does, or a fresh one per frame which always takes the full
+    path.
+*/
+void tst_QGeoCameraTiles::panBenchmark()
+{
+    QFETCH(bool, incremental);
+
+    const QList<QGeoCameraData> cameras = panSequence(12.0, 100);
+    QGeoCameraTiles ct;
+    ct.setTileSize(256);
+    ct.setScreenSize(QSize(1920, 1080));
+    ct.setPluginString("pluginA");
+
+    int count = 0;
+    QBENCHMARK {
+        for (const QGeoCameraData &camera : cameras) {
+            if (incremental) {
+                ct.setCameraData(camera);
+                count += ct.createTiles().size();
+            } else {
+                QGeoCameraTiles fresh;
+                fresh.setTileSize(256);
+                fresh.setScreenSize(QSize(1920, 1080));
+                fresh.setPluginString("pluginA");
+                fresh.setCameraData(camera);
+                count += fresh.createTiles().size();
+            }
+        }
+    }
+    QVERIFY(count > 0);
+}
+
 void tst_QGeoCameraTiles::tilesPlugin()
 {
     QGeoCameraData camera;
@@ -0,0 +1,1010 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtCore/QString>
+#include <QtCore/QBuffer>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtTest/QtTest>
+
+#include "qgeofiletilecache_p.h"
+#include "qgeotilespec_p.h"
+#include "qgeotilepackstorage_p.h"
+#include "qgeotiledirectoryindex_p.h"
+
+QT_USE_NAMESPACE
+
+static QList<QGeoTileSpec> decodedTiles(const QSignalSpy &spy)
+{
+    QList<QGeoTileSpec> tiles;
+    for (const QList<QVariant> &args : spy)
+        tiles += args.at(0).value<QList<QGeoTileSpec> >();
+    return tiles;
+}
+
+static QByteArray solidTile(const QColor &color)
+{
+    QImage image(8, 8, QImage::Format_ARGB32_Premultiplied);
+    image.fill(color);
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return bytes;
+}
+
+// Serves tiles from a directory outside of the cache, like the OSM offline tiles
+class OfflineTileCache : public QGeoFileTileCache
+{
+public:
+    OfflineTileCache(const QString &directory)
+        : QGeoFileTileCache(directory)
+    {
+    }
+
+    QHash<QGeoTileSpec, QString> offlineTiles;
+
+protected:
+    QString offlineTileFilename(const QGeoTileSpec &spec) const Q_DECL_OVERRIDE
+    {
+        return offlineTiles.value(spec);
+    }
+};
+
+static const QString indexFileName = QStringLiteral("tilecache.index");
+static const QString packFileName = QStringLiteral("tiles.pack");
+
+class tst_QGeoFileTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QGeoFileTileCache();
+
+private:
+    void populate(const QString &directory, int count, const QString &storage = QStringLiteral("files"));
+    QAbstractGeoTileCache *createCache(const QString &directory, const QString &storage = QStringLiteral("files"));
+    QGeoTileSpec spec(int i) const;
+
+private Q_SLOTS:
+    void initTestCase();
+    void indexRoundTrip();
+    void rescanWithoutIndex();
+    void staleIndexEntry();
+    void initTime_data();
+    void initTime();
+    void packRoundTrip();
+    void packTruncatedRecord();
+    void packCompaction();
+    void packChurn();
+    void packCache();
+    void storageInsert_data();
+    void storageInsert();
+    void storageRead_data();
+    void storageRead();
+    void storageEviction_data();
+    void storageEviction();
+    void asyncDecode();
+    void asyncCancel();
+    void asyncStaleEntry();
+    void asyncOfflineTile();
+    void placeholderFromParent();
+    void placeholderFromChildren();
+    void placeholderReplaced();
+    void panFrameTime_data();
+    void panFrameTime();
+    void statisticsTiers();
+    void statisticsEvictions();
+    void statisticsReset();
+    void latencyHistogram();
+    void directoryIndex();
+    void directoryIndexBuildTime_data();
+    void directoryIndexBuildTime();
+
+private:
+    QByteArray m_tileBytes;
+    QByteArray m_largeTileBytes;
+};
+
+tst_QGeoFileTileCache::tst_QGeoFileTileCache()
+{
+}
+
+void tst_QGeoFileTileCache::initTestCase()
+{
+    QImage image(8, 8, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QBuffer buffer(&m_tileBytes);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+
+    // A tile that costs about as much to decode as a real one
+    QImage large(256, 256, QImage::Format_RGB32);
+    for (int y = 0; y < large.height(); ++y)
+        for (int x = 0; x < large.width(); ++x)
+            large.setPixel(x, y, qRgb((x * 7 + y) & 0xff, (x ^ y) & 0xff, (x * y) & 0xff));
+    QBuffer largeBuffer(&m_largeTileBytes);
+    largeBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(large.save(&largeBuffer, "PNG"));
+}
+
+QGeoTileSpec tst_QGeoFileTileCache::spec(int i) const
+{
+    return QGeoTileSpec(QStringLiteral("test"), 1, 16, i % 1024, i / 1024);
+}
+
+QAbstractGeoTileCache *tst_QGeoFileTileCache::createCache(const QString &directory, const QString &storage)
+{
+    QGeoFileTileCache *cache = new QGeoFileTileCache(directory);
+    cache->setDiskStorage(QGeoTileDiskStorage::create(storage));
+    cache->init();
+    return cache;
+}
+
+void tst_QGeoFileTileCache::populate(const QString &directory, int count, const QString &storage)
+{
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(directory, storage));
+    cache->setMaxDiskUsage(count * m_tileBytes.size());
+    for (int i = 0; i < count; ++i)
+        cache->insert(spec(i), m_tileBytes, QStringLiteral("png"), QAbstractGeoTileCache::DiskCache);
+    QCOMPARE(cache->diskUsage(), count * m_tileBytes.size());
+}
+
+void tst_QGeoFileTileCache::indexRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 100);
+    QVERIFY(QFile::exists(QDir(dir.path()).filePath(indexFileName)));
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    // restored synchronously, and invalidated until the next clean shutdown
+    QCOMPARE(cache->diskUsage(), 100 * m_tileBytes.size());
+    QVERIFY(!QFile::exists(QDir(dir.path()).filePath(indexFileName)));
+
+    QSharedPointer<QGeoTileTexture> tex = cache->get(spec(42));
+    QVERIFY(!tex.isNull());
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+
+    cache.reset();
+    QVERIFY(QFile::exists(QDir(dir.path()).filePath(indexFileName)));
+}
+
+void tst_QGeoFileTileCache::rescanWithoutIndex()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 100);
+    QVERIFY(QFile::remove(QDir(dir.path()).filePath(indexFileName)));
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QTRY_COMPARE(cache->diskUsage(), 100 * m_tileBytes.size());
+    QVERIFY(!cache->get(spec(7)).isNull());
+}
+
+void tst_QGeoFileTileCache::staleIndexEntry()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 10);
+    const QString removed = QGeoFileTileCache::tileSpecToFilenameDefault(spec(3), QStringLiteral("png"), dir.path());
+    QVERIFY(QFile::remove(removed));
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QCOMPARE(cache->diskUsage(), 10 * m_tileBytes.size());
+    QVERIFY(cache->get(spec(3)).isNull());
+    QCOMPARE(cache->diskUsage(), 9 * m_tileBytes.size());
+}
+
+void tst_QGeoFileTileCache::initTime_data()
+{
+    QTest::addColumn<int>("tiles");
+    QTest::addColumn<bool>("useIndex");
+    QTest::newRow("1000 tiles, index") << 1000 << true;
+    QTest::newRow("1000 tiles, rescan") << 1000 << false;
+    QTest::newRow("20000 tiles, index") << 20000 << true;
+    QTest::newRow("20000 tiles, rescan") << 20000 << false;
+}
+
+void tst_QGeoFileTileCache::initTime()
+{
+    QFETCH(int, tiles);
+    QFETCH(bool, useIndex);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), tiles);
+    const QString indexPath = QDir(dir.path()).filePath(indexFileName);
+
+    QBENCHMARK {
+        if (!useIndex)
+            QFile::remove(indexPath);
+        QScopedPointer<QAbstractGeoTileCache> cache(new QGeoFileTileCache(dir.path()));
+        cache->setMaxDiskUsage(tiles * m_tileBytes.size());
+        cache->init();
+        QTRY_COMPARE(cache->diskUsage(), tiles * m_tileBytes.size());
+    }
+}
+
+void tst_QGeoFileTileCache::packRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QDir d(dir.path());
+
+    {
+        QGeoTilePackStorage storage;
+        QVERIFY(storage.open(dir.path()));
+        QVERIFY(storage.write(d.filePath("a"), QByteArray("first")));
+        QVERIFY(storage.write(d.filePath("b"), QByteArray("second")));
+        QVERIFY(storage.write(d.filePath("c"), QByteArray("third")));
+        QVERIFY(storage.write(d.filePath("a"), QByteArray("replaced")));
+        storage.remove(d.filePath("b"));
+        QCOMPARE(storage.size(d.filePath("a")), qint64(8));
+        QCOMPARE(storage.size(d.filePath("b")), qint64(0));
+    }
+
+    QGeoTilePackStorage storage;
+    QVERIFY(storage.open(dir.path()));
+    QByteArray bytes;
+    QVERIFY(storage.read(d.filePath("a"), &bytes));
+    QCOMPARE(bytes, QByteArray("replaced"));
+    QVERIFY(!storage.read(d.filePath("b"), &bytes));
+    QVERIFY(storage.read(d.filePath("c"), &bytes));
+    QCOMPARE(bytes, QByteArray("third"));
+
+    QVector<QGeoTileDiskStorage::Entry> entries;
+    QVERIFY(storage.list(&entries, true));
+    QCOMPARE(entries.size(), 2);
+
+    storage.clear();
+    entries.clear();
+    QVERIFY(storage.list(&entries, false));
+    QVERIFY(entries.isEmpty());
+}
+
+void tst_QGeoFileTileCache::packTruncatedRecord()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QDir d(dir.path());
+    qint64 validSize = 0;
+
+    {
+        QGeoTilePackStorage storage;
+        QVERIFY(storage.open(dir.path()));
+        QVERIFY(storage.write(d.filePath("a"), QByteArray("indexed")));
+        storage.sync();
+        QVERIFY(storage.write(d.filePath("b"), QByteArray("appended")));
+    }
+
+    {
+        // simulate a crash in the middle of an append
+        QFile pack(d.filePath(packFileName));
+        QVERIFY(pack.open(QIODevice::ReadWrite | QIODevice::Append));
+        validSize = pack.size();
+        QDataStream out(&pack);
+        out << quint32(1) << quint32(1000) << qint64(0);
+        pack.write("c");
+        pack.write("partial");
+    }
+
+    QGeoTilePackStorage storage;
+    QVERIFY(storage.open(dir.path()));
+    QByteArray bytes;
+    QVERIFY(storage.read(d.filePath("a"), &bytes));
+    QCOMPARE(bytes, QByteArray("indexed"));
+    QVERIFY(storage.read(d.filePath("b"), &bytes));
+    QCOMPARE(bytes, QByteArray("appended"));
+    QVERIFY(!storage.read(d.filePath("c"), &bytes));
+    QCOMPARE(QFileInfo(d.filePath(packFileName)).size(), validSize);
+}
+
+void tst_QGeoFileTileCache::packCompaction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QDir d(dir.path());
+
+    QGeoTilePackStorage storage;
+    QVERIFY(storage.open(dir.path()));
+    const QByteArray payload(1024, 'x');
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(storage.write(d.filePath(QString::number(i)), payload));
+    for (int i = 0; i < 100; i += 2)
+        storage.remove(d.filePath(QString::number(i)));
+    QVERIFY(storage.deadBytes() > storage.liveBytes() / 2);
+
+    const qint64 live = storage.liveBytes();
+    QVERIFY(storage.compact());
+    QCOMPARE(storage.deadBytes(), qint64(0));
+    QCOMPARE(storage.liveBytes(), live);
+
+    QByteArray bytes;
+    QVERIFY(!storage.read(d.filePath("0"), &bytes));
+    QVERIFY(storage.read(d.filePath("99"), &bytes));
+    QCOMPARE(bytes, payload);
+}
+
+// Overwriting and removing tiles for far longer than the compaction
+// threshold never lets the pack grow past twice its live size
+void tst_QGeoFileTileCache::packChurn()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QDir d(dir.path());
+    const QString pack = d.filePath(QStringLiteral("tiles.pack"));
+
+    QGeoTilePackStorage storage;
+    QVERIFY(storage.open(dir.path()));
+    const QByteArray payload(16 * 1024, 'x');
+    const qint64 budget = 1024 * 1024;
+    qint64 largest = 0;
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 64; ++i) {
+            const QString name = d.filePath(QString::number(i));
+            if ((i + round) % 3 == 0)
+                storage.remove(name);
+            else
+                QVERIFY(storage.write(name, payload));
+            const qint64 live = storage.liveBytes();
+            const qint64 size = QFileInfo(pack).size();
+            QVERIFY2(size <= 12 + live + qMax(live, budget) + payload.size() + 64,
+                     qPrintable(QStringLiteral("pack is %1 bytes for %2 live").arg(size).arg(live)));
+            largest = qMax(largest, size);
+        }
+    }
+    // About 14 MB went through the pack
+    QVERIFY(largest < 4 * budget);
+    QVERIFY(storage.deadBytes() <= qMax(storage.liveBytes(), budget));
+
+    QByteArray bytes;
+    QVERIFY(storage.read(d.filePath("1"), &bytes));
+    QCOMPARE(bytes, payload);
+}
+
+void tst_QGeoFileTileCache::packCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 100, QStringLiteral("pack"));
+    QVERIFY(QFile::exists(QDir(dir.path()).filePath(packFileName)));
+    QVERIFY(!QFile::exists(QGeoFileTileCache::tileSpecToFilenameDefault(spec(0), QStringLiteral("png"), dir.path())));
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path(), QStringLiteral("pack")));
+    QCOMPARE(cache->diskUsage(), 100 * m_tileBytes.size());
+    QSharedPointer<QGeoTileTexture> tex = cache->get(spec(42));
+    QVERIFY(!tex.isNull());
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+
+    // the index-less path goes through the storage listing as well
+    cache.reset();
+    QVERIFY(QFile::remove(QDir(dir.path()).filePath(indexFileName)));
+    cache.reset(createCache(dir.path(), QStringLiteral("pack")));
+    QTRY_COMPARE(cache->diskUsage(), 100 * m_tileBytes.size());
+    QVERIFY(!cache->get(spec(7)).isNull());
+
+    cache->clearAll();
+    QCOMPARE(cache->diskUsage(), 0);
+    QVERIFY(cache->get(spec(7)).isNull());
+}
+
+static void addStorageRows()
+{
+    QTest::addColumn<QString>("storage");
+    QTest::newRow("files") << QStringLiteral("files");
+    QTest::newRow("pack") << QStringLiteral("pack");
+#if QT_CONFIG(sharedmemory)
+    QTest::newRow("shared") << QStringLiteral("shared");
+#endif
+}
+
+void tst_QGeoFileTileCache::storageInsert_data()
+{
+    addStorageRows();
+}
+
+void tst_QGeoFileTileCache::storageInsert()
+{
+    QFETCH(QString, storage);
+    const int tiles = 2000;
+
+    QBENCHMARK {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        populate(dir.path(), tiles, storage);
+    }
+}
+
+void tst_QGeoFileTileCache::storageRead_data()
+{
+    addStorageRows();
+}
+
+void tst_QGeoFileTileCache::storageRead()
+{
+    QFETCH(QString, storage);
+    const int tiles = 2000;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), tiles, storage);
+    QScopedPointer<QGeoTileDiskStorage> s(QGeoTileDiskStorage::create(storage));
+    QVERIFY(s->open(dir.path()));
+
+    QVector<QString> names;
+    for (int i = 0; i < tiles; ++i)
+        names.append(QGeoFileTileCache::tileSpecToFilenameDefault(spec((i * 7919) % tiles), QStringLiteral("png"), dir.path()));
+
+    QBENCHMARK {
+        QByteArray bytes;
+        for (const QString &name : qAsConst(names))
+            QVERIFY(s->read(name, &bytes));
+    }
+}
+
+void tst_QGeoFileTileCache::storageEviction_data()
+{
+    addStorageRows();
+}
+
+void tst_QGeoFileTileCache::storageEviction()
+{
+    QFETCH(QString, storage);
+    const int tiles = 500;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path(), storage));
+    cache->setMaxDiskUsage(tiles * m_tileBytes.size());
+
+    // every insert past the first round evicts one tile
+    int i = 0;
+    QBENCHMARK {
+        for (int n = 0; n < tiles; ++n, ++i)
+            cache->insert(spec(i), m_tileBytes, QStringLiteral("png"), QAbstractGeoTileCache::DiskCache);
+    }
+    QVERIFY(cache->diskUsage() <= tiles * m_tileBytes.size());
+}
+
+void tst_QGeoFileTileCache::asyncDecode()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 10);
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QSignalSpy spy(cache.data(), &QAbstractGeoTileCache::tilesDecoded);
+
+    bool pending = false;
+    QVERIFY(cache->getAsync(spec(1), &pending).isNull());
+    QVERIFY(pending);
+    QVERIFY(cache->getAsync(spec(2), &pending).isNull());
+    QVERIFY(pending);
+    // not cached at all
+    QVERIFY(cache->getAsync(spec(100), &pending).isNull());
+    QVERIFY(!pending);
+
+    QTRY_COMPARE(decodedTiles(spy).size(), 2);
+    const QList<QGeoTileSpec> decoded = decodedTiles(spy);
+    QVERIFY(decoded.contains(spec(1)));
+    QVERIFY(decoded.contains(spec(2)));
+
+    // now served straight from the texture cache
+    QSharedPointer<QGeoTileTexture> tex = cache->getAsync(spec(1), &pending);
+    QVERIFY(!pending);
+    QVERIFY(!tex.isNull());
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+}
+
+void tst_QGeoFileTileCache::asyncCancel()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 10);
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QSignalSpy spy(cache.data(), &QAbstractGeoTileCache::tilesDecoded);
+
+    bool pending = false;
+    cache->getAsync(spec(3), &pending);
+    QVERIFY(pending);
+    cache->getAsync(spec(4), &pending);
+    QVERIFY(pending);
+    cache->cancelAsync(spec(3));
+
+    QTRY_VERIFY(!spy.isEmpty());
+    QTest::qWait(50);
+    QCOMPARE(decodedTiles(spy), QList<QGeoTileSpec>() << spec(4));
+
+    // a cancelled tile can be looked up again
+    cache->getAsync(spec(3), &pending);
+    QVERIFY(pending);
+}
+
+void tst_QGeoFileTileCache::asyncStaleEntry()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 10);
+    QVERIFY(QFile::remove(QGeoFileTileCache::tileSpecToFilenameDefault(spec(5), QStringLiteral("png"), dir.path())));
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QSignalSpy spy(cache.data(), &QAbstractGeoTileCache::tilesDecoded);
+
+    bool pending = false;
+    cache->getAsync(spec(5), &pending);
+    QVERIFY(pending);
+    QTRY_COMPARE(spy.count(), 1);
+    QVERIFY(spy.at(0).at(0).value<QList<QGeoTileSpec> >().isEmpty());
+    QCOMPARE(spy.at(0).at(1).value<QList<QGeoTileSpec> >(), QList<QGeoTileSpec>() << spec(5));
+    QCOMPARE(cache->diskUsage(), 9 * m_tileBytes.size());
+}
+
+void tst_QGeoFileTileCache::asyncOfflineTile()
+{
+    QTemporaryDir cacheDir;
+    QTemporaryDir offlineDir;
+    QVERIFY(cacheDir.isValid());
+    QVERIFY(offlineDir.isValid());
+
+    // The tile exists only in the offline directory, never in the cache
+    const QString fileName = offlineDir.path() + QStringLiteral("/offline.png");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(m_tileBytes);
+    file.close();
+
+    OfflineTileCache *offlineCache = new OfflineTileCache(cacheDir.path());
+    offlineCache->offlineTiles.insert(spec(7), fileName);
+    QScopedPointer<QAbstractGeoTileCache> cache(offlineCache);
+    cache->init();
+    QSignalSpy spy(cache.data(), &QAbstractGeoTileCache::tilesDecoded);
+
+    // Found without fetching: the request manager only fetches tiles that
+    // are neither returned nor pending
+    QVERIFY(cache->isCached(spec(7), QAbstractGeoTileCache::DiskCache));
+    bool pending = false;
+    QVERIFY(cache->getAsync(spec(7), &pending).isNull());
+    QVERIFY(pending);
+    QVERIFY(cache->getAsync(spec(8), &pending).isNull());
+    QVERIFY(!pending);
+
+    QTRY_COMPARE(decodedTiles(spy), QList<QGeoTileSpec>() << spec(7));
+    QSharedPointer<QGeoTileTexture> tex = cache->getAsync(spec(7), &pending);
+    QVERIFY(!pending);
+    QVERIFY(!tex.isNull());
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+    // not copied into the disk cache
+    QCOMPARE(cache->diskUsage(), 0);
+
+    // The synchronous lookup finds it as well
+    OfflineTileCache *syncCache = new OfflineTileCache(cacheDir.path());
+    syncCache->offlineTiles.insert(spec(7), fileName);
+    QScopedPointer<QAbstractGeoTileCache> other(syncCache);
+    other->init();
+    tex = other->get(spec(7));
+    QVERIFY(!tex.isNull());
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+}
+
+void tst_QGeoFileTileCache::placeholderFromParent()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+
+    // Left half red, right half blue, two levels above the tile
+    QImage image(8, 8, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    for (int y = 0; y < 8; ++y)
+        for (int x = 4; x < 8; ++x)
+            image.setPixel(x, y, qRgb(0, 0, 255));
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+
+    const QGeoTileSpec ancestor(QStringLiteral("test"), 1, 8, 10, 20);
+    cache->insert(ancestor, bytes, QStringLiteral("png"));
+    // Only decoded textures are used
+    QVERIFY(cache->placeholder(QGeoTileSpec(QStringLiteral("test"), 1, 10, 43, 80)).isNull());
+    QVERIFY(cache->get(ancestor));
+
+    const QGeoTileSpec tile(QStringLiteral("test"), 1, 10, 43, 80); // right half of the ancestor
+    QSharedPointer<QGeoTileTexture> tex = cache->placeholder(tile);
+    QVERIFY(tex);
+    QVERIFY(tex->provisional);
+    QCOMPARE(tex->spec, tile);
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+    QCOMPARE(tex->image.pixel(4, 4), qRgb(0, 0, 255));
+
+    // Kept, but not mistaken for the tile itself
+    QCOMPARE(cache->placeholder(tile), tex);
+    bool pending = true;
+    QVERIFY(cache->getAsync(tile, &pending).isNull());
+    QVERIFY(!pending);
+    QVERIFY(cache->get(tile).isNull());
+    QVERIFY(!cache->isCached(tile));
+
+    // Too far from the ancestor
+    QVERIFY(cache->placeholder(QGeoTileSpec(QStringLiteral("test"), 1, 13, 320, 640)).isNull());
+}
+
+void tst_QGeoFileTileCache::placeholderFromChildren()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+
+    const QColor colors[4] = { Qt::red, Qt::green, Qt::blue, Qt::yellow };
+    const QGeoTileSpec tile(QStringLiteral("test"), 1, 10, 7, 9);
+    for (int i = 0; i < 3; ++i) {
+        const QGeoTileSpec child(QStringLiteral("test"), 1, 11, 14 + (i & 1), 18 + (i >> 1));
+        cache->insert(child, solidTile(colors[i]), QStringLiteral("png"));
+        QVERIFY(cache->get(child));
+    }
+    // Three children and no ancestor would leave a hole
+    QVERIFY(cache->placeholder(tile).isNull());
+
+    const QGeoTileSpec last(QStringLiteral("test"), 1, 11, 15, 19);
+    cache->insert(last, solidTile(colors[3]), QStringLiteral("png"));
+    QVERIFY(cache->get(last));
+
+    QSharedPointer<QGeoTileTexture> tex = cache->placeholder(tile);
+    QVERIFY(tex);
+    QVERIFY(tex->provisional);
+    QCOMPARE(tex->image.size(), QSize(8, 8));
+    QCOMPARE(QColor(tex->image.pixel(1, 1)), colors[0]);
+    QCOMPARE(QColor(tex->image.pixel(6, 1)), colors[1]);
+    QCOMPARE(QColor(tex->image.pixel(1, 6)), colors[2]);
+    QCOMPARE(QColor(tex->image.pixel(6, 6)), colors[3]);
+}
+
+void tst_QGeoFileTileCache::placeholderReplaced()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+
+    const QGeoTileSpec parent(QStringLiteral("test"), 1, 5, 1, 1);
+    const QGeoTileSpec tile(QStringLiteral("test"), 1, 6, 2, 3);
+    cache->insert(parent, solidTile(Qt::red), QStringLiteral("png"));
+    QVERIFY(cache->get(parent));
+    QSharedPointer<QGeoTileTexture> placeholder = cache->placeholder(tile);
+    QVERIFY(placeholder);
+
+    cache->insert(tile, solidTile(Qt::blue), QStringLiteral("png"));
+    QSharedPointer<QGeoTileTexture> tex = cache->get(tile);
+    QVERIFY(tex);
+    QVERIFY(!tex->provisional);
+    QCOMPARE(QColor(tex->image.pixel(4, 4)), QColor(Qt::blue));
+    QCOMPARE(cache->placeholder(tile), tex);
+}
+
+void tst_QGeoFileTileCache::panFrameTime_data()
+{
+    QTest::addColumn<bool>("async");
+    QTest::newRow("sync") << false;
+    QTest::newRow("async") << true;
+}
+
+/*
+    Pans a 5x4 tile viewport one column per frame over a warm disk cache and
+    reports the time spent in the worst frame looking up the tiles that just
+    became visible, which is what the GUI thread pays for during a fast pan.
+*/
+void tst_QGeoFileTileCache::panFrameTime()
+{
+    QFETCH(bool, async);
+    const int columns = 64;
+    const int rows = 4;
+    const int viewColumns = 5;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+        cache->setMaxDiskUsage(columns * rows * m_largeTileBytes.size());
+        for (int x = 0; x < columns; ++x)
+            for (int y = 0; y < rows; ++y)
+                cache->insert(QGeoTileSpec(QStringLiteral("test"), 1, 10, x, y), m_largeTileBytes,
+                              QStringLiteral("png"), QAbstractGeoTileCache::DiskCache);
+    }
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QSignalSpy spy(cache.data(), &QAbstractGeoTileCache::tilesDecoded);
+    QElapsedTimer timer;
+    qint64 worstFrame = 0;
+    int pendingTiles = 0;
+    for (int frame = 0; frame + viewColumns <= columns; ++frame) {
+        timer.start();
+        // the first frame sees the whole viewport, the next ones a single new column
+        for (int x = frame == 0 ? 0 : frame + viewColumns - 1; x < frame + viewColumns; ++x) {
+            for (int y = 0; y < rows; ++y) {
+                const QGeoTileSpec tile(QStringLiteral("test"), 1, 10, x, y);
+                if (async) {
+                    bool pending = false;
+                    cache->getAsync(tile, &pending);
+                    pendingTiles += pending;
+                } else {
+                    QVERIFY(!cache->get(tile).isNull());
+                }
+            }
+        }
+        worstFrame = qMax(worstFrame, timer.nsecsElapsed());
+        // ~60 fps, and lets deliveries in
+        QTest::qWait(16);
+    }
+
+    if (async)
+        QTRY_COMPARE_WITH_TIMEOUT(decodedTiles(spy).size(), pendingTiles, 10000);
+
+    QTest::setBenchmarkResult(worstFrame / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+void tst_QGeoFileTileCache::statisticsTiers()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 10);
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    cache->resetStatistics();
+
+    // cold: misses the texture and memory tiers, decoded from disk
+    QVERIFY(!cache->get(spec(1)).isNull());
+    QGeoTileCacheStatistics stats = cache->statistics();
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::TextureTier].misses, quint64(1));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::MemoryTier].misses, quint64(1));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::DiskTier].hits, quint64(1));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::DiskTier].bytesOut, quint64(m_tileBytes.size()));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::MemoryTier].bytesIn, quint64(m_tileBytes.size()));
+    QVERIFY(stats.tiers[QGeoTileCacheStatistics::TextureTier].bytesIn > 0);
+    QCOMPARE(stats.decodeTime.count(), quint64(1));
+
+    // warm: served from the texture tier without decoding
+    QVERIFY(!cache->get(spec(1)).isNull());
+    stats = cache->statistics();
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::TextureTier].hits, quint64(1));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::TextureTier].bytesOut,
+             stats.tiers[QGeoTileCacheStatistics::TextureTier].bytesIn);
+    QCOMPARE(stats.decodeTime.count(), quint64(1));
+
+    // not cached anywhere
+    QVERIFY(cache->get(spec(100)).isNull());
+    stats = cache->statistics();
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::TextureTier].misses, quint64(2));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::MemoryTier].misses, quint64(2));
+    QCOMPARE(stats.tiers[QGeoTileCacheStatistics::DiskTier].misses, quint64(1));
+
+    const QVariantMap map = stats.toVariantMap();
+    QCOMPARE(map.value(QStringLiteral("texture")).toMap().value(QStringLiteral("hits")).toULongLong(), quint64(1));
+    QCOMPARE(map.value(QStringLiteral("decodeTime")).toMap().value(QStringLiteral("count")).toULongLong(), quint64(1));
+    QVERIFY(!stats.toString().isEmpty());
+}
+
+void tst_QGeoFileTileCache::statisticsEvictions()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const int tiles = 10;
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    cache->setMaxDiskUsage(tiles * m_tileBytes.size());
+    cache->resetStatistics();
+    for (int i = 0; i < 2 * tiles; ++i)
+        cache->insert(spec(i), m_tileBytes, QStringLiteral("png"), QAbstractGeoTileCache::DiskCache);
+
+    const QGeoTileCacheStatistics stats = cache->statistics();
+    const QGeoTileCacheStatistics::TierCounters &disk = stats.tiers[QGeoTileCacheStatistics::DiskTier];
+    QCOMPARE(disk.bytesIn, quint64(2 * tiles * m_tileBytes.size()));
+    QCOMPARE(disk.evictions, quint64(tiles));
+    QVERIFY(disk.cost <= disk.maxCost);
+}
+
+void tst_QGeoFileTileCache::statisticsReset()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    populate(dir.path(), 10);
+
+    QScopedPointer<QAbstractGeoTileCache> cache(createCache(dir.path()));
+    QSignalSpy spy(cache.data(), &QAbstractGeoTileCache::statisticsChanged);
+    QVERIFY(!cache->get(spec(1)).isNull());
+    cache->recordFetchTime(1500);
+    QCOMPARE(cache->statistics().fetchTime.count(), quint64(1));
+
+    // notifications are coalesced
+    QTRY_COMPARE(spy.count(), 1);
+
+    cache->resetStatistics();
+    const QGeoTileCacheStatistics stats = cache->statistics();
+    for (int i = 0; i < QGeoTileCacheStatistics::TierCount; ++i) {
+        QCOMPARE(stats.tiers[i].hits, quint64(0));
+        QCOMPARE(stats.tiers[i].misses, quint64(0));
+        QCOMPARE(stats.tiers[i].bytesOut, quint64(0));
+    }
+    QCOMPARE(stats.decodeTime.count(), quint64(0));
+    QCOMPARE(stats.fetchTime.count(), quint64(0));
+    // the cached tile itself is still there
+    QVERIFY(stats.tiers[QGeoTileCacheStatistics::DiskTier].cost > 0);
+}
+
+void tst_QGeoFileTileCache::latencyHistogram()
+{
+    QGeoTileLatencyHistogram histogram;
+    QCOMPARE(histogram.percentileUsecs(0.5), qint64(0));
+
+    // 90 fast samples and 10 slow ones
+    for (int i = 0; i < 90; ++i)
+        histogram.add(100);
+    for (int i = 0; i < 10; ++i)
+        histogram.add(50000);
+
+    QCOMPARE(histogram.count(), quint64(100));
+    QCOMPARE(histogram.maxUsecs(), qint64(50000));
+    QCOMPARE(histogram.totalUsecs(), qint64(90 * 100 + 10 * 50000));
+    // percentiles are reported as the upper bound of their bucket
+    QCOMPARE(histogram.percentileUsecs(0.5), qint64(128));
+    QCOMPARE(histogram.percentileUsecs(0.9), qint64(128));
+    QCOMPARE(histogram.percentileUsecs(0.95), qint64(50000));
+    QCOMPARE(histogram.percentileUsecs(1.0), qint64(50000));
+
+    quint64 total = 0;
+    for (int i = 0; i < QGeoTileLatencyHistogram::BucketCount; ++i)
+        total += histogram.bucket(i);
+    QCOMPARE(total, histogram.count());
+
+    // out of range samples land in the end buckets
+    histogram.clear();
+    histogram.add(-5);
+    histogram.add(qint64(1) << 40);
+    QCOMPARE(histogram.bucket(0), quint64(1));
+    QCOMPARE(histogram.bucket(QGeoTileLatencyHistogram::BucketCount - 1), quint64(1));
+}
+
+static bool writeFile(const QString &path, const QByteArray &bytes)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size();
+}
+
+void tst_QGeoFileTileCache::directoryIndex()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    const QString indexFile = QDir(cacheDir.path()).filePath(QStringLiteral("offline.index"));
+    const QDir root(dir.path());
+    QVERIFY(root.mkpath(QStringLiteral("a")));
+    QVERIFY(root.mkpath(QStringLiteral("b/c")));
+
+    // The same tile in two places, the one in b/c is newer
+    const QString older = root.filePath(QStringLiteral("a/osm-l-1-2-1-1.png"));
+    const QString newer = root.filePath(QStringLiteral("b/c/osm-l-1-2-1-1.png"));
+    QVERIFY(writeFile(older, m_tileBytes));
+    QVERIFY(writeFile(newer, m_tileBytes));
+    {
+        QFile file(older);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(QDateTime::currentDateTime().addDays(-1), QFileDevice::FileModificationTime));
+    }
+    QVERIFY(writeFile(root.filePath(QStringLiteral("a/osm-l-1-2-0-1.png")), m_tileBytes));
+    QVERIFY(writeFile(root.filePath(QStringLiteral("a/README")), QByteArray("no tile")));
+
+    QGeoTileDirectoryIndex index;
+    QVERIFY(index.build(dir.path(), indexFile));
+    QVERIFY(!index.isLoaded());
+    QCOMPARE(index.entries().size(), 2);
+    QHash<QString, QString> paths;
+    for (const QGeoTileDirectoryIndex::Entry &entry : index.entries())
+        paths.insert(entry.fileName, entry.filePath);
+    QCOMPARE(paths.value(QStringLiteral("osm-l-1-2-1-1.png")), newer);
+    QVERIFY(QFile::exists(indexFile));
+
+    // Unchanged tree: the persisted index is used
+    QGeoTileDirectoryIndex warm;
+    QVERIFY(warm.build(dir.path(), indexFile));
+    QVERIFY(warm.isLoaded());
+    QCOMPARE(warm.entries().size(), 2);
+
+    // Another directory does not reuse it
+    QTemporaryDir otherDir;
+    QVERIFY(otherDir.isValid());
+    QGeoTileDirectoryIndex other;
+    QVERIFY(!other.load(otherDir.path(), indexFile));
+
+    // A new file changes the time of its directory
+    QTest::qWait(20);
+    QVERIFY(writeFile(root.filePath(QStringLiteral("b/c/osm-l-1-2-2-1.png")), m_tileBytes));
+    QGeoTileDirectoryIndex changed;
+    QVERIFY(!changed.load(dir.path(), indexFile));
+    QVERIFY(changed.build(dir.path(), indexFile));
+    QCOMPARE(changed.entries().size(), 3);
+
+    // So does a new directory
+    QTest::qWait(20);
+    QVERIFY(root.mkpath(QStringLiteral("b/c/d")));
+    QVERIFY(!QGeoTileDirectoryIndex().load(dir.path(), indexFile));
+
+    // Canceled scans report it
+    QAtomicInt cancel(1);
+    QVERIFY(!QGeoTileDirectoryIndex().scan(dir.path(), &cancel));
+}
+
+void tst_QGeoFileTileCache::directoryIndexBuildTime_data()
+{
+    QTest::addColumn<int>("tiles");
+    QTest::addColumn<bool>("warm");
+    QTest::newRow("5000 tiles, cold") << 5000 << false;
+    QTest::newRow("5000 tiles, warm") << 5000 << true;
+    QTest::newRow("20000 tiles, cold") << 20000 << false;
+    QTest::newRow("20000 tiles, warm") << 20000 << true;
+}
+
+/*
+    Time to list an offline tile directory laid out as zoom/x/y, from
+    scratch (cold) or from the index persisted by an earlier run (warm).
+*/
+void tst_QGeoFileTileCache::directoryIndexBuildTime()
+{
+    QFETCH(int, tiles);
+    QFETCH(bool, warm);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    const QString indexFile = QDir(cacheDir.path()).filePath(QStringLiteral("offline.index"));
+    const QDir root(dir.path());
+    const int perDirectory = 100;
+    for (int i = 0; i < tiles; ++i) {
+        const QString subdir = QStringLiteral("16/%1").arg(i / perDirectory);
+        if (i % perDirectory == 0)
+            QVERIFY(root.mkpath(subdir));
+        const QString name = QStringLiteral("osm-l-1-16-%1-%2.png").arg(i / perDirectory).arg(i % perDirectory);
+        QVERIFY(writeFile(root.filePath(subdir + QLatin1Char('/') + name), m_tileBytes));
+    }
+    if (warm)
+        QVERIFY(QGeoTileDirectoryIndex().build(dir.path(), indexFile));
+
+    QBENCHMARK {
+        if (!warm)
+            QFile::remove(indexFile);
+        QGeoTileDirectoryIndex index;
+        QVERIFY(index.build(dir.path(), indexFile));
+        QCOMPARE(index.isLoaded(), warm);
+        QCOMPARE(index.entries().size(), tiles);
+    }
+}
+
+QTEST_MAIN(tst_QGeoFileTileCache)
+
+#include "tst_qgeofiletilecache.moc"
@@ -0,0 +1,7 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeomapitemindex
+
+SOURCES += tst_qgeomapitemindex.cpp
+
+QT += location-private testlib
@@ -0,0 +1,259 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtLocation/private/qgeomapitemindex_p.h>
+
+#include <algorithm>
+
+QT_USE_NAMESPACE
+
+typedef QVector<QDeclarativeGeoMapItemBase *> Items;
+
+class tst_QGeoMapItemIndex : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void insertRemove_data();
+    void insertRemove();
+    void update();
+    void drain();
+    void touchingEdges();
+
+private:
+    QRectF randomRect();
+    void verifyIndex(const QGeoMapItemIndex &index, const QHash<QDeclarativeGeoMapItemBase *, QRectF> &reference);
+
+    QRandomGenerator m_random;
+};
+
+// The index only stores the pointers, never dereferences them
+static QDeclarativeGeoMapItemBase *fakeItem(int i)
+{
+    return reinterpret_cast<QDeclarativeGeoMapItemBase *>(quintptr(i + 1) * 8);
+}
+
+static bool touches(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right()
+            && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+/*
+    Mostly small items clustered like map content, with some points, lines,
+    large items, and items past the dateline at x > 1.
+*/
+QRectF tst_QGeoMapItemIndex::randomRect()
+{
+    const double x = m_random.generateDouble();
+    const double y = m_random.generateDouble();
+    switch (m_random.bounded(8)) {
+    case 0:
+        return QRectF(x, y, 0.0, 0.0);
+    case 1:
+        return QRectF(x, y, 0.01 * m_random.generateDouble(), 0.0);
+    case 2:
+        return QRectF(x, y, 0.3 * m_random.generateDouble(), 0.3 * m_random.generateDouble());
+    case 3:
+        return QRectF(0.95 + 0.05 * x, y, 0.1 * m_random.generateDouble(), 0.01);
+    default:
+        return QRectF(0.5 + 0.1 * x, 0.5 + 0.1 * y,
+                      0.005 * m_random.generateDouble(), 0.005 * m_random.generateDouble());
+    }
+}
+
+/*
+    Compares intersecting() with a brute force scan of the reference, for a
+    few random queries, and checks the item to leaf mapping through bounds().
+*/
+void tst_QGeoMapItemIndex::verifyIndex(const QGeoMapItemIndex &index,
+                                       const QHash<QDeclarativeGeoMapItemBase *, QRectF> &reference)
+{
+    QCOMPARE(index.size(), reference.size());
+
+    QVector<QRectF> queries;
+    queries << QRectF(0.0, 0.0, 2.0, 1.0) << QRectF(0.55, 0.55, 0.0, 0.0);
+    for (int i = 0; i < 3; ++i)
+        queries << randomRect();
+    for (const QRectF &query : qAsConst(queries)) {
+        Items found;
+        index.intersecting(query, found);
+        Items expected;
+        for (auto it = reference.constBegin(); it != reference.constEnd(); ++it) {
+            if (touches(it.value(), query))
+                expected.append(it.key());
+        }
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        QCOMPARE(found, expected);
+    }
+}
+
+void tst_QGeoMapItemIndex::insertRemove_data()
+{
+    QTest::addColumn<quint32>("seed");
+    QTest::addColumn<int>("operations");
+
+    QTest::newRow("1") << quint32(1) << 4000;
+    QTest::newRow("2") << quint32(2) << 4000;
+    QTest::newRow("3") << quint32(3) << 4000;
+}
+
+/*
+    Random inserts and removals, weighted to grow the tree to a few thousand
+    items first, then to shrink it, which goes through leaf and inner node
+    splits, underfull nodes being reinserted and the root collapsing.
+*/
+void tst_QGeoMapItemIndex::insertRemove()
+{
+    QFETCH(quint32, seed);
+    QFETCH(int, operations);
+    m_random.seed(seed);
+
+    QGeoMapItemIndex index;
+    QHash<QDeclarativeGeoMapItemBase *, QRectF> reference;
+    QVector<QDeclarativeGeoMapItemBase *> present;
+    int next = 0;
+    for (int i = 0; i < operations; ++i) {
+        const bool growing = i < operations / 2;
+        if (present.isEmpty() || m_random.bounded(10) < (growing ? 8 : 2)) {
+            QDeclarativeGeoMapItemBase *item = fakeItem(next++);
+            const QRectF bounds = randomRect();
+            index.insert(item, bounds);
+            reference.insert(item, bounds);
+            present.append(item);
+        } else {
+            const int at = m_random.bounded(present.size());
+            QDeclarativeGeoMapItemBase *item = present.at(at);
+            present[at] = present.last();
+            present.removeLast();
+            index.remove(item);
+            reference.remove(item);
+            QVERIFY(!index.contains(item));
+        }
+
+        verifyIndex(index, reference);
+        if (QTest::currentTestFailed())
+            return;
+        for (int j = 0; j < 3 && !present.isEmpty(); ++j) {
+            QDeclarativeGeoMapItemBase *item = present.at(m_random.bounded(present.size()));
+            QVERIFY(index.contains(item));
+            QCOMPARE(index.bounds(item), reference.value(item));
+        }
+    }
+}
+
+// Inserting an item again moves it
+void tst_QGeoMapItemIndex::update()
+{
+    m_random.seed(4);
+    QGeoMapItemIndex index;
+    QHash<QDeclarativeGeoMapItemBase *, QRectF> reference;
+    for (int i = 0; i < 2000; ++i) {
+        const QRectF bounds = randomRect();
+        index.insert(fakeItem(i), bounds);
+        reference.insert(fakeItem(i), bounds);
+    }
+    for (int i = 0; i < 2000; ++i) {
+        QDeclarativeGeoMapItemBase *item = fakeItem(m_random.bounded(2000));
+        const QRectF bounds = randomRect();
+        index.insert(item, bounds);
+        reference.insert(item, bounds);
+        QCOMPARE(index.bounds(item), bounds);
+        verifyIndex(index, reference);
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
+
+// Removing everything collapses the tree level by level down to an empty root
+void tst_QGeoMapItemIndex::drain()
+{
+    m_random.seed(5);
+    QGeoMapItemIndex index;
+    QHash<QDeclarativeGeoMapItemBase *, QRectF> reference;
+    QVector<QDeclarativeGeoMapItemBase *> present;
+    for (int i = 0; i < 3000; ++i) {
+        const QRectF bounds = randomRect();
+        index.insert(fakeItem(i), bounds);
+        reference.insert(fakeItem(i), bounds);
+        present.append(fakeItem(i));
+    }
+    verifyIndex(index, reference);
+
+    while (!present.isEmpty()) {
+        const int at = m_random.bounded(present.size());
+        QDeclarativeGeoMapItemBase *item = present.at(at);
+        present[at] = present.last();
+        present.removeLast();
+        index.remove(item);
+        reference.remove(item);
+        verifyIndex(index, reference);
+        if (QTest::currentTestFailed())
+            return;
+    }
+    QCOMPARE(index.size(), 0);
+
+    // Still usable once empty
+    index.remove(fakeItem(0));
+    index.insert(fakeItem(0), QRectF(0.1, 0.1, 0.1, 0.1));
+    Items found;
+    index.intersecting(QRectF(0.0, 0.0, 1.0, 1.0), found);
+    QCOMPARE(found, Items() << fakeItem(0));
+    index.clear();
+    QCOMPARE(index.size(), 0);
+    QVERIFY(!index.contains(fakeItem(0)));
+}
+
+// Points, lines and items sharing an edge with the query are found
+void tst_QGeoMapItemIndex::touchingEdges()
+{
+    QGeoMapItemIndex index;
+    index.insert(fakeItem(0), QRectF(0.5, 0.5, 0.0, 0.0));
+    index.insert(fakeItem(1), QRectF(0.2, 0.3, 0.1, 0.0));
+    index.insert(fakeItem(2), QRectF(0.6, 0.1, 0.1, 0.1));
+
+    Items found;
+    index.intersecting(QRectF(0.5, 0.5, 0.1, 0.1), found);
+    QCOMPARE(found, Items() << fakeItem(0));
+    found.clear();
+    index.intersecting(QRectF(0.25, 0.0, 0.0, 1.0), found);
+    QCOMPARE(found, Items() << fakeItem(1));
+    found.clear();
+    index.intersecting(QRectF(0.4, 0.2, 0.2, 0.1), found);
+    std::sort(found.begin(), found.end());
+    QCOMPARE(found, Items() << fakeItem(2));
+    found.clear();
+    index.intersecting(QRectF(0.71, 0.0, 0.1, 0.1), found);
+    QVERIFY(found.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(tst_QGeoMapItemIndex)
+
+#include "tst_qgeomapitemindex.moc"
@@ -0,0 +1,7 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeopathsimplification
+
+SOURCES += tst_qgeopathsimplification.cpp
+
+QT += location-private positioning-private testlib
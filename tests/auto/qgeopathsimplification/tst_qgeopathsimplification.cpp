@@ -0,0 +1,182 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtLocation/private/qgeomapitemgeometry_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_QGeoPathSimplification : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void shortPath();
+    void errorBound_data();
+    void errorBound();
+    void nestedLevels();
+    void invalidate();
+    void rankBenchmark_data();
+    void rankBenchmark();
+};
+
+// A GPS like track in map projection units: a random walk with small steps
+static QList<QDoubleVector2D> track(int size, bool closed = false)
+{
+    QList<QDoubleVector2D> path;
+    path.reserve(size);
+    quint32 seed = 12345;
+    QDoubleVector2D p(0.5, 0.4);
+    double heading = 0.0;
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        heading += ((seed >> 8) % 2001 - 1000) / 5000.0;
+        if (closed) {
+            const double angle = 2.0 * M_PI * i / size;
+            const double radius = 0.01 * (1.0 + 0.05 * std::sin(heading));
+            p = QDoubleVector2D(0.5 + radius * std::cos(angle), 0.4 + radius * std::sin(angle));
+        } else {
+            p += 1e-6 * QDoubleVector2D(std::cos(heading), std::sin(heading));
+        }
+        path.append(p);
+    }
+    return path;
+}
+
+static double segmentDistance(const QDoubleVector2D &p, const QDoubleVector2D &a, const QDoubleVector2D &b)
+{
+    const QDoubleVector2D ab = b - a;
+    const double length2 = ab.x() * ab.x() + ab.y() * ab.y();
+    double t = 0.0;
+    if (length2 > 0.0)
+        t = qBound(0.0, QDoubleVector2D::dotProduct(p - a, ab) / length2, 1.0);
+    return (p - (a + t * ab)).length();
+}
+
+void tst_QGeoPathSimplification::shortPath()
+{
+    QGeoPathSimplificationCache cache;
+    const QList<QDoubleVector2D> path = track(QGeoPathSimplificationCache::MinimumPathSize - 1);
+    QCOMPARE(&cache.path(path, 3.0), &path);
+}
+
+void tst_QGeoPathSimplification::errorBound_data()
+{
+    QTest::addColumn<bool>("closed");
+    QTest::addColumn<double>("zoomLevel");
+
+    for (bool closed : { false, true }) {
+        for (double zoom : { 2.0, 7.5, 12.0, 16.0 }) {
+            const QByteArray name = QByteArray(closed ? "ring" : "track") + " at zoom " + QByteArray::number(zoom);
+            QTest::newRow(name.constData()) << closed << zoom;
+        }
+    }
+}
+
+void tst_QGeoPathSimplification::errorBound()
+{
+    QFETCH(bool, closed);
+    QFETCH(double, zoomLevel);
+
+    const QList<QDoubleVector2D> source = track(20000, closed);
+    QGeoPathSimplificationCache cache;
+    const QList<QDoubleVector2D> simplified = cache.path(source, zoomLevel, closed);
+
+    QVERIFY(simplified.size() <= source.size());
+    QVERIFY(simplified.size() >= (closed ? 3 : 2));
+    QCOMPARE(simplified.first(), source.first());
+    QCOMPARE(simplified.last(), source.last());
+
+    // The simplified path is a subsequence of the source, and every dropped
+    // vertex is within tolerance of the segment replacing it
+    const double tol = QGeoPathSimplificationCache::tolerance(int(std::ceil(zoomLevel)));
+    int kept = 0;
+    int previous = 0;
+    for (int i = 1; i < source.size(); ++i) {
+        if (kept + 1 < simplified.size() && source.at(i) == simplified.at(kept + 1)) {
+            for (int j = previous + 1; j < i; ++j)
+                QVERIFY(segmentDistance(source.at(j), source.at(previous), source.at(i)) <= tol * (1.0 + 1e-9));
+            previous = i;
+            ++kept;
+        }
+    }
+    QCOMPARE(kept, simplified.size() - 1);
+}
+
+void tst_QGeoPathSimplification::nestedLevels()
+{
+    const QList<QDoubleVector2D> source = track(50000);
+    QGeoPathSimplificationCache cache;
+    int previous = 0;
+    for (int level = 0; level <= 20; ++level) {
+        const int size = cache.path(source, level).size();
+        QVERIFY(size >= previous);
+        previous = size;
+    }
+    // Coarse levels are much smaller than the source
+    QVERIFY(cache.path(source, 8).size() < source.size() / 10);
+}
+
+void tst_QGeoPathSimplification::invalidate()
+{
+    QList<QDoubleVector2D> source = track(1000);
+    QGeoPathSimplificationCache cache;
+    const QList<QDoubleVector2D> before = cache.path(source, 20);
+
+    // Same size, different points: the cache must be invalidated explicitly
+    source[500] += QDoubleVector2D(0.01, 0.0);
+    cache.invalidate();
+    const QList<QDoubleVector2D> after = cache.path(source, 20);
+    QVERIFY(after.contains(source.at(500)));
+    QVERIFY(!before.contains(source.at(500)));
+}
+
+void tst_QGeoPathSimplification::rankBenchmark_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("50k") << 50000;
+    QTest::newRow("200k") << 200000;
+}
+
+// Ranking the vertices is the one-off cost of a path change
+void tst_QGeoPathSimplification::rankBenchmark()
+{
+    QFETCH(int, size);
+    const QList<QDoubleVector2D> source = track(size);
+    QGeoPathSimplificationCache cache;
+    QBENCHMARK {
+        cache.invalidate();
+        cache.path(source, 14.0);
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoPathSimplification)
+
+#include "tst_qgeopathsimplification.moc"
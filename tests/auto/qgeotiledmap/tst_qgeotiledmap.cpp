@@ -33,10 +33,18 @@
 #include <QtTest/QtTest>
 #include <QtTest/QSignalSpy>
 #include <QtPositioning/private/qwebmercator_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
 #include <QtLocation/QGeoServiceProvider>
 #include <QtLocation/private/qgeotiledmap_p.h>
+#include <QtLocation/private/qgeotiledmappingmanagerengine_p.h>
+#include <QtLocation/private/qgeotilespec_p.h>
 #include <QtLocation/private/qgeomappingmanager_p.h>
 #include <QtLocation/private/qgeocameracapabilities_p.h>
+#include <QtLocation/private/qgeotileseedjob_p.h>
+#include <QtLocation/private/qabstractgeotilecache_p.h>
+#include <QtLocation/private/qgeocameratiles_p.h>
+#include <QtPositioning/QGeoRectangle>
+#include <QtPositioning/QGeoPath>
 
 QT_USE_NAMESPACE
 
@@ -48,9 +56,21 @@ class FetchTileCounter: public QObject
 public Q_SLOTS:
     void tileFetched(const QGeoTileSpec& spec) {
         m_tiles << spec;
+        m_order << spec;
+        if (m_clock.isValid())
+            m_lastFetch = m_clock.nsecsElapsed();
     }
 public:
+    void reset() {
+        m_tiles.clear();
+        m_order.clear();
+        m_lastFetch = 0;
+        m_clock.start();
+    }
     QSet<QGeoTileSpec> m_tiles;
+    QList<QGeoTileSpec> m_order;
+    QElapsedTimer m_clock;
+    qint64 m_lastFetch = 0;
 };
 
 class tst_QGeoTiledMap : public QObject
@@ -63,11 +83,22 @@ public:
 
 private:
     void waitForFetch(int count);
+    void waitForIdle();
 
 private Q_SLOTS:
     void initTestCase();
     void fetchTiles();
     void fetchTiles_data();
+    void fetchOrder();
+    void timeToFullViewport();
+    void flickBlankTime_data();
+    void flickBlankTime();
+    void sharedInFlight();
+    void updateTileRequests_data();
+    void updateTileRequests();
+    void seedRegion();
+    void seedRegionResume();
+    void seedPath();
 
 private:
     QScopedPointer<QGeoTiledMapTest> m_map;
@@ -197,6 +228,381 @@ void tst_QGeoTiledMap::fetchTiles_data()
     QTest::newRow("zoomLevel: 4.6 ,visible count: 4 : prefetch count: 4") << 4.6 << 4 << 4 + 4  + 4 << QGeoTiledMap::PrefetchTwoNeighbourLayers << 5;
 }
 
+void tst_QGeoTiledMap::fetchOrder()
+{
+    // Large enough for the visible tiles to come in a single batch of several rings
+    m_map->setViewportSize(QSize(1024, 1024));
+    m_map->setPrefetchStyle(QGeoTiledMap::NoPrefetching);
+
+    QGeoCameraData camera;
+    const QDoubleVector2D center(0.3, 0.6);
+    camera.setCenter(QWebMercator::mercatorToCoord(center));
+    camera.setZoomLevel(5);
+    QTest::qWait(10);
+    m_map->clearData();
+    m_tilesCounter->reset();
+    m_map->setCameraData(camera);
+    waitForIdle();
+
+    QVERIFY(m_tilesCounter->m_order.size() > 9);
+    // visible tiles are fetched nearest to the center first
+    double previous = 0;
+    for (const QGeoTileSpec &tile : qAsConst(m_tilesCounter->m_order)) {
+        const double side = 1 << tile.zoom();
+        const double dx = tile.x() + 0.5 - center.x() * side;
+        const double dy = tile.y() + 0.5 - center.y() * side;
+        const double distance = dx * dx + dy * dy;
+        QVERIFY2(distance >= previous - 0.25, "tile fetched out of priority order");
+        previous = qMax(previous, distance);
+    }
+
+    m_map->setViewportSize(QSize(256, 256));
+}
+
+/*
+    Pans over a series of positions on a cold cache and reports the average
+    time between the camera change and the arrival of the last tile it needed.
+*/
+void tst_QGeoTiledMap::timeToFullViewport()
+{
+    m_map->setViewportSize(QSize(1024, 768));
+    m_map->setPrefetchStyle(QGeoTiledMap::NoPrefetching);
+
+    QGeoCameraData camera;
+    camera.setZoomLevel(6);
+    qint64 total = 0;
+    const int steps = 10;
+    for (int i = 0; i < steps; ++i) {
+        camera.setCenter(QWebMercator::mercatorToCoord(QDoubleVector2D(0.2 + 0.05 * i, 0.4)));
+        QTest::qWait(10);
+        m_map->clearData();
+        m_tilesCounter->reset();
+        m_map->setCameraData(camera);
+        waitForIdle();
+        QVERIFY(!m_tilesCounter->m_tiles.isEmpty());
+        total += m_tilesCounter->m_lastFetch;
+    }
+
+    QTest::setBenchmarkResult(total / steps / 1000000.0, QTest::WalltimeMilliseconds);
+    m_map->setViewportSize(QSize(256, 256));
+}
+
+void tst_QGeoTiledMap::flickBlankTime_data()
+{
+    QTest::addColumn<QGeoTiledMap::PrefetchStyle>("style");
+
+    QTest::newRow("no prefetching") << QGeoTiledMap::NoPrefetching;
+    QTest::newRow("two neighbour layers") << QGeoTiledMap::PrefetchTwoNeighbourLayers;
+    QTest::newRow("predictive") << QGeoTiledMap::PrefetchPredictive;
+}
+
+/*
+    Replays recorded flicks with a round trip per tile and reports the time the
+    visible tiles stayed blank, summed over the tiles, in tile milliseconds.
+*/
+void tst_QGeoTiledMap::flickBlankTime()
+{
+    QFETCH(QGeoTiledMap::PrefetchStyle, style);
+
+    struct Flick {
+        double x;       // mercator center at release
+        double y;
+        int dx;         // flick vector in pixels and its duration, as the gesture area starts it
+        int dy;
+        int msecs;
+    };
+    static const Flick flicks[] = {
+        { 0.30, 0.40,   450,    0,  600 },
+        { 0.33, 0.40,  -566, -566,  800 },
+        { 0.36, 0.36,     0, 1250, 1000 },
+        { 0.36, 0.28, -1000,  750, 1000 }
+    };
+    const QSize viewport(1024, 768);
+    const double zoomLevel = 6;
+    const double mapWidth = 256.0 * (1 << int(zoomLevel));
+
+    m_map->setViewportSize(viewport);
+    m_map->setPrefetchStyle(style);
+    QTest::qWait(10);
+    m_map->clearData();
+    m_fetcher->setLatency(150);
+
+    QGeoTiledMappingManagerEngine *engine = m_map->m_engine;
+    QAbstractGeoTileCache *cache = engine->tileCache();
+    QGeoCameraTiles visibleTiles;
+    visibleTiles.setTileSize(256);
+    visibleTiles.setScreenSize(viewport);
+    visibleTiles.setPluginString(engine->managerName() + QLatin1Char('_') + QString::number(engine->managerVersion()));
+    visibleTiles.setMapType(m_map->activeMapType());
+
+    qint64 blank = 0;
+    for (const Flick &flick : flicks) {
+        // The flick starts where panning left the map, with its tiles in place
+        const QDoubleVector2D from(flick.x, flick.y);
+        const QDoubleVector2D to = from - QDoubleVector2D(flick.dx, flick.dy) / mapWidth;
+        QGeoCameraData camera;
+        camera.setZoomLevel(zoomLevel);
+        camera.setCenter(QWebMercator::mercatorToCoord(from));
+        m_map->setCameraData(camera);
+        m_map->prefetchData();
+        waitForIdle();
+
+        QGeoCameraData destination = camera;
+        destination.setCenter(QWebMercator::mercatorToCoord(to));
+        m_map->prefetchCameraPath(destination, flick.msecs);
+
+        // Follows the easing of the flick animation frame by frame, then waits at rest
+        QElapsedTimer clock;
+        clock.start();
+        int missing = 0;
+        qint64 now = 0;
+        do {
+            const double t = qMin(1.0, double(now) / flick.msecs);
+            const double f = 1.0 - (1.0 - t) * (1.0 - t);
+            camera.setCenter(QWebMercator::mercatorToCoord(from + (to - from) * f));
+            m_map->setCameraData(camera);
+            visibleTiles.setCameraData(camera);
+
+            missing = 0;
+            for (const QGeoTileSpec &tile : visibleTiles.createTiles()) {
+                if (!cache->isCached(tile))
+                    ++missing;
+            }
+            QTest::qWait(16);
+            blank += missing * (clock.elapsed() - now);
+            now = clock.elapsed();
+        } while ((now < flick.msecs || missing > 0) && now < 10000);
+        QCOMPARE(missing, 0);
+        m_map->prefetchData();
+        waitForIdle();
+    }
+
+    m_fetcher->setLatency(0);
+    QTest::setBenchmarkResult(blank, QTest::WalltimeMilliseconds);
+    m_map->setViewportSize(QSize(256, 256));
+}
+
+void tst_QGeoTiledMap::sharedInFlight()
+{
+    // A second provider caching in the same directory
+    QVariantMap parameters;
+    parameters["tileSize"] = 256;
+    parameters["maxZoomLevel"] = 8;
+    parameters["finishRequestImmediately"] = true;
+    QGeoServiceProvider provider("qmlgeo.test.plugin", parameters);
+    provider.setAllowExperimental(true);
+    QGeoMappingManager *mappingManager = provider.mappingManager();
+    QVERIFY(mappingManager);
+    QScopedPointer<QGeoTiledMapTest> other(static_cast<QGeoTiledMapTest*>(mappingManager->createMap(this)));
+    QVERIFY(other);
+    other->setViewportSize(QSize(256, 256));
+    other->setActiveMapType(other->m_engine->supportedMapTypes().first());
+    other->setPrefetchStyle(QGeoTiledMap::NoPrefetching);
+    m_map->setPrefetchStyle(QGeoTiledMap::NoPrefetching);
+
+    FetchTileCounter otherCounter;
+    connect(other->m_engine->tileFetcher(), SIGNAL(tileFetched(const QGeoTileSpec&)), &otherCounter, SLOT(tileFetched(const QGeoTileSpec&)));
+
+    QGeoCameraData camera;
+    camera.setCenter(QWebMercator::mercatorToCoord(QDoubleVector2D(0.5, 0.5)));
+    camera.setZoomLevel(4);
+    QTest::qWait(10);
+    other->clearData();
+    m_map->clearData();
+    m_tilesCounter->reset();
+    otherCounter.reset();
+    m_map->setCameraData(camera);
+    other->setCameraData(camera);
+    waitForIdle();
+
+    // Both maps want the same tiles, they are downloaded only once
+    QVERIFY(!m_tilesCounter->m_tiles.isEmpty());
+    QCOMPARE(otherCounter.m_tiles.size(), 0);
+    for (const QGeoTileSpec &tile : qAsConst(m_tilesCounter->m_tiles))
+        QVERIFY(other->m_engine->tileCache()->get(tile));
+}
+
+void tst_QGeoTiledMap::updateTileRequests_data()
+{
+    QTest::addColumn<int>("side");
+    QTest::addColumn<int>("mapCount");
+
+    QTest::newRow("16 tiles, 1 map") << 4 << 1;
+    QTest::newRow("16 tiles, 4 maps") << 4 << 4;
+    QTest::newRow("64 tiles, 1 map") << 8 << 1;
+    QTest::newRow("64 tiles, 4 maps") << 8 << 4;
+    QTest::newRow("256 tiles, 1 map") << 16 << 1;
+    QTest::newRow("256 tiles, 4 maps") << 16 << 4;
+}
+
+/*
+    Cost of the engine bookkeeping when maps pan back and forth by one column
+    of tiles, for a number of visible tiles and maps sharing the engine.
+*/
+void tst_QGeoTiledMap::updateTileRequests()
+{
+    QFETCH(int, side);
+    QFETCH(int, mapCount);
+
+    QGeoTiledMappingManagerEngine *engine = m_map->m_engine;
+    QList<QGeoTiledMap *> maps;
+    for (int i = 0; i < mapCount; ++i)
+        maps << static_cast<QGeoTiledMap *>(engine->createMap());
+
+    const QString plugin = QStringLiteral("qmlgeo.test.plugin");
+    QSet<QGeoTileSpec> view;
+    QSet<QGeoTileSpec> column;
+    QSet<QGeoTileSpec> nextColumn;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x)
+            view.insert(QGeoTileSpec(plugin, 1, 8, x, y));
+        column.insert(QGeoTileSpec(plugin, 1, 8, 0, y));
+        nextColumn.insert(QGeoTileSpec(plugin, 1, 8, side, y));
+    }
+
+    for (QGeoTiledMap *map : qAsConst(maps))
+        engine->updateTileRequests(map, view, QSet<QGeoTileSpec>());
+
+    QBENCHMARK {
+        for (QGeoTiledMap *map : qAsConst(maps))
+            engine->updateTileRequests(map, nextColumn, column);
+        for (QGeoTiledMap *map : qAsConst(maps))
+            engine->updateTileRequests(map, column, nextColumn);
+    }
+
+    qDeleteAll(maps);
+    QTest::qWait(10);
+}
+
+void tst_QGeoTiledMap::seedRegion()
+{
+    QGeoTiledMappingManagerEngine *engine = m_map->m_engine;
+    QTest::qWait(10);
+    m_map->clearData();
+    m_tilesCounter->reset();
+
+    // Two by two tiles on each level, across the dateline
+    const QGeoRectangle region(QGeoCoordinate(40, 170), QGeoCoordinate(-40, -170));
+    QScopedPointer<QGeoTileSeedJob> job(engine->seedRegion(region, 1, 3, 1));
+    job->setTilesPerSecond(0);
+    QSignalSpy finished(job.data(), &QGeoTileSeedJob::finished);
+    QTRY_COMPARE(finished.count(), 1);
+
+    QCOMPARE(job->state(), QGeoTileSeedJob::Finished);
+    QCOMPARE(job->tileCount(), quint64(12));
+    QCOMPARE(job->position(), quint64(12));
+    QCOMPARE(job->fetchedCount(), quint64(12));
+    QCOMPARE(job->failedCount(), quint64(0));
+    QCOMPARE(m_tilesCounter->m_tiles.size(), 12);
+
+    QAbstractGeoTileCache *cache = engine->tileCache();
+    for (const QGeoTileSpec &tile : qAsConst(m_tilesCounter->m_tiles)) {
+        QVERIFY(tile.zoom() >= 1 && tile.zoom() <= 3);
+        QVERIFY(tile.x() == 0 || tile.x() == (1 << tile.zoom()) - 1);
+        // seeding does not push the visible tiles out of memory
+        QVERIFY(cache->isCached(tile, QAbstractGeoTileCache::DiskCache));
+        QVERIFY(!cache->isCached(tile, QAbstractGeoTileCache::MemoryCache));
+    }
+
+    // Seeding again downloads nothing
+    m_tilesCounter->reset();
+    job.reset(engine->seedRegion(region, 1, 3, 1));
+    job->setTilesPerSecond(0);
+    QSignalSpy finishedAgain(job.data(), &QGeoTileSeedJob::finished);
+    QTRY_COMPARE(finishedAgain.count(), 1);
+    QCOMPARE(job->skippedCount(), quint64(12));
+    QCOMPARE(job->fetchedCount(), quint64(0));
+    QTest::qWait(50);
+    QVERIFY(m_tilesCounter->m_tiles.isEmpty());
+}
+
+void tst_QGeoTiledMap::seedRegionResume()
+{
+    QGeoTiledMappingManagerEngine *engine = m_map->m_engine;
+    QTest::qWait(10);
+    m_map->clearData();
+    m_tilesCounter->reset();
+
+    const QGeoRectangle region(QGeoCoordinate(60, -30), QGeoCoordinate(-60, 30));
+    QScopedPointer<QGeoTileSeedJob> job(engine->seedRegion(region, 2, 4, 1));
+    const quint64 tileCount = job->tileCount();
+    QVERIFY(tileCount > 8);
+    job->setTilesPerSecond(0);
+    job->setMaxPendingTiles(1);
+    QGeoTileSeedJob *first = job.data();
+    connect(first, &QGeoTileSeedJob::progressChanged, first, [first](quint64 position) {
+        if (position >= 5)
+            first->cancel();
+    });
+    QTRY_COMPARE(job->state(), QGeoTileSeedJob::Canceled);
+    const quint64 position = job->position();
+    QVERIFY(position >= 5 && position < tileCount);
+
+    QScopedPointer<QGeoTileSeedJob> resumed(engine->seedRegion(region, 2, 4, 1, position));
+    resumed->setTilesPerSecond(0);
+    QCOMPARE(resumed->position(), position);
+    QSignalSpy finished(resumed.data(), &QGeoTileSeedJob::finished);
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(resumed->position(), tileCount);
+
+    // Every tile downloaded exactly once over both jobs
+    QTest::qWait(50);
+    QCOMPARE(quint64(m_tilesCounter->m_tiles.size()), tileCount);
+    QCOMPARE(m_tilesCounter->m_order.size(), m_tilesCounter->m_tiles.size());
+}
+
+// A long diagonal path crosses tiles that hold none of its vertices
+void tst_QGeoTiledMap::seedPath()
+{
+    QGeoTiledMappingManagerEngine *engine = m_map->m_engine;
+    QTest::qWait(10);
+    m_map->clearData();
+    m_tilesCounter->reset();
+
+    const QGeoCoordinate from(10.0, 10.0);
+    const QGeoCoordinate to(10.5, 10.6);
+    const int zoom = 14;
+    QScopedPointer<QGeoTileSeedJob> job(engine->seedRegion(QGeoPath({ from, to }), zoom, zoom, 1));
+    job->setTilesPerSecond(0);
+    job->setMaxPendingTiles(16);
+    QSignalSpy finished(job.data(), &QGeoTileSeedJob::finished);
+    QTRY_COMPARE(finished.count(), 1);
+    QTest::qWait(50);
+
+    QSet<QPair<int, int> > seeded;
+    for (const QGeoTileSpec &tile : qAsConst(m_tilesCounter->m_tiles)) {
+        QCOMPARE(tile.zoom(), zoom);
+        seeded.insert(qMakePair(tile.x(), tile.y()));
+    }
+
+    // The tiles along the segment, as drawn in Mercator space
+    const QDoubleVector2D a = QWebMercator::coordToMercator(from);
+    const QDoubleVector2D b = QWebMercator::coordToMercator(to);
+    const int side = 1 << zoom;
+    QSet<QPair<int, int> > crossed;
+    for (int i = 0; i <= 10000; ++i) {
+        const QDoubleVector2D p = a + (b - a) * (i / 10000.0);
+        crossed.insert(qMakePair(int(p.x() * side), int(p.y() * side)));
+    }
+    QVERIFY(crossed.size() > 40);
+    for (const auto &tile : qAsConst(crossed))
+        QVERIFY2(seeded.contains(tile), qPrintable(QStringLiteral("tile %1/%2 not seeded").arg(tile.first).arg(tile.second)));
+
+    // Only the tiles along the path out of its bounding box
+    QVERIFY(quint64(seeded.size()) < job->tileCount() / 4);
+    QVERIFY(seeded.size() <= crossed.size() + 4);
+}
+
+void tst_QGeoTiledMap::waitForIdle()
+{
+    // Wait until no tile arrived for a while
+    int count = -1;
+    while (count != m_tilesCounter->m_order.size()) {
+        count = m_tilesCounter->m_order.size();
+        QTest::qWait(100);
+    }
+}
+
 void tst_QGeoTiledMap::waitForFetch(int count)
 {
     int timeout = 0;
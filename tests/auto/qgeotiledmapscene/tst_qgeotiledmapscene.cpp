@@ -40,6 +40,7 @@
 #include <qtest.h>
 
 #include <QList>
+#include <QScopedPointer>
 #include <QPair>
 #include <QDebug>
 
@@ -394,6 +395,42 @@ class tst_QGeoTiledMapScene : public QObject
             populateScreenMercatorData();
         }
 
+        void clonedProjection()
+        {
+            QGeoCameraData camera;
+            camera.setZoomLevel(6.5);
+            camera.setCenter(QGeoCoordinate(45.0, 10.0));
+            camera.setBearing(30.0);
+            camera.setTilt(25.0);
+
+            QGeoProjectionWebMercator projection;
+            projection.setViewportSize(QSize(640, 480));
+            projection.setCameraData(camera);
+
+            QScopedPointer<QGeoProjection> clone(projection.clone());
+            QVERIFY(clone);
+
+            const QList<QDoubleVector2D> region = projection.visibleRegion();
+            const QList<QDoubleVector2D> clonedRegion = clone->visibleRegion();
+            QCOMPARE(clonedRegion.size(), region.size());
+            for (int i = 0; i < region.size(); ++i) {
+                QVERIFY(qFuzzyCompare(clonedRegion.at(i).x(), region.at(i).x()));
+                QVERIFY(qFuzzyCompare(clonedRegion.at(i).y(), region.at(i).y()));
+            }
+
+            const QGeoCoordinate coordinate(45.5, 10.5);
+            const QPointF position = projection.coordinateToItemPosition(coordinate, false).toPointF();
+            const QPointF clonedPosition = clone->coordinateToItemPosition(coordinate, false).toPointF();
+            QVERIFY(qAbs(clonedPosition.x() - position.x()) < 1e-6);
+            QVERIFY(qAbs(clonedPosition.y() - position.y()) < 1e-6);
+            QCOMPARE(clone->minimumZoom(), projection.minimumZoom());
+
+            // The clone does not follow the original
+            camera.setZoomLevel(7.5);
+            projection.setCameraData(camera);
+            QVERIFY(qAbs(clone->coordinateToItemPosition(coordinate, false).x() - clonedPosition.x()) < 1e-6);
+        }
+
 };
 
 QTEST_GUILESS_MAIN(tst_QGeoTiledMapScene)
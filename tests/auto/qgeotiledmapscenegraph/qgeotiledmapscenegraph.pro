@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeotiledmapscenegraph
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeotiledmapscenegraph.cpp
+
+QT += location-private positioning-private quick-private testlib
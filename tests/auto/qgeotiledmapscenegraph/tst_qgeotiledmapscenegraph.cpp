@@ -0,0 +1,244 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qgeotilespec_p.h"
+#include "qgeotiledmapscene_p.h"
+#include "qgeocameratiles_p.h"
+#include "qgeocameradata_p.h"
+#include "qgeomaptype_p.h"
+#include "qabstractgeotilecache_p.h"
+#include "qgeocameracapabilities_p.h"
+#include <QtPositioning/private/qwebmercator_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGNode>
+#include <QtQuick/private/qquickitem_p.h>
+#include <QtGui/QGuiApplication>
+#include <QtTest/QtTest>
+
+QT_USE_NAMESPACE
+
+// Draws a tile scene the way QDeclarativeGeoMap does
+class SceneItem : public QQuickItem
+{
+public:
+    SceneItem(QGeoTiledMapScene *scene)
+        : m_scene(scene)
+    {
+        setFlag(ItemHasContents);
+    }
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override
+    {
+        return m_scene->updateSceneGraph(oldNode, window());
+    }
+
+private:
+    QGeoTiledMapScene *m_scene;
+};
+
+class tst_QGeoTiledMapSceneGraph : public QObject
+{
+    Q_OBJECT
+
+private:
+    void setUpScene(const QSize &viewport);
+    void moveCamera(const QDoubleVector2D &center);
+    static void countNodes(QSGNode *node, int *geometryNodes);
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void rendersTiles();
+    void nodesFollowView();
+    void frameTime_data();
+    void frameTime();
+
+private:
+    QScopedPointer<QQuickWindow> m_window;
+    QScopedPointer<QGeoTiledMapScene> m_scene;
+    QScopedPointer<QGeoCameraTiles> m_cameraTiles;
+    SceneItem *m_item = 0;
+    QGeoCameraData m_camera;
+    QImage m_tileImage;
+};
+
+void tst_QGeoTiledMapSceneGraph::init()
+{
+    m_tileImage = QImage(256, 256, QImage::Format_ARGB32_Premultiplied);
+    m_tileImage.fill(QColor(Qt::darkGreen));
+}
+
+void tst_QGeoTiledMapSceneGraph::cleanup()
+{
+    m_window.reset();
+    m_scene.reset();
+    m_cameraTiles.reset();
+    m_item = 0;
+}
+
+void tst_QGeoTiledMapSceneGraph::setUpScene(const QSize &viewport)
+{
+    m_scene.reset(new QGeoTiledMapScene());
+    m_scene->setScreenSize(viewport);
+    m_scene->setTileSize(256);
+
+    m_cameraTiles.reset(new QGeoCameraTiles());
+    m_cameraTiles->setTileSize(256);
+    m_cameraTiles->setScreenSize(viewport);
+    m_cameraTiles->setPluginString(QStringLiteral("scenegraph_test"));
+    m_cameraTiles->setMapType(QGeoMapType(QGeoMapType::StreetMap, "street map", "street map", false, false, 1,
+                                          QByteArrayLiteral(""), QGeoCameraCapabilities()));
+
+    m_window.reset(new QQuickWindow());
+    m_window->resize(viewport);
+    m_item = new SceneItem(m_scene.data());
+    m_item->setSize(viewport);
+    m_item->setParentItem(m_window->contentItem());
+    m_window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_window.data()));
+
+    m_camera.setZoomLevel(10);
+    moveCamera(QDoubleVector2D(0.52, 0.34));
+}
+
+void tst_QGeoTiledMapSceneGraph::moveCamera(const QDoubleVector2D &center)
+{
+    m_camera.setCenter(QWebMercator::mercatorToCoord(center));
+    m_cameraTiles->setCameraData(m_camera);
+    const QSet<QGeoTileSpec> tiles = m_cameraTiles->createTiles();
+
+    m_scene->setCameraData(m_camera);
+    m_scene->setVisibleTiles(tiles);
+    const QSet<QGeoTileSpec> textured = m_scene->texturedTiles();
+    for (const QGeoTileSpec &spec : tiles) {
+        if (textured.contains(spec))
+            continue;
+        QSharedPointer<QGeoTileTexture> texture(new QGeoTileTexture());
+        texture->spec = spec;
+        texture->image = m_tileImage;
+        m_scene->addTile(spec, texture);
+    }
+    m_item->update();
+}
+
+void tst_QGeoTiledMapSceneGraph::countNodes(QSGNode *node, int *geometryNodes)
+{
+    if (node->type() == QSGNode::GeometryNodeType)
+        ++*geometryNodes;
+    for (QSGNode *child = node->firstChild(); child; child = child->nextSibling())
+        countNodes(child, geometryNodes);
+}
+
+void tst_QGeoTiledMapSceneGraph::rendersTiles()
+{
+    setUpScene(QSize(800, 600));
+    const QImage frame = m_window->grabWindow();
+    QCOMPARE(frame.size() / m_window->effectiveDevicePixelRatio(), QSize(800, 600));
+    QCOMPARE(frame.pixelColor(frame.width() / 2, frame.height() / 2), QColor(Qt::darkGreen));
+    QCOMPARE(frame.pixelColor(1, 1), QColor(Qt::darkGreen));
+    QCOMPARE(frame.pixelColor(frame.width() - 2, frame.height() - 2), QColor(Qt::darkGreen));
+}
+
+void tst_QGeoTiledMapSceneGraph::nodesFollowView()
+{
+    setUpScene(QSize(800, 600));
+    m_window->grabWindow();
+    QSGNode *root = QQuickItemPrivate::get(m_item)->paintNode;
+    QVERIFY(root);
+    int before = 0;
+    countNodes(root, &before);
+    // one node per visible tile at most, a few atlas batches at best
+    QVERIFY(before > 0);
+    QVERIFY(before <= m_scene->visibleTiles().size() + 1);
+
+    // Panning a long way replaces every tile, without piling up nodes
+    for (int i = 1; i <= 20; ++i) {
+        moveCamera(QDoubleVector2D(0.52 + 0.0005 * i, 0.34));
+        m_window->grabWindow();
+    }
+    int after = 0;
+    countNodes(root, &after);
+    QVERIFY(after <= m_scene->visibleTiles().size() + 1);
+
+    const QImage frame = m_window->grabWindow();
+    QCOMPARE(frame.pixelColor(frame.width() / 2, frame.height() / 2), QColor(Qt::darkGreen));
+}
+
+void tst_QGeoTiledMapSceneGraph::frameTime_data()
+{
+    QTest::addColumn<QSize>("viewport");
+    QTest::addColumn<bool>("atlas");
+
+    QTest::newRow("1080p, atlas") << QSize(1920, 1080) << true;
+    QTest::newRow("1080p, texture per tile") << QSize(1920, 1080) << false;
+    QTest::newRow("4K, atlas") << QSize(3840, 2160) << true;
+    QTest::newRow("4K, texture per tile") << QSize(3840, 2160) << false;
+}
+
+/*
+    Time to sync and render a frame of a panning map, new tiles included.
+    The atlas only makes a difference with the OpenGL backend, which is used
+    when the platform provides it and QT_QUICK_BACKEND does not say otherwise.
+*/
+void tst_QGeoTiledMapSceneGraph::frameTime()
+{
+    QFETCH(QSize, viewport);
+    QFETCH(bool, atlas);
+
+    setUpScene(viewport);
+    m_scene->setTextureAtlasEnabled(atlas);
+    m_window->grabWindow();
+
+    // About a tenth of a tile per frame
+    double x = 0.52;
+    QBENCHMARK {
+        x += 0.0001;
+        moveCamera(QDoubleVector2D(x, 0.34));
+        m_window->grabWindow();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Headless by default, with the software backend unless asked for another one
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    if (!qEnvironmentVariableIsSet("QT_QUICK_BACKEND"))
+        QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+
+    QGuiApplication app(argc, argv);
+    tst_QGeoTiledMapSceneGraph tc;
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "tst_qgeotiledmapscenegraph.moc"
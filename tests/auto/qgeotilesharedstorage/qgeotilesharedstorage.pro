@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+SUBDIRS += tilewriter test
+test.depends = tilewriter
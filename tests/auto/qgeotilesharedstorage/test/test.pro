@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeotilesharedstorage
+DESTDIR = $$OUT_PWD/..
+
+INCLUDEPATH += ../../../../src/location/maps
+
+SOURCES += tst_qgeotilesharedstorage.cpp
+
+QT += location-private gui testlib
@@ -0,0 +1,294 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtCore/QDir>
+#include <QtCore/QBuffer>
+#include <QtCore/QProcess>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtTest/QtTest>
+
+#include "qgeofiletilecache_p.h"
+#include "qgeotilesharedstorage_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoTileSharedStorage : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString fileName(const QString &directory, int i) const;
+    QFileInfoList tileFiles(const QString &directory) const;
+
+private Q_SLOTS:
+    void initTestCase();
+    void readFromOtherStorage();
+    void coordinatedEviction();
+    void capacityFromBudget();
+    void leastRecentlyUsed();
+    void longNameUpdate();
+    void concurrentWriters();
+    void sharedTileCache();
+
+private:
+    QString m_writer;
+};
+
+QString tst_QGeoTileSharedStorage::fileName(const QString &directory, int i) const
+{
+    const QGeoTileSpec spec(QStringLiteral("test"), 1, 16, i % 1024, i / 1024);
+    return QGeoFileTileCache::tileSpecToFilenameDefault(spec, QStringLiteral("png"), directory);
+}
+
+QFileInfoList tst_QGeoTileSharedStorage::tileFiles(const QString &directory) const
+{
+    return QDir(directory).entryInfoList(QStringList() << QStringLiteral("*-*-*-*.*"), QDir::Files);
+}
+
+void tst_QGeoTileSharedStorage::initTestCase()
+{
+    m_writer = QCoreApplication::applicationDirPath() + QLatin1String("/tilewriter");
+}
+
+void tst_QGeoTileSharedStorage::readFromOtherStorage()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileSharedStorage a;
+    QGeoTileSharedStorage b;
+    QVERIFY(a.open(dir.path()));
+    QVERIFY(b.open(dir.path()));
+    if (!a.isShared())
+        QSKIP("Shared memory is not available");
+    QVERIFY(b.isShared());
+
+    const QString name = fileName(dir.path(), 1);
+    const QByteArray bytes(300, 'x');
+    QVERIFY(a.write(name, bytes));
+
+    QString stem = name;
+    stem.chop(4);
+    QCOMPARE(b.lookup(stem), name);
+    QCOMPARE(b.size(name), qint64(bytes.size()));
+    QCOMPARE(b.totalCost(), qint64(bytes.size()));
+
+    // served from shared memory, not from the file
+    QVERIFY(QFile::remove(name));
+    QByteArray read;
+    QVERIFY(b.read(name, &read));
+    QCOMPARE(read, bytes);
+
+    b.remove(name);
+    QVERIFY(a.lookup(stem).isEmpty());
+    QCOMPARE(a.tileCount(), 0);
+}
+
+void tst_QGeoTileSharedStorage::coordinatedEviction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileSharedStorage a;
+    QGeoTileSharedStorage b;
+    QVERIFY(a.open(dir.path()));
+    QVERIFY(b.open(dir.path()));
+    if (!a.isShared())
+        QSKIP("Shared memory is not available");
+
+    a.setMaxCost(1000, true);
+    for (int i = 0; i < 6; ++i) {
+        QVERIFY(a.write(fileName(dir.path(), i), QByteArray(100, 'a')));
+        QVERIFY(b.write(fileName(dir.path(), 100 + i), QByteArray(100, 'b')));
+    }
+
+    QCOMPARE(a.totalCost(), qint64(1000));
+    QCOMPARE(b.tileCount(), 10);
+    QCOMPARE(b.evictionCount(), quint64(2));
+    QCOMPARE(tileFiles(dir.path()).size(), 10);
+}
+
+// The index holds as many tiles as the budget set before opening allows,
+// rather than a fixed count
+void tst_QGeoTileSharedStorage::capacityFromBudget()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileSharedStorage a;
+    a.setMaxCost(20000, false);
+    QVERIFY(a.open(dir.path()));
+    if (!a.isShared())
+        QSKIP("Shared memory is not available");
+    QVERIFY(a.tileCapacity() >= 20000);
+
+    const QByteArray bytes(10, 'x');
+    for (int i = 0; i < 20000; ++i)
+        QVERIFY(a.write(fileName(dir.path(), i), bytes));
+    QCOMPARE(a.tileCount(), 20000);
+    QCOMPARE(a.evictionCount(), quint64(0));
+    QCOMPARE(a.totalCost(), qint64(20000));
+
+    QTemporaryDir bytesDir;
+    QVERIFY(bytesDir.isValid());
+    QGeoTileSharedStorage b;
+    b.setMaxCost(200 * 1024 * 1024, true);
+    QVERIFY(b.open(bytesDir.path()));
+    QVERIFY(b.tileCapacity() >= 200 * 256);
+}
+
+void tst_QGeoTileSharedStorage::leastRecentlyUsed()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileSharedStorage a;
+    QGeoTileSharedStorage b;
+    QVERIFY(a.open(dir.path()));
+    QVERIFY(b.open(dir.path()));
+    if (!a.isShared())
+        QSKIP("Shared memory is not available");
+
+    a.setMaxCost(4, false);
+    for (int i = 0; i < 4; ++i)
+        QVERIFY(a.write(fileName(dir.path(), i), QByteArray(10, 'a')));
+
+    // a use in the other process counts as well
+    QByteArray bytes;
+    QVERIFY(b.read(fileName(dir.path(), 0), &bytes));
+    QVERIFY(a.write(fileName(dir.path(), 4), QByteArray(10, 'a')));
+
+    QCOMPARE(a.totalCost(), qint64(4));
+    QVERIFY(QFile::exists(fileName(dir.path(), 0)));
+    QVERIFY(!QFile::exists(fileName(dir.path(), 1)));
+}
+
+// Rewriting a tile under a name too long for a slot drops it from the index
+void tst_QGeoTileSharedStorage::longNameUpdate()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileSharedStorage a;
+    QGeoTileSharedStorage b;
+    QVERIFY(a.open(dir.path()));
+    QVERIFY(b.open(dir.path()));
+    if (!a.isShared())
+        QSKIP("Shared memory is not available");
+
+    const QString name = fileName(dir.path(), 1);
+    QString stem = name;
+    stem.chop(4);
+    QVERIFY(a.write(name, QByteArray(10, 'a')));
+    QCOMPARE(b.lookup(stem), name);
+
+    const QString longName = stem + QLatin1Char('.') + QString(120, QLatin1Char('x'));
+    const QByteArray bytes(20, 'b');
+    QVERIFY(a.write(longName, bytes));
+    QVERIFY(b.lookup(stem).isEmpty());
+    QCOMPARE(b.tileCount(), 0);
+    QCOMPARE(b.totalCost(), qint64(0));
+
+    // still readable from the file
+    QByteArray read;
+    QVERIFY(b.read(longName, &read));
+    QCOMPARE(read, bytes);
+}
+
+void tst_QGeoTileSharedStorage::concurrentWriters()
+{
+    const int writers = 3;
+    const int tiles = 500;
+    const qint64 maxBytes = 60000;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    // keeps the segment alive after the writers exit
+    QGeoTileSharedStorage storage;
+    QVERIFY(storage.open(dir.path()));
+    if (!storage.isShared())
+        QSKIP("Shared memory is not available");
+
+    QVector<QProcess *> processes;
+    for (int i = 0; i < writers; ++i) {
+        QProcess *process = new QProcess(this);
+        process->start(m_writer, QStringList() << dir.path() << QString::number(i * tiles)
+                                               << QString::number(tiles) << QString::number(maxBytes));
+        processes.append(process);
+    }
+    for (QProcess *process : qAsConst(processes)) {
+        QVERIFY2(process->waitForFinished(60000), qPrintable(process->errorString()));
+        QCOMPARE(process->exitStatus(), QProcess::NormalExit);
+        QCOMPARE(process->exitCode(), 0);
+        delete process;
+    }
+
+    // the index and the directory agree, and the budget held
+    const QFileInfoList files = tileFiles(dir.path());
+    qint64 bytes = 0;
+    for (const QFileInfo &info : files)
+        bytes += info.size();
+    QCOMPARE(files.size(), storage.tileCount());
+    QCOMPARE(storage.totalCost(), bytes);
+    QVERIFY(bytes <= maxBytes);
+    QVERIFY(storage.evictionCount() > 0);
+}
+
+void tst_QGeoTileSharedStorage::sharedTileCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QImage image(8, 8, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+
+    QScopedPointer<QGeoFileTileCache> a(new QGeoFileTileCache(dir.path()));
+    a->setDiskStorage(QGeoTileDiskStorage::create(QStringLiteral("shared")));
+    a->init();
+    QScopedPointer<QGeoFileTileCache> b(new QGeoFileTileCache(dir.path()));
+    b->setDiskStorage(QGeoTileDiskStorage::create(QStringLiteral("shared")));
+    b->init();
+    if (!a->diskStorage()->isShared())
+        QSKIP("Shared memory is not available");
+
+    const QGeoTileSpec spec(QStringLiteral("test"), 1, 3, 2, 1);
+    QVERIFY(!b->isCached(spec, QAbstractGeoTileCache::DiskCache));
+    a->insert(spec, png, QStringLiteral("png"), QAbstractGeoTileCache::DiskCache);
+
+    QVERIFY(b->isCached(spec, QAbstractGeoTileCache::DiskCache));
+    QCOMPARE(b->diskUsage(), png.size());
+    QSharedPointer<QGeoTileTexture> tt = b->get(spec);
+    QVERIFY(tt);
+    QCOMPARE(tt->image.size(), QSize(8, 8));
+}
+
+QTEST_MAIN(tst_QGeoTileSharedStorage)
+
+#include "tst_qgeotilesharedstorage.moc"
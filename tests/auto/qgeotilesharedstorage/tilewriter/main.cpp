@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+
+#include "qgeofiletilecache_p.h"
+#include "qgeotilesharedstorage_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+// Writes tiles to a shared storage, as another application using the same
+// cache directory would.
+// Usage: tilewriter <directory> <first tile> <tile count> <max bytes>
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() != 5)
+        return 2;
+
+    const QString directory = args.at(1);
+    const int first = args.at(2).toInt();
+    const int count = args.at(3).toInt();
+    const qint64 maxBytes = args.at(4).toLongLong();
+
+    QGeoTileSharedStorage storage;
+    if (!storage.open(directory) || !storage.isShared())
+        return 1;
+    storage.setMaxCost(maxBytes, true);
+
+    for (int i = first; i < first + count; ++i) {
+        const QGeoTileSpec spec(QStringLiteral("test"), 1, 16, i % 1024, i / 1024);
+        const QString filename = QGeoFileTileCache::tileSpecToFilenameDefault(spec, QStringLiteral("png"), directory);
+        // tiles of different sizes, so that byte accounting is exercised
+        if (!storage.write(filename, QByteArray(100 + i % 300, char('a' + i % 26))))
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = tilewriter
+DESTDIR = $$OUT_PWD/..
+
+INCLUDEPATH += ../../../../src/location/maps
+
+SOURCES += main.cpp
+
+QT = core location-private
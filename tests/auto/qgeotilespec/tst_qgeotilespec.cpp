@@ -28,6 +28,7 @@
 
 #include <QtCore/QString>
 #include <QtTest/QtTest>
+#include <cmath>
 
 #include "qgeotilespec_p.h"
 
@@ -59,6 +60,9 @@ private Q_SLOTS:
     void lessThanOperatorTest();
     void qHashTest_data();
     void qHashTest();
+    void qHashDistribution();
+    void setDifference_data();
+    void setDifference();
 };
 
 tst_QGeoTileSpec::tst_QGeoTileSpec()
@@ -312,6 +316,66 @@ void tst_QGeoTileSpec::qHashTest()
     QVERIFY(hash2 != hash3);
 }
 
+void tst_QGeoTileSpec::qHashDistribution()
+{
+    // Neighbouring tiles over a few zoom levels, as in a tilted viewport
+    QSet<uint> hashes;
+    QSet<uint> buckets;
+    int count = 0;
+    for (int zoom = 10; zoom < 13; ++zoom) {
+        for (int y = 0; y < 64; ++y) {
+            for (int x = 0; x < 64; ++x) {
+                const uint hash = qHash(QGeoTileSpec(QStringLiteral("osm"), 1, zoom, 300 + x, 700 + y));
+                hashes.insert(hash);
+                buckets.insert(hash % 16381);
+                ++count;
+            }
+        }
+    }
+
+    QCOMPARE(hashes.size(), count);
+    // A uniform hash fills about 1 - 1/e^(count/buckets) of the buckets
+    QVERIFY(buckets.size() > 0.95 * 16381 * (1.0 - std::exp(-double(count) / 16381)));
+}
+
+void tst_QGeoTileSpec::setDifference_data()
+{
+    QTest::addColumn<int>("side");
+    QTest::newRow("8x8") << 8;
+    QTest::newRow("16x16") << 16;
+    QTest::newRow("32x32") << 32;
+}
+
+/*
+    The set differences done by QGeoTiledMapPrivate::updateScene() and
+    QGeoTiledMapRootNode::updateTiles() when the map pans by one tile.
+*/
+void tst_QGeoTileSpec::setDifference()
+{
+    QFETCH(int, side);
+
+    QSet<QGeoTileSpec> before;
+    QSet<QGeoTileSpec> after;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            before.insert(QGeoTileSpec(QStringLiteral("osm"), 1, 14, 8000 + x, 5000 + y));
+            after.insert(QGeoTileSpec(QStringLiteral("osm"), 1, 14, 8001 + x, 5000 + y));
+        }
+    }
+    QHash<QGeoTileSpec, int> nodes;
+    for (const QGeoTileSpec &spec : qAsConst(before))
+        nodes.insert(spec, 0);
+
+    int changed = 0;
+    QBENCHMARK {
+        const QSet<QGeoTileSpec> removed = before - after;
+        const QSet<QGeoTileSpec> added = after - before;
+        const QSet<QGeoTileSpec> inGraph = QSet<QGeoTileSpec>::fromList(nodes.keys());
+        changed = removed.size() + added.size() + (inGraph - after).size();
+    }
+    QCOMPARE(changed, 3 * side);
+}
+
 QTEST_APPLESS_MAIN(tst_QGeoTileSpec)
 
 #include "tst_qgeotilespec.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeotilevalidators
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeotilevalidators.cpp
+
+QT += location-private network gui testlib
@@ -0,0 +1,457 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtCore/QBuffer>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtTest/QtTest>
+
+#include "qgeotilevalidators_p.h"
+#include "qgeofiletilecache_p.h"
+#include "qgeotiledmapreply_p.h"
+#include "qgeotiledmappingmanagerengine_p.h"
+#include "qgeotilefetcher_p.h"
+#include "qgeotilespec_p.h"
+#include "qgeocameracapabilities_p.h"
+
+QT_USE_NAMESPACE
+
+/*
+    Local stand-in for a tile server: serves one tile with an ETag and
+    answers If-None-Match with 304 while the tile is unchanged.
+*/
+class TileServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    TileServer() : requests(0), notModified(0), lastResponseBytes(0)
+    {
+        connect(this, &QTcpServer::newConnection, this, &TileServer::accept);
+    }
+
+    void setTile(const QByteArray &bytes, const QByteArray &tag)
+    {
+        body = bytes;
+        etag = tag;
+    }
+
+    QByteArray body;
+    QByteArray etag;
+    int requests;
+    int notModified;
+    qint64 lastResponseBytes;
+    QByteArray lastIfNoneMatch;
+
+private Q_SLOTS:
+    void accept()
+    {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, &TileServer::read);
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    }
+
+    void read()
+    {
+        QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+        QByteArray &request = m_pending[socket];
+        request += socket->readAll();
+        const int end = request.indexOf("\r\n\r\n");
+        if (end < 0)
+            return;
+
+        lastIfNoneMatch.clear();
+        const QList<QByteArray> lines = request.left(end).split('\n');
+        for (const QByteArray &line : lines) {
+            const int colon = line.indexOf(':');
+            if (colon > 0 && line.left(colon).trimmed().toLower() == "if-none-match")
+                lastIfNoneMatch = line.mid(colon + 1).trimmed();
+        }
+        m_pending.remove(socket);
+        ++requests;
+
+        QByteArray response;
+        if (!lastIfNoneMatch.isEmpty() && lastIfNoneMatch == etag) {
+            ++notModified;
+            response = "HTTP/1.1 304 Not Modified\r\n"
+                       "ETag: " + etag + "\r\n"
+                       "Cache-Control: max-age=3600\r\n"
+                       "Connection: close\r\n\r\n";
+        } else {
+            response = "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: image/png\r\n"
+                       "ETag: " + etag + "\r\n"
+                       "Cache-Control: max-age=3600\r\n"
+                       "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+        }
+        lastResponseBytes = response.size();
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+
+private:
+    QHash<QTcpSocket *, QByteArray> m_pending;
+};
+
+class TestTileReply : public QGeoTiledMapReply
+{
+    Q_OBJECT
+public:
+    TestTileReply(QNetworkReply *reply, const QGeoTileSpec &spec)
+        : QGeoTiledMapReply(spec)
+    {
+        connect(reply, &QNetworkReply::finished, this, &TestTileReply::networkReplyFinished);
+        connect(this, &QGeoTiledMapReply::aborted, reply, &QNetworkReply::abort);
+        connect(this, &QObject::destroyed, reply, &QObject::deleteLater);
+        setMapImageFormat(QStringLiteral("png"));
+    }
+
+private Q_SLOTS:
+    void networkReplyFinished()
+    {
+        QNetworkReply *reply = static_cast<QNetworkReply *>(sender());
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            setError(CommunicationError, reply->errorString());
+            return;
+        }
+        setValidators(QGeoTileValidators::fromHttpHeaders(reply->rawHeaderPairs()));
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
+            setNotModified(true);
+        else
+            setMapImageData(reply->readAll());
+        setFinished(true);
+    }
+};
+
+class TestTileFetcher : public QGeoTileFetcher
+{
+    Q_OBJECT
+public:
+    TestTileFetcher(QGeoMappingManagerEngine *engine, const QUrl &baseUrl)
+        : QGeoTileFetcher(engine), m_baseUrl(baseUrl), m_nm(new QNetworkAccessManager(this))
+    {
+    }
+
+protected:
+    QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec) Q_DECL_OVERRIDE
+    {
+        QNetworkRequest request(m_baseUrl.resolved(QUrl(QString::fromLatin1("%1/%2/%3.png")
+                                                        .arg(spec.zoom()).arg(spec.x()).arg(spec.y()))));
+        const QGeoTileHttpHeaders conditionalHeaders = tileValidators(spec).conditionalHeaders();
+        for (const auto &header : conditionalHeaders)
+            request.setRawHeader(header.first, header.second);
+        return new TestTileReply(m_nm->get(request), spec);
+    }
+
+private:
+    QUrl m_baseUrl;
+    QNetworkAccessManager *m_nm;
+};
+
+class TestEngine : public QGeoTiledMappingManagerEngine
+{
+    Q_OBJECT
+public:
+    TestEngine(const QString &directory, const QUrl &baseUrl)
+    {
+        QGeoCameraCapabilities capabilities;
+        capabilities.setMinimumZoomLevel(0.0);
+        capabilities.setMaximumZoomLevel(20.0);
+        setCameraCapabilities(capabilities);
+        setTileSize(QSize(256, 256));
+        setTileCache(new QGeoFileTileCache(directory));
+        setTileFetcher(new TestTileFetcher(this, baseUrl));
+    }
+};
+
+class tst_QGeoTileValidators : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QGeoTileValidators();
+
+private Q_SLOTS:
+    void initTestCase();
+    void fromHttpHeaders_data();
+    void fromHttpHeaders();
+    void validators();
+    void httpDate();
+    void conditionalHeaders();
+    void refreshed();
+    void streaming();
+    void revalidation();
+
+private:
+    QByteArray m_tileBytes;
+    QByteArray m_changedTileBytes;
+};
+
+tst_QGeoTileValidators::tst_QGeoTileValidators()
+{
+}
+
+void tst_QGeoTileValidators::initTestCase()
+{
+    QImage image(256, 256, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb((x * 7 + y) & 0xff, (x ^ y) & 0xff, (x * y) & 0xff));
+    QBuffer buffer(&m_tileBytes);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+
+    image.fill(Qt::red);
+    QBuffer changedBuffer(&m_changedTileBytes);
+    changedBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&changedBuffer, "PNG"));
+}
+
+void tst_QGeoTileValidators::fromHttpHeaders_data()
+{
+    QTest::addColumn<QByteArray>("cacheControl");
+    QTest::addColumn<QByteArray>("expires");
+    QTest::addColumn<QByteArray>("age");
+    QTest::addColumn<int>("lifetime"); // seconds, -1 if the tile never expires
+
+    const QDateTime received(QDate(2018, 3, 1), QTime(12, 0), Qt::UTC);
+    const QByteArray in300 = QGeoTileValidators::toHttpDate(received.addSecs(300));
+
+    QTest::newRow("none") << QByteArray() << QByteArray() << QByteArray() << -1;
+    QTest::newRow("max-age") << QByteArray("public, max-age=600") << QByteArray() << QByteArray() << 600;
+    QTest::newRow("max-age minus age") << QByteArray("max-age=600") << QByteArray() << QByteArray("100") << 500;
+    QTest::newRow("age beyond max-age") << QByteArray("max-age=600") << QByteArray() << QByteArray("900") << 0;
+    QTest::newRow("expires") << QByteArray() << in300 << QByteArray() << 300;
+    QTest::newRow("max-age over expires") << QByteArray("max-age=60") << in300 << QByteArray() << 60;
+    QTest::newRow("no-cache") << QByteArray("no-cache, max-age=600") << QByteArray() << QByteArray() << 0;
+    QTest::newRow("no-store") << QByteArray("No-Store") << in300 << QByteArray() << 0;
+    QTest::newRow("invalid expires") << QByteArray() << QByteArray("0") << QByteArray() << 0;
+}
+
+void tst_QGeoTileValidators::fromHttpHeaders()
+{
+    QFETCH(QByteArray, cacheControl);
+    QFETCH(QByteArray, expires);
+    QFETCH(QByteArray, age);
+    QFETCH(int, lifetime);
+
+    const QDateTime received(QDate(2018, 3, 1), QTime(12, 0), Qt::UTC);
+    QGeoTileHttpHeaders headers;
+    if (!cacheControl.isEmpty())
+        headers.append(qMakePair(QByteArray("Cache-Control"), cacheControl));
+    if (!expires.isEmpty())
+        headers.append(qMakePair(QByteArray("Expires"), expires));
+    if (!age.isEmpty())
+        headers.append(qMakePair(QByteArray("Age"), age));
+
+    const QGeoTileValidators v = QGeoTileValidators::fromHttpHeaders(headers, received);
+    QCOMPARE(v.fetched, received);
+    if (lifetime < 0) {
+        QVERIFY(!v.expires.isValid());
+        QVERIFY(!v.isExpired(received.addYears(10)));
+    } else {
+        QCOMPARE(v.expires, received.addSecs(lifetime));
+        QCOMPARE(v.isExpired(received.addSecs(lifetime)), true);
+        QCOMPARE(v.isExpired(received.addSecs(lifetime - 1)), false);
+    }
+}
+
+void tst_QGeoTileValidators::validators()
+{
+    QGeoTileHttpHeaders headers;
+    headers.append(qMakePair(QByteArray("etag"), QByteArray(" W/\"abc\" ")));
+    headers.append(qMakePair(QByteArray("Last-Modified"), QByteArray("Sun, 06 Nov 1994 08:49:37 GMT")));
+    const QGeoTileValidators v = QGeoTileValidators::fromHttpHeaders(headers);
+    QCOMPARE(v.etag, QByteArray("W/\"abc\""));
+    QCOMPARE(v.lastModified, QDateTime(QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC));
+    QVERIFY(v.canRevalidate());
+
+    QVERIFY(!QGeoTileValidators::fromHttpHeaders(QGeoTileHttpHeaders()).canRevalidate());
+}
+
+void tst_QGeoTileValidators::httpDate()
+{
+    const QDateTime date(QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC);
+    QCOMPARE(QGeoTileValidators::toHttpDate(date), QByteArray("Sun, 06 Nov 1994 08:49:37 GMT"));
+    QCOMPARE(QGeoTileValidators::toHttpDate(date.toOffsetFromUtc(3600)), QByteArray("Sun, 06 Nov 1994 08:49:37 GMT"));
+    QCOMPARE(QGeoTileValidators::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), date);
+    QCOMPARE(QGeoTileValidators::parseHttpDate("Sun, 06 Nov 1994 09:49:37 +0100"), date);
+    QVERIFY(!QGeoTileValidators::parseHttpDate("yesterday").isValid());
+}
+
+void tst_QGeoTileValidators::conditionalHeaders()
+{
+    QGeoTileValidators v;
+    QVERIFY(v.conditionalHeaders().isEmpty());
+
+    v.lastModified = QDateTime(QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC);
+    QGeoTileHttpHeaders headers = v.conditionalHeaders();
+    QCOMPARE(headers.size(), 1);
+    QCOMPARE(headers.at(0).first, QByteArray("If-Modified-Since"));
+    QCOMPARE(headers.at(0).second, QByteArray("Sun, 06 Nov 1994 08:49:37 GMT"));
+
+    v.etag = "\"abc\"";
+    headers = v.conditionalHeaders();
+    QCOMPARE(headers.size(), 2);
+    QCOMPARE(headers.at(0).first, QByteArray("If-None-Match"));
+    QCOMPARE(headers.at(0).second, QByteArray("\"abc\""));
+}
+
+void tst_QGeoTileValidators::refreshed()
+{
+    QGeoTileValidators cached;
+    cached.etag = "\"abc\"";
+    cached.lastModified = QDateTime(QDate(2018, 1, 1), QTime(0, 0), Qt::UTC);
+    cached.expires = QDateTime(QDate(2018, 2, 1), QTime(0, 0), Qt::UTC);
+    cached.fetched = QDateTime(QDate(2018, 1, 1), QTime(0, 0), Qt::UTC);
+
+    // A 304 without validators keeps the cached ones
+    QGeoTileValidators notModified;
+    notModified.fetched = QDateTime(QDate(2018, 3, 1), QTime(0, 0), Qt::UTC);
+    QGeoTileValidators v = cached.refreshed(notModified);
+    QCOMPARE(v.etag, cached.etag);
+    QCOMPARE(v.lastModified, cached.lastModified);
+    QVERIFY(!v.expires.isValid());
+    QCOMPARE(v.fetched, notModified.fetched);
+
+    notModified.etag = "\"def\"";
+    notModified.expires = notModified.fetched.addSecs(60);
+    v = cached.refreshed(notModified);
+    QCOMPARE(v.etag, QByteArray("\"def\""));
+    QCOMPARE(v.expires, notModified.expires);
+}
+
+void tst_QGeoTileValidators::streaming()
+{
+    QGeoTileValidators v;
+    v.etag = "\"abc\"";
+    v.lastModified = QDateTime(QDate(2018, 1, 1), QTime(0, 0), Qt::UTC);
+    v.fetched = QDateTime(QDate(2018, 3, 1), QTime(12, 0), Qt::UTC);
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << v;
+    }
+    QGeoTileValidators read;
+    QDataStream in(data);
+    in >> read;
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QCOMPARE(read.etag, v.etag);
+    QCOMPARE(read.lastModified, v.lastModified);
+    QVERIFY(!read.expires.isValid());
+    QCOMPARE(read.fetched, v.fetched);
+}
+
+/*
+    A stale cached tile is shown right away and revalidated with a
+    conditional request: the unchanged tile costs a 304 without a body,
+    the changed one is downloaded and replaces it.
+*/
+void tst_QGeoTileValidators::revalidation()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TileServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    server.setTile(m_tileBytes, "\"a\"");
+    const QUrl baseUrl(QString::fromLatin1("http://127.0.0.1:%1/").arg(server.serverPort()));
+    const QGeoTileSpec spec(QStringLiteral("test"), 1, 3, 2, 5);
+
+    {
+        TestEngine engine(dir.path(), baseUrl);
+        QAbstractGeoTileCache *cache = engine.tileCache();
+        QGeoTileFetcher *fetcher = engine.tileFetcher();
+        QSignalSpy finishedSpy(fetcher, &QGeoTileFetcher::tileFinished);
+        QSignalSpy notModifiedSpy(fetcher, &QGeoTileFetcher::tileNotModified);
+
+        fetcher->updateTileRequests(QSet<QGeoTileSpec>() << spec, QSet<QGeoTileSpec>());
+        QTRY_COMPARE(finishedSpy.count(), 1);
+        QCOMPARE(server.requests, 1);
+        QVERIFY(server.lastIfNoneMatch.isEmpty());
+
+        // Fresh for an hour
+        QTRY_VERIFY(cache->get(spec));
+        QVERIFY(!cache->needsRevalidation(spec, 0));
+        bool pending = false;
+        QVERIFY(engine.getTileTextureAsync(0, spec, &pending));
+        QTest::qWait(50);
+        QCOMPARE(server.requests, 1);
+
+        // The tileset changed after the tile was fetched
+        QTest::qWait(20);
+        cache->setStaleBefore(spec.mapId(), QDateTime::currentDateTimeUtc());
+        QGeoTileValidators v;
+        QVERIFY(cache->needsRevalidation(spec, &v));
+        QCOMPARE(v.etag, QByteArray("\"a\""));
+
+        // Still shown while revalidated, and only revalidated once
+        QVERIFY(engine.getTileTextureAsync(0, spec, &pending));
+        QVERIFY(engine.getTileTextureAsync(0, spec, &pending));
+        QTRY_COMPARE(notModifiedSpy.count(), 1);
+        QCOMPARE(server.requests, 2);
+        QCOMPARE(server.notModified, 1);
+        QCOMPARE(server.lastIfNoneMatch, QByteArray("\"a\""));
+        QVERIFY(server.lastResponseBytes < m_tileBytes.size());
+        QCOMPARE(finishedSpy.count(), 1);
+        QTRY_VERIFY(!cache->needsRevalidation(spec, 0));
+
+        // Now the tile itself changed
+        server.setTile(m_changedTileBytes, "\"b\"");
+        QTest::qWait(20);
+        cache->setStaleBefore(spec.mapId(), QDateTime::currentDateTimeUtc());
+        QVERIFY(engine.getTileTextureAsync(0, spec, &pending));
+        QTRY_COMPARE(finishedSpy.count(), 2);
+        QCOMPARE(server.requests, 3);
+        QCOMPARE(server.notModified, 1);
+        QCOMPARE(finishedSpy.last().at(1).toByteArray(), m_changedTileBytes);
+        QTRY_VERIFY(!cache->needsRevalidation(spec, 0));
+
+        QTest::qWait(20);
+        cache->setStaleBefore(spec.mapId(), QDateTime::currentDateTimeUtc());
+    }
+
+    // Validators and the stale mark survive the cache
+    QGeoFileTileCache *fileCache = new QGeoFileTileCache(dir.path());
+    QScopedPointer<QAbstractGeoTileCache> cache(fileCache);
+    cache->init();
+    QGeoTileValidators v;
+    QVERIFY(cache->needsRevalidation(spec, &v));
+    QCOMPARE(v.etag, QByteArray("\"b\""));
+}
+
+QTEST_MAIN(tst_QGeoTileValidators)
+
+#include "tst_qgeotilevalidators.moc"
@@ -0,0 +1,269 @@
+/****************************************************************************
+**
+** Copyright (C) 2018 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtPositioning/QGeoPositionInfo>
+#include <QtPositioning/QGeoSatelliteInfo>
+#include <QtPositioning/private/qlocationutils_p.h>
+
+#include <cmath>
+
+QT_USE_NAMESPACE
+
+Q_DECLARE_METATYPE(QGeoPositionInfo::Attribute)
+
+static QByteArray withChecksum(const QByteArray &body)
+{
+    int checksum = 0;
+    for (int i = 1; i < body.size(); ++i)
+        checksum ^= body.at(i);
+    return body + '*' + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper() + "\r\n";
+}
+
+class tst_QLocationUtils : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void positionSentences_data()
+    {
+        QTest::addColumn<QByteArray>("sentence");
+        QTest::addColumn<bool>("fix");
+        QTest::addColumn<QGeoCoordinate>("coordinate");
+        QTest::addColumn<QTime>("time");
+        QTest::addColumn<QDate>("date");
+
+        const QGeoCoordinate brisbane(-27.579940, 153.100207);
+        QGeoCoordinate brisbaneHigh = brisbane;
+        brisbaneHigh.setAltitude(28.4);
+        const QTime time(5, 4, 35, 440);
+
+        QTest::newRow("GPGGA") << withChecksum("$GPGGA,050435.44,2734.7964,S,15306.0124,E,1,03,2.0,28.4,M,,,,0000")
+                               << true << brisbaneHigh << time << QDate();
+        QTest::newRow("GNGGA no fix") << withChecksum("$GNGGA,050435.44,2734.7964,S,15306.0124,E,0,03,2.0,28.4,M,,,,0000")
+                                      << false << brisbaneHigh << time << QDate();
+        QTest::newRow("GNGNS") << withChecksum("$GNGNS,050435.44,2734.7964,S,15306.0124,E,ANN,08,2.0,28.4,39.0,,")
+                               << true << brisbaneHigh << time << QDate();
+        QTest::newRow("GNGNS no fix") << withChecksum("$GNGNS,050435.44,2734.7964,S,15306.0124,E,NN,00,,,,,")
+                                      << false << brisbane << time << QDate();
+        QTest::newRow("GPGLL") << withChecksum("$GPGLL,2734.7964,S,15306.0124,E,050435.44,A,A")
+                               << true << brisbane << time << QDate();
+        QTest::newRow("BDRMC") << withChecksum("$BDRMC,050435.44,A,2734.7964,S,15306.0124,E,0.4,74.7,300916,,,A")
+                               << true << brisbane << time << QDate(2016, 9, 30);
+        QTest::newRow("GPRMC leap day") << withChecksum("$GPRMC,050435.44,V,2734.7964,S,15306.0124,E,,,290200,,")
+                                        << false << brisbane << time << QDate(2000, 2, 29);
+        QTest::newRow("GPZDA") << withChecksum("$GPZDA,050435.44,30,09,2016,00,00")
+                               << false << QGeoCoordinate() << time << QDate(2016, 9, 30);
+        QTest::newRow("GPGST") << withChecksum("$GPGST,050435.44,1.1,2.0,1.5,30.0,3.0,4.0,5.0")
+                               << false << QGeoCoordinate() << time << QDate();
+        QTest::newRow("seconds only") << withChecksum("$GPGGA,050435,2734.7964,S,15306.0124,E,1,03,2.0,28.4,M,,,,0000")
+                                      << true << brisbaneHigh << QTime(5, 4, 35) << QDate();
+        QTest::newRow("exponent") << withChecksum("$GPGLL,2.7347964e3,S,15306.0124,E,050435.44,A,A")
+                                  << true << brisbane << time << QDate();
+    }
+
+    void positionSentences()
+    {
+        QFETCH(QByteArray, sentence);
+        QFETCH(bool, fix);
+        QFETCH(QGeoCoordinate, coordinate);
+        QFETCH(QTime, time);
+        QFETCH(QDate, date);
+
+        QGeoPositionInfo info;
+        bool hasFix = !fix;
+        QVERIFY(QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(),
+                                                   &info, 5.1, &hasFix));
+        QCOMPARE(hasFix, fix);
+        QCOMPARE(info.coordinate().isValid(), coordinate.isValid());
+        if (coordinate.isValid()) {
+            QVERIFY(qAbs(info.coordinate().latitude() - coordinate.latitude()) < 1e-6);
+            QVERIFY(qAbs(info.coordinate().longitude() - coordinate.longitude()) < 1e-6);
+            QCOMPARE(qIsNaN(info.coordinate().altitude()), qIsNaN(coordinate.altitude()));
+            if (!qIsNaN(coordinate.altitude()))
+                QCOMPARE(info.coordinate().altitude(), coordinate.altitude());
+        }
+        QCOMPARE(info.timestamp().time(), time);
+        QCOMPARE(info.timestamp().date(), date);
+    }
+
+    void attributes_data()
+    {
+        QTest::addColumn<QByteArray>("sentence");
+        QTest::addColumn<QGeoPositionInfo::Attribute>("attribute");
+        QTest::addColumn<double>("value");
+
+        const double uere = 5.1;
+        QTest::newRow("GGA hdop") << withChecksum("$GPGGA,050435.44,2734.7964,S,15306.0124,E,1,03,2.0,28.4,M,,,,0000")
+                                  << QGeoPositionInfo::HorizontalAccuracy << 2 * 2.0 * uere;
+        QTest::newRow("GSA vdop") << withChecksum("$GNGSA,A,3,03,22,06,19,11,14,32,01,28,18,,,1.8,1.0,1.5")
+                                  << QGeoPositionInfo::VerticalAccuracy << 2 * 1.5 * uere;
+        QTest::newRow("GST horizontal") << withChecksum("$GPGST,050435.44,1.1,2.0,1.5,30.0,3.0,4.0,5.0")
+                                        << QGeoPositionInfo::HorizontalAccuracy << 10.0;
+        QTest::newRow("GST vertical") << withChecksum("$GPGST,050435.44,1.1,2.0,1.5,30.0,3.0,4.0,5.0")
+                                      << QGeoPositionInfo::VerticalAccuracy << 10.0;
+        QTest::newRow("RMC speed") << withChecksum("$GPRMC,050435.44,A,2734.7964,S,15306.0124,E,10.0,74.7,300916,11.5,W,A")
+                                   << QGeoPositionInfo::GroundSpeed << 10.0 * 1.852 / 3.6;
+        QTest::newRow("RMC variation") << withChecksum("$GPRMC,050435.44,A,2734.7964,S,15306.0124,E,10.0,74.7,300916,11.5,W,A")
+                                       << QGeoPositionInfo::MagneticVariation << -11.5;
+        QTest::newRow("VTG direction") << withChecksum("$GPVTG,74.7,T,,M,0.4,N,0.7,K,A")
+                                       << QGeoPositionInfo::Direction << 74.7;
+    }
+
+    void attributes()
+    {
+        QFETCH(QByteArray, sentence);
+        QFETCH(QGeoPositionInfo::Attribute, attribute);
+        QFETCH(double, value);
+
+        QGeoPositionInfo info;
+        QVERIFY(QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(),
+                                                   &info, 5.1));
+        QVERIFY(info.hasAttribute(attribute));
+        QCOMPARE(info.attribute(attribute), qreal(value));
+    }
+
+    void rejectedSentences_data()
+    {
+        QTest::addColumn<QByteArray>("sentence");
+
+        QTest::newRow("bad checksum") << QByteArray("$GPGGA,050435.44,2734.7964,S,15306.0124,E,1,03,2.0,28.4,M,,,,0000*00\r\n");
+        QTest::newRow("no checksum") << QByteArray("$GPGGA,050435.44,2734.7964,S,15306.0124,E,1,03,2.0,28.4,M,,,,0000\r\n");
+        QTest::newRow("unknown type") << withChecksum("$GPXYZ,1,2,3");
+        QTest::newRow("satellites") << withChecksum("$GPGSV,1,1,01,01,40,083,46");
+        QTest::newRow("no talker") << withChecksum("$GGA,050435.44,2734.7964,S,15306.0124,E,1");
+    }
+
+    void rejectedSentences()
+    {
+        QFETCH(QByteArray, sentence);
+
+        QGeoPositionInfo info;
+        QVERIFY(!QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(),
+                                                    &info, 5.1));
+    }
+
+    void nmeaTime_data()
+    {
+        QTest::addColumn<QByteArray>("field");
+        QTest::addColumn<QTime>("time");
+
+        QTest::newRow("seconds") << QByteArray("235959") << QTime(23, 59, 59);
+        QTest::newRow("tenths") << QByteArray("000001.5") << QTime(0, 0, 1, 500);
+        QTest::newRow("hundredths") << QByteArray("120000.25") << QTime(12, 0, 0, 250);
+        QTest::newRow("micros") << QByteArray("120000.123456") << QTime(12, 0, 0, 123);
+        QTest::newRow("empty fraction") << QByteArray("120000.") << QTime(12, 0, 0);
+        QTest::newRow("bad fraction") << QByteArray("120000.x") << QTime(12, 0, 0);
+        QTest::newRow("short") << QByteArray("12000") << QTime();
+        QTest::newRow("hour 24") << QByteArray("240000") << QTime();
+        QTest::newRow("letters") << QByteArray("12a000") << QTime();
+    }
+
+    void nmeaTime()
+    {
+        QFETCH(QByteArray, field);
+        QFETCH(QTime, time);
+
+        QTime result;
+        QCOMPARE(QLocationUtils::getNmeaTime(field, &result), time.isValid());
+        QCOMPARE(result, time);
+    }
+
+    void latLongMatchesFullParser()
+    {
+        // the fast path must produce the very same doubles as QByteArray::toDouble
+        QRandomGenerator rng(1);
+        for (int i = 0; i < 10000; ++i) {
+            const QByteArray lat = QByteArray::number(rng.bounded(9000.0), 'f', 1 + i % 8);
+            const QByteArray lng = QByteArray::number(rng.bounded(18000.0), 'f', 1 + i % 8);
+            double fastLat, fastLng;
+            QVERIFY(QLocationUtils::getNmeaLatLong(lat, 'N', lng, 'W', &fastLat, &fastLng));
+
+            const double latDeg = std::floor(lat.toDouble() / 100.0);
+            const double lngDeg = std::floor(lng.toDouble() / 100.0);
+            QCOMPARE(fastLat, latDeg + 100.0 * (lat.toDouble() / 100.0 - latDeg) / 60.0);
+            QCOMPARE(fastLng, -(lngDeg + 100.0 * (lng.toDouble() / 100.0 - lngDeg) / 60.0));
+        }
+    }
+
+    void satellites()
+    {
+        const QByteArray gps = withChecksum("$GPGSV,3,2,11,14,25,170,00,16,57,208,39,18,67,296,40,19,40,246,00");
+        QList<QGeoSatelliteInfo> infos;
+        int number = 0;
+        int count = 0;
+        QVERIFY(QLocationUtils::getSatInfoFromNmea(gps.constData(), gps.size(), &infos, &number, &count));
+        QCOMPARE(number, 2);
+        QCOMPARE(count, 3);
+        QCOMPARE(infos.size(), 4);
+        QCOMPARE(infos.at(1).satelliteIdentifier(), 16);
+        QCOMPARE(infos.at(1).satelliteSystem(), QGeoSatelliteInfo::GPS);
+        QCOMPARE(infos.at(1).signalStrength(), 39);
+        QCOMPARE(infos.at(1).attribute(QGeoSatelliteInfo::Elevation), qreal(57));
+        QCOMPARE(infos.at(1).attribute(QGeoSatelliteInfo::Azimuth), qreal(208));
+
+        // mixed talker with a trailing NMEA 4.1 signal ID and an empty signal strength
+        const QByteArray mixed = withChecksum("$GNGSV,1,1,02,05,10,020,,70,45,180,33,1");
+        QVERIFY(QLocationUtils::getSatInfoFromNmea(mixed.constData(), mixed.size(), &infos));
+        QCOMPARE(infos.size(), 6);
+        QCOMPARE(infos.at(4).satelliteSystem(), QGeoSatelliteInfo::GPS);
+        QCOMPARE(infos.at(4).signalStrength(), -1);
+        QCOMPARE(infos.at(5).satelliteSystem(), QGeoSatelliteInfo::GLONASS);
+
+        const QByteArray position = withChecksum("$GPGLL,2734.7964,S,15306.0124,E,050435.44,A,A");
+        QVERIFY(!QLocationUtils::getSatInfoFromNmea(position.constData(), position.size(), &infos));
+    }
+
+    void parseBenchmark()
+    {
+        const QList<QByteArray> sentences = QList<QByteArray>()
+                << withChecksum("$GPRMC,050435.44,A,2734.7964,S,15306.0124,E,0.4,74.7,300916,,,A")
+                << withChecksum("$GPGGA,050435.44,2734.7964,S,15306.0124,E,1,03,2.0,28.4,M,,,,0000")
+                << withChecksum("$GNGSA,A,3,03,22,06,19,11,14,32,01,28,18,,,1.8,1.0,1.5")
+                << withChecksum("$GPVTG,74.7,T,,M,0.4,N,0.7,K,A")
+                << withChecksum("$GPGST,050435.44,1.1,2.0,1.5,30.0,3.0,4.0,5.0")
+                << withChecksum("$GNGNS,050435.44,2734.7964,S,15306.0124,E,ANN,08,2.0,28.4,39.0,,");
+
+        // one iteration parses 6000 sentences; throughput is 6000 / time
+        const int rounds = 1000;
+        QGeoPositionInfo info;
+        bool hasFix;
+        QBENCHMARK {
+            for (int i = 0; i < rounds; ++i) {
+                for (const QByteArray &sentence : sentences)
+                    QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(),
+                                                       &info, 5.1, &hasFix);
+            }
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(tst_QLocationUtils)
+
+#include "tst_qlocationutils.moc"